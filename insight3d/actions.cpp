@@ -96,6 +96,8 @@ bool action_triangulate_vertices(
 			vertex->z = 0;
 		}
 
+		geometry_vertex_changed(i);
+
 		// release resources
 		ATOMIC_RW(opencv, cvReleaseMat(&reconstructed_vertex); );
 	}
@@ -16,7 +16,7 @@ bool debug_initialize()
 }
 
 // initialize application subsystems 
-bool initialization()
+bool initialization(const bool headless)
 {
 	// GNU GPL license notification
 	printf("insight3d 0.5, 2007-2010\n");
@@ -40,8 +40,9 @@ bool initialization()
 	bool state = 
 		core_debug_initialize() && 
 		debug_initialize() && // todo merge this with core_debug
-		core_initialize() &&
+		core_initialize(headless) &&
 		geometry_initialize() && 
+		geometry_autosave_initialize() && 
 		image_loader_initialize(4, 32) &&
 		ui_initialize() &&
 		visualization_initialize() && 
@@ -49,12 +50,28 @@ bool initialization()
 		ui_create() && 
 		image_loader_start_thread();
 
+	// intermediate results of untitled project are cached in current directory 
+	cache_open(NULL);
+
 	printf("ok\n");
 
 	// initialize the whole package
 	return state; 
 }
 
+// initialize only what batch pipeline needs 
+bool initialization_batch()
+{
+	printf("insight3d 0.5, 2007-2010\n");
+	printf("licensed under GNU AGPL 3\n\n");
+
+	return 
+		core_debug_initialize() && 
+		core_initialize(true) &&
+		geometry_initialize() && 
+		image_loader_initialize(4, 32);
+}
+
 static pthread_t gui_rendering_thread;
 
 // main loop 
@@ -73,6 +90,7 @@ bool main_loop()
 	while (core_state.running)
 	{
 		GUI_Event_Descriptor event;
+		bool idle = false;
 
 		// process event 
 		LOCK(geometry)
@@ -115,8 +133,25 @@ bool main_loop()
 					}
 				}
 			}
+			else
+			{
+				idle = true;
+			}
 		}
 		UNLOCK(geometry);
+
+		// journal what the event changed (the writer thread does the rest)
+		geometry_autosave_tick();
+
+		// don't spin while there's nothing to do, otherwise show what the event changed
+		if (idle) 
+		{
+			SDL_Delay(1);
+		}
+		else
+		{
+			gui_request_redraw();
+		}
 	};
 
 	return true; 
@@ -125,8 +160,19 @@ bool main_loop()
 // deallocate program structures
 bool release()
 {
+	geometry_autosave_release();
 	geometry_release();
 	image_loader_release();
+	cache_release();
+
+	return true;
+}
+
+// deallocate structures of batch pipeline (image loader thread isn't running)
+bool release_batch()
+{
+	geometry_release();
+	cache_release();
 
 	return true;
 }
@@ -2,10 +2,14 @@
 #define __APPLICATION
 
 #include "geometry_structures.h"
+#include "geometry_autosave.h"
+#include "core_cache.h"
 #include "core_image_loader.h"
 #include "gui.h"
 #include "ui_core.h"
 #include "ui_visualization.h"
+#include "ui_benchmark.h"
+#include "tool_batch.h"
 
 extern bool mousealreadydown;
 extern double delta_time; // time elapsed since last frame rendering\
@@ -14,8 +18,11 @@ extern double delta_time; // time elapsed since last frame rendering\
 // application data structures)
 bool debug_initialize();
 
-// initialize application subsystems 
-bool initialization();
+// initialize application subsystems (headless skips everything that needs a desktop)
+bool initialization(const bool headless = false);
+
+// initialize only what batch pipeline needs (core, geometry and image loader, no user interface)
+bool initialization_batch();
 
 // main loop 
 bool main_loop(); 
@@ -23,6 +30,9 @@ bool main_loop();
 // deallocate program structures
 bool release();
 
+// deallocate structures of batch pipeline
+bool release_batch();
+
 // error reporting routine 
 bool report_error();
 
@@ -0,0 +1,574 @@
+#include "core_cache.h"
+#include <ctype.h>
+
+// cached file (names of entries are hashes of their keys followed by extension)
+struct Cache_Entry
+{
+	char * name;
+	unsigned long long size;
+	time_t used;
+};
+
+// remembered hash of contents of a file
+struct Cache_File_Hash
+{
+	char * filename;
+	unsigned long long size;
+	time_t modification_time;
+	Cache_Key hash;
+};
+
+// cache state
+struct Cache
+{
+	char * directory;                  // NULL until the cache is opened
+	bool created;                      // directory exists
+	unsigned long long limit, total;
+	Cache_Entry * entries;
+	size_t entries_count, entries_allocated;
+	Cache_File_Hash * files;
+	size_t files_count, files_allocated;
+	unsigned int temporary_id;
+};
+
+static Cache cache = { NULL, false, CACHE_DEFAULT_LIMIT, 0, NULL, 0, 0, NULL, 0, 0, 0 };
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// number of hex digits in the name of an entry
+static const size_t CACHE_NAME_LENGTH = 32;
+static const char * const CACHE_TEMPORARY_EXTENSION = ".tmp";
+
+// * keys *
+
+static unsigned long long cache_rotate(const unsigned long long x, const int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+// final avalanche (from MurmurHash3)
+static unsigned long long cache_finalize(unsigned long long x)
+{
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+// mix 8 bytes into the key (both halves are updated by differently scrambled words)
+static void cache_key_mix(Cache_Key & key, unsigned long long word)
+{
+	word *= 0x87c37b91114253d5ULL;
+	word = cache_rotate(word, 31);
+	word *= 0x4cf5ad432745937fULL;
+
+	key.hash[0] = cache_rotate(key.hash[0] ^ word, 27) * 5 + 0x52dce729 + key.hash[1];
+	key.hash[1] = cache_rotate(key.hash[1] ^ cache_rotate(word, 33), 31) * 5 + 0x38495ab5 + key.hash[0];
+}
+
+// start new key for entries of given kind
+void cache_key_init(Cache_Key & key, const char * kind, const int version)
+{
+	key.hash[0] = 0x6a09e667f3bcc908ULL;
+	key.hash[1] = 0xbb67ae8584caa73bULL;
+	cache_key_add_string(key, kind);
+	cache_key_add_int(key, version);
+}
+
+// add input to the key (size goes first, so that consecutive inputs can't be confused)
+void cache_key_add(Cache_Key & key, const void * data, const size_t size)
+{
+	cache_key_mix(key, size);
+
+	const unsigned char * const bytes = (const unsigned char *)data;
+	size_t i = 0;
+	unsigned long long word;
+	for (; i + 8 <= size; i += 8)
+	{
+		memcpy(&word, bytes + i, 8);
+		cache_key_mix(key, word);
+	}
+
+	if (i < size)
+	{
+		word = 0;
+		memcpy(&word, bytes + i, size - i);
+		cache_key_mix(key, word);
+	}
+}
+
+void cache_key_add_int(Cache_Key & key, const long long value)
+{
+	cache_key_add(key, &value, sizeof(value));
+}
+
+void cache_key_add_double(Cache_Key & key, const double value)
+{
+	cache_key_add(key, &value, sizeof(value));
+}
+
+void cache_key_add_string(Cache_Key & key, const char * s)
+{
+	cache_key_add(key, s, strlen(s));
+}
+
+// index of remembered hash of the file (files_count if there is none)
+// expects cache_mutex
+static size_t cache_find_file(const char * filename)
+{
+	for (size_t i = 0; i < cache.files_count; i++)
+	{
+		if (strcmp(cache.files[i].filename, filename) == 0) return i;
+	}
+
+	return cache.files_count;
+}
+
+// add contents of the file to the key, returns false if it can't be read
+bool cache_key_add_file(Cache_Key & key, const char * filename)
+{
+	const time_t modification_time = interface_filesystem_modification_time(filename);
+	const unsigned long long size = interface_filesystem_file_size(filename);
+	if (modification_time == 0) return false;
+
+	// maybe we've already read it
+	pthread_mutex_lock(&cache_mutex);
+	size_t found = cache_find_file(filename);
+	if (found < cache.files_count && cache.files[found].size == size && cache.files[found].modification_time == modification_time)
+	{
+		const Cache_Key hash = cache.files[found].hash;
+		pthread_mutex_unlock(&cache_mutex);
+		cache_key_add(key, hash.hash, sizeof(hash.hash));
+		return true;
+	}
+	pthread_mutex_unlock(&cache_mutex);
+
+	// hash the contents (without holding the lock, this takes a while)
+	Cache_Key hash;
+	cache_key_init(hash, "file", 1);
+	if (size > 0)
+	{
+		Filesystem_Mapping mapping;
+		if (!interface_filesystem_map_file(filename, &mapping)) return false;
+		cache_key_add(hash, mapping.data, mapping.size);
+		interface_filesystem_unmap_file(&mapping);
+	}
+	else
+	{
+		cache_key_add(hash, NULL, 0);
+	}
+
+	// and remember it
+	pthread_mutex_lock(&cache_mutex);
+	found = cache_find_file(filename);
+	if (found == cache.files_count)
+	{
+		if (cache.files_count == cache.files_allocated)
+		{
+			const size_t allocated = cache.files_allocated ? 2 * cache.files_allocated : 64;
+			Cache_File_Hash * const files = (Cache_File_Hash *)realloc(cache.files, allocated * sizeof(Cache_File_Hash));
+			if (files)
+			{
+				cache.files = files;
+				cache.files_allocated = allocated;
+			}
+		}
+
+		if (cache.files_count < cache.files_allocated)
+		{
+			found = cache.files_count++;
+			cache.files[found].filename = strdup(filename);
+		}
+	}
+
+	if (found < cache.files_count)
+	{
+		cache.files[found].size = size;
+		cache.files[found].modification_time = modification_time;
+		cache.files[found].hash = hash;
+	}
+	pthread_mutex_unlock(&cache_mutex);
+
+	cache_key_add(key, hash.hash, sizeof(hash.hash));
+	return true;
+}
+
+// * index *
+
+// full path of the file in the cache directory (has to be freed)
+// expects cache_mutex
+static char * cache_path(const char * name)
+{
+	char * path = ALLOC(char, strlen(cache.directory) + strlen(FILESYSTEM_PATH_SEPARATOR) + strlen(name) + 1);
+	strcpy(path, cache.directory);
+	strcat(path, FILESYSTEM_PATH_SEPARATOR);
+	strcat(path, name);
+	return path;
+}
+
+// name of the entry with given key (has to be freed)
+static char * cache_entry_name(const Cache_Key & key, const char * extension)
+{
+	char * name = ALLOC(char, CACHE_NAME_LENGTH + strlen(extension) + 1);
+	sprintf(name, "%016llx%016llx%s", cache_finalize(key.hash[0]), cache_finalize(key.hash[1]), extension);
+	return name;
+}
+
+// is it a name of an entry (or of a temporary file of an entry)?
+static bool cache_entry_name_valid(const char * name)
+{
+	for (size_t i = 0; i < CACHE_NAME_LENGTH; i++)
+	{
+		if (!isxdigit((unsigned char)name[i])) return false;
+	}
+
+	return name[CACHE_NAME_LENGTH] == '\0' || name[CACHE_NAME_LENGTH] == '.';
+}
+
+// name of the entry stored at given path (NULL if it's not in current cache directory)
+// expects cache_mutex
+static const char * cache_entry_name_of(const char * filename)
+{
+	if (!cache.directory) return NULL;
+	const size_t length = strlen(cache.directory), separator_length = strlen(FILESYSTEM_PATH_SEPARATOR);
+	if (strncmp(filename, cache.directory, length) != 0 || strncmp(filename + length, FILESYSTEM_PATH_SEPARATOR, separator_length) != 0) return NULL;
+	const char * const name = filename + length + separator_length;
+	return cache_entry_name_valid(name) ? name : NULL;
+}
+
+// add entry to the index or update it
+// expects cache_mutex
+static void cache_index(const char * name, const unsigned long long size, const time_t used)
+{
+	for (size_t i = 0; i < cache.entries_count; i++)
+	{
+		if (strcmp(cache.entries[i].name, name) == 0)
+		{
+			cache.total += size - cache.entries[i].size;
+			cache.entries[i].size = size;
+			cache.entries[i].used = used;
+			return;
+		}
+	}
+
+	if (cache.entries_count == cache.entries_allocated)
+	{
+		const size_t allocated = cache.entries_allocated ? 2 * cache.entries_allocated : 256;
+		Cache_Entry * const entries = (Cache_Entry *)realloc(cache.entries, allocated * sizeof(Cache_Entry));
+		if (!entries) return;
+		cache.entries = entries;
+		cache.entries_allocated = allocated;
+	}
+
+	Cache_Entry * const entry = cache.entries + cache.entries_count++;
+	entry->name = strdup(name);
+	entry->size = size;
+	entry->used = used;
+	cache.total += size;
+}
+
+// mark entry used (the modification time of the file keeps the order for the next session)
+// expects cache_mutex
+static void cache_touch(const char * name, const char * filename)
+{
+	for (size_t i = 0; i < cache.entries_count; i++)
+	{
+		if (strcmp(cache.entries[i].name, name) == 0)
+		{
+			cache.entries[i].used = time(NULL);
+			break;
+		}
+	}
+
+	interface_filesystem_touch(filename);
+}
+
+static int cache_compare_entries(const void * a, const void * b)
+{
+	const time_t x = ((const Cache_Entry *)a)->used, y = ((const Cache_Entry *)b)->used;
+	return x < y ? -1 : x > y ? 1 : 0;
+}
+
+// delete least recently used entries until the cache fits into its limit; the entry which
+// is being committed is kept, even if it's alone bigger than the limit
+// expects cache_mutex
+static void cache_evict(const char * keep)
+{
+	if (cache.total <= cache.limit) return;
+
+	qsort(cache.entries, cache.entries_count, sizeof(Cache_Entry), cache_compare_entries);
+
+	size_t kept = 0;
+	for (size_t i = 0; i < cache.entries_count; i++)
+	{
+		Cache_Entry * const entry = cache.entries + i;
+		bool deleted = false;
+
+		if (cache.total > cache.limit && !(keep && strcmp(entry->name, keep) == 0))
+		{
+			// files which are still open can't be deleted on some systems, they'll go next time
+			char * const filename = cache_path(entry->name);
+			deleted = remove(filename) == 0 || interface_filesystem_modification_time(filename) == 0;
+			FREE(filename);
+		}
+
+		if (deleted)
+		{
+			cache.total -= entry->size;
+			free(entry->name);
+		}
+		else
+		{
+			cache.entries[kept++] = *entry;
+		}
+	}
+
+	cache.entries_count = kept;
+}
+
+// forget the index
+// expects cache_mutex
+static void cache_clear()
+{
+	for (size_t i = 0; i < cache.entries_count; i++)
+	{
+		free(cache.entries[i].name);
+	}
+
+	free(cache.entries);
+	cache.entries = NULL;
+	cache.entries_count = cache.entries_allocated = 0;
+	cache.total = 0;
+
+	FREE(cache.directory);
+	cache.directory = NULL;
+	cache.created = false;
+}
+
+// index files found in cache directory, temporary files left by previous sessions are deleted
+// expects cache_mutex
+static void cache_scan_visitor(const char * name, unsigned long long size, time_t modification_time, void *)
+{
+	if (!cache_entry_name_valid(name)) return;
+
+	if (interface_filesystem_has_extension(name, CACHE_TEMPORARY_EXTENSION))
+	{
+		char * const filename = cache_path(name);
+		remove(filename);
+		FREE(filename);
+		return;
+	}
+
+	cache_index(name, size, modification_time);
+}
+
+// create the directory, if we haven't done so yet
+// expects cache_mutex
+static bool cache_create_directory()
+{
+	if (!cache.directory) return false;
+	if (!cache.created) cache.created = interface_filesystem_make_directory(cache.directory);
+	return cache.created;
+}
+
+// * public interface *
+
+// use cache belonging to the project saved under given filename
+void cache_open(const char * project_filename)
+{
+	pthread_mutex_lock(&cache_mutex);
+	cache_clear();
+
+	const char * const base = project_filename ? project_filename : "untitled";
+	cache.directory = ALLOC(char, strlen(base) + strlen(CACHE_EXTENSION) + 1);
+	strcpy(cache.directory, base);
+	strcat(cache.directory, CACHE_EXTENSION);
+
+	// existing cache is indexed and trimmed
+	if (interface_filesystem_list_directory(cache.directory, cache_scan_visitor, NULL))
+	{
+		cache.created = true;
+		cache_evict(NULL);
+	}
+
+	pthread_mutex_unlock(&cache_mutex);
+}
+
+// change size limit of the cache
+void cache_set_limit(const unsigned long long limit)
+{
+	pthread_mutex_lock(&cache_mutex);
+	cache.limit = limit;
+	cache_evict(NULL);
+	pthread_mutex_unlock(&cache_mutex);
+}
+
+// read the entry into memory
+bool cache_get(const Cache_Key & key, const char * extension, void ** data, size_t * size)
+{
+	*data = NULL;
+	*size = 0;
+
+	pthread_mutex_lock(&cache_mutex);
+	if (!cache.created)
+	{
+		pthread_mutex_unlock(&cache_mutex);
+		return false;
+	}
+
+	char * const name = cache_entry_name(key, extension);
+	char * const filename = cache_path(name);
+	pthread_mutex_unlock(&cache_mutex);
+
+	// read the file
+	bool ok = false;
+	FILE * const f = fopen(filename, "rb");
+	if (f)
+	{
+		const unsigned long long length = interface_filesystem_file_size(filename);
+		if (length < SIZE_MAX)
+		{
+			*data = ALLOC(char, (size_t)length + 1);
+			ok = *data && fread(*data, 1, (size_t)length, f) == length;
+			*size = (size_t)length;
+		}
+		fclose(f);
+	}
+
+	if (ok)
+	{
+		pthread_mutex_lock(&cache_mutex);
+		cache_touch(name, filename);
+		pthread_mutex_unlock(&cache_mutex);
+	}
+	else
+	{
+		FREE(*data);
+		*data = NULL;
+		*size = 0;
+	}
+
+	FREE(filename);
+	FREE(name);
+	return ok;
+}
+
+// store the entry
+bool cache_put(const Cache_Key & key, const char * extension, const void * data, const size_t size)
+{
+	pthread_mutex_lock(&cache_mutex);
+	if (!cache_create_directory())
+	{
+		pthread_mutex_unlock(&cache_mutex);
+		return false;
+	}
+
+	char * const name = cache_entry_name(key, extension);
+	char * const filename = cache_path(name);
+
+	// every writer has its own temporary file
+	char * const temporary = ALLOC(char, strlen(filename) + 16 + strlen(CACHE_TEMPORARY_EXTENSION));
+	sprintf(temporary, "%s.%u%s", filename, cache.temporary_id++, CACHE_TEMPORARY_EXTENSION);
+	pthread_mutex_unlock(&cache_mutex);
+
+	// write it and move it in place
+	bool ok = false;
+	FILE * const f = fopen(temporary, "wb");
+	if (f)
+	{
+		ok = fwrite(data, 1, size, f) == size;
+		ok = fclose(f) == 0 && ok;
+	}
+
+	if (ok)
+	{
+		remove(filename);
+		ok = rename(temporary, filename) == 0;
+	}
+
+	if (ok)
+	{
+		cache_commit(filename);
+	}
+	else
+	{
+		remove(temporary);
+	}
+
+	FREE(temporary);
+	FREE(filename);
+	FREE(name);
+	return ok;
+}
+
+// filename of the entry
+char * cache_filename(const Cache_Key & key, const char * extension)
+{
+	pthread_mutex_lock(&cache_mutex);
+	char * filename = NULL;
+	if (cache_create_directory())
+	{
+		char * const name = cache_entry_name(key, extension);
+		filename = cache_path(name);
+		FREE(name);
+	}
+	pthread_mutex_unlock(&cache_mutex);
+
+	return filename;
+}
+
+// mark the entry used, returns false if it doesn't exist
+bool cache_lookup(const char * filename)
+{
+	if (interface_filesystem_modification_time(filename) == 0) return false;
+
+	pthread_mutex_lock(&cache_mutex);
+	const char * const name = cache_entry_name_of(filename);
+	if (name) cache_touch(name, filename);
+	pthread_mutex_unlock(&cache_mutex);
+
+	return true;
+}
+
+// announce new entry
+void cache_commit(const char * filename)
+{
+	const unsigned long long size = interface_filesystem_file_size(filename);
+
+	pthread_mutex_lock(&cache_mutex);
+	const char * const name = cache_entry_name_of(filename);
+	if (name)
+	{
+		cache_index(name, size, time(NULL));
+		cache_evict(name);
+	}
+	pthread_mutex_unlock(&cache_mutex);
+}
+
+// filename of a named file in the cache directory
+char * cache_named_filename(const char * name)
+{
+	pthread_mutex_lock(&cache_mutex);
+	char * const filename = cache_create_directory() ? cache_path(name) : strdup(name);
+	pthread_mutex_unlock(&cache_mutex);
+
+	return filename;
+}
+
+// forget the index
+void cache_release()
+{
+	pthread_mutex_lock(&cache_mutex);
+	cache_clear();
+
+	for (size_t i = 0; i < cache.files_count; i++)
+	{
+		free(cache.files[i].filename);
+	}
+
+	free(cache.files);
+	cache.files = NULL;
+	cache.files_count = cache.files_allocated = 0;
+	pthread_mutex_unlock(&cache_mutex);
+}
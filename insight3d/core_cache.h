@@ -0,0 +1,70 @@
+#ifndef __CORE_CACHE
+#define __CORE_CACHE
+
+#include "core_debug.h"
+#include "interface_filesystem.h"
+#include "portability.h"
+#include <pthread.h>
+#include <time.h>
+
+// cache of expensive intermediate results (image features, tiled images, ...) kept in a directory
+// next to the project (or in untitled.cache in the current directory if the project hasn't been
+// saved yet); entries are named by a hash of everything they were computed from - contents of the
+// input files, parameters and version of the format - so an entry is never stale, it just stops
+// being found; entries are written atomically and the least recently used ones are deleted
+// whenever the cache grows over its limit; other files in the directory (named files, e.g.
+// debugging dumps) are never deleted
+// note all functions are thread-safe
+
+// extension of the cache directory and its default size limit
+const char * const CACHE_EXTENSION = ".cache";
+const unsigned long long CACHE_DEFAULT_LIMIT = 4ULL << 30;
+
+// hash of the inputs of an entry
+struct Cache_Key
+{
+	unsigned long long hash[2];
+};
+
+// start new key for entries of given kind (the version should be bumped whenever the format
+// or the way the entries are computed changes)
+void cache_key_init(Cache_Key & key, const char * kind, const int version);
+
+// add input to the key
+void cache_key_add(Cache_Key & key, const void * data, const size_t size);
+void cache_key_add_int(Cache_Key & key, const long long value);
+void cache_key_add_double(Cache_Key & key, const double value);
+void cache_key_add_string(Cache_Key & key, const char * s);
+
+// add contents of the file to the key, returns false if it can't be read; hashes of files are
+// remembered (by name, size and modification time), so every file is read only once
+bool cache_key_add_file(Cache_Key & key, const char * filename);
+
+// use cache belonging to the project saved under given filename (NULL if it doesn't have any);
+// the directory is created when the first entry is written
+void cache_open(const char * project_filename);
+
+// change size limit of the cache (in bytes)
+void cache_set_limit(const unsigned long long limit);
+
+// read the entry into memory allocated by ALLOC, returns false if it isn't cached
+bool cache_get(const Cache_Key & key, const char * extension, void ** data, size_t * size);
+
+// store the entry, returns false if it couldn't be written
+bool cache_put(const Cache_Key & key, const char * extension, const void * data, const size_t size);
+
+// filename of the entry for producers and consumers which access files themselves (has to be
+// freed; NULL if the cache directory can't be created); the entry should be written into a
+// temporary file and renamed, then announced using cache_commit; cache_lookup marks the entry
+// used and returns false if it doesn't exist
+char * cache_filename(const Cache_Key & key, const char * extension);
+bool cache_lookup(const char * filename);
+void cache_commit(const char * filename);
+
+// filename of a named file in the cache directory (falls back to current directory, has to be freed)
+char * cache_named_filename(const char * name);
+
+// forget the index (the directory stays)
+void cache_release();
+
+#endif
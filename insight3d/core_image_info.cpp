@@ -0,0 +1,258 @@
+#include "core_image_info.h"
+
+// EXIF tags we're interested in
+static const unsigned int IMAGE_INFO_EXIF_IFD = 0x8769;
+static const unsigned int IMAGE_INFO_EXIF_FOCAL_LENGTH = 0x920a;
+static const unsigned int IMAGE_INFO_EXIF_FOCAL_LENGTH_35MM = 0xa405;
+static const unsigned int IMAGE_INFO_EXIF_PIXEL_X_DIMENSION = 0xa002;
+static const unsigned int IMAGE_INFO_EXIF_FOCAL_PLANE_X_RESOLUTION = 0xa20e;
+static const unsigned int IMAGE_INFO_EXIF_FOCAL_PLANE_RESOLUTION_UNIT = 0xa210;
+
+// TIFF structure inside EXIF segment
+struct Image_Info_Exif
+{
+	const unsigned char * data;
+	size_t size;
+	bool little_endian;
+};
+
+static unsigned int image_info_big_endian_16(const unsigned char * p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+static unsigned int image_info_big_endian_32(const unsigned char * p)
+{
+	return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | p[3];
+}
+
+static unsigned int image_info_exif_16(const Image_Info_Exif & exif, const size_t offset)
+{
+	const unsigned char * const p = exif.data + offset;
+	return exif.little_endian ? p[0] | (p[1] << 8) : image_info_big_endian_16(p);
+}
+
+static unsigned int image_info_exif_32(const Image_Info_Exif & exif, const size_t offset)
+{
+	const unsigned char * const p = exif.data + offset;
+	return exif.little_endian ? p[0] | (p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24) : image_info_big_endian_32(p);
+}
+
+// numeric value of IFD entry (short, long or rational), returns false for other types
+static bool image_info_exif_number(const Image_Info_Exif & exif, const size_t entry, double & value)
+{
+	const unsigned int type = image_info_exif_16(exif, entry + 2);
+	switch (type)
+	{
+		case 3: // short
+			value = image_info_exif_16(exif, entry + 8);
+			return true;
+
+		case 4: // long
+			value = image_info_exif_32(exif, entry + 8);
+			return true;
+
+		case 5: // rational
+		case 10: // signed rational
+		{
+			const size_t offset = image_info_exif_32(exif, entry + 8);
+			if (offset > exif.size || exif.size - offset < 8) return false;
+			const unsigned int numerator = image_info_exif_32(exif, offset), denominator = image_info_exif_32(exif, offset + 4);
+			if (denominator == 0) return false;
+			value = type == 5 ? (double)numerator / denominator : (double)(int)numerator / (int)denominator;
+			return true;
+		}
+
+		default:
+			return false;
+	}
+}
+
+// go through IFD at given offset, collecting the values we know
+static void image_info_exif_ifd(const Image_Info_Exif & exif, const size_t offset, Image_Info & info, double & pixel_x_dimension, double & x_resolution, double & resolution_unit, const bool follow)
+{
+	if (offset > exif.size || exif.size - offset < 2) return;
+	const size_t count = image_info_exif_16(exif, offset);
+	if ((exif.size - offset - 2) / 12 < count) return;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const size_t entry = offset + 2 + 12 * i;
+		const unsigned int tag = image_info_exif_16(exif, entry);
+		double value;
+
+		if (tag == IMAGE_INFO_EXIF_IFD && follow)
+		{
+			image_info_exif_ifd(exif, image_info_exif_32(exif, entry + 8), info, pixel_x_dimension, x_resolution, resolution_unit, false);
+		}
+		else if (!image_info_exif_number(exif, entry, value) || value <= 0)
+		{
+			continue;
+		}
+		else if (tag == IMAGE_INFO_EXIF_FOCAL_LENGTH) info.focal_length = value;
+		else if (tag == IMAGE_INFO_EXIF_FOCAL_LENGTH_35MM) info.focal_length_35mm = value;
+		else if (tag == IMAGE_INFO_EXIF_PIXEL_X_DIMENSION) pixel_x_dimension = value;
+		else if (tag == IMAGE_INFO_EXIF_FOCAL_PLANE_X_RESOLUTION) x_resolution = value;
+		else if (tag == IMAGE_INFO_EXIF_FOCAL_PLANE_RESOLUTION_UNIT) resolution_unit = value;
+	}
+}
+
+// parse EXIF segment (without the "Exif\0\0" header)
+static void image_info_exif(const unsigned char * data, const size_t size, Image_Info & info)
+{
+	if (size < 8) return;
+
+	Image_Info_Exif exif;
+	exif.data = data;
+	exif.size = size;
+	if (memcmp(data, "II*\0", 4) == 0) exif.little_endian = true;
+	else if (memcmp(data, "MM\0*", 4) == 0) exif.little_endian = false;
+	else return;
+
+	double pixel_x_dimension = 0, x_resolution = 0, resolution_unit = 2;
+	image_info_exif_ifd(exif, image_info_exif_32(exif, 4), info, pixel_x_dimension, x_resolution, resolution_unit, true);
+
+	// sensor width from focal plane resolution (pixels per unit)
+	double unit = 0;
+	switch ((int)resolution_unit)
+	{
+		case 2: unit = 25.4; break; // inch
+		case 3: unit = 10; break;   // cm
+		case 4: unit = 1; break;    // mm
+		case 5: unit = 0.001; break; // um
+	}
+
+	if (pixel_x_dimension == 0) pixel_x_dimension = info.width;
+	if (x_resolution > 0 && unit > 0 && pixel_x_dimension > 0)
+	{
+		info.sensor_width = pixel_x_dimension / x_resolution * unit;
+	}
+}
+
+// walk JPEG segments until the frame header
+static bool image_info_jpeg(FILE * const file, Image_Info & info)
+{
+	unsigned char * exif = NULL;
+	size_t exif_size = 0;
+	bool found = false;
+
+	while (!found)
+	{
+		// marker (possibly preceded by fill bytes)
+		int c = fgetc(file);
+		if (c != 0xff) break;
+		while ((c = fgetc(file)) == 0xff);
+		if (c == EOF || c == 0xd9 || c == 0xda) break; // end of image or start of scan before any frame header
+		if (c == 0x01 || (c >= 0xd0 && c <= 0xd7)) continue; // markers without length
+
+		unsigned char header[2];
+		if (fread(header, 1, 2, file) != 2) break;
+		const size_t length = image_info_big_endian_16(header);
+		if (length < 2) break;
+
+		// start of frame (all of them except huffman tables, arithmetic coding conditioning and jpg extensions)
+		if (c >= 0xc0 && c <= 0xcf && c != 0xc4 && c != 0xc8 && c != 0xcc)
+		{
+			unsigned char frame[5];
+			if (length < 7 || fread(frame, 1, 5, file) != 5) break;
+			info.height = image_info_big_endian_16(frame + 1);
+			info.width = image_info_big_endian_16(frame + 3);
+			found = info.width > 0 && info.height > 0;
+			break;
+		}
+
+		// application segment with EXIF (the first one wins)
+		if (c == 0xe1 && !exif && length - 2 >= 6)
+		{
+			unsigned char * const segment = ALLOC(unsigned char, length - 2);
+			if (!segment || fread(segment, 1, length - 2, file) != length - 2)
+			{
+				FREE(segment);
+				break;
+			}
+
+			if (memcmp(segment, "Exif\0\0", 6) == 0)
+			{
+				exif = segment;
+				exif_size = length - 2;
+			}
+			else
+			{
+				FREE(segment);
+			}
+			continue;
+		}
+
+		if (fseek(file, (long)length - 2, SEEK_CUR) != 0) break;
+	}
+
+	// EXIF is read after frame header, since the sensor width may need the image width
+	if (found && exif) image_info_exif(exif + 6, exif_size - 6, info);
+	FREE(exif);
+	return found;
+}
+
+// image header of PNG
+static bool image_info_png(FILE * const file, Image_Info & info)
+{
+	unsigned char header[16];
+	if (fread(header, 1, 16, file) != 16 || memcmp(header + 4, "IHDR", 4) != 0) return false;
+	const unsigned int width = image_info_big_endian_32(header + 8), height = image_info_big_endian_32(header + 12);
+	if (width == 0 || height == 0 || width > 0x7fffffff || height > 0x7fffffff) return false;
+	info.width = (int)width;
+	info.height = (int)height;
+	return true;
+}
+
+// read information about image from its header
+bool image_info_probe(const char * filename, Image_Info & info)
+{
+	memset(&info, 0, sizeof(info));
+
+	FILE * const file = fopen(filename, "rb");
+	if (!file) return false;
+
+	unsigned char signature[8];
+	bool ok = false;
+	if (fread(signature, 1, 2, file) == 2 && signature[0] == 0xff && signature[1] == 0xd8)
+	{
+		ok = image_info_jpeg(file, info);
+	}
+	else if (fread(signature + 2, 1, 6, file) == 6 && memcmp(signature, "\x89PNG\r\n\x1a\n", 8) == 0)
+	{
+		ok = image_info_png(file, info);
+	}
+
+	fclose(file);
+	if (!ok) memset(&info, 0, sizeof(info));
+	return ok;
+}
+
+// focal length in pixels and film back in mm (if the sensor size is known)
+bool image_info_focal_length(const Image_Info & info, double & f, double & film_back)
+{
+	f = film_back = 0;
+	if (info.width <= 0 || info.height <= 0) return false;
+	const double diagonal = sqrt((double)info.width * info.width + (double)info.height * info.height);
+
+	// width of the sensor, either stored directly or deduced from the crop factor
+	if (info.sensor_width > 0)
+	{
+		film_back = info.sensor_width;
+	}
+	else if (info.focal_length > 0 && info.focal_length_35mm > 0)
+	{
+		film_back = IMAGE_INFO_35MM_DIAGONAL * info.focal_length / info.focal_length_35mm * info.width / diagonal;
+	}
+
+	if (info.focal_length > 0 && film_back > 0)
+	{
+		f = info.focal_length * info.width / film_back;
+	}
+	else if (info.focal_length_35mm > 0)
+	{
+		f = info.focal_length_35mm * diagonal / IMAGE_INFO_35MM_DIAGONAL;
+	}
+
+	return f > 0;
+}
@@ -0,0 +1,34 @@
+#ifndef __CORE_IMAGE_INFO
+#define __CORE_IMAGE_INFO
+
+#include "core_debug.h"
+#include "portability.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// reads the size of the image and what the camera stored about its optics (EXIF focal length
+// and focal plane resolution) from the header of JPEG and PNG files, without decoding any
+// pixels; other formats aren't recognized and have to be loaded to learn their size
+
+// diagonal of 35 mm film (which 35 mm equivalent focal lengths refer to)
+const double IMAGE_INFO_35MM_DIAGONAL = 43.266615305567875;
+
+struct Image_Info
+{
+	int width, height;         // size in pixels
+	double focal_length;       // focal length in mm (0 if unknown)
+	double focal_length_35mm;  // 35 mm equivalent focal length (0 if unknown)
+	double sensor_width;       // width of the sensor in mm, derived from focal plane resolution (0 if unknown)
+};
+
+// read information about image from its header, returns false if the format isn't recognized
+// or the header is damaged
+// note safe to call from any thread
+bool image_info_probe(const char * filename, Image_Info & info);
+
+// focal length in pixels and width of the sensor in mm (film back) for image of given size,
+// returns false if the camera didn't store enough to tell
+bool image_info_focal_length(const Image_Info & info, double & f, double & film_back);
+
+#endif
@@ -19,7 +19,6 @@ DYNAMIC_STRUCTURE(Image_Loader_Shots, Image_Loader_Shot);
 static const int IMAGE_LOADER_FULL_SIZE = 2048, IMAGE_LOADER_LOW_SIZE = 256;
 static unsigned int image_loader_cache_full_count;
 static unsigned int image_loader_cache_low_count;
-static const size_t IMAGE_LOADER_MAX_REQUESTS = 1000;
 
 // threading variables 
 static pthread_t image_loader_thread;
@@ -39,12 +38,710 @@ static Image_Loader_Shots image_loader_shots;
 static Image_Loader_Requests image_loader_requests; 
 
 // indices of free request slots
-static size_t image_loader_free_ids[IMAGE_LOADER_MAX_REQUESTS];
-static size_t image_loader_free_ids_counter;
+static size_t * image_loader_free_ids;
+static size_t image_loader_free_ids_counter, image_loader_free_ids_size;
+
+// priority queue (binary heap) of shots with pending requests, see image_loader_queue_before
+static size_t * image_loader_queue;
+static size_t image_loader_queue_count, image_loader_queue_size;
 
 // counter of unprocessed requests 
 static size_t image_loader_unprocessed_counter;
 
+// zeros used to clear textures of trimmed regions 
+static uchar * image_loader_zeros;
+static size_t image_loader_zeros_size;
+
+// textures are streamed to gpu through a ring of pixel buffers - loader thread copies 
+// pixels into mapped buffer and rendering thread then only unmaps it and starts 
+// the transfer, which runs asynchronously and doesn't stall the frame 
+enum Image_Loader_Stream_State { 
+	IMAGE_LOADER_STREAM_UNMAPPED, IMAGE_LOADER_STREAM_MAPPED, IMAGE_LOADER_STREAM_FILLING, IMAGE_LOADER_STREAM_FILLED 
+};
+
+struct Image_Loader_Stream_Slot
+{
+	GLuint buffer;
+	Image_Loader_Stream_State state;
+	uchar * pixels; // mapped memory of the buffer 
+
+	// where the pixels are copied from while filling (detached views of region requests are owned by the buffer)
+	IplImage * source;
+	bool source_owned;
+	int source_x, source_y;
+
+	// what are the pixels for (request_time is 0 for shot's own textures)
+	size_t shot_id, request_id, request_time;
+	Image_Loader_Quality quality;
+	int width, height; 
+
+	// texture layout of region requests
+	int texture_width, texture_height, offset_x, offset_y;
+	bool trimmed;
+};
+
+static const int IMAGE_LOADER_STREAM_SLOTS = 3;
+static const size_t IMAGE_LOADER_STREAM_SLOT_SIZE = 3 * IMAGE_LOADER_FULL_SIZE * IMAGE_LOADER_FULL_SIZE;
+static Image_Loader_Stream_Slot image_loader_stream_slots[IMAGE_LOADER_STREAM_SLOTS];
+static bool image_loader_stream_initialized; // pixel buffers were set up in current opengl context
+static bool image_loader_streaming;          // pixel buffers are supported and used
+static bool image_loader_stream_wanted;      // rendering thread waits for something to be staged
+static bool image_loader_stream_copying;     // loader thread is filling buffers without holding the lock
+
+// some suggested shots might not be loaded yet 
+static bool image_loader_prefetch_pending;
+
+// large images are loaded from (and converted into) tiled stores 
+static bool image_loader_tiled;
+
+// textures of tiles from tiled stores, recycled in lru fashion (used only by rendering thread)
+struct Image_Loader_Tile_Texture
+{
+	bool set; 
+	size_t shot_id; 
+	int level, x, y; 
+	GLuint texture;
+	size_t used; // frame in which the tile was used the last time 
+};
+
+static const int IMAGE_LOADER_TILE_TEXTURES = 384, IMAGE_LOADER_TILE_UPLOADS = 8;
+static Image_Loader_Tile_Texture image_loader_tile_textures[IMAGE_LOADER_TILE_TEXTURES];
+static size_t image_loader_tile_frame;
+static bool image_loader_tile_textures_discard; // shots were released, rendering thread should delete the textures 
+
+// check that the handle refers to living request (slots of cancelled requests are reused)
+// expects LOCK_RW(image_loader)
+static bool image_loader_valid_handle(const Image_Loader_Request_Handle handle)
+{
+	return IS_SET(image_loader_requests, handle.id) && image_loader_requests.data[handle.id].time == handle.time;
+}
+
+#define ASSERT_VALID_HANDLE(handle) ASSERT(image_loader_valid_handle(handle), "request handle is invalid or was already cancelled")
+
+// order of shots in the queue - shots with requests which have nothing to show yet go first, 
+// older requests before newer ones
+// expects LOCK_RW(image_loader)
+static bool image_loader_queue_before(const size_t a, const size_t b)
+{
+	const Image_Loader_Shot * const shot_a = image_loader_shots.data + a, * const shot_b = image_loader_shots.data + b;
+	const bool urgent_a = shot_a->pending_urgent > 0, urgent_b = shot_b->pending_urgent > 0;
+
+	if (urgent_a != urgent_b) return urgent_a;
+	return image_loader_requests.data[shot_a->pending_first].time < image_loader_requests.data[shot_b->pending_first].time;
+}
+
+// place shot at given position in the queue
+// expects LOCK_RW(image_loader)
+static void image_loader_queue_place(const size_t position, const size_t shot_id)
+{
+	image_loader_queue[position] = shot_id;
+	image_loader_shots.data[shot_id].queue_position = position + 1;
+}
+
+// move shot towards the top of the queue 
+// expects LOCK_RW(image_loader)
+static void image_loader_queue_sift_up(size_t position)
+{
+	const size_t shot_id = image_loader_queue[position];
+
+	while (position > 0 && image_loader_queue_before(shot_id, image_loader_queue[(position - 1) / 2]))
+	{
+		image_loader_queue_place(position, image_loader_queue[(position - 1) / 2]);
+		position = (position - 1) / 2;
+	}
+
+	image_loader_queue_place(position, shot_id);
+}
+
+// move shot towards the bottom of the queue 
+// expects LOCK_RW(image_loader)
+static void image_loader_queue_sift_down(size_t position)
+{
+	const size_t shot_id = image_loader_queue[position];
+
+	while (2 * position + 1 < image_loader_queue_count) 
+	{
+		size_t child = 2 * position + 1; 
+		if (child + 1 < image_loader_queue_count && image_loader_queue_before(image_loader_queue[child + 1], image_loader_queue[child])) child++;
+		if (!image_loader_queue_before(image_loader_queue[child], shot_id)) break;
+
+		image_loader_queue_place(position, image_loader_queue[child]);
+		position = child;
+	}
+
+	image_loader_queue_place(position, shot_id);
+}
+
+// insert, remove or reorder shot in the queue after it's pending requests changed 
+// expects LOCK_RW(image_loader)
+static void image_loader_queue_update(const size_t shot_id)
+{
+	Image_Loader_Shot * const shot = image_loader_shots.data + shot_id;
+
+	if (shot->pending_count > 0 && shot->queue_position == 0)
+	{
+		// insert 
+		if (image_loader_queue_count == image_loader_queue_size) 
+		{
+			image_loader_queue_size = image_loader_queue_size ? 2 * image_loader_queue_size : 64;
+			image_loader_queue = (size_t *)realloc(image_loader_queue, image_loader_queue_size * sizeof(size_t));
+		}
+
+		image_loader_queue_place(image_loader_queue_count++, shot_id);
+		image_loader_queue_sift_up(image_loader_queue_count - 1);
+	}
+	else if (shot->pending_count == 0 && shot->queue_position > 0)
+	{
+		// remove, the last shot takes it's place 
+		const size_t position = shot->queue_position - 1;
+		shot->queue_position = 0;
+
+		if (position < --image_loader_queue_count) 
+		{
+			const size_t moved = image_loader_queue[image_loader_queue_count];
+			image_loader_queue_place(position, moved);
+			image_loader_queue_sift_up(position);
+			image_loader_queue_sift_down(image_loader_shots.data[moved].queue_position - 1);
+		}
+	}
+	else if (shot->queue_position > 0)
+	{
+		// key changed 
+		image_loader_queue_sift_up(shot->queue_position - 1);
+		image_loader_queue_sift_down(shot->queue_position - 1);
+	}
+}
+
+// keep request in it's shot's list of pending requests as long as it's not done 
+// and update the queue accordingly; has to be called whenever request's done flag 
+// or current quality changes
+// expects LOCK_RW(image_loader)
+static void image_loader_schedule_request(const size_t request_id, const bool cancelled = false)
+{
+	Image_Loader_Request * const request = image_loader_requests.data + request_id;
+	Image_Loader_Shot * const shot = image_loader_shots.data + request->shot_id;
+	const bool pending = !cancelled && !request->done;
+	const bool urgent = pending && request->current_quality == IMAGE_LOADER_NOT_LOADED;
+
+	if (pending && !request->pending) 
+	{
+		// append to the end of the list (requests are ordered by age)
+		request->pending_next = SIZE_MAX;
+		request->pending_prev = shot->pending_count > 0 ? shot->pending_last : SIZE_MAX;
+		if (shot->pending_count > 0) 
+		{
+			image_loader_requests.data[shot->pending_last].pending_next = request_id;
+		}
+		else 
+		{
+			shot->pending_first = request_id;
+		}
+		shot->pending_last = request_id;
+		shot->pending_count++;
+	}
+	else if (!pending && request->pending) 
+	{
+		// unlink 
+		if (request->pending_prev != SIZE_MAX) image_loader_requests.data[request->pending_prev].pending_next = request->pending_next;
+		else shot->pending_first = request->pending_next;
+		if (request->pending_next != SIZE_MAX) image_loader_requests.data[request->pending_next].pending_prev = request->pending_prev;
+		else shot->pending_last = request->pending_prev;
+		shot->pending_count--;
+	}
+	request->pending = pending;
+
+	if (urgent != request->urgent) 
+	{
+		shot->pending_urgent += urgent ? 1 : -1;
+		request->urgent = urgent;
+	}
+
+	image_loader_queue_update(request->shot_id);
+}
+
+// release request's reference to low or full version of shot's image 
+// expects LOCK_RW(image_loader)
+static void image_loader_release_reference(Image_Loader_Request * const request, Image_Loader_Shot * const shot, const Image_Loader_Quality quality)
+{
+	if (quality == IMAGE_LOADER_LOW_RESOLUTION && request->low_reference)
+	{
+		ASSERT(shot->low_counter > 0, "number of requests for low version is zero although one of them is releasing it");
+		shot->low_counter--;
+		request->low_reference = false;
+	}
+	else if (quality == IMAGE_LOADER_FULL_RESOLUTION && request->full_reference)
+	{
+		ASSERT(shot->full_counter > 0, "number of requests for full version is zero although one of them is releasing it");
+		shot->full_counter--;
+		request->full_reference = false;
+	}
+}
+
+// stop viewing shot's image (the view was either uploaded or replaced by a better one)
+// expects LOCK_RW(image_loader), obtains LOCK_RW(opencv)
+static void image_loader_release_view(Image_Loader_Request * const request, Image_Loader_Shot * const shot)
+{
+	if (!request->image) return;
+
+	if (request->image_owned) 
+	{
+		ATOMIC_RW(opencv, cvReleaseImage(&request->image); );
+	}
+	else if (request->current_quality == IMAGE_LOADER_FULL_RESOLUTION)
+	{
+		ASSERT(shot->full_view_counter > 0, "releasing view of full version which isn't counted");
+		shot->full_view_counter--;
+	}
+	else
+	{
+		ASSERT(shot->low_view_counter > 0, "releasing view of low version which isn't counted");
+		shot->low_view_counter--;
+	}
+
+	request->image = NULL;
+	request->image_owned = false;
+}
+
+// copy viewed pixels out of shot's image, so that the image can be released from memory 
+// before the render thread gets to upload the view 
+// expects LOCK_RW(image_loader), obtains LOCK_RW(opencv)
+static void image_loader_detach_view(Image_Loader_Request * const request, Image_Loader_Shot * const shot)
+{
+	ASSERT(request->image && !request->image_owned, "detaching view which isn't viewing shot's image");
+	const IplImage * const img = request->image;
+
+	IplImage * detached = NULL;
+	if (request->view_width > 0 && request->view_height > 0)
+	{
+		ATOMIC_RW(opencv, detached = cvCreateImage(cvSize(request->view_width, request->view_height), img->depth, img->nChannels); );
+
+		for (int y = 0; y < request->view_height; y++)
+		{
+			memcpy(
+				detached->imageData + detached->widthStep * y, 
+				img->imageData + img->widthStep * (request->view_y + y) + request->view_x * img->nChannels, 
+				request->view_width * img->nChannels
+			);
+		}
+	}
+
+	const Image_Loader_Quality quality = request->current_quality;
+	image_loader_release_view(request, shot);
+	image_loader_release_reference(request, shot, quality);
+
+	request->image = detached;
+	request->image_owned = detached != NULL;
+	request->view_x = 0;
+	request->view_y = 0;
+}
+
+// detach all views of shot's low or full image 
+// expects LOCK_RW(image_loader), obtains LOCK_RW(opencv)
+static void image_loader_detach_views(const size_t shot_id, const Image_Loader_Quality quality)
+{
+	Image_Loader_Shot * const shot = image_loader_shots.data + shot_id;
+
+	for ALL(image_loader_requests, i) 
+	{
+		Image_Loader_Request * const request = image_loader_requests.data + i;
+
+		if (
+			request->shot_id == shot_id && request->content != IMAGE_LOADER_ALL && 
+			request->image && !request->image_owned && request->current_quality == quality
+		)
+		{
+			image_loader_detach_view(request, shot);
+		}
+	}
+}
+
+// region request has lost it's texture and there are no pixels to upload it again, 
+// put it back into the queue 
+// expects LOCK_RW(image_loader)
+static void image_loader_reset_region_request(Image_Loader_Request * const request, Image_Loader_Shot * const shot)
+{
+	if (request->done) 
+	{
+		request->done = false;
+		image_loader_unprocessed_counter++;
+	}
+
+	if (request->quality != IMAGE_LOADER_FULL_RESOLUTION)
+	{
+		if (request->current_quality >= IMAGE_LOADER_LOW_RESOLUTION) shot->low_unprocessed_counter++;
+		if (!request->low_reference) 
+		{
+			shot->low_counter++;
+			request->low_reference = true;
+		}
+	}
+
+	if (request->quality != IMAGE_LOADER_LOW_RESOLUTION)
+	{
+		if (request->current_quality >= IMAGE_LOADER_FULL_RESOLUTION) shot->full_unprocessed_counter++;
+		if (!request->full_reference) 
+		{
+			shot->full_counter++;
+			request->full_reference = true;
+		}
+	}
+
+	request->current_quality = IMAGE_LOADER_NOT_LOADED;
+	request->gl_texture_quality = IMAGE_LOADER_NOT_LOADED;
+	image_loader_schedule_request(request - image_loader_requests.data);
+}
+
+// copy rectangle of image into pixel buffer (rows are packed tightly)
+static void image_loader_stream_copy(uchar * const pixels, const IplImage * const image, const int x, const int y, const int width, const int height)
+{
+	const int row = 3 * width;
+	for (int i = 0; i < height; i++)
+	{
+		memcpy(pixels + i * row, image->imageData + (y + i) * image->widthStep + 3 * x, row);
+	}
+}
+
+// find pixel buffer ready to be filled 
+// expects LOCK_RW(image_loader)
+static Image_Loader_Stream_Slot * image_loader_stream_free_slot()
+{
+	for (int i = 0; i < IMAGE_LOADER_STREAM_SLOTS; i++) 
+	{
+		if (image_loader_stream_slots[i].state == IMAGE_LOADER_STREAM_MAPPED) return image_loader_stream_slots + i;
+	}
+
+	return NULL;
+}
+
+// claim pixel buffer for shot's image 
+// expects LOCK_RW(image_loader)
+static void image_loader_stream_stage_shot(Image_Loader_Stream_Slot * const slot, const size_t shot_id, IplImage * const image, const Image_Loader_Quality quality)
+{
+	slot->source = image;
+	slot->source_owned = false;
+	slot->source_x = 0;
+	slot->source_y = 0;
+	slot->shot_id = shot_id; 
+	slot->request_id = SIZE_MAX; 
+	slot->request_time = 0;
+	slot->quality = quality; 
+	slot->width = image->width; 
+	slot->height = image->height; 
+	slot->state = IMAGE_LOADER_STREAM_FILLING;
+}
+
+// claim pixel buffer for viewed rectangle of region request 
+// expects LOCK_RW(image_loader)
+static void image_loader_stream_stage_request(Image_Loader_Stream_Slot * const slot, const size_t request_id)
+{
+	Image_Loader_Request * const request = image_loader_requests.data + request_id;
+	ASSERT_IS_SET(image_loader_shots, request->shot_id);
+	Image_Loader_Shot * const shot = image_loader_shots.data + request->shot_id;
+
+	slot->source = request->image;
+	slot->source_owned = request->image_owned;
+	slot->source_x = request->view_x;
+	slot->source_y = request->view_y;
+	slot->shot_id = request->shot_id;
+	slot->request_id = request_id;
+	slot->request_time = request->time;
+	slot->quality = request->current_quality;
+	slot->width = request->view_width;
+	slot->height = request->view_height;
+	slot->texture_width = request->gl_texture_width;
+	slot->texture_height = request->gl_texture_height;
+	slot->offset_x = request->view_offset_x;
+	slot->offset_y = request->view_offset_y;
+	slot->trimmed = request->view_trimmed;
+	slot->state = IMAGE_LOADER_STREAM_FILLING;
+
+	// the request doesn't need its pixels anymore (detached view is handed over to the buffer, 
+	// shot's image stays in memory until the buffer is filled, see image_loader_stream_fill)
+	request->stream_wanted = false;
+	request->staged = true;
+	if (request->image_owned) 
+	{
+		request->image = NULL;
+		request->image_owned = false;
+	}
+	else
+	{
+		image_loader_release_view(request, shot);
+	}
+	image_loader_release_reference(request, shot, request->current_quality);
+}
+
+// claim mapped pixel buffers for images the rendering thread is waiting for 
+// expects LOCK_RW(image_loader)
+static void image_loader_stream_stage()
+{
+	Image_Loader_Stream_Slot * slot;
+	if (!(slot = image_loader_stream_free_slot())) return;
+
+	for ALL(image_loader_shots, i) 
+	{
+		Image_Loader_Shot * const shot = image_loader_shots.data + i;
+
+		if (shot->full_stream_wanted && shot->full && !shot->full_staged) 
+		{
+			image_loader_stream_stage_shot(slot, i, shot->full, IMAGE_LOADER_FULL_RESOLUTION);
+			shot->full_stream_wanted = false;
+			shot->full_staged = true;
+			if (!(slot = image_loader_stream_free_slot())) return;
+		}
+
+		if (shot->low_stream_wanted && shot->low && !shot->low_staged) 
+		{
+			image_loader_stream_stage_shot(slot, i, shot->low, IMAGE_LOADER_LOW_RESOLUTION);
+			shot->low_stream_wanted = false;
+			shot->low_staged = true;
+			if (!(slot = image_loader_stream_free_slot())) return;
+		}
+	}
+
+	for ALL(image_loader_requests, i) 
+	{
+		Image_Loader_Request * const request = image_loader_requests.data + i;
+
+		if (request->stream_wanted && !request->staged && request->image && request->view_width > 0 && request->view_height > 0)
+		{
+			image_loader_stream_stage_request(slot, i);
+			if (!(slot = image_loader_stream_free_slot())) return;
+		}
+	}
+
+	// everything we've been asked for is staged 
+	image_loader_stream_wanted = false;
+}
+
+// copy images the rendering thread is waiting for into mapped pixel buffers; buffers are 
+// claimed under the lock, but the pixels (up to 12 MB per buffer) are copied without it, 
+// so that the rendering thread doesn't wait for us 
+// note sources stay in memory meanwhile - shots' images are released only by the loader thread 
+// (and by image_loader_cancel_all_requests, which waits for the copying to finish)
+// expects LOCK_RW(image_loader) (locked just once, it's unlocked while copying)
+static void image_loader_stream_fill()
+{
+	if (!image_loader_streaming || !image_loader_stream_wanted) return;
+	image_loader_stream_stage();
+
+	bool filling = false;
+	for (int i = 0; i < IMAGE_LOADER_STREAM_SLOTS; i++) 
+	{
+		filling = filling || image_loader_stream_slots[i].state == IMAGE_LOADER_STREAM_FILLING;
+	}
+	if (!filling) return;
+
+	// buffers stay mapped until they're filled (rendering thread skips them and 
+	// image_loader_flush_texture_ids waits as well)
+	image_loader_stream_copying = true;
+	UNLOCK_RW(image_loader)
+	{
+		for (int i = 0; i < IMAGE_LOADER_STREAM_SLOTS; i++) 
+		{
+			Image_Loader_Stream_Slot * const slot = image_loader_stream_slots + i;
+			if (slot->state != IMAGE_LOADER_STREAM_FILLING) continue;
+			image_loader_stream_copy(slot->pixels, slot->source, slot->source_x, slot->source_y, slot->width, slot->height);
+		}
+	}
+	LOCK_RW(image_loader);
+	image_loader_stream_copying = false;
+
+	for (int i = 0; i < IMAGE_LOADER_STREAM_SLOTS; i++) 
+	{
+		Image_Loader_Stream_Slot * const slot = image_loader_stream_slots + i;
+		if (slot->state != IMAGE_LOADER_STREAM_FILLING) continue;
+
+		if (slot->source_owned) 
+		{
+			ATOMIC_RW(opencv, cvReleaseImage(&slot->source); );
+		}
+		slot->source = NULL;
+		slot->source_owned = false;
+		slot->state = IMAGE_LOADER_STREAM_FILLED;
+	}
+}
+
+// wait until the loader thread fills claimed pixel buffers 
+// expects LOCK_RW(image_loader) (locked just once, it's unlocked while waiting)
+static void image_loader_stream_wait()
+{
+	while (image_loader_stream_copying) 
+	{
+		UNLOCK_RW(image_loader)
+		{
+			SDL_Delay(1);
+		}
+		LOCK_RW(image_loader);
+	}
+}
+
+// region request's texture can take new pixels without reallocating if it has the right size 
+// (trimmed regions also need the same layout, otherwise the border around the image would 
+// keep pixels of the previous version)
+// expects LOCK_RW(image_loader)
+static bool image_loader_region_texture_reusable(
+	const Image_Loader_Request * const request, const int texture_width, const int texture_height, 
+	const bool trimmed, const Image_Loader_Quality quality
+)
+{
+	return 
+		request->gl_texture_id && 
+		request->gl_texture_storage_width == texture_width && request->gl_texture_storage_height == texture_height &&
+		(!trimmed || request->gl_texture_quality == quality)
+	;
+}
+
+// create texture from pixels in currently bound pixel buffer 
+// expects LOCK_RW(image_loader), LOCK_RW(opengl)
+static void image_loader_stream_complete(Image_Loader_Stream_Slot * const slot, const bool valid)
+{
+	if (slot->request_time == 0) 
+	{
+		// * shot's own texture *
+
+		if (!IS_SET(image_loader_shots, slot->shot_id)) return;
+		Image_Loader_Shot * const shot = image_loader_shots.data + slot->shot_id;
+		const bool full = slot->quality == IMAGE_LOADER_FULL_RESOLUTION;
+		bool * const staged = full ? &shot->full_staged : &shot->low_staged;
+		GLuint * const texture = full ? &shot->full_texture : &shot->low_texture;
+		const int counter = full ? shot->full_counter : shot->low_counter;
+
+		// shots could have been flushed meanwhile
+		if (!*staged) return;
+		*staged = false;
+
+		// nobody needs the texture anymore or it's already there
+		if (!valid || counter == 0 || *texture) return;
+
+		// texture storage is allocated once, pixels then come from the pixel buffer 
+		// (with the buffer bound NULL would mean its offset 0, so it's unbound for a while)
+		glGenTextures(1, texture);
+		glBindTexture(GL_TEXTURE_2D, *texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		opengl_bind_buffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, slot->width, slot->height, 0, GL_BGR_EXT, GL_UNSIGNED_BYTE, NULL);
+		opengl_bind_buffer(GL_PIXEL_UNPACK_BUFFER_ARB, slot->buffer);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, slot->width, slot->height, GL_BGR_EXT, GL_UNSIGNED_BYTE, (GLvoid *)0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	else
+	{
+		// * region request *
+
+		if (!IS_SET(image_loader_requests, slot->request_id)) return;
+		Image_Loader_Request * const request = image_loader_requests.data + slot->request_id;
+		if (request->time != slot->request_time || !request->staged) return;
+		request->staged = false;
+		ASSERT_IS_SET(image_loader_shots, request->shot_id);
+
+		// pixels were lost while in the buffer, we'll have to load them again 
+		if (!valid) 
+		{
+			if (!request->image) image_loader_reset_region_request(request, image_loader_shots.data + request->shot_id);
+			return;
+		}
+
+		// old texture stays on screen until the better one arrives, if it has the same size 
+		// the pixels simply replace its contents 
+		if (image_loader_region_texture_reusable(request, slot->texture_width, slot->texture_height, slot->trimmed, slot->quality)) 
+		{
+			glBindTexture(GL_TEXTURE_2D, request->gl_texture_id);
+		}
+		else
+		{
+			if (request->gl_texture_id) glDeleteTextures(1, &request->gl_texture_id);
+
+			const size_t texture_size = 3 * slot->texture_width * slot->texture_height;
+			if (slot->trimmed && image_loader_zeros_size < texture_size)
+			{
+				image_loader_zeros = (uchar *)realloc(image_loader_zeros, texture_size);
+				memset(image_loader_zeros, 0, texture_size);
+				image_loader_zeros_size = texture_size;
+			}
+
+			glGenTextures(1, &request->gl_texture_id);
+			glBindTexture(GL_TEXTURE_2D, request->gl_texture_id);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+			// storage (and zeros) come from client memory, so the pixel buffer has to be unbound for a while
+			opengl_bind_buffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+			glTexImage2D(
+				GL_TEXTURE_2D, 0, GL_RGB, slot->texture_width, slot->texture_height, 0, GL_BGR_EXT, GL_UNSIGNED_BYTE, 
+				slot->trimmed ? image_loader_zeros : NULL
+			);
+			opengl_bind_buffer(GL_PIXEL_UNPACK_BUFFER_ARB, slot->buffer);
+			request->gl_texture_storage_width = slot->texture_width;
+			request->gl_texture_storage_height = slot->texture_height;
+		}
+
+		glTexSubImage2D(GL_TEXTURE_2D, 0, slot->offset_x, slot->offset_y, slot->width, slot->height, GL_BGR_EXT, GL_UNSIGNED_BYTE, (GLvoid *)0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		request->gl_texture_quality = slot->quality;
+	}
+}
+
+// finish transfers of staged pixel buffers and map free buffers for the loader thread
+// must be called by the thread owning opengl context
+// expects LOCK_RW(image_loader), obtains LOCK_RW(opengl)
+static void image_loader_stream_upload()
+{
+	LOCK_RW(opengl)
+	{
+		// pixel buffers have to be created in current context 
+		if (!image_loader_stream_initialized) 
+		{
+			image_loader_stream_initialized = true; 
+			image_loader_streaming = opengl_initialize_buffers() && opengl_pixel_buffers_available();
+
+			for (int i = 0; i < IMAGE_LOADER_STREAM_SLOTS; i++) 
+			{
+				Image_Loader_Stream_Slot * const slot = image_loader_stream_slots + i;
+				slot->buffer = 0;
+				slot->pixels = NULL;
+				slot->state = IMAGE_LOADER_STREAM_UNMAPPED;
+				if (image_loader_streaming) opengl_gen_buffers(1, &slot->buffer);
+			}
+		}
+
+		if (image_loader_streaming) 
+		{
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+			for (int i = 0; i < IMAGE_LOADER_STREAM_SLOTS; i++) 
+			{
+				Image_Loader_Stream_Slot * const slot = image_loader_stream_slots + i;
+
+				if (slot->state == IMAGE_LOADER_STREAM_FILLED) 
+				{
+					// unmapping fails if the contents were lost (e.g. on video mode change)
+					opengl_bind_buffer(GL_PIXEL_UNPACK_BUFFER_ARB, slot->buffer);
+					const bool valid = opengl_unmap_buffer(GL_PIXEL_UNPACK_BUFFER_ARB) == GL_TRUE;
+					image_loader_stream_complete(slot, valid);
+					slot->pixels = NULL;
+					slot->state = IMAGE_LOADER_STREAM_UNMAPPED;
+				}
+
+				if (slot->state == IMAGE_LOADER_STREAM_UNMAPPED) 
+				{
+					// orphan the old storage, so that we don't wait for pending transfer 
+					opengl_bind_buffer(GL_PIXEL_UNPACK_BUFFER_ARB, slot->buffer);
+					opengl_buffer_data(GL_PIXEL_UNPACK_BUFFER_ARB, IMAGE_LOADER_STREAM_SLOT_SIZE, NULL, GL_STREAM_DRAW_ARB);
+					if ((slot->pixels = (uchar *)opengl_map_buffer(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB)))
+					{
+						slot->state = IMAGE_LOADER_STREAM_MAPPED;
+					}
+				}
+			}
+
+			opengl_bind_buffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+		}
+	}
+	UNLOCK_RW(opengl);
+}
+
 // release unused image from memory (full resolution version)
 // note we could use some more sophisticated releasing strategy
 // expects LOCK_RW(image_loader), obtains LOCK_RW(opencv)
@@ -53,10 +750,31 @@ void image_loader_free_full()
 	// if it's necessary to release something 
 	if (image_loader_full_counter >= image_loader_cache_full_count)
 	{
-		// find shot without requests 
+		// find shot without requests (prefetched images of suggested shots go last)
 		size_t i; 
 		bool found;
-		LAMBDA_FIND(image_loader_shots, i, found, image_loader_shots.data[i].full && image_loader_shots.data[i].full_counter == 0)
+		LAMBDA_FIND(image_loader_shots, i, found, image_loader_shots.data[i].full && image_loader_shots.data[i].full_counter == 0 && !image_loader_shots.data[i].suggested)
+		if (!found) 
+		{
+			LAMBDA_FIND(image_loader_shots, i, found, image_loader_shots.data[i].full && image_loader_shots.data[i].full_counter == 0)
+		}
+
+		// if there is none, take shot which is needed only by region views waiting for upload 
+		// and give those views their own copy of the pixels 
+		if (!found) 
+		{
+			LAMBDA_FIND(
+				image_loader_shots, i, found, 
+				image_loader_shots.data[i].full && 
+				image_loader_shots.data[i].full_view_counter > 0 && 
+				image_loader_shots.data[i].full_counter == image_loader_shots.data[i].full_view_counter
+			)
+
+			if (found) 
+			{
+				image_loader_detach_views(i, IMAGE_LOADER_FULL_RESOLUTION);
+			}
+		}
 
 		if (found)
 		{
@@ -83,10 +801,31 @@ void image_loader_free_low()
 	// if it's necessary to release something 
 	if (image_loader_low_counter >= image_loader_cache_low_count)
 	{
-		// find shot without requests 
+		// find shot without requests (prefetched images of suggested shots go last)
 		size_t i;
 		bool found;
-		LAMBDA_FIND(image_loader_shots, i, found, image_loader_shots.data[i].low && image_loader_shots.data[i].low_counter == 0)
+		LAMBDA_FIND(image_loader_shots, i, found, image_loader_shots.data[i].low && image_loader_shots.data[i].low_counter == 0 && !image_loader_shots.data[i].suggested)
+		if (!found) 
+		{
+			LAMBDA_FIND(image_loader_shots, i, found, image_loader_shots.data[i].low && image_loader_shots.data[i].low_counter == 0)
+		}
+
+		// if there is none, take shot which is needed only by region views waiting for upload 
+		// and give those views their own copy of the pixels 
+		if (!found) 
+		{
+			LAMBDA_FIND(
+				image_loader_shots, i, found, 
+				image_loader_shots.data[i].low && 
+				image_loader_shots.data[i].low_view_counter > 0 && 
+				image_loader_shots.data[i].low_counter == image_loader_shots.data[i].low_view_counter
+			)
+
+			if (found) 
+			{
+				image_loader_detach_views(i, IMAGE_LOADER_LOW_RESOLUTION);
+			}
+		}
 
 		if (found) 
 		{
@@ -202,139 +941,128 @@ void image_loader_resolve_request(const size_t request_id)
 				}
 
 				// decide, if we can actually improve upon something 
-				if  (achieved_quality > request->current_quality)
+				if  (achieved_quality > request->current_quality && img)
 				{
-					// extract the region 
-					IplImage * cut = NULL; 
-					if (img) 
+					// recalculate coordinates
+					const int
+						min_xi = (int)(min_x / shot->width * img->width),
+						min_yi = (int)(min_y / shot->height * img->height),
+						max_xi = (int)(max_x / shot->width * img->width),
+						max_yi = (int)(max_y / shot->height * img->height),
+						region_width = max_xi - min_xi + 1, 
+						region_height = max_yi - min_yi + 1
+					;
+
+					// the texture will have sides of the form 2^n 
+					int texture_width = 1, texture_height = 1;
+					while (texture_width < region_width) texture_width *= 2; 
+					while (texture_height < region_height) texture_height *= 2;
+
+					// calculate what might eventually become texturing coordinates 
+					request->gl_texture_width = texture_width;
+					request->gl_texture_height = texture_height;
+					request->gl_texture_min_x = 0;
+					request->gl_texture_min_y = 0; 
+					request->gl_texture_max_x = region_width / (double)texture_width; 
+					request->gl_texture_max_y = region_height / (double)texture_height;
+
+					// the previous (low resolution) view isn't needed anymore 
+					image_loader_release_view(request, shot);
+
+					// trim the region to fit the image and view it (no pixels are copied here, 
+					// they'll be uploaded directly from shot's image)
+					const int
+						view_min_x = min_xi < 0 ? 0 : min_xi, 
+						view_min_y = min_yi < 0 ? 0 : min_yi, 
+						view_max_x = max_xi >= img->width ? img->width - 1 : max_xi, 
+						view_max_y = max_yi >= img->height ? img->height - 1 : max_yi
+					;
+
+					request->image = img; 
+					request->image_owned = false;
+					request->view_x = view_min_x;
+					request->view_y = view_min_y; 
+					request->view_width = view_max_x - view_min_x + 1; 
+					request->view_height = view_max_y - view_min_y + 1; 
+					request->view_offset_x = view_min_x - min_xi; 
+					request->view_offset_y = view_min_y - min_yi;
+					request->view_trimmed = view_min_x != min_xi || view_min_y != min_yi || view_max_x != max_xi || view_max_y != max_yi;
+
+					if (achieved_quality == IMAGE_LOADER_FULL_RESOLUTION) 
 					{
-						// recalculate coordinates
-						int
-							min_xi = (int)(min_x / shot->width * img->width),
-							min_yi = (int)(min_y / shot->height * img->height),
-							max_xi = (int)(max_x / shot->width * img->width),
-							max_yi = (int)(max_y / shot->height * img->height)
-						;
-
-						// create image for the region 
-						ATOMIC_RW(opencv, cut = opencv_create_exp_image(max_xi - min_xi + 1, max_yi - min_yi + 1, img->depth, img->nChannels); );
-
-						if (cut) 
-						{
-							// set it as black 
-							ATOMIC_RW(opencv, cvZero(cut); );
-
-							// calculate what might eventually become texturing coordinates 
-							request->gl_texture_min_x = 0;
-							request->gl_texture_min_y = 0; 
-							request->gl_texture_max_x = (max_xi - min_xi + 1) / (double)(cut->width); 
-							request->gl_texture_max_y = (max_yi - min_yi + 1) / (double)(cut->height);
-
-							// trim the region to fit the image
-							if (min_xi < 0) min_xi = 0;
-							if (min_yi < 0) min_yi = 0;
-							if (max_xi >= img->width) max_xi = img->width - 1;
-							if (max_yi >= img->height) max_yi = img->height - 1;
-
-							// copy the region 
-							for (int y = min_yi; y <= max_yi; y++)
-							{
-								for (int x = min_xi; x <= max_xi; x++)
-								{
-									((uchar*)(cut->imageData + cut->widthStep * (y - min_yi)))[(x - min_xi) * 3 + 0] = ((uchar*)(img->imageData + img->widthStep * y))[x * 3 + 0];
-									((uchar*)(cut->imageData + cut->widthStep * (y - min_yi)))[(x - min_xi) * 3 + 1] = ((uchar*)(img->imageData + img->widthStep * y))[x * 3 + 1];
-									((uchar*)(cut->imageData + cut->widthStep * (y - min_yi)))[(x - min_xi) * 3 + 2] = ((uchar*)(img->imageData + img->widthStep * y))[x * 3 + 2];
-								}
-							}
-						}
+						shot->full_view_counter++; 
+					}
+					else
+					{
+						shot->low_view_counter++;
 					}
 
 					// save the result
-					if (cut)
+					switch (request->quality)
 					{
-						switch (request->quality)
+						case IMAGE_LOADER_LOW_RESOLUTION:
 						{
-							case IMAGE_LOADER_LOW_RESOLUTION:
+							if (achieved_quality == IMAGE_LOADER_LOW_RESOLUTION)
 							{
-								if (achieved_quality == IMAGE_LOADER_LOW_RESOLUTION)
-								{
-									ASSERT(!request->image, "unprocessed request has allocated memory for image");
-									request->image = cut;
-									request->current_quality = IMAGE_LOADER_LOW_RESOLUTION;
-									request->done = true;
-									shot->low_counter--; // here, we're decrementing the total amount of requests, because we don't need the original image anymore
-									shot->low_unprocessed_counter--;
-									image_loader_unprocessed_counter--;
-								}
-								else 
-								{
-									ASSERT(false, "inconsistent state variable");
-								}
-								break; 
+								request->current_quality = IMAGE_LOADER_LOW_RESOLUTION;
+								request->done = true;
+								shot->low_unprocessed_counter--;
+								image_loader_unprocessed_counter--;
+							}
+							else 
+							{
+								ASSERT(false, "inconsistent state variable");
 							}
+							break; 
+						}
 
-							case IMAGE_LOADER_FULL_RESOLUTION: 
+						case IMAGE_LOADER_FULL_RESOLUTION: 
+						{
+							if (achieved_quality == IMAGE_LOADER_FULL_RESOLUTION)
 							{
-								if (achieved_quality == IMAGE_LOADER_FULL_RESOLUTION)
-								{
-									ASSERT(!request->image, "unprocessed request has allocated memory for image");
-									request->image = cut;
-									request->current_quality = IMAGE_LOADER_FULL_RESOLUTION;
-									request->done = true;
-									shot->full_counter--;
-									shot->full_unprocessed_counter--;
-									image_loader_unprocessed_counter--;
-								}
-								else
-								{
-									ASSERT(false, "inconsistent state variable");
-								}
-								break;
+								request->current_quality = IMAGE_LOADER_FULL_RESOLUTION;
+								request->done = true;
+								shot->full_unprocessed_counter--;
+								image_loader_unprocessed_counter--;
+							}
+							else
+							{
+								ASSERT(false, "inconsistent state variable");
 							}
+							break;
+						}
 
-							case IMAGE_LOADER_CONTINUOUS_LOADING:
+						case IMAGE_LOADER_CONTINUOUS_LOADING:
+						{
+							if (achieved_quality >= IMAGE_LOADER_LOW_RESOLUTION)
 							{
-								if (achieved_quality >= IMAGE_LOADER_LOW_RESOLUTION)
+								if (request->current_quality < IMAGE_LOADER_LOW_RESOLUTION)
 								{
-									if (request->image)
-									{
-										ASSERT(achieved_quality == IMAGE_LOADER_FULL_RESOLUTION, "inconsistent state variable");
-										ASSERT(request->current_quality == IMAGE_LOADER_LOW_RESOLUTION, "inconsistent state variable");
-										LOCK_RW(opencv)
-										{
-											cvReleaseImage(&request->image);
-										}
-										UNLOCK_RW(opencv); 
-									}
-
-									if (request->current_quality < IMAGE_LOADER_LOW_RESOLUTION)
-									{
-										shot->low_counter--;
-										shot->low_unprocessed_counter--;
-									}
-
-									if (achieved_quality == IMAGE_LOADER_FULL_RESOLUTION) 
-									{
-										shot->full_counter--; 
-										shot->full_unprocessed_counter--; 
-										image_loader_unprocessed_counter--;
-										request->done = true;
-									}
-
-									request->image = cut;
-									request->current_quality = achieved_quality;
+									shot->low_unprocessed_counter--;
 								}
-								else
+
+								if (achieved_quality == IMAGE_LOADER_FULL_RESOLUTION) 
 								{
-									ASSERT(false, "achieved_quality must be at least low resolution");
+									// low version won't be needed by this request anymore
+									image_loader_release_reference(request, shot, IMAGE_LOADER_LOW_RESOLUTION);
+									shot->full_unprocessed_counter--; 
+									image_loader_unprocessed_counter--;
+									request->done = true;
 								}
-								break; 
+
+								request->current_quality = achieved_quality;
 							}
+							else
+							{
+								ASSERT(false, "achieved_quality must be at least low resolution");
+							}
+							break; 
 						}
 					}
 
 					// we're done, if the request was resolved (at least partially), it was marked as such 
-					// and appropriate counters were decremented
+					// and appropriate counters were decremented; the view keeps it's reference to shot's 
+					// image until it's uploaded to opengl
 				}
 			}
 
@@ -357,42 +1085,289 @@ void image_loader_resolve_request(const size_t request_id)
 					break; 
 				}
 
-				case IMAGE_LOADER_FULL_RESOLUTION: 
-				{
-					if (shot->full) 
-					{
-						request->image = shot->full; 
-						request->current_quality = IMAGE_LOADER_FULL_RESOLUTION;
-						request->done = true;
-						shot->full_unprocessed_counter--;
-						image_loader_unprocessed_counter--;
-					}
-					break;
-				}
+				case IMAGE_LOADER_FULL_RESOLUTION: 
+				{
+					if (shot->full) 
+					{
+						request->image = shot->full; 
+						request->current_quality = IMAGE_LOADER_FULL_RESOLUTION;
+						request->done = true;
+						shot->full_unprocessed_counter--;
+						image_loader_unprocessed_counter--;
+					}
+					break;
+				}
+
+				case IMAGE_LOADER_CONTINUOUS_LOADING:
+				{
+					if (shot->low && request->current_quality < IMAGE_LOADER_LOW_RESOLUTION)
+					{
+						request->image = shot->low; 
+						request->current_quality = IMAGE_LOADER_LOW_RESOLUTION;
+						shot->low_unprocessed_counter--;
+					}
+					if (shot->full) 
+					{
+						request->image = shot->full; 
+						request->current_quality = IMAGE_LOADER_FULL_RESOLUTION;
+						request->done = true;
+						shot->full_unprocessed_counter--;
+						image_loader_unprocessed_counter--;
+					}
+					break; 
+				}
+			}
+
+			break; 
+		}
+	}
+
+	image_loader_schedule_request(request_id);
+}
+
+// serve pending requests of the shot from images already in memory 
+// expects LOCK_RW(image_loader), obtains LOCK_RW(opencv)
+static void image_loader_resolve_shot(const size_t shot_id)
+{
+	Image_Loader_Shot * const shot = image_loader_shots.data + shot_id;
+	size_t request_id = shot->pending_count > 0 ? shot->pending_first : SIZE_MAX;
+
+	while (request_id != SIZE_MAX) 
+	{
+		// resolving might unlink the request 
+		const size_t next = image_loader_requests.data[request_id].pending_next;
+		image_loader_resolve_request(request_id);
+		request_id = next;
+	}
+}
+
+// decode image and resize it to size x size; if tiles are enabled, large images are decoded 
+// from their tiled store, which is created the first time they're loaded (this takes a while)
+// expects LOCK_RW(opencv)
+static IplImage * image_loader_decode(const char * const filename, const int size, const bool tiled, Image_Store ** store, int * width, int * height)
+{
+	IplImage * image;
+	*store = tiled ? image_store_open(filename) : NULL;
+
+	if (*store) 
+	{
+		// read only the level we need 
+		image = image_store_read_level(*store, image_store_level_for(*store, size, size));
+		*width = (*store)->width; 
+		*height = (*store)->height;
+	}
+	else
+	{
+		image = cvLoadImage(filename); 
+
+		if (!image) 
+		{
+			image = opencv_create_substitute_image();
+		}
+		else if (tiled && (image->width > IMAGE_LOADER_FULL_SIZE || image->height > IMAGE_LOADER_FULL_SIZE) && image_store_create(filename, image))
+		{
+			*store = image_store_open(filename);
+		}
+
+		*width = image->width;
+		*height = image->height;
+	}
+
+	IplImage * resize = cvCreateImage(cvSize(size, size), image->depth, image->nChannels);
+	cvResize(image, resize); 
+	cvReleaseImage(&image);
+	return resize;
+}
+
+// keep the store for displaying tiles, unless the shot already has one 
+// expects LOCK_RW(image_loader)
+static void image_loader_keep_store(Image_Loader_Shot * const shot, Image_Store * const store)
+{
+	if (!store) return;
+
+	if (!shot->store) 
+	{
+		shot->store = store;
+	}
+	else
+	{
+		image_store_close(store);
+	}
+}
+
+// load full version of shot's image (and low version too, if it's missing and fits into the cache)
+// expects LOCK_RW(image_loader), which is released while loading, obtains LOCK_RW(opencv)
+static void image_loader_load_full(const size_t shot_id)
+{
+	Image_Loader_Shot * shot = image_loader_shots.data + shot_id;
+
+	// if necessary, free memory by releasing one of unused images
+	image_loader_free_full();
+
+	// get image parameters and unlock
+	const char * const filename = shot->filename;
+	bool calculate_low = !shot->low && image_loader_low_counter < image_loader_cache_low_count;
+	const bool tiled = image_loader_tiled;
+
+	int loaded_width, loaded_height; 
+	IplImage * full, * low; 
+	Image_Store * store;
+
+	UNLOCK_RW(image_loader)
+	{
+		// load image
+		LOCK_RW(opencv)
+		{
+			full = image_loader_decode(filename, IMAGE_LOADER_FULL_SIZE, tiled, &store, &loaded_width, &loaded_height);
+		
+			// we might want to compute low version 
+			low = NULL;
+			if (calculate_low) 
+			{
+				low = cvCreateImage(cvSize(IMAGE_LOADER_LOW_SIZE, IMAGE_LOADER_LOW_SIZE), full->depth, full->nChannels);
+				cvResize(full, low);
+			}
+		}
+		UNLOCK_RW(opencv);
+	}
+	LOCK_RW(image_loader);
+
+	// lock again, shots might have been reallocated or released meanwhile 
+	shot = image_loader_shots.data + shot_id;
+	if (!IS_SET(image_loader_shots, shot_id) || shot->filename != filename || shot->full)
+	{
+		ATOMIC_RW(opencv, cvReleaseImage(&full); if (low) cvReleaseImage(&low); );
+		image_store_close(store);
+		return;
+	}
+
+	// save the data 
+	image_loader_keep_store(shot, store);
+	image_loader_full_counter++;
+	shot->full = full;
+	shot->width = loaded_width;
+	shot->height = loaded_height;
+	if (calculate_low)
+	{
+		if (!shot->low) 
+		{
+			image_loader_low_counter++;
+			shot->low = low;
+		}
+		else
+		{
+			ATOMIC_RW(opencv, cvReleaseImage(&low); );
+		}
+	}
+}
+
+// load low version of shot's image 
+// expects LOCK_RW(image_loader), which is released while loading, obtains LOCK_RW(opencv)
+static void image_loader_load_low(const size_t shot_id)
+{
+	Image_Loader_Shot * shot = image_loader_shots.data + shot_id;
+
+	// if necessary, free memory by releasing one of unused images
+	image_loader_free_low();
+
+	// get image parameters 
+	const char * const filename = shot->filename;
+	const bool tiled = image_loader_tiled;
+
+	IplImage * low; 
+	int loaded_width, loaded_height; 
+	Image_Store * store;
+
+	// load image
+	UNLOCK_RW(image_loader)
+	{
+		LOCK_RW(opencv)
+		{
+			// opencv_begin();
+			low = image_loader_decode(filename, IMAGE_LOADER_LOW_SIZE, tiled, &store, &loaded_width, &loaded_height);
+		}
+		UNLOCK_RW(opencv)
+	}
+	LOCK_RW(image_loader)
+
+	// lock again, shots might have been reallocated or released meanwhile 
+	shot = image_loader_shots.data + shot_id;
+	if (!IS_SET(image_loader_shots, shot_id) || shot->filename != filename || shot->low)
+	{
+		ATOMIC_RW(opencv, cvReleaseImage(&low); );
+		image_store_close(store);
+		return;
+	}
+
+	// save info about the low-res version
+	image_loader_keep_store(shot, store);
+	image_loader_low_counter++;
+	shot->low = low;
+	shot->width = loaded_width;
+	shot->height = loaded_height;
+}
+
+// check if there's room for another full version without releasing images anybody asked for
+// expects LOCK_RW(image_loader)
+static bool image_loader_room_full() 
+{
+	if (image_loader_full_counter < image_loader_cache_full_count) return true;
+
+	size_t i; 
+	bool found;
+	LAMBDA_FIND(image_loader_shots, i, found, image_loader_shots.data[i].full && image_loader_shots.data[i].full_counter == 0 && !image_loader_shots.data[i].suggested)
+	return found;
+}
+
+// check if there's room for another low version without releasing images anybody asked for
+// expects LOCK_RW(image_loader)
+static bool image_loader_room_low() 
+{
+	if (image_loader_low_counter < image_loader_cache_low_count) return true;
+
+	size_t i; 
+	bool found;
+	LAMBDA_FIND(image_loader_shots, i, found, image_loader_shots.data[i].low && image_loader_shots.data[i].low_counter == 0 && !image_loader_shots.data[i].suggested)
+	return found;
+}
+
+// load one image of suggested shots, returns false if there's nothing to do 
+// expects LOCK_RW(image_loader), obtains LOCK_RW(opencv)
+static bool image_loader_prefetch()
+{
+	if (!image_loader_prefetch_pending) return false;
 
-				case IMAGE_LOADER_CONTINUOUS_LOADING:
-				{
-					if (shot->low && request->current_quality < IMAGE_LOADER_LOW_RESOLUTION)
-					{
-						request->image = shot->low; 
-						request->current_quality = IMAGE_LOADER_LOW_RESOLUTION;
-						shot->low_unprocessed_counter--;
-					}
-					if (shot->full) 
-					{
-						request->image = shot->full; 
-						request->current_quality = IMAGE_LOADER_FULL_RESOLUTION;
-						request->done = true;
-						shot->full_unprocessed_counter--;
-						image_loader_unprocessed_counter--;
-					}
-					break; 
-				}
-			}
+	for ALL(image_loader_shots, i) 
+	{
+		Image_Loader_Shot * const shot = image_loader_shots.data + i;
+		if (!shot->suggested) continue;
 
-			break; 
+		if (shot->suggested_quality >= IMAGE_LOADER_FULL_RESOLUTION && !shot->full && image_loader_room_full())
+		{
+			image_loader_load_full(i);
+			return true;
+		}
+
+		if (!shot->low && image_loader_room_low())
+		{
+			image_loader_load_low(i);
+			return true;
 		}
 	}
+
+	// all suggested images are in memory (or there's no room for them)
+	image_loader_prefetch_pending = false;
+	return false;
+}
+
+// let the rendering thread know there's something new to show 
+// (the event only wakes up render scheduler, application ignores it)
+static void image_loader_wake_renderer()
+{
+	SDL_Event event;
+	memset(&event, 0, sizeof(event));
+	event.type = SDL_USEREVENT;
+	SDL_PushEvent(&event);
 }
 
 // thread function
@@ -415,164 +1390,59 @@ void * image_loader_thread_function(void * arg)
 				break;
 			}
 
-			// check if there are requests to process
-			if (image_loader_unprocessed_counter == 0) 
+			// copy pixels the rendering thread is waiting for 
+			const bool staging = image_loader_stream_wanted;
+			image_loader_stream_fill();
+			if (staging && !image_loader_stream_wanted) 
 			{
-				// probably nothing...
-				// SDL_Delay(100);
+				image_loader_wake_renderer();
 			}
-			else
-			{
-				// * we have work to do *
-
-				// try to resolve requests which can be resolved immediately 
-				for ALL(image_loader_requests, i) 
-				{
-					Image_Loader_Request * const request = image_loader_requests.data + i;
 
-					if (!request->done) 
-					{
-						image_loader_resolve_request(i);
-					}
-				}
-				
-				// find optimal shot to process
-				size_t best_shot = SIZE_MAX; 
-				bool best_found = false; 
-				size_t best_count = 0;
+			ASSERT(
+				image_loader_queue_count > 0 || image_loader_unprocessed_counter == 0, 
+				"there are unprocessed requests, but no shot is queued"
+			);
 
-				for ALL(image_loader_shots, i) 
+			// check if there are requests to process
+			if (image_loader_queue_count == 0) 
+			{
+				// if not, we can load images which will probably be needed soon
+				if (!image_loader_prefetch()) 
 				{
-					Image_Loader_Shot * const shot = image_loader_shots.data + i; 
-					// printf("%d ", i); 
-
-					if (shot->full_unprocessed_counter + shot->low_unprocessed_counter >= best_count || !best_found)
-					{
-						best_found = true;
-						best_shot = i;
-						best_count = shot->full_unprocessed_counter + shot->low_unprocessed_counter;
-					}
-
-					ASSERT(best_count <= 2 * image_loader_requests.count, "number of unprocessed requests for one shot is bigger than the number of all requests");
-					// note that we're multiplying by 2 because continuous loading request adds one to both full and low counters
-					// (thus, this is not necessarily tight bound)
+					// probably nothing...
+					// SDL_Delay(100);
 				}
+			}
+			else
+			{
+				// * we have work to do *
 
-				ASSERT(best_found, "no shot with pending requests found even though there are unprocessed requests");
+				// take the most urgent shot and serve what can be served from memory 
+				const size_t best_shot = image_loader_queue[0];
+				image_loader_resolve_shot(best_shot);
 				Image_Loader_Shot * shot = image_loader_shots.data + best_shot;
 
 				// full resolution version is requested and currently not in memory
 				if (shot->full_unprocessed_counter > 0 && !shot->full) 
 				{
-					// if necessary, free memory by releasing one of unused images
-					image_loader_free_full();
-
-					// get image parameters and unlock
-					const char * const filename = shot->filename;
-					bool calculate_low = !shot->low && image_loader_low_counter < image_loader_cache_low_count;
-
-					int loaded_width, loaded_height; 
-					IplImage * full, * low; 
-
-					UNLOCK_RW(image_loader)
-					{
-						// load image
-						LOCK_RW(opencv)
-						{
-							full = cvLoadImage(filename); 
-						
-							if (!full) 
-							{
-								full = opencv_create_substitute_image();
-							}
-							loaded_width = full->width;
-						       	loaded_height = full->height;
-							IplImage * resize = cvCreateImage(cvSize(IMAGE_LOADER_FULL_SIZE, IMAGE_LOADER_FULL_SIZE), full->depth, full->nChannels);
-							cvResize(full, resize); 
-							cvReleaseImage(&full);
-							full = resize;
-						
-							// we might want to compute low version 
-							low = NULL;
-							if (calculate_low) 
-							{
-								low = cvCreateImage(cvSize(IMAGE_LOADER_LOW_SIZE, IMAGE_LOADER_LOW_SIZE), full->depth, full->nChannels);
-								cvResize(full, low);
-							}
-						}
-						UNLOCK_RW(opencv);
-					}
-					LOCK_RW(image_loader);
-
-					// lock again and save the data
-					image_loader_full_counter++;
-					shot->full = full;
-					shot->width = loaded_width;
-					shot->height = loaded_height;
-					if (calculate_low)
-					{
-						image_loader_low_counter++;
-						shot->low = low;
-					}
+					image_loader_load_full(best_shot);
 				}
 
 				// low resolution version is requested and currently not in memory
-				if (shot->low_unprocessed_counter > 0 && !shot->low)
+				// (shots might have been reallocated or released while loading)
+				shot = image_loader_shots.data + best_shot;
+				if (IS_SET(image_loader_shots, best_shot) && shot->low_unprocessed_counter > 0 && !shot->low)
 				{
-					// if necessary, free memory by releasing one of unused images
-					// locks opencv
-					image_loader_free_low();
-
-					// get image parameters 
-					const char * const filename = shot->filename;
-
-					IplImage * low; 
-					int loaded_width, loaded_height; 
-
-					// load image
-					UNLOCK_RW(image_loader)
-					{
-						LOCK_RW(opencv)
-						{
-							// opencv_begin();
-							low = cvLoadImage(filename);
-							if (!low)
-							{
-								low = opencv_create_substitute_image();
-							}
-							loaded_width = low->width; 
-							loaded_height = low->height;
-							IplImage * resize = cvCreateImage(cvSize(IMAGE_LOADER_LOW_SIZE, IMAGE_LOADER_LOW_SIZE), low->depth, low->nChannels);
-							cvResize(low, resize);
-							cvReleaseImage(&low);
-							low = resize;
-						}
-						UNLOCK_RW(opencv)
-					}
-					LOCK_RW(image_loader)
-
-					// lock again and save info about the low-res version
-					image_loader_low_counter++;
-					shot->low = low;
-					shot->width = loaded_width;
-					shot->height = loaded_height;
+					image_loader_load_low(best_shot);
 				}
 
-				// process requests 
-				for ALL(image_loader_requests, i)
+				// resolve requests for the shot we've just loaded
+				if (IS_SET(image_loader_shots, best_shot)) 
 				{
-					Image_Loader_Request * const request = image_loader_requests.data + i; 
-
-					// if the request is for shot we've just loaded, resolve the request
-					if (
-						request->shot_id == best_shot 
-						&& 
-						!(request->quality == request->current_quality || request->quality == IMAGE_LOADER_CONTINUOUS_LOADING && request->current_quality == IMAGE_LOADER_FULL_RESOLUTION)
-					)
-					{
-						image_loader_resolve_request(i);
-					}
+					image_loader_resolve_shot(best_shot);
 				}
+
+				image_loader_wake_renderer();
 			}
 		}
 		UNLOCK_RW(image_loader);
@@ -591,7 +1461,16 @@ bool image_loader_initialize(const int cache_full_count, const int cache_low_cou
 	image_loader_full_counter = 0; 
 	image_loader_low_counter = 0;
 	image_loader_free_ids_counter = 0;
+	image_loader_queue_count = 0;
 	image_loader_unprocessed_counter = 0;
+	image_loader_stream_initialized = false;
+	image_loader_streaming = false;
+	image_loader_stream_wanted = false;
+	image_loader_stream_copying = false;
+	image_loader_prefetch_pending = false;
+	image_loader_tiled = false;
+	image_loader_tile_frame = 0;
+	image_loader_tile_textures_discard = false;
 	DYN_INIT(image_loader_shots); 
 	DYN_INIT(image_loader_requests);
 
@@ -648,8 +1527,6 @@ Image_Loader_Request_Handle image_loader_new_request(
 		
 	LOCK_RW(image_loader)
 	{
-		ASSERT(image_loader_requests.count < IMAGE_LOADER_MAX_REQUESTS, "maximum number of requests reached");
-
 		// create request structure
 		size_t id;
 
@@ -680,6 +1557,13 @@ Image_Loader_Request_Handle image_loader_new_request(
 		request->sx = sx; 
 		request->sy = sy; 
 		request->done = false;
+		request->time = handle.time;
+		request->stream_wanted = false;
+		request->staged = false;
+		request->pending = false;
+		request->urgent = false;
+		request->low_reference = content != IMAGE_LOADER_ALL && quality != IMAGE_LOADER_FULL_RESOLUTION;
+		request->full_reference = content != IMAGE_LOADER_ALL && quality != IMAGE_LOADER_LOW_RESOLUTION;
 
 		// increase the number of active requests for this shot
 		DYN(image_loader_shots, shot_id);
@@ -713,11 +1597,9 @@ Image_Loader_Request_Handle image_loader_new_request(
 			}
 		}
 
-		// try to resolve this request immediately (if it looks like it's important enough) 
-		if (request->content == IMAGE_LOADER_ALL)
-		{
-			image_loader_resolve_request(handle.id);
-		}
+		// queue the request and try to resolve it immediately (regions are only views, so this is cheap)
+		image_loader_schedule_request(handle.id);
+		image_loader_resolve_request(handle.id);
 	}
 	UNLOCK_RW(image_loader);
 
@@ -737,7 +1619,7 @@ void image_loader_cancel_request(Image_Loader_Request_Handle * handle)
 	LOCK_RW(image_loader)
 	{
 		ASSERT(image_loader_nonempty_handle(*handle), "trying to release empty request handle");
-		ASSERT_IS_SET(image_loader_requests, handle->id);
+		ASSERT_VALID_HANDLE(*handle);
 		Image_Loader_Request * const request = image_loader_requests.data + handle->id;
 		const size_t shot_id = request->shot_id;
 		ASSERT_IS_SET(image_loader_shots, shot_id); 
@@ -784,10 +1666,8 @@ void image_loader_cancel_request(Image_Loader_Request_Handle * handle)
 		else
 		{
 			// decrease the counter of unprocessed requests 
-			// strong todo (priority) add free
 			if (!request->done) 
 			{
-				// if the request wasn't fullfilled, simply decrement counters
 				ASSERT(image_loader_unprocessed_counter > 0, "number of unprocessed requests is not positive even though we've found at least one");
 				image_loader_unprocessed_counter--; 
 
@@ -795,47 +1675,31 @@ void image_loader_cancel_request(Image_Loader_Request_Handle * handle)
 				{
 					case IMAGE_LOADER_LOW_RESOLUTION:
 						ASSERT(shot->low_unprocessed_counter > 0, "number of unprocessed requests for low version is zero although one unfinished is being cancelled");
-						ASSERT(shot->low_counter > 0, "number of requests for low version is zero although one unfinished is being cancelled");
 						shot->low_unprocessed_counter--;
-						shot->low_counter--;
 						break; 
 					case IMAGE_LOADER_FULL_RESOLUTION: 
 						ASSERT(shot->full_unprocessed_counter > 0, "number of unprocessed requests for full version is zero although one unfinished is being cancelled");
-						ASSERT(shot->full_counter > 0, "number of requests for full version is zero although one unfinished is being cancelled");
 						shot->full_unprocessed_counter--;
-						shot->full_counter--; 
 						break;
 					case IMAGE_LOADER_CONTINUOUS_LOADING: 
 						ASSERT(shot->full_unprocessed_counter > 0, "number of unprocessed requests for full version is zero although one unfinished is being cancelled");
-						ASSERT(shot->full_counter > 0, "number of requests for full version is zero although one unfinished is being cancelled");
 						shot->full_unprocessed_counter--;
-						shot->full_counter--;
 						if (request->current_quality < IMAGE_LOADER_LOW_RESOLUTION)
 						{
 							ASSERT(shot->low_unprocessed_counter > 0, "number of unprocessed requests for low version is zero although one unfinished is being cancelled");
-							ASSERT(shot->low_counter > 0, "number of requests for low version is zero although one unfinished is being cancelled");
 							shot->low_unprocessed_counter--; 
-							shot->low_counter--; 
 						}
 						break; 
 				}
 			}
 
-			// we're not decreasing the number of requests here, because requests for parts
-			// of image do not depend on the whole image - a copy is made instead
+			// stop viewing shot's image and release whatever references the request still holds 
+			// (views which have been uploaded to opengl don't hold any)
+			image_loader_release_view(request, shot);
+			image_loader_release_reference(request, shot, IMAGE_LOADER_LOW_RESOLUTION);
+			image_loader_release_reference(request, shot, IMAGE_LOADER_FULL_RESOLUTION);
 
 			// we'll also immediately delete textures from memory
-			if (request->image) 
-			{
-				LOCK_RW(opencv)
-				{
-					cvReleaseImage(&request->image); 
-				}
-				UNLOCK_RW(opencv);
-
-				request->image = NULL; 
-			}
-
 			if (request->gl_texture_id) 
 			{
 				LOCK_RW(opengl)
@@ -843,6 +1707,7 @@ void image_loader_cancel_request(Image_Loader_Request_Handle * handle)
 					glDeleteTextures(1, &request->gl_texture_id);
 				}
 				UNLOCK_RW(opengl);
+				request->gl_texture_id = 0;
 			}
 		}
 
@@ -874,7 +1739,13 @@ void image_loader_cancel_request(Image_Loader_Request_Handle * handle)
 		}
 
 		// delete the request 
+		image_loader_schedule_request(handle->id, true);
 		request->set = false;
+		if (image_loader_free_ids_counter == image_loader_free_ids_size) 
+		{
+			image_loader_free_ids_size = image_loader_free_ids_size ? 2 * image_loader_free_ids_size : 256;
+			image_loader_free_ids = (size_t *)realloc(image_loader_free_ids, image_loader_free_ids_size * sizeof(size_t));
+		}
 		image_loader_free_ids[image_loader_free_ids_counter++] = handle->id;
 	
 		// mark handle as empty 
@@ -888,7 +1759,7 @@ void image_loader_cancel_request(Image_Loader_Request_Handle * handle)
 // expects LOCK_RW(image_loader)
 static bool image_loader_request_ready_nolock(Image_Loader_Request_Handle handle) 
 {
-	ASSERT_IS_SET(image_loader_requests, handle.id);
+	ASSERT_VALID_HANDLE(handle);
 	return
 		image_loader_requests.data[handle.id].done 
 		|| 
@@ -917,7 +1788,7 @@ bool image_loader_opengl_upload_ready_dual(
 {
 	LOCK_RW(image_loader)
 	{
-		ASSERT_IS_SET(image_loader_requests, handle.id);
+		ASSERT_VALID_HANDLE(handle);
 		Image_Loader_Request * request = image_loader_requests.data + handle.id; 
 		
 		*low_texture = 0;
@@ -1001,6 +1872,28 @@ bool image_loader_opengl_upload_ready(
 	}
 }
 
+// quality of the texture currently uploaded for region request 
+// obtains LOCK_R(image_loader)
+Image_Loader_Quality image_loader_opengl_texture_quality(Image_Loader_Request_Handle handle)
+{
+	Image_Loader_Quality quality = IMAGE_LOADER_NOT_LOADED;
+
+	LOCK_R(image_loader)
+	{
+		ASSERT_VALID_HANDLE(handle);
+		const Image_Loader_Request * const request = image_loader_requests.data + handle.id;
+		ASSERT(request->content != IMAGE_LOADER_ALL, "texture quality is tracked only for region requests");
+
+		if (request->gl_texture_id) 
+		{
+			quality = request->gl_texture_quality;
+		}
+	}
+	UNLOCK_R(image_loader);
+
+	return quality;
+}
+
 // uploads texture to opengl
 // note if there are more requests for one image, it's cause multiple uploads to opengl
 // obtains LOCK_RW(image_loader), LOCK_RW(opengl)
@@ -1011,11 +1904,14 @@ void image_loader_upload_to_opengl(Image_Loader_Request_Handle handle)
 		// error c:\_\projects\insight3d\insight3d\core_image_loader.cpp, 1031: accessing undefin
 		// ed index -572662307 in dynamic array
 		// [happened when terminating the application by clicking the [x] button]
-		ASSERT_IS_SET(image_loader_requests, handle.id);
+		ASSERT_VALID_HANDLE(handle);
 		Image_Loader_Request * const request = image_loader_requests.data + handle.id;
 		ASSERT_IS_SET(image_loader_shots, request->shot_id);
 		Image_Loader_Shot * const shot = image_loader_shots.data + request->shot_id;
 
+		// finish transfers staged since the last call 
+		image_loader_stream_upload();
+
 		// check if this request is ready (at least partially)
 		if (image_loader_request_ready_nolock(handle))
 		{
@@ -1025,7 +1921,16 @@ void image_loader_upload_to_opengl(Image_Loader_Request_Handle handle)
 				// * it's new entire image * 
 				
 				// check if there's actually something new to upload
-				if (!shot->full_texture && shot->full) 
+				if (!shot->full_texture && shot->full && image_loader_streaming)
+				{
+					// ask loader thread to stage the pixels 
+					if (!shot->full_staged) 
+					{
+						shot->full_stream_wanted = true; 
+						image_loader_stream_wanted = true;
+					}
+				}
+				else if (!shot->full_texture && shot->full) 
 				{
 					// upload full texture
 					LOCK_RW(opengl)
@@ -1041,7 +1946,15 @@ void image_loader_upload_to_opengl(Image_Loader_Request_Handle handle)
 					UNLOCK_RW(opengl);
 				}
 
-				if (!shot->low_texture && shot->low) 
+				if (!shot->low_texture && shot->low && image_loader_streaming)
+				{
+					if (!shot->low_staged) 
+					{
+						shot->low_stream_wanted = true; 
+						image_loader_stream_wanted = true;
+					}
+				}
+				else if (!shot->low_texture && shot->low) 
 				{
 					// upload low texture 
 					LOCK_RW(opengl)
@@ -1061,30 +1974,94 @@ void image_loader_upload_to_opengl(Image_Loader_Request_Handle handle)
 			{
 				// * it's just a part of an image *
 
-				// if we loaded better version of this texture 
-				if (request->gl_texture_id && request->current_quality > request->gl_texture_quality)
+				const bool better = request->gl_texture_id && request->current_quality > request->gl_texture_quality;
+
+				if (request->staged) 
+				{
+					// pixels are on their way to gpu 
+				}
+				else if (
+					image_loader_streaming && (better || !request->gl_texture_id) && 
+					request->image && request->view_width > 0 && request->view_height > 0
+				)
+				{
+					// ask loader thread to stage the pixels 
+					request->stream_wanted = true; 
+					image_loader_stream_wanted = true;
+				}
+				// if we loaded better version of this texture (and it doesn't fit into the old one)
+				else if (
+					better && 
+					!image_loader_region_texture_reusable(
+						request, request->gl_texture_width, request->gl_texture_height, request->view_trimmed, request->current_quality
+					)
+				)
 				{
 					// delete the texture 
 					ATOMIC_RW(opengl, glDeleteTextures(1, &request->gl_texture_id); );
 					request->gl_texture_id = 0;
 				}
 
-				ASSERT(request->image, "image not ready although request is done");
-
-				if (!request->gl_texture_id)
+				if (!request->staged && !request->stream_wanted && (!request->gl_texture_id || better))
 				{
-					// upload the texture
+					ASSERT(request->image || request->view_width <= 0 || request->view_height <= 0, "image not ready although request is done");
+					const size_t texture_size = 3 * request->gl_texture_width * request->gl_texture_height;
+
+					// parts of the region outside of the image are black
+					if (request->view_trimmed && image_loader_zeros_size < texture_size)
+					{
+						image_loader_zeros = (uchar *)realloc(image_loader_zeros, texture_size);
+						memset(image_loader_zeros, 0, texture_size);
+						image_loader_zeros_size = texture_size;
+					}
+
+					// upload the texture straight from the viewed rectangle (into the old texture, if it's kept)
 					LOCK_RW(opengl)
 					{
-						glGenTextures(1, &request->gl_texture_id);
-						glBindTexture(GL_TEXTURE_2D, request->gl_texture_id);
-						glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-						glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-						glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-						glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, request->image->width, request->image->height, 0, GL_BGR_EXT, GL_UNSIGNED_BYTE, request->image->imageData);
+						if (request->gl_texture_id) 
+						{
+							glBindTexture(GL_TEXTURE_2D, request->gl_texture_id);
+						}
+						else
+						{
+							glGenTextures(1, &request->gl_texture_id);
+							glBindTexture(GL_TEXTURE_2D, request->gl_texture_id);
+							glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+							glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+							glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+							glTexImage2D(
+								GL_TEXTURE_2D, 0, GL_RGB, request->gl_texture_width, request->gl_texture_height, 0, GL_BGR_EXT, GL_UNSIGNED_BYTE, 
+								request->view_trimmed ? image_loader_zeros : NULL
+							);
+							request->gl_texture_storage_width = request->gl_texture_width;
+							request->gl_texture_storage_height = request->gl_texture_height;
+						}
+
+						if (request->image && request->view_width > 0 && request->view_height > 0)
+						{
+							// rows of IplImage are aligned to 4 bytes 
+							glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+							glPixelStorei(GL_UNPACK_ROW_LENGTH, request->image->width);
+							glPixelStorei(GL_UNPACK_SKIP_PIXELS, request->view_x);
+							glPixelStorei(GL_UNPACK_SKIP_ROWS, request->view_y);
+							glTexSubImage2D(
+								GL_TEXTURE_2D, 0, request->view_offset_x, request->view_offset_y, request->view_width, request->view_height, 
+								GL_BGR_EXT, GL_UNSIGNED_BYTE, request->image->imageData
+							);
+							glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+							glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+							glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+							glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+						}
+
 						glBindTexture(GL_TEXTURE_2D, 0);
 					}
 					UNLOCK_RW(opengl);
+
+					// pixels are on gpu now, shot's image can be released 
+					request->gl_texture_quality = request->current_quality;
+					image_loader_release_view(request, shot);
+					image_loader_release_reference(request, shot, request->current_quality);
 				}
 			}
 		}
@@ -1109,12 +2086,38 @@ void image_loader_get_original_dimensions(Image_Loader_Request_Handle handle, in
 	UNLOCK_R(image_loader);
 }
 
+// shot and rectangle requested by region request 
+// obtains LOCK_R(image_loader)
+bool image_loader_get_region(Image_Loader_Request_Handle handle, size_t * shot_id, double * x1, double * y1, double * x2, double * y2)
+{
+	bool found = false;
+	LOCK_R(image_loader)
+	{
+		if (image_loader_nonempty_handle(handle) && image_loader_valid_handle(handle) && image_loader_requests.data[handle.id].content == IMAGE_LOADER_REGION)
+		{
+			const Image_Loader_Request * const request = image_loader_requests.data + handle.id;
+			*shot_id = request->shot_id;
+			*x1 = request->x;
+			*y1 = request->y;
+			*x2 = request->sx;
+			*y2 = request->sy;
+			found = true;
+		}
+	}
+	UNLOCK_R(image_loader);
+
+	return found;
+}
+
 // flush texture ids
 // obtains LOCK_RW(image_loader)
 void image_loader_flush_texture_ids() 
 {
 	LOCK_RW(image_loader)
 	{
+		// pixel buffers which are being filled have to stay mapped until the loader thread is done
+		image_loader_stream_wait();
+
 		// go through all requests 
 		for ALL(image_loader_requests, i)
 		{
@@ -1122,6 +2125,15 @@ void image_loader_flush_texture_ids()
 
 			request->gl_texture_quality = IMAGE_LOADER_NOT_LOADED; 
 			request->gl_texture_id = 0;
+			request->stream_wanted = false;
+			request->staged = false;
+
+			// uploaded regions don't have their pixels anymore, we'll have to load them again
+			if (request->content != IMAGE_LOADER_ALL && !request->image && request->current_quality > IMAGE_LOADER_NOT_LOADED)
+			{
+				ASSERT_IS_SET(image_loader_shots, request->shot_id);
+				image_loader_reset_region_request(request, image_loader_shots.data + request->shot_id);
+			}
 		}
 
 		// and through all shots 
@@ -1131,12 +2143,45 @@ void image_loader_flush_texture_ids()
 
 			shot->full_texture = 0; 
 			shot->low_texture = 0;
+			shot->full_stream_wanted = shot->low_stream_wanted = false; 
+			shot->full_staged = shot->low_staged = false;
+		}
+
+		// and through tiles
+		for (int i = 0; i < IMAGE_LOADER_TILE_TEXTURES; i++)
+		{
+			image_loader_tile_textures[i].set = false; 
+			image_loader_tile_textures[i].texture = 0;
 		}
+		image_loader_tile_textures_discard = false;
+
+		// pixel buffers belong to the old context too, rendering thread will create new ones
+		image_loader_stream_initialized = false;
+		image_loader_streaming = false;
+		image_loader_stream_wanted = false;
 	}
 	UNLOCK_RW(image_loader);
 }
 
-// todo set suggested flag
+// suggest that shot's image will probably be needed soon 
+// obtains LOCK_RW(image_loader)
+void image_loader_suggest(const size_t shot_id, const char * const filename, const Image_Loader_Quality quality)
+{
+	LOCK_RW(image_loader)
+	{
+		DYN(image_loader_shots, shot_id);
+		Image_Loader_Shot * const shot = image_loader_shots.data + shot_id;
+
+		shot->filename = filename;
+		if (!shot->suggested || quality > shot->suggested_quality) 
+		{
+			shot->suggested_quality = quality;
+		}
+		shot->suggested = true;
+		image_loader_prefetch_pending = true;
+	}
+	UNLOCK_RW(image_loader);
+}
 
 // clear all suggested flags 
 // obtains LOCK_RW(image_loader)
@@ -1149,9 +2194,35 @@ void image_loaded_flush_suggested()
 		{
 			Image_Loader_Shot * const shot = image_loader_shots.data + i; 
 			shot->suggested = false; 
+			shot->suggested_quality = IMAGE_LOADER_NOT_LOADED;
+		}
+
+		image_loader_prefetch_pending = false;
+	}
+	UNLOCK_RW(image_loader);
+}
+
+// is the loader still processing some requests (or holding loaded pixels which weren't uploaded yet)
+// obtains LOCK_RW(image_loader)
+bool image_loader_busy()
+{
+	bool busy;
+
+	LOCK_RW(image_loader)
+	{
+		busy = image_loader_unprocessed_counter > 0;
+
+		for (int i = 0; i < IMAGE_LOADER_STREAM_SLOTS && !busy; i++) 
+		{
+			busy = 
+				image_loader_stream_slots[i].state == IMAGE_LOADER_STREAM_FILLING || 
+				image_loader_stream_slots[i].state == IMAGE_LOADER_STREAM_FILLED
+			;
 		}
 	}
 	UNLOCK_RW(image_loader);
+
+	return busy;
 }
 
 // cancel all requests 
@@ -1164,7 +2235,7 @@ void image_loader_cancel_all_requests()
 		{
 			Image_Loader_Request_Handle handle; 
 			handle.id = i; 
-			handle.time = 1;
+			handle.time = image_loader_requests.data[i].time;
 
 			UNLOCK_RW(image_loader)
 			{
@@ -1173,6 +2244,9 @@ void image_loader_cancel_all_requests()
 			LOCK_RW(image_loader);
 		}
 
+		// shots' images might be just copied into pixel buffers
+		image_loader_stream_wait();
+
 		for ALL(image_loader_shots, i)
 		{
 			Image_Loader_Shot * const shot = image_loader_shots.data + i; 
@@ -1183,12 +2257,179 @@ void image_loader_cancel_all_requests()
 				if (shot->low) cvReleaseImage(&shot->low);
 			}
 			UNLOCK_RW(opencv);
+
+			image_store_close(shot->store);
+			shot->store = NULL;
 		}
 
+		// tile textures refer to released shots
+		image_loader_tile_textures_discard = true;
+
 		image_loader_full_counter = 0;
 		image_loader_low_counter = 0;
 
+		ASSERT(image_loader_queue_count == 0, "shot still queued although all requests were cancelled");
 		DYN_FREE(image_loader_shots);
 	}
 	UNLOCK_RW(image_loader);
 }
+
+// enable or disable tiled stores for large images 
+// obtains LOCK_RW(image_loader)
+void image_loader_set_tiled(const bool tiled)
+{
+	ATOMIC_RW(image_loader, image_loader_tiled = tiled; );
+}
+
+// are tiled stores enabled? 
+// obtains LOCK_RW(image_loader)
+bool image_loader_get_tiled()
+{
+	ATOMIC_RW(image_loader, const bool tiled = image_loader_tiled; );
+	return tiled;
+}
+
+// find tile texture (uploading it if necessary and we haven't uploaded too much in this frame already)
+// expects LOCK_RW(image_loader), obtains LOCK_RW(opengl)
+static GLuint image_loader_tile_texture(const size_t shot_id, const Image_Store * const store, const int level, const int x, const int y, int * uploads)
+{
+	int lru = 0;
+	for (int i = 0; i < IMAGE_LOADER_TILE_TEXTURES; i++) 
+	{
+		Image_Loader_Tile_Texture * const tile = image_loader_tile_textures + i;
+
+		if (tile->set && tile->shot_id == shot_id && tile->level == level && tile->x == x && tile->y == y) 
+		{
+			tile->used = image_loader_tile_frame;
+			return tile->texture;
+		}
+
+		if (!tile->set || (image_loader_tile_textures[lru].set && tile->used < image_loader_tile_textures[lru].used)) lru = i;
+	}
+
+	if (*uploads >= IMAGE_LOADER_TILE_UPLOADS) return 0;
+	(*uploads)++;
+
+	// recycle the least recently used texture (tiles have all the same size)
+	Image_Loader_Tile_Texture * const tile = image_loader_tile_textures + lru;
+	tile->set = true; 
+	tile->shot_id = shot_id; 
+	tile->level = level; 
+	tile->x = x; 
+	tile->y = y; 
+	tile->used = image_loader_tile_frame;
+
+	LOCK_RW(opengl)
+	{
+		if (!tile->texture) glGenTextures(1, &tile->texture);
+		glBindTexture(GL_TEXTURE_2D, tile->texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexImage2D(
+			GL_TEXTURE_2D, 0, GL_RGB, store->tile_size, store->tile_size, 0, GL_BGR_EXT, GL_UNSIGNED_BYTE, 
+			image_store_tile(store, level, x, y)
+		);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	UNLOCK_RW(opengl);
+
+	return tile->texture;
+}
+
+// get textures of tiles covering part of request's image 
+// obtains LOCK_RW(image_loader), LOCK_RW(opengl)
+int image_loader_get_tiles(
+	Image_Loader_Request_Handle handle, double x1, double y1, double x2, double y2, const double screen_width, 
+	Image_Loader_Tile * tiles, const int max_count, bool * pending
+)
+{
+	int count = 0;
+	*pending = false;
+
+	LOCK_RW(image_loader)
+	{
+		ASSERT_VALID_HANDLE(handle);
+		const size_t shot_id = image_loader_requests.data[handle.id].shot_id;
+		ASSERT_IS_SET(image_loader_shots, shot_id);
+		const Image_Store * const store = image_loader_shots.data[shot_id].store;
+
+		// delete textures of released shots 
+		if (image_loader_tile_textures_discard) 
+		{
+			LOCK_RW(opengl)
+			{
+				for (int i = 0; i < IMAGE_LOADER_TILE_TEXTURES; i++) 
+				{
+					if (image_loader_tile_textures[i].texture) glDeleteTextures(1, &image_loader_tile_textures[i].texture);
+					image_loader_tile_textures[i].texture = 0;
+					image_loader_tile_textures[i].set = false;
+				}
+			}
+			UNLOCK_RW(opengl);
+			image_loader_tile_textures_discard = false;
+		}
+
+		if (x1 < 0) x1 = 0; 
+		if (y1 < 0) y1 = 0; 
+		if (x2 > 1) x2 = 1; 
+		if (y2 > 1) y2 = 1;
+
+		if (image_loader_tiled && store && x2 > x1 && y2 > y1) 
+		{
+			// coarsest level which has at least one pixel per screen pixel 
+			const double needed = screen_width / (x2 - x1);
+			int level = store->levels - 1; 
+			while (level > 0 && store->level_width[level] < needed) level--;
+
+			// full version is detailed enough 
+			if (store->level_width[level] > IMAGE_LOADER_FULL_SIZE) 
+			{
+				const int 
+					T = store->tile_size, 
+					width = store->level_width[level], 
+					height = store->level_height[level], 
+					tx1 = (int)(x1 * width) / T, 
+					ty1 = (int)(y1 * height) / T,
+					tx2 = (int)(x2 * width) / T < store->tiles_x[level] ? (int)(x2 * width) / T : store->tiles_x[level] - 1, 
+					ty2 = (int)(y2 * height) / T < store->tiles_y[level] ? (int)(y2 * height) / T : store->tiles_y[level] - 1;
+
+				image_loader_tile_frame++;
+				int uploads = 0;
+
+				for (int ty = ty1; ty <= ty2; ty++) 
+				{
+					for (int tx = tx1; tx <= tx2 && count < max_count; tx++) 
+					{
+						// tiles which didn't fit into this frame's upload budget are skipped 
+						// (full version underneath is shown instead)
+						const GLuint texture = image_loader_tile_texture(shot_id, store, level, tx, ty, &uploads);
+						if (!texture) 
+						{
+							*pending = true;
+							continue;
+						}
+
+						const int 
+							right = (tx + 1) * T < width ? (tx + 1) * T : width, 
+							bottom = (ty + 1) * T < height ? (ty + 1) * T : height;
+
+						Image_Loader_Tile * const tile = tiles + count++;
+						tile->texture = texture; 
+						tile->x1 = tx * T / (double)width; 
+						tile->y1 = ty * T / (double)height; 
+						tile->x2 = right / (double)width; 
+						tile->y2 = bottom / (double)height; 
+						tile->texture_x = (right - tx * T) / (double)T; 
+						tile->texture_y = (bottom - ty * T) / (double)T;
+					}
+				}
+			}
+		}
+	}
+	UNLOCK_RW(image_loader);
+
+	return count;
+}
@@ -7,6 +7,7 @@
 #include "core_state.h"
 #include "core_debug.h"
 #include "core_structures.h"
+#include "core_image_store.h"
 #include <iostream>
 
 // specifies the desired quality of requested image
@@ -35,8 +36,28 @@ struct Image_Loader_Request
 	Image_Loader_Quality current_quality;
 	GLuint gl_texture_id;
 	Image_Loader_Quality gl_texture_quality;
+	int gl_texture_width, gl_texture_height;
+	int gl_texture_storage_width, gl_texture_storage_height; // size gl_texture_id was allocated with (it's kept if it fits)
 	double gl_texture_min_x, gl_texture_min_y, gl_texture_max_x, gl_texture_max_y;
 	IplImage * image;
+
+	// region requests don't copy pixels, they only view a rectangle of shot's image 
+	// until it's uploaded to opengl (unless the view had to be detached, see image_loader_detach_view)
+	bool image_owned;
+	int view_x, view_y, view_width, view_height;    // viewed rectangle in image pixels (trimmed to fit the image)
+	int view_offset_x, view_offset_y;               // where the rectangle goes in the texture
+	bool view_trimmed;                              // part of the requested region lies outside of the image 
+
+	// request is holding shot's low/full image in memory (counted in low_counter/full_counter)
+	bool low_reference, full_reference;
+
+	// streaming through pixel buffers (pixels are wanted by rendering thread or already copied into a buffer)
+	bool stream_wanted, staged;
+	size_t time; // time of the handle, used to check that handles of cancelled requests aren't used anymore
+
+	// scheduling (pending requests of a shot form a list ordered by age, urgent ones have nothing to show yet)
+	bool pending, urgent;
+	size_t pending_prev, pending_next;
 };
 
 DYNAMIC_STRUCTURE_DECLARATIONS(Image_Loader_Requests, Image_Loader_Request);
@@ -47,7 +68,9 @@ struct Image_Loader_Shot
 	bool set;
 
 	// flag used to suggest that this shot might be potencially needed in the future
+	// (it's image is then loaded when there's nothing else to do and released last)
 	bool suggested;
+	Image_Loader_Quality suggested_quality;
 
 	// image meta
 	const char * filename;
@@ -57,11 +80,25 @@ struct Image_Loader_Shot
 	IplImage * full;
 	GLuint full_texture; 
 	int full_counter, full_unprocessed_counter; 
+	int full_view_counter; // number of region requests viewing full version (and waiting for upload)
 
 	// low version 
 	IplImage * low; 
 	GLuint low_texture;
 	int low_counter, low_unprocessed_counter;
+	int low_view_counter;
+
+	// streaming through pixel buffers
+	bool full_stream_wanted, full_staged;
+	bool low_stream_wanted, low_staged;
+
+	// tiled store of very large image (used to display it in full detail)
+	Image_Store * store;
+
+	// scheduling (see Image_Loader_Request)
+	size_t pending_first, pending_last;
+	int pending_count, pending_urgent;
+	size_t queue_position; // position in the priority queue + 1, or 0 if the shot isn't queued
 };
 
 DYNAMIC_STRUCTURE_DECLARATIONS(Image_Loader_Shots, Image_Loader_Shot);
@@ -129,20 +166,61 @@ bool image_loader_opengl_upload_ready(
 	double * texture_min_x = NULL, double * texture_min_y = NULL, double * texture_max_x = NULL, double * texture_max_y = NULL
 );
 
+// quality of the texture currently uploaded for region request (it grows as better version gets loaded, 
+// so it can be used to tell that the texture returned by image_loader_opengl_upload_ready was replaced)
+Image_Loader_Quality image_loader_opengl_texture_quality(Image_Loader_Request_Handle handle);
+
 // uploads texture to opengl
 // note if there are more requests for one image, it's cause multiple uploads to opengl
+// note region requests are uploaded directly from shot's image (using GL_UNPACK_ROW_LENGTH) 
+// note if pixel buffers are supported, pixels are copied into them by loader thread and the texture 
+// appears a few frames later; calling this also finishes all transfers staged since the last call, 
+// so it has to be called by the rendering thread 
 void image_loader_upload_to_opengl(Image_Loader_Request_Handle handle);
 
 // get original dimensions of this request's image 
 void image_loader_get_original_dimensions(Image_Loader_Request_Handle handle, int * width, int * height);
 
+// shot and rectangle (relative image coordinates) requested by region request, returns false if 
+// the handle isn't valid anymore or doesn't belong to region request
+bool image_loader_get_region(Image_Loader_Request_Handle handle, size_t * shot_id, double * x1, double * y1, double * x2, double * y2);
+
 // flush texture ids
 void image_loader_flush_texture_ids();
 
+// suggest that shot's image will probably be needed soon (it's prefetched into the cache at low priority)
+void image_loader_suggest(const size_t shot_id, const char * const filename, const Image_Loader_Quality quality);
+
 // clear all suggested flags 
 void image_loaded_flush_suggested();
 
 // cancel all requests
 void image_loader_cancel_all_requests();
 
+// is the loader still processing some requests (or holding loaded pixels which weren't uploaded yet)
+bool image_loader_busy();
+
+// tile of shot's image uploaded to opengl 
+struct Image_Loader_Tile
+{
+	GLuint texture; 
+	double x1, y1, x2, y2;          // covered rectangle in relative image coordinates
+	double texture_x, texture_y;    // texture coordinates of the bottom right corner (border tiles are padded)
+};
+
+// enable or disable tiled stores for large images (they're created the first time the image is loaded)
+void image_loader_set_tiled(const bool tiled);
+bool image_loader_get_tiled();
+
+// textures of tiles covering rectangle x1, y1, x2, y2 (relative image coordinates) of request's image 
+// at a level with at least screen_width pixels across the rectangle; returns the number of tiles, 
+// which is zero if there's no store or the full version is detailed enough; tiles are uploaded 
+// only a few per call, so the first calls might return just some of them (pending is set then 
+// and the caller should draw another frame)
+// note must be called by the rendering thread 
+int image_loader_get_tiles(
+	Image_Loader_Request_Handle handle, double x1, double y1, double x2, double y2, const double screen_width, 
+	Image_Loader_Tile * tiles, const int max_count, bool * pending
+);
+
 #endif
@@ -0,0 +1,280 @@
+#include "core_image_store.h"
+
+// file header
+struct Image_Store_Header
+{
+	char magic[8];
+	int version; 
+	int width, height, levels, tile_size;
+};
+
+static const char IMAGE_STORE_MAGIC[8] = { 'I', '3', 'D', 'T', 'I', 'L', 'E', 'S' };
+static const int IMAGE_STORE_VERSION = 1;
+static const char * const IMAGE_STORE_EXTENSION = ".tiles";
+
+// fill in dimensions and offsets of levels 
+static bool image_store_layout(Image_Store * store)
+{
+	if (store->width <= 0 || store->height <= 0 || store->tile_size <= 0 || store->levels <= 0 || store->levels > IMAGE_STORE_MAX_LEVELS) 
+	{
+		return false;
+	}
+
+	const size_t tile_bytes = 3 * store->tile_size * store->tile_size;
+	size_t offset = sizeof(Image_Store_Header);
+	int width = store->width, height = store->height;
+
+	for (int level = 0; level < store->levels; level++)
+	{
+		store->level_width[level] = width; 
+		store->level_height[level] = height;
+		store->tiles_x[level] = (width + store->tile_size - 1) / store->tile_size;
+		store->tiles_y[level] = (height + store->tile_size - 1) / store->tile_size;
+		store->level_offset[level] = offset;
+		offset += tile_bytes * store->tiles_x[level] * store->tiles_y[level];
+
+		width = (width + 1) / 2; 
+		height = (height + 1) / 2;
+	}
+
+	// the file must contain all tiles 
+	return !store->mapping.data || store->mapping.size >= offset;
+}
+
+// number of levels needed for image of given size 
+static int image_store_levels_count(int width, int height)
+{
+	int levels = 1; 
+	while ((width > IMAGE_STORE_COARSEST_SIZE || height > IMAGE_STORE_COARSEST_SIZE) && levels < IMAGE_STORE_MAX_LEVELS) 
+	{
+		width = (width + 1) / 2; 
+		height = (height + 1) / 2;
+		levels++;
+	}
+
+	return levels;
+}
+
+// filename of the store belonging to the image (has to be freed)
+char * image_store_filename(const char * image_filename, bool * cached)
+{
+	// the store is identified by what the image contains and how it's tiled 
+	Cache_Key key; 
+	cache_key_init(key, "image_store", IMAGE_STORE_VERSION);
+	cache_key_add_int(key, IMAGE_STORE_TILE_SIZE); 
+	cache_key_add_int(key, IMAGE_STORE_COARSEST_SIZE);
+	char * filename = cache_key_add_file(key, image_filename) ? cache_filename(key, IMAGE_STORE_EXTENSION) : NULL;
+	if (cached) *cached = filename != NULL;
+	if (filename) return filename;
+
+	// there's no cache, the store goes next to the image 
+	filename = ALLOC(char, strlen(image_filename) + strlen(IMAGE_STORE_EXTENSION) + 1);
+	strcpy(filename, image_filename); 
+	strcat(filename, IMAGE_STORE_EXTENSION);
+	return filename;
+}
+
+// write tiles of one level 
+static bool image_store_write_level(FILE * f, const IplImage * image, unsigned char * tile)
+{
+	const int T = IMAGE_STORE_TILE_SIZE;
+
+	for (int ty = 0; ty < image->height; ty += T) 
+	{
+		for (int tx = 0; tx < image->width; tx += T)
+		{
+			const int 
+				w = tx + T <= image->width ? T : image->width - tx, 
+				h = ty + T <= image->height ? T : image->height - ty;
+
+			// border tiles are padded
+			if (w < T || h < T) memset(tile, 0, 3 * T * T);
+
+			for (int y = 0; y < h; y++) 
+			{
+				memcpy(tile + 3 * T * y, image->imageData + (ty + y) * image->widthStep + 3 * tx, 3 * w);
+			}
+
+			if (fwrite(tile, 3 * T * T, 1, f) != 1) return false;
+		}
+	}
+
+	return true;
+}
+
+// convert decoded image into tiled store, returns false if it couldn't be written 
+// expects LOCK_RW(opencv)
+bool image_store_create(const char * image_filename, const IplImage * image)
+{
+	if (image->nChannels != 3 || image->depth != IPL_DEPTH_8U) return false;
+
+	// write into temporary file first, so that nobody maps half-written store 
+	bool cached;
+	char * filename = image_store_filename(image_filename, &cached);
+	char * temporary = ALLOC(char, strlen(filename) + 5);
+	strcpy(temporary, filename);
+	strcat(temporary, ".tmp");
+
+	FILE * f = fopen(temporary, "wb"); 
+	if (!f) 
+	{
+		FREE(temporary);
+		FREE(filename);
+		return false;
+	}
+
+	Image_Store_Header header; 
+	memcpy(header.magic, IMAGE_STORE_MAGIC, sizeof(header.magic));
+	header.version = IMAGE_STORE_VERSION; 
+	header.width = image->width; 
+	header.height = image->height;
+	header.levels = image_store_levels_count(image->width, image->height);
+	header.tile_size = IMAGE_STORE_TILE_SIZE;
+
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+	unsigned char * tile = ALLOC(unsigned char, 3 * IMAGE_STORE_TILE_SIZE * IMAGE_STORE_TILE_SIZE);
+
+	// every level is computed from the previous one 
+	const IplImage * level = image; 
+	IplImage * allocated = NULL;
+	for (int i = 0; ok && i < header.levels; i++) 
+	{
+		if (i > 0) 
+		{
+			IplImage * half = cvCreateImage(cvSize((level->width + 1) / 2, (level->height + 1) / 2), IPL_DEPTH_8U, 3);
+			cvResize(level, half, CV_INTER_AREA);
+			if (allocated) cvReleaseImage(&allocated);
+			level = allocated = half;
+		}
+
+		ok = image_store_write_level(f, level, tile);
+	}
+
+	if (allocated) cvReleaseImage(&allocated);
+	FREE(tile);
+	ok = fclose(f) == 0 && ok;
+
+	// replace the old store 
+	if (ok) 
+	{
+		remove(filename);
+		ok = rename(temporary, filename) == 0;
+	}
+	
+	if (!ok) remove(temporary);
+	else if (cached) cache_commit(filename);
+
+	FREE(temporary);
+	FREE(filename);
+	return ok;
+}
+
+// open store of the image, returns NULL if there is none or it's older than the image
+Image_Store * image_store_open(const char * image_filename)
+{
+	bool cached;
+	char * filename = image_store_filename(image_filename, &cached);
+
+	// outdated stores are ignored (they'll be overwritten), the ones in the cache can't be outdated
+	bool current;
+	if (cached) 
+	{
+		current = cache_lookup(filename);
+	}
+	else
+	{
+		const time_t image_time = interface_filesystem_modification_time(image_filename);
+		const time_t store_time = interface_filesystem_modification_time(filename);
+		current = store_time != 0 && store_time >= image_time;
+	}
+
+	if (!current)
+	{
+		FREE(filename);
+		return NULL;
+	}
+
+	Image_Store * store = ALLOC(Image_Store, 1);
+	memset(store, 0, sizeof(Image_Store));
+	const bool mapped = interface_filesystem_map_file(filename, &store->mapping);
+	FREE(filename);
+
+	if (!mapped || store->mapping.size < sizeof(Image_Store_Header))
+	{
+		image_store_close(store);
+		return NULL;
+	}
+
+	// check the header
+	Image_Store_Header header; 
+	memcpy(&header, store->mapping.data, sizeof(header));
+	store->width = header.width; 
+	store->height = header.height; 
+	store->levels = header.levels; 
+	store->tile_size = header.tile_size;
+
+	if (
+		memcmp(header.magic, IMAGE_STORE_MAGIC, sizeof(header.magic)) != 0 || 
+		header.version != IMAGE_STORE_VERSION || 
+		!image_store_layout(store)
+	)
+	{
+		image_store_close(store);
+		return NULL;
+	}
+
+	return store;
+}
+
+// close the store 
+void image_store_close(Image_Store * store)
+{
+	if (!store) return;
+	interface_filesystem_unmap_file(&store->mapping);
+	FREE(store);
+}
+
+// pixels of one tile 
+const unsigned char * image_store_tile(const Image_Store * store, const int level, const int x, const int y)
+{
+	ASSERT(level >= 0 && level < store->levels && x >= 0 && x < store->tiles_x[level] && y >= 0 && y < store->tiles_y[level], "tile out of range");
+	const size_t tile_bytes = 3 * store->tile_size * store->tile_size;
+	return store->mapping.data + store->level_offset[level] + tile_bytes * (y * store->tiles_x[level] + x);
+}
+
+// coarsest level at least width x height pixels large (or level 0 if there is none)
+int image_store_level_for(const Image_Store * store, const int width, const int height)
+{
+	for (int level = store->levels - 1; level > 0; level--)
+	{
+		if (store->level_width[level] >= width && store->level_height[level] >= height) return level;
+	}
+
+	return 0;
+}
+
+// assemble the whole level into new image 
+// expects LOCK_RW(opencv)
+IplImage * image_store_read_level(const Image_Store * store, const int level)
+{
+	const int T = store->tile_size, width = store->level_width[level], height = store->level_height[level];
+	IplImage * image = cvCreateImage(cvSize(width, height), IPL_DEPTH_8U, 3);
+
+	for (int ty = 0; ty < store->tiles_y[level]; ty++)
+	{
+		for (int tx = 0; tx < store->tiles_x[level]; tx++)
+		{
+			const unsigned char * const tile = image_store_tile(store, level, tx, ty);
+			const int 
+				w = (tx + 1) * T <= width ? T : width - tx * T, 
+				h = (ty + 1) * T <= height ? T : height - ty * T;
+
+			for (int y = 0; y < h; y++)
+			{
+				memcpy(image->imageData + (ty * T + y) * image->widthStep + 3 * tx * T, tile + 3 * T * y, 3 * w);
+			}
+		}
+	}
+
+	return image;
+}
@@ -0,0 +1,55 @@
+#ifndef __CORE_IMAGE_STORE
+#define __CORE_IMAGE_STORE
+
+#include "interface_opencv.h"
+#include "interface_filesystem.h"
+#include "core_cache.h"
+#include "core_debug.h"
+#include "portability.h"
+
+// tiled image pyramid, stored in the project's cache (keyed by contents of the image, or in a
+// file next to the image if there's no cache) and memory-mapped when used; 
+// it allows us to load only the part of a very large photograph we actually need 
+// (level 0 is the original image, every next level has half the size, the coarsest 
+// level fits into IMAGE_STORE_COARSEST_SIZE; tiles are stored uncompressed in BGR and 
+// the tiles on right and bottom border are padded with zeros)
+
+const int IMAGE_STORE_TILE_SIZE = 256; 
+const int IMAGE_STORE_COARSEST_SIZE = 2048;
+const int IMAGE_STORE_MAX_LEVELS = 16;
+
+struct Image_Store
+{
+	int width, height, levels, tile_size;
+	int level_width[IMAGE_STORE_MAX_LEVELS], level_height[IMAGE_STORE_MAX_LEVELS]; 
+	int tiles_x[IMAGE_STORE_MAX_LEVELS], tiles_y[IMAGE_STORE_MAX_LEVELS];
+	size_t level_offset[IMAGE_STORE_MAX_LEVELS];
+	Filesystem_Mapping mapping;
+};
+
+// filename of the store belonging to the image (has to be freed), cached is set if it's
+// an entry of the cache
+char * image_store_filename(const char * image_filename, bool * cached = NULL);
+
+// convert decoded image into tiled store, returns false if it couldn't be written 
+// expects LOCK_RW(opencv)
+bool image_store_create(const char * image_filename, const IplImage * image);
+
+// open store of the image, returns NULL if there is none or it's older than the image
+// (stores in the cache are never outdated)
+Image_Store * image_store_open(const char * image_filename);
+
+// close the store 
+void image_store_close(Image_Store * store);
+
+// pixels of one tile (tile_size x tile_size BGR pixels, rows packed tightly)
+const unsigned char * image_store_tile(const Image_Store * store, const int level, const int x, const int y);
+
+// coarsest level at least width x height pixels large (or level 0 if there is none)
+int image_store_level_for(const Image_Store * store, const int width, const int height);
+
+// assemble the whole level into new image 
+// expects LOCK_RW(opencv)
+IplImage * image_store_read_level(const Image_Store * store, const int level);
+
+#endif
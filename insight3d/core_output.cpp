@@ -0,0 +1,294 @@
+#include "core_output.h"
+
+// writer thread - writes out buffers handed over by output_flush
+static void * output_thread_function(void * arg)
+{
+	Output_File * const out = (Output_File *)arg;
+
+	pthread_mutex_lock(&out->mutex);
+	while (true)
+	{
+		while (!out->pending && !out->terminate) pthread_cond_wait(&out->condition, &out->mutex);
+		if (!out->pending) break;
+
+		// write without holding the lock, so that the caller can keep formatting
+		char * const data = out->pending;
+		const size_t size = out->pending_size;
+		pthread_mutex_unlock(&out->mutex);
+		const bool ok = fwrite(data, 1, size, out->file) == size;
+		pthread_mutex_lock(&out->mutex);
+
+		if (!ok) out->failed = true;
+		out->pending = NULL;
+		pthread_cond_broadcast(&out->condition);
+	}
+	pthread_mutex_unlock(&out->mutex);
+
+	return NULL;
+}
+
+// wait until writer thread is done with the pending buffer
+static void output_wait(Output_File * out)
+{
+	if (!out->background) return;
+
+	pthread_mutex_lock(&out->mutex);
+	while (out->pending) pthread_cond_wait(&out->condition, &out->mutex);
+	pthread_mutex_unlock(&out->mutex);
+}
+
+// open file for writing, returns NULL on failure
+Output_File * output_open(const char * filename, const bool background /*= false*/)
+{
+	FILE * file = fopen(filename, "wb");
+	if (!file) return NULL;
+
+	// we do the buffering ourselves
+	setvbuf(file, NULL, _IONBF, 0);
+
+	Output_File * out = ALLOC(Output_File, 1);
+	memset(out, 0, sizeof(Output_File));
+	out->file = file;
+	out->buffers[0] = ALLOC(char, OUTPUT_BUFFER_SIZE);
+	out->buffer = out->buffers[0];
+
+	if (background)
+	{
+		out->buffers[1] = ALLOC(char, OUTPUT_BUFFER_SIZE);
+		pthread_mutex_init(&out->mutex, NULL);
+		pthread_cond_init(&out->condition, NULL);
+		out->background = pthread_create(&out->thread, NULL, output_thread_function, out) == 0;
+
+		// without the thread we simply write on our own
+		if (!out->background)
+		{
+			pthread_cond_destroy(&out->condition);
+			pthread_mutex_destroy(&out->mutex);
+		}
+	}
+
+	return out;
+}
+
+// write out everything and close the file, returns false if any write failed
+bool output_close(Output_File * out)
+{
+	output_flush(out);
+
+	if (out->background)
+	{
+		pthread_mutex_lock(&out->mutex);
+		out->terminate = true;
+		pthread_cond_broadcast(&out->condition);
+		pthread_mutex_unlock(&out->mutex);
+
+		pthread_join(out->thread, NULL);
+		pthread_cond_destroy(&out->condition);
+		pthread_mutex_destroy(&out->mutex);
+	}
+
+	const bool ok = !out->failed && !ferror(out->file);
+	const bool closed = fclose(out->file) == 0;
+
+	FREE(out->buffers[0]);
+	FREE(out->buffers[1]);
+	FREE(out);
+
+	return ok && closed;
+}
+
+// limit number of significant digits of doubles (0 restores exact output)
+void output_set_precision(Output_File * out, const int precision)
+{
+	out->precision = precision;
+}
+
+// hand the buffer to the file (or the writer thread)
+void output_flush(Output_File * out)
+{
+	if (!out->used) return;
+
+	if (!out->background)
+	{
+		if (fwrite(out->buffer, 1, out->used, out->file) != out->used) out->failed = true;
+		out->used = 0;
+		return;
+	}
+
+	// previous buffer has to be written before we hand over this one
+	pthread_mutex_lock(&out->mutex);
+	while (out->pending) pthread_cond_wait(&out->condition, &out->mutex);
+	out->pending = out->buffer;
+	out->pending_size = out->used;
+	pthread_cond_broadcast(&out->condition);
+	pthread_mutex_unlock(&out->mutex);
+
+	// and continue with the other one
+	out->buffer = out->buffer == out->buffers[0] ? out->buffers[1] : out->buffers[0];
+	out->used = 0;
+}
+
+// make room for size bytes (at most OUTPUT_BUFFER_SIZE) and return where to put them
+static inline char * output_reserve(Output_File * out, const size_t size)
+{
+	if (out->used + size > OUTPUT_BUFFER_SIZE) output_flush(out);
+	return out->buffer + out->used;
+}
+
+// raw bytes
+void output_write(Output_File * out, const void * data, const size_t size)
+{
+	if (size > OUTPUT_BUFFER_SIZE)
+	{
+		// too big to be buffered, write it directly after everything before it
+		output_flush(out);
+		output_wait(out);
+		if (fwrite(data, 1, size, out->file) != size) out->failed = true;
+		return;
+	}
+
+	memcpy(output_reserve(out, size), data, size);
+	out->used += size;
+}
+
+// string
+void output_string(Output_File * out, const char * s)
+{
+	output_write(out, s, strlen(s));
+}
+
+// single character
+void output_char(Output_File * out, const char c)
+{
+	*output_reserve(out, 1) = c;
+	out->used++;
+}
+
+// integers
+void output_int(Output_File * out, const long long value)
+{
+	if (value < 0)
+	{
+		output_char(out, '-');
+
+		// careful about the most negative value
+		output_size(out, (size_t)(-(value + 1)) + 1);
+	}
+	else
+	{
+		output_size(out, (size_t)value);
+	}
+}
+
+void output_size(Output_File * out, size_t value)
+{
+	char digits[24], * p = digits + sizeof(digits);
+	do
+	{
+		*--p = '0' + (char)(value % 10);
+		value /= 10;
+	}
+	while (value);
+
+	output_write(out, p, digits + sizeof(digits) - p);
+}
+
+// printf follows the locale (which gtk may have changed), files always use decimal point
+static int output_decimal_point(char * buffer, const int length)
+{
+	const char decimal_point = localeconv()->decimal_point[0];
+	if (decimal_point != '.' && length > 0)
+	{
+		char * const p = (char *)memchr(buffer, decimal_point, length);
+		if (p) *p = '.';
+	}
+
+	return length;
+}
+
+// double formatted so that it parses back to the same value
+int output_format_double(char * buffer, const double value)
+{
+	// integral values are common (zeros, flags, pixel sizes) and don't need printf
+	if (fabs(value) < 9007199254740992.0 && value == floor(value) && !(value == 0 && signbit(value)))
+	{
+		long long integer = (long long)value;
+		char digits[24], * p = digits + sizeof(digits);
+		const bool negative = integer < 0;
+		if (negative) integer = -integer;
+
+		do
+		{
+			*--p = '0' + (char)(integer % 10);
+			integer /= 10;
+		}
+		while (integer);
+
+		if (negative) *--p = '-';
+		const int length = (int)(digits + sizeof(digits) - p);
+		memcpy(buffer, p, length);
+		buffer[length] = '\0';
+		return length;
+	}
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+	// shortest digits in a single pass
+	const std::to_chars_result result = std::to_chars(buffer, buffer + 31, value);
+	*result.ptr = '\0';
+	return (int)(result.ptr - buffer);
+#else
+	// 17 significant digits are always enough
+	return output_decimal_point(buffer, snprintf(buffer, 32, "%.17g", value));
+#endif
+}
+
+void output_double(Output_File * out, const double value)
+{
+	char * const p = output_reserve(out, 32);
+	if (out->precision > 0 && out->precision < 18 && value != floor(value))
+	{
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+		const std::to_chars_result result = std::to_chars(p, p + 31, value, std::chars_format::general, out->precision);
+		out->used += result.ptr - p;
+#else
+		out->used += output_decimal_point(p, snprintf(p, 32, "%.*g", out->precision, value));
+#endif
+	}
+	else
+	{
+		out->used += output_format_double(p, value);
+	}
+}
+
+// printf-style formatting (for the odd line that isn't worth splitting into calls)
+void output_printf(Output_File * out, const char * format, ...)
+{
+	va_list arguments;
+	va_start(arguments, format);
+	char * p = output_reserve(out, 1024);
+	va_list copy;
+	va_copy(copy, arguments);
+	int length = vsnprintf(p, OUTPUT_BUFFER_SIZE - out->used, format, copy);
+	va_end(copy);
+
+	if (length >= 0 && (size_t)length >= OUTPUT_BUFFER_SIZE - out->used)
+	{
+		// didn't fit
+		output_flush(out);
+		if ((size_t)length < OUTPUT_BUFFER_SIZE)
+		{
+			length = vsnprintf(out->buffer, OUTPUT_BUFFER_SIZE, format, arguments);
+		}
+		else
+		{
+			char * s = ALLOC(char, length + 1);
+			vsnprintf(s, length + 1, format, arguments);
+			output_write(out, s, length);
+			FREE(s);
+			length = 0;
+		}
+	}
+
+	if (length > 0) out->used += length;
+	va_end(arguments);
+}
@@ -0,0 +1,75 @@
+#ifndef __CORE_OUTPUT
+#define __CORE_OUTPUT
+
+#include "core_structures.h"
+#include "core_debug.h"
+#include "portability.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <locale.h>
+
+// shortest round-trip formatting of doubles comes from the standard library where it has it
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+// buffered text and binary output shared by project saving and exporters; values are
+// formatted straight into a large buffer, which is written out when it fills up (optionally
+// by a background thread, while the caller keeps formatting into the second buffer); doubles
+// are written so that they read back to the same value
+
+const size_t OUTPUT_BUFFER_SIZE = 1 << 20;
+
+struct Output_File
+{
+	FILE * file;
+	char * buffers[2];
+	char * buffer;                              // buffer being filled
+	size_t used;
+	bool failed;
+	int precision;                              // significant digits of doubles (0 means as many as needed to read them back)
+
+	// background writing
+	bool background, terminate;
+	char * pending;                             // buffer handed to the writer thread (NULL if none)
+	size_t pending_size;
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t condition;
+};
+
+// open file for writing, returns NULL on failure
+Output_File * output_open(const char * filename, const bool background = false);
+
+// write out everything and close the file, returns false if any write failed
+bool output_close(Output_File * out);
+
+// limit number of significant digits of doubles (0 restores exact output)
+void output_set_precision(Output_File * out, const int precision);
+
+// hand the buffer to the file (or the writer thread)
+void output_flush(Output_File * out);
+
+// raw bytes
+void output_write(Output_File * out, const void * data, const size_t size);
+
+// text
+void output_string(Output_File * out, const char * s);
+void output_char(Output_File * out, const char c);
+void output_int(Output_File * out, const long long value);
+void output_size(Output_File * out, const size_t value);
+void output_double(Output_File * out, const double value);
+
+// note printf follows the locale (which gtk may have changed), so doubles should be written by output_double
+void output_printf(Output_File * out, const char * format, ...);
+
+// double formatted so that it parses back to the same value - with the fewest significant digits
+// if the standard library provides std::to_chars, otherwise with 17 (buffer has to hold at least
+// 32 characters), returns the length
+int output_format_double(char * buffer, const double value);
+
+#endif
@@ -0,0 +1,282 @@
+#include "core_parser.h"
+#include <locale.h>
+#ifdef LINUX
+#include <unistd.h>
+#endif
+
+// powers of ten exactly representable as doubles
+static const double parser_powers[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// text is split into chunks of at least this size
+static const size_t PARSER_CHUNK_MIN_SIZE = 1 << 18;
+static const int PARSER_MAX_THREADS = 32;
+
+// skip spaces and tabs (not line ends)
+void parser_skip_spaces(const char *& p, const char * const end)
+{
+	while (p < end && (*p == ' ' || *p == '\t')) p++;
+}
+
+// skip to the beginning of the next line
+void parser_skip_line(const char *& p, const char * const end)
+{
+	const char * const line_end = (const char *)memchr(p, '\n', end - p);
+	p = line_end ? line_end + 1 : end;
+}
+
+// parse number, returns false if there isn't any
+bool parser_double(const char *& p, const char * const end, double & value)
+{
+	const char * s = p;
+	const bool negative = s < end && *s == '-';
+	if (s < end && (*s == '-' || *s == '+')) s++;
+
+	// collect digits into integer mantissa
+	unsigned long long mantissa = 0;
+	int significant = 0, exponent = 0;
+	bool any = false;
+	while (s < end && *s >= '0' && *s <= '9')
+	{
+		if (significant < 19) mantissa = mantissa * 10 + (*s - '0'); else exponent++;
+		if (mantissa) significant++;
+		any = true;
+		s++;
+	}
+
+	if (s < end && *s == '.')
+	{
+		s++;
+		while (s < end && *s >= '0' && *s <= '9')
+		{
+			if (significant < 19)
+			{
+				mantissa = mantissa * 10 + (*s - '0');
+				exponent--;
+			}
+			if (mantissa) significant++;
+			any = true;
+			s++;
+		}
+	}
+
+	if (!any) return false;
+
+	// exponent (only if there are digits after it)
+	if (s + 1 < end && (*s == 'e' || *s == 'E'))
+	{
+		const char * e = s + 1;
+		const bool negative_exponent = *e == '-';
+		if (*e == '-' || *e == '+') e++;
+
+		if (e < end && *e >= '0' && *e <= '9')
+		{
+			int n = 0;
+			while (e < end && *e >= '0' && *e <= '9')
+			{
+				if (n < 100000) n = n * 10 + (*e - '0');
+				e++;
+			}
+
+			exponent += negative_exponent ? -n : n;
+			s = e;
+		}
+	}
+
+	// mantissa and power of ten are both exact, so is the result of a single operation
+	if (significant <= 19 && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+	{
+		value = exponent >= 0 ? (double)mantissa * parser_powers[exponent] : (double)mantissa / parser_powers[-exponent];
+		if (negative) value = -value;
+		p = s;
+		return true;
+	}
+
+	// otherwise let the library round it correctly
+	char local[128], * buffer = local;
+	const size_t length = s - p;
+	if (length >= sizeof(local)) buffer = ALLOC(char, length + 1);
+	memcpy(buffer, p, length);
+	buffer[length] = '\0';
+
+	// strtod follows the locale (which gtk may have changed)
+	const char decimal_point = localeconv()->decimal_point[0];
+	if (decimal_point != '.')
+	{
+		char * dot = strchr(buffer, '.');
+		if (dot) *dot = decimal_point;
+	}
+
+	value = strtod(buffer, NULL);
+	if (buffer != local) FREE(buffer);
+	p = s;
+	return true;
+}
+
+// parse non-negative integer, returns false if there isn't any
+bool parser_size(const char *& p, const char * const end, size_t & value)
+{
+	const char * s = p;
+	if (s < end && *s == '+') s++;
+	if (s >= end || *s < '0' || *s > '9') return false;
+
+	value = 0;
+	while (s < end && *s >= '0' && *s <= '9')
+	{
+		const size_t next = value * 10 + (*s - '0');
+		if (next / 10 != value) return false;
+		value = next;
+		s++;
+	}
+
+	p = s;
+	return true;
+}
+
+// work of one parsing thread
+struct Parser_Chunk
+{
+	const char * begin, * end;
+	int columns;
+	double * values;
+	size_t rows;
+	bool malformed;
+	pthread_t thread;
+};
+
+// parse rows of one chunk
+static void * parser_chunk_function(void * arg)
+{
+	Parser_Chunk * const chunk = (Parser_Chunk *)arg;
+	const char * p = chunk->begin, * const end = chunk->end;
+
+	// count lines to know how much space we need
+	size_t lines = 1;
+	for (const char * q = p; (q = (const char *)memchr(q, '\n', end - q)); q++) lines++;
+	chunk->values = ALLOC(double, lines * chunk->columns);
+	chunk->rows = 0;
+	chunk->malformed = false;
+
+	while (p < end)
+	{
+		// skip empty lines
+		parser_skip_spaces(p, end);
+		if (p >= end) break;
+		if (*p == '\n' || *p == '\r')
+		{
+			parser_skip_line(p, end);
+			continue;
+		}
+
+		double * const row = chunk->values + chunk->rows * chunk->columns;
+		for (int i = 0; i < chunk->columns; i++)
+		{
+			parser_skip_spaces(p, end);
+			if (!parser_double(p, end, row[i]))
+			{
+				chunk->malformed = true;
+				return NULL;
+			}
+		}
+
+		chunk->rows++;
+		parser_skip_line(p, end);
+	}
+
+	return NULL;
+}
+
+// number of processors to split the work among
+int parser_processors()
+{
+#ifdef LINUX
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int)count : 1;
+#else
+	const char * const count = getenv("NUMBER_OF_PROCESSORS");
+	return count && atoi(count) > 0 ? atoi(count) : 1;
+#endif
+}
+
+// parse table, splitting the text into chunks parsed in parallel
+bool parser_table(const char * const data, const size_t size, const int columns, Parser_Table & table)
+{
+	memset(&table, 0, sizeof(table));
+	table.columns = columns;
+
+	// split at line ends
+	int count = parser_processors();
+	if (count > PARSER_MAX_THREADS) count = PARSER_MAX_THREADS;
+	if ((size_t)count > size / PARSER_CHUNK_MIN_SIZE + 1) count = (int)(size / PARSER_CHUNK_MIN_SIZE + 1);
+
+	Parser_Chunk chunks[PARSER_MAX_THREADS];
+	const char * begin = data, * const end = data + size;
+	int chunks_count = 0;
+	for (int i = 0; i < count && begin < end; i++)
+	{
+		const char * chunk_end = i + 1 == count ? end : data + size / count * (i + 1);
+		if (chunk_end < begin) chunk_end = begin;
+		parser_skip_line(chunk_end, end);
+
+		Parser_Chunk * const chunk = chunks + chunks_count++;
+		chunk->begin = begin;
+		chunk->end = chunk_end;
+		chunk->columns = columns;
+		begin = chunk_end;
+	}
+
+	// parse them (the first one on this thread)
+	bool threaded[PARSER_MAX_THREADS];
+	for (int i = 1; i < chunks_count; i++)
+	{
+		threaded[i] = pthread_create(&chunks[i].thread, NULL, parser_chunk_function, chunks + i) == 0;
+	}
+
+	if (chunks_count > 0) parser_chunk_function(chunks);
+
+	for (int i = 1; i < chunks_count; i++)
+	{
+		if (threaded[i]) pthread_join(chunks[i].thread, NULL); else parser_chunk_function(chunks + i);
+	}
+
+	// join the rows up to the first malformed line
+	table.complete = true;
+	int used = 0;
+	for (; used < chunks_count; used++)
+	{
+		table.rows += chunks[used].rows;
+		if (chunks[used].malformed)
+		{
+			table.complete = false;
+			used++;
+			break;
+		}
+	}
+
+	table.values = ALLOC(double, table.rows * columns + 1);
+	bool ok = table.values != NULL;
+	size_t row = 0;
+	for (int i = 0; i < chunks_count; i++)
+	{
+		if (ok && i < used)
+		{
+			memcpy(table.values + row * columns, chunks[i].values, sizeof(double) * chunks[i].rows * columns);
+			row += chunks[i].rows;
+		}
+
+		FREE(chunks[i].values);
+	}
+
+	if (!ok) memset(&table, 0, sizeof(table));
+	return ok;
+}
+
+// release values of the table
+void parser_table_free(Parser_Table & table)
+{
+	FREE(table.values);
+	table.values = NULL;
+	table.rows = 0;
+}
@@ -0,0 +1,46 @@
+#ifndef __CORE_PARSER
+#define __CORE_PARSER
+
+#include "core_debug.h"
+#include "portability.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// fast parsing of numbers from text held in memory (typically a mapped file, so the text
+// doesn't have to be zero terminated); numbers are parsed by hand whenever the result is
+// exact and with strtod otherwise, so the values are the same as from iostream
+
+// skip spaces and tabs (not line ends)
+void parser_skip_spaces(const char *& p, const char * const end);
+
+// skip to the beginning of the next line
+void parser_skip_line(const char *& p, const char * const end);
+
+// parse number, returns false if there isn't any
+bool parser_double(const char *& p, const char * const end, double & value);
+
+// number of processors to split the work among
+int parser_processors();
+
+// parse non-negative integer, returns false if there isn't any
+bool parser_size(const char *& p, const char * const end, size_t & value);
+
+// table of numbers, one row per line (empty lines are skipped, anything after the last
+// column is ignored)
+struct Parser_Table
+{
+	double * values; // rows * columns
+	size_t rows;
+	int columns;
+	bool complete;   // false if parsing stopped at a malformed line
+};
+
+// parse table, splitting the text into chunks parsed in parallel
+// note rows are counted first so that every chunk allocates its values just once
+bool parser_table(const char * const data, const size_t size, const int columns, Parser_Table & table);
+
+// release values of the table
+void parser_table_free(Parser_Table & table);
+
+#endif
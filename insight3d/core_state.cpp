@@ -3,7 +3,7 @@
 Core_State core_state;
 
 // initialize core state
-bool core_initialize()
+bool core_initialize(const bool headless)
 {
 	memset(&core_state, 0, sizeof(core_state));
 
@@ -12,6 +12,7 @@ bool core_initialize()
 	core_state.last_ticks = SDL_GetTicks(); 
 	core_state.ticks = SDL_GetTicks(); 
 	core_state.running = true; 
+	core_state.headless = headless;
 
 	return true;
 }
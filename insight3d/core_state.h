@@ -22,6 +22,7 @@ struct Core_State
 	bool mouse_focus;
 	bool keyboard_focus;
 	Uint32 ticks, last_ticks;
+	bool headless; // running without user interface (benchmarks)
 
 	// error management
 	CORE_ERROR error;
@@ -34,6 +35,6 @@ extern Core_State core_state;
 #define CHECK_ERROR(condition, error_code) if ((condition)) { core_state.error = (error_code); return false; }
 
 // initialize core state
-bool core_initialize();
+bool core_initialize(const bool headless = false);
 
 #endif
@@ -20,6 +20,7 @@
 #define DYN_INIT(variable_name) (dyn_initialize(&(variable_name)))
 #define DYN_FREE(variable_name) (dyn_free(&(variable_name)))
 #define DYN(variable_name, index) (dyn(&(variable_name), (index)))
+#define DYN_RESERVE(variable_name, count) (dyn_reserve(&(variable_name), (count)))
 #define ADD(variable_name) (DYN((variable_name), ((variable_name).count)))
 #define LAST(variable_name) ((variable_name).data[((variable_name).count) - 1])
 #define LAST_INDEX(variable_name) (((variable_name).count) - 1)
@@ -48,6 +49,7 @@ extern pthread_mutex_t print_mutex;
 #define UNLOCK_RW(resource) pthread_mutex_unlock(&(resource##_mutex));
 #define UNLOCK_R(resource) pthread_mutex_unlock(&(resource##_mutex));
 #define UNLOCK(resource) UNLOCK_RW(resource)
+#define TRYLOCK(resource) (pthread_mutex_trylock(&(resource##_mutex)) == 0)
 #define UPGRADE_TO_RW(resource)
 #define WAS_UNLOCKED_RW(resource) 
 #define WAS_UNLOCKED_R(resource)
@@ -65,6 +67,7 @@ struct structure_name { \
 void dyn_initialize(structure_name * dynamic_structure); \
 void dyn_free(structure_name * dynamic_structure); \
 structure_name * dyn(structure_name * dynamic_structure, size_t index); \
+bool dyn_reserve(structure_name * dynamic_structure, size_t count); \
 size_t dyn_next(const structure_name & dynamic_structure, const size_t from); \
 size_t dyn_first(const structure_name & dynamic_structure); \
 size_t * dyn_build_reindex(const structure_name & dynamic_structure);
@@ -128,6 +131,22 @@ structure_name * dyn(structure_name * dynamic_structure, size_t index) \
 	} \
 }\
 \
+bool dyn_reserve(structure_name * dynamic_structure, size_t count) \
+{ \
+	if (count <= dynamic_structure->allocated) return true; \
+\
+	structure_type * q; \
+	if (NULL == (q = (structure_type *)realloc(dynamic_structure->data, count * sizeof(structure_type)))) \
+	{ \
+		return false; \
+	} \
+\
+	memset(q + dynamic_structure->allocated, 0, (count - dynamic_structure->allocated) * sizeof(structure_type)); \
+	dynamic_structure->data = q; \
+	dynamic_structure->allocated = count; \
+	return true; \
+} \
+\
 size_t dyn_next(const structure_name & dynamic_structure, const size_t from)\
 {\
 	for (size_t i = from; i < dynamic_structure.count; ++i) if (dynamic_structure.data[i].set)\
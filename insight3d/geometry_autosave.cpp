@@ -0,0 +1,1003 @@
+#include "geometry_autosave.h"
+
+// shot copied for the writer thread
+struct Geometry_Autosave_Shot
+{
+	bool set;
+	Geometry_Project_Shot record;
+	char * image_filename, * name;
+};
+
+// polygon copied for the writer thread (its vertex ids are in the block's pool)
+struct Geometry_Autosave_Polygon
+{
+	bool set;
+	size_t first, count;
+};
+
+// copies of items [from, to) of some kind (points are copied per shot)
+struct Geometry_Autosave_Block
+{
+	GEOMETRY_CHANGE kind;
+	size_t shot_id, from, to;
+	void * items;                      // Vertex, Point, Geometry_Autosave_Shot or Geometry_Autosave_Polygon
+	unsigned long long * ids;          // vertex ids of polygons
+};
+
+// items copied by the main thread and handed to the writer thread, which serializes them into records
+struct Geometry_Autosave_Batch
+{
+	// main thread
+	Geometry_Autosave_Block * blocks;
+	size_t blocks_count, blocks_allocated;
+	char * filename;                   // set if the batch is a snapshot replacing the journal
+
+	// writer thread
+	char * data;
+	size_t size, allocated;
+	size_t start;                      // checksummed part starts here (after file header)
+
+	bool failed;                       // ran out of memory
+	Geometry_Autosave_Batch * next;
+};
+
+// autosave state
+struct Geometry_Autosave
+{
+	bool enabled;
+
+	// main thread
+	char * filename;                   // journal of the current project
+	size_t version;                    // version of geometric data autosaved so far
+	bool snapshot;                     // next autosave has to rewrite the journal
+	Uint32 last_ticks;
+
+	// shared with the writer thread
+	Geometry_Autosave_Batch * queue, * queue_last;
+	bool terminate, failed, compact;
+	pthread_t thread;
+	pthread_cond_t condition;
+
+	// writer thread only
+	FILE * writer_file;
+	char * writer_filename;
+	size_t snapshot_size, appended_size;
+};
+
+static Geometry_Autosave geometry_autosave;
+static pthread_mutex_t geometry_autosave_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// * journal records *
+
+// checksum of committed batch (FNV-1a)
+static unsigned long long geometry_autosave_checksum(const char * data, const size_t size)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+// filename with extension appended (has to be freed)
+static char * geometry_autosave_filename(const char * filename, const char * extension)
+{
+	char * result = ALLOC(char, strlen(filename) + strlen(extension) + 1);
+	strcpy(result, filename);
+	strcat(result, extension);
+	return result;
+}
+
+// new batch (snapshot if filename is given)
+static Geometry_Autosave_Batch * geometry_autosave_new_batch(const char * filename)
+{
+	Geometry_Autosave_Batch * batch = ALLOC(Geometry_Autosave_Batch, 1);
+	memset(batch, 0, sizeof(Geometry_Autosave_Batch));
+	if (filename) batch->filename = strdup(filename);
+	return batch;
+}
+
+// release copied items (they aren't needed once they're serialized)
+static void geometry_autosave_free_blocks(Geometry_Autosave_Batch * batch)
+{
+	for (size_t i = 0; i < batch->blocks_count; i++)
+	{
+		Geometry_Autosave_Block * const block = batch->blocks + i;
+		if (block->kind == GEOMETRY_CHANGE_SHOTS && block->items)
+		{
+			Geometry_Autosave_Shot * const shots_copy = (Geometry_Autosave_Shot *)block->items;
+			for (size_t j = 0; j < block->to - block->from; j++)
+			{
+				FREE(shots_copy[j].image_filename);
+				FREE(shots_copy[j].name);
+			}
+		}
+
+		FREE(block->items);
+		FREE(block->ids);
+	}
+
+	FREE(batch->blocks);
+	batch->blocks = NULL;
+	batch->blocks_count = batch->blocks_allocated = 0;
+}
+
+static void geometry_autosave_free_batch(Geometry_Autosave_Batch * batch)
+{
+	geometry_autosave_free_blocks(batch);
+	FREE(batch->data);
+	FREE(batch->filename);
+	FREE(batch);
+}
+
+// append record to the batch and return where to put its payload (NULL if we're out of memory)
+static char * geometry_autosave_record(
+	Geometry_Autosave_Batch * batch, const unsigned int type, const size_t id, const size_t shot_id,
+	const size_t size, const bool deleted = false
+)
+{
+	if (batch->failed) return NULL;
+
+	const size_t padded = (size + 7) / 8 * 8;
+	const size_t needed = batch->size + sizeof(Geometry_Autosave_Record) + padded;
+	if (needed > batch->allocated)
+	{
+		size_t allocated = batch->allocated > 0 ? batch->allocated : 1 << 12;
+		while (allocated < needed) allocated *= 2;
+
+		char * const data = (char *)realloc(batch->data, allocated);
+		if (!data)
+		{
+			batch->failed = true;
+			return NULL;
+		}
+
+		batch->data = data;
+		batch->allocated = allocated;
+	}
+
+	Geometry_Autosave_Record * const record = (Geometry_Autosave_Record *)(batch->data + batch->size);
+	memset(record, 0, sizeof(Geometry_Autosave_Record));
+	record->type = type;
+	record->flags = deleted ? GEOMETRY_AUTOSAVE_DELETED : 0;
+	record->id = id;
+	record->shot_id = shot_id;
+	record->size = size;
+
+	char * const payload = (char *)(record + 1);
+	memset(payload + size, 0, padded - size);
+	batch->size = needed;
+
+	return payload;
+}
+
+// * copying items (main thread) *
+
+// copy items [from, to) of given kind into new block
+// expects LOCK(geometry)
+static void geometry_autosave_block(Geometry_Autosave_Batch * batch, const GEOMETRY_CHANGE kind, const size_t from, size_t to, const size_t shot_id = 0)
+{
+	if (batch->failed) return;
+
+	// items might have been removed since the change was recorded
+	size_t count;
+	switch (kind)
+	{
+		case GEOMETRY_CHANGE_VERTICES: count = vertices.count; break;
+		case GEOMETRY_CHANGE_POINTS: count = IS_SET(shots, shot_id) ? shots.data[shot_id].points.count : 0; break;
+		case GEOMETRY_CHANGE_SHOTS: count = shots.count; break;
+		case GEOMETRY_CHANGE_POLYGONS: count = polygons.count; break;
+		default: return; // calibrations are intermediate results, what comes out of them is recorded as changes of shots and vertices
+	}
+
+	if (to > count) to = count;
+	if (from >= to) return;
+
+	if (batch->blocks_count == batch->blocks_allocated)
+	{
+		const size_t allocated = batch->blocks_allocated > 0 ? 2 * batch->blocks_allocated : 16;
+		Geometry_Autosave_Block * const blocks = (Geometry_Autosave_Block *)realloc(batch->blocks, allocated * sizeof(Geometry_Autosave_Block));
+		if (!blocks)
+		{
+			batch->failed = true;
+			return;
+		}
+
+		batch->blocks = blocks;
+		batch->blocks_allocated = allocated;
+	}
+
+	Geometry_Autosave_Block * const block = batch->blocks + batch->blocks_count++;
+	memset(block, 0, sizeof(Geometry_Autosave_Block));
+	block->kind = kind;
+	block->shot_id = shot_id;
+	block->from = from;
+	block->to = to;
+	count = to - from;
+
+	switch (kind)
+	{
+		case GEOMETRY_CHANGE_VERTICES:
+		{
+			// plain structures, copied as they are
+			block->items = ALLOC(Vertex, count);
+			if (block->items) memcpy(block->items, vertices.data + from, count * sizeof(Vertex));
+			break;
+		}
+
+		case GEOMETRY_CHANGE_POINTS:
+		{
+			block->items = ALLOC(Point, count);
+			if (block->items) memcpy(block->items, shots.data[shot_id].points.data + from, count * sizeof(Point));
+			break;
+		}
+
+		case GEOMETRY_CHANGE_SHOTS:
+		{
+			// there are just a few shots, so they're converted right away
+			Geometry_Autosave_Shot * const shots_copy = ALLOC(Geometry_Autosave_Shot, count);
+			block->items = shots_copy;
+			if (!shots_copy) break;
+			memset(shots_copy, 0, count * sizeof(Geometry_Autosave_Shot));
+
+			for (size_t i = 0; i < count; i++)
+			{
+				const Shot * const shot = shots.data + from + i;
+				Geometry_Autosave_Shot * const copy = shots_copy + i;
+				copy->set = shot->set;
+				if (!copy->set) continue;
+
+				Geometry_Project_Shot * const record = &copy->record;
+				record->f = shot->f;
+				record->film_back = shot->film_back;
+				record->fovx = shot->fovx;
+				record->fovy = shot->fovy;
+				record->pp_x = shot->pp_x;
+				record->pp_y = shot->pp_y;
+				record->width = shot->width;
+				record->height = shot->height;
+				record->calibrated = shot->calibrated;
+				record->resected = shot->resected;
+				record->info_status = shot->info_status;
+
+				if (shot->projection)
+				{
+					for (int k = 0; k < 12; k++) record->P[k] = OPENCV_ELEM(shot->projection, k / 4, k % 4);
+				}
+
+				copy->image_filename = strdup(shot->image_filename ? shot->image_filename : "");
+				copy->name = strdup(shot->name ? shot->name : "");
+				if (!copy->image_filename || !copy->name) batch->failed = true;
+			}
+			break;
+		}
+
+		case GEOMETRY_CHANGE_POLYGONS:
+		{
+			Geometry_Autosave_Polygon * const polygons_copy = ALLOC(Geometry_Autosave_Polygon, count);
+			block->items = polygons_copy;
+			if (!polygons_copy) break;
+
+			size_t ids_count = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				const Polygon_3d * const polygon = polygons.data + from + i;
+				Geometry_Autosave_Polygon * const copy = polygons_copy + i;
+				copy->set = polygon->set;
+				copy->first = ids_count;
+				copy->count = 0;
+				if (!copy->set) continue;
+				for ALL(polygon->vertices, j) copy->count++;
+				ids_count += copy->count;
+			}
+
+			block->ids = ALLOC(unsigned long long, ids_count + 1);
+			if (!block->ids) break;
+
+			for (size_t i = 0; i < count; i++)
+			{
+				const Polygon_3d * const polygon = polygons.data + from + i;
+				if (!polygon->set) continue;
+
+				unsigned long long * ids = block->ids + polygons_copy[i].first;
+				for ALL(polygon->vertices, j) *ids++ = polygon->vertices.data[j].value;
+			}
+			break;
+		}
+
+		default:
+			break;
+	}
+
+	if (!block->items || (kind == GEOMETRY_CHANGE_POLYGONS && !block->ids)) batch->failed = true;
+}
+
+// copy of everything (deleted items are included, so that the ids stay the same)
+// expects LOCK(geometry)
+static void geometry_autosave_capture_snapshot(Geometry_Autosave_Batch * batch)
+{
+	geometry_autosave_block(batch, GEOMETRY_CHANGE_SHOTS, 0, shots.count);
+	geometry_autosave_block(batch, GEOMETRY_CHANGE_VERTICES, 0, vertices.count);
+	geometry_autosave_block(batch, GEOMETRY_CHANGE_POLYGONS, 0, polygons.count);
+
+	for ALL(shots, i)
+	{
+		geometry_autosave_block(batch, GEOMETRY_CHANGE_POINTS, 0, shots.data[i].points.count, i);
+	}
+}
+
+// copy of items changed since given version (shots go first, so that their points have
+// somewhere to go)
+// expects LOCK(geometry)
+static void geometry_autosave_capture_changes(Geometry_Autosave_Batch * batch, const size_t since)
+{
+	for (int pass = 0; pass < 2; pass++)
+	{
+		size_t position = 0;
+		Geometry_Change change;
+		while (geometry_journal_next(position, since, change))
+		{
+			if ((change.kind == GEOMETRY_CHANGE_SHOTS) != (pass == 0)) continue;
+			geometry_autosave_block(batch, change.kind, change.from, change.to, change.shot_id);
+		}
+	}
+}
+
+// * journal records (writer thread) *
+
+// state of vertex
+static void geometry_autosave_vertex(Geometry_Autosave_Batch * batch, const size_t vertex_id, const Vertex * const vertex)
+{
+	if (!vertex->set)
+	{
+		geometry_autosave_record(batch, GEOMETRY_AUTOSAVE_VERTEX, vertex_id, 0, 0, true);
+		return;
+	}
+
+	Geometry_Project_Vertex * const record = (Geometry_Project_Vertex *)geometry_autosave_record(batch, GEOMETRY_AUTOSAVE_VERTEX, vertex_id, 0, sizeof(Geometry_Project_Vertex));
+	if (!record) return;
+
+	record->x = vertex->x;
+	record->y = vertex->y;
+	record->z = vertex->z;
+	record->reconstructed = vertex->reconstructed;
+	record->vertex_type = vertex->vertex_type;
+}
+
+// state of point
+static void geometry_autosave_point(Geometry_Autosave_Batch * batch, const size_t shot_id, const size_t point_id, const Point * const point)
+{
+	if (!point->set)
+	{
+		geometry_autosave_record(batch, GEOMETRY_AUTOSAVE_POINT, point_id, shot_id, 0, true);
+		return;
+	}
+
+	Geometry_Project_Point * const record = (Geometry_Project_Point *)geometry_autosave_record(batch, GEOMETRY_AUTOSAVE_POINT, point_id, shot_id, sizeof(Geometry_Project_Point));
+	if (!record) return;
+
+	record->x = point->x;
+	record->y = point->y;
+	record->vertex = point->vertex;
+}
+
+// state of polygon
+static void geometry_autosave_polygon(Geometry_Autosave_Batch * batch, const size_t polygon_id, const Geometry_Autosave_Polygon * const polygon, const unsigned long long * ids)
+{
+	if (!polygon->set)
+	{
+		geometry_autosave_record(batch, GEOMETRY_AUTOSAVE_POLYGON, polygon_id, 0, 0, true);
+		return;
+	}
+
+	const size_t size = polygon->count * sizeof(unsigned long long);
+	char * const record = geometry_autosave_record(batch, GEOMETRY_AUTOSAVE_POLYGON, polygon_id, 0, size);
+	if (record) memcpy(record, ids + polygon->first, size);
+}
+
+// state of shot
+static void geometry_autosave_shot(Geometry_Autosave_Batch * batch, const size_t shot_id, const Geometry_Autosave_Shot * const shot)
+{
+	if (!shot->set)
+	{
+		geometry_autosave_record(batch, GEOMETRY_AUTOSAVE_SHOT, shot_id, 0, 0, true);
+		return;
+	}
+
+	const size_t image_filename_size = strlen(shot->image_filename) + 1, name_size = strlen(shot->name) + 1;
+	char * const payload = geometry_autosave_record(batch, GEOMETRY_AUTOSAVE_SHOT, shot_id, 0, sizeof(Geometry_Project_Shot) + image_filename_size + name_size);
+	if (!payload) return;
+
+	Geometry_Project_Shot * const record = (Geometry_Project_Shot *)payload;
+	memcpy(record, &shot->record, sizeof(Geometry_Project_Shot));
+	record->image_filename = 0;
+	record->name = image_filename_size;
+	memcpy(payload + sizeof(Geometry_Project_Shot), shot->image_filename, image_filename_size);
+	memcpy(payload + sizeof(Geometry_Project_Shot) + image_filename_size, shot->name, name_size);
+}
+
+// serialize copied items into records terminated with checksum of the batch (snapshots start
+// with the file header and reset)
+static void geometry_autosave_encode(Geometry_Autosave_Batch * batch)
+{
+	if (batch->failed) return;
+
+	if (batch->filename)
+	{
+		batch->allocated = 1 << 16;
+		batch->data = ALLOC(char, batch->allocated);
+		batch->failed = !batch->data;
+		if (batch->failed) return;
+
+		Geometry_Project_Header * const header = (Geometry_Project_Header *)batch->data;
+		memset(header, 0, sizeof(Geometry_Project_Header));
+		memcpy(header->magic, GEOMETRY_AUTOSAVE_MAGIC, sizeof(header->magic));
+		header->version = GEOMETRY_AUTOSAVE_VERSION;
+		header->byte_order = GEOMETRY_PROJECT_BYTE_ORDER;
+		batch->size = batch->start = sizeof(Geometry_Project_Header);
+
+		geometry_autosave_record(batch, GEOMETRY_AUTOSAVE_RESET, 0, 0, 0);
+	}
+
+	for (size_t i = 0; i < batch->blocks_count; i++)
+	{
+		const Geometry_Autosave_Block * const block = batch->blocks + i;
+		for (size_t id = block->from; id < block->to; id++)
+		{
+			const size_t k = id - block->from;
+			switch (block->kind)
+			{
+				case GEOMETRY_CHANGE_VERTICES: geometry_autosave_vertex(batch, id, (const Vertex *)block->items + k); break;
+				case GEOMETRY_CHANGE_POINTS: geometry_autosave_point(batch, block->shot_id, id, (const Point *)block->items + k); break;
+				case GEOMETRY_CHANGE_SHOTS: geometry_autosave_shot(batch, id, (const Geometry_Autosave_Shot *)block->items + k); break;
+				case GEOMETRY_CHANGE_POLYGONS: geometry_autosave_polygon(batch, id, (const Geometry_Autosave_Polygon *)block->items + k, block->ids); break;
+				default: break;
+			}
+		}
+	}
+
+	geometry_autosave_free_blocks(batch);
+	if (batch->failed) return;
+
+	const unsigned long long checksum = geometry_autosave_checksum(batch->data + batch->start, batch->size - batch->start);
+	char * const payload = geometry_autosave_record(batch, GEOMETRY_AUTOSAVE_COMMIT, 0, 0, sizeof(checksum));
+	if (payload) memcpy(payload, &checksum, sizeof(checksum));
+}
+
+// * writer thread *
+
+// write the batch out, snapshot is written aside and replaces the journal only once it's complete
+static bool geometry_autosave_write(Geometry_Autosave_Batch * batch)
+{
+	if (!batch->filename)
+	{
+		FILE * const file = geometry_autosave.writer_file;
+		return file && fwrite(batch->data, 1, batch->size, file) == batch->size && fflush(file) == 0;
+	}
+
+	if (geometry_autosave.writer_file) fclose(geometry_autosave.writer_file);
+	geometry_autosave.writer_file = NULL;
+
+	char * const temporary = geometry_autosave_filename(batch->filename, ".tmp");
+	FILE * file = fopen(temporary, "wb");
+	bool ok = file && fwrite(batch->data, 1, batch->size, file) == batch->size;
+	if (file && fclose(file) != 0) ok = false;
+
+	if (ok)
+	{
+		// note that rename doesn't replace existing files on windows
+		remove(batch->filename);
+		ok = rename(temporary, batch->filename) == 0;
+	}
+
+	if (!ok) remove(temporary);
+	FREE(temporary);
+	if (!ok) return false;
+
+	// journal of the previous project isn't needed anymore
+	if (geometry_autosave.writer_filename && strcmp(geometry_autosave.writer_filename, batch->filename) != 0)
+	{
+		remove(geometry_autosave.writer_filename);
+	}
+
+	FREE(geometry_autosave.writer_filename);
+	geometry_autosave.writer_filename = batch->filename;
+	batch->filename = NULL;
+
+	geometry_autosave.writer_file = fopen(geometry_autosave.writer_filename, "ab");
+	return geometry_autosave.writer_file != NULL;
+}
+
+// writes out batches queued by the main thread
+static void * geometry_autosave_thread_function(void *)
+{
+	LOCK(geometry_autosave);
+	while (true)
+	{
+		while (!geometry_autosave.queue && !geometry_autosave.terminate)
+		{
+			pthread_cond_wait(&geometry_autosave.condition, &geometry_autosave_mutex);
+		}
+
+		if (geometry_autosave.terminate) break;
+
+		Geometry_Autosave_Batch * const batch = geometry_autosave.queue;
+		geometry_autosave.queue = batch->next;
+		if (!geometry_autosave.queue) geometry_autosave.queue_last = NULL;
+		UNLOCK(geometry_autosave);
+
+		geometry_autosave_encode(batch);
+		const bool snapshot = batch->filename != NULL, out_of_memory = batch->failed;
+		const bool ok = !out_of_memory && geometry_autosave_write(batch);
+		if (ok && snapshot)
+		{
+			geometry_autosave.snapshot_size = batch->size;
+			geometry_autosave.appended_size = 0;
+		}
+		else if (ok)
+		{
+			geometry_autosave.appended_size += batch->size;
+		}
+		geometry_autosave_free_batch(batch);
+
+		LOCK(geometry_autosave);
+		if (!ok)
+		{
+			// main thread will try again with a snapshot
+			if (!geometry_autosave.failed) printf(out_of_memory ? "Autosave failed (out of memory).\n" : "Autosave failed (unable to write the journal).\n");
+			geometry_autosave.failed = true;
+		}
+
+		// journal got bigger than the state it describes, main thread will rewrite it
+		if (
+			geometry_autosave.appended_size > geometry_autosave.snapshot_size && 
+			geometry_autosave.appended_size > GEOMETRY_AUTOSAVE_COMPACTION_SIZE
+		)
+		{
+			geometry_autosave.compact = true;
+		}
+	}
+
+	// we're finishing fine, so the journal isn't needed
+	while (geometry_autosave.queue)
+	{
+		Geometry_Autosave_Batch * const batch = geometry_autosave.queue;
+		geometry_autosave.queue = batch->next;
+		geometry_autosave_free_batch(batch);
+	}
+	geometry_autosave.queue_last = NULL;
+	UNLOCK(geometry_autosave);
+
+	if (geometry_autosave.writer_file) fclose(geometry_autosave.writer_file);
+	if (geometry_autosave.writer_filename) remove(geometry_autosave.writer_filename);
+	FREE(geometry_autosave.writer_filename);
+	geometry_autosave.writer_file = NULL;
+	geometry_autosave.writer_filename = NULL;
+
+	return NULL;
+}
+
+// hand the batch over to the writer thread
+// obtains LOCK(geometry_autosave)
+static void geometry_autosave_enqueue(Geometry_Autosave_Batch * batch)
+{
+	LOCK(geometry_autosave);
+
+	// snapshot makes everything queued before it obsolete
+	if (batch->filename)
+	{
+		while (geometry_autosave.queue)
+		{
+			Geometry_Autosave_Batch * const obsolete = geometry_autosave.queue;
+			geometry_autosave.queue = obsolete->next;
+			geometry_autosave_free_batch(obsolete);
+		}
+		geometry_autosave.queue_last = NULL;
+	}
+
+	if (geometry_autosave.queue_last) geometry_autosave.queue_last->next = batch; else geometry_autosave.queue = batch;
+	geometry_autosave.queue_last = batch;
+	pthread_cond_signal(&geometry_autosave.condition);
+
+	UNLOCK(geometry_autosave);
+}
+
+// * main thread *
+
+// copy what changed (or everything) and queue it, the writer thread serializes it
+// expects LOCK(geometry)
+static void geometry_autosave_save()
+{
+	const size_t version = geometry_version();
+	const bool snapshot = geometry_autosave.snapshot || !geometry_journal_complete(geometry_autosave.version);
+
+	Geometry_Autosave_Batch * const batch = geometry_autosave_new_batch(snapshot ? geometry_autosave.filename : NULL);
+	if (snapshot)
+	{
+		geometry_autosave_capture_snapshot(batch);
+	}
+	else
+	{
+		geometry_autosave_capture_changes(batch, geometry_autosave.version);
+	}
+
+	if (batch->failed)
+	{
+		printf("Autosave failed (out of memory).\n");
+		geometry_autosave_free_batch(batch);
+		geometry_autosave.snapshot = true;
+		return;
+	}
+
+	geometry_autosave.version = version;
+	geometry_autosave.snapshot = false;
+	geometry_autosave_enqueue(batch);
+}
+
+// start writer thread and journal of untitled project
+bool geometry_autosave_initialize()
+{
+	memset(&geometry_autosave, 0, sizeof(geometry_autosave));
+	if (core_state.headless) return true;
+
+	pthread_cond_init(&geometry_autosave.condition, NULL);
+	if (pthread_create(&geometry_autosave.thread, NULL, geometry_autosave_thread_function, NULL))
+	{
+		pthread_cond_destroy(&geometry_autosave.condition);
+		core_state.error = CORE_ERROR_UNABLE_TO_CREATE_THREAD;
+		return false;
+	}
+
+	geometry_autosave.enabled = true;
+	geometry_autosave.last_ticks = SDL_GetTicks();
+	geometry_autosave_start(NULL);
+
+	return true;
+}
+
+// journal the project saved under given filename from now on
+void geometry_autosave_start(const char * project_filename)
+{
+	if (!geometry_autosave.enabled) return;
+
+	char * const filename = geometry_autosave_filename(project_filename ? project_filename : "untitled", GEOMETRY_AUTOSAVE_EXTENSION);
+
+	// journal left there by a session which didn't finish is kept aside
+	if (
+		(!geometry_autosave.filename || strcmp(filename, geometry_autosave.filename) != 0) &&
+		interface_filesystem_modification_time(filename) != 0
+	)
+	{
+		char * const recovered = geometry_autosave_filename(filename, GEOMETRY_AUTOSAVE_RECOVERED_EXTENSION);
+		remove(recovered);
+		if (rename(filename, recovered) == 0)
+		{
+			printf("Autosave journal of a session which didn't finish kept as %s (File|Recover autosave).\n", recovered);
+		}
+		FREE(recovered);
+	}
+
+	FREE(geometry_autosave.filename);
+	geometry_autosave.filename = filename;
+	geometry_autosave.snapshot = true;
+
+	LOCK(geometry)
+	{
+		geometry_autosave_save();
+	}
+	UNLOCK(geometry);
+}
+
+// autosave changes if it's time to do so
+void geometry_autosave_tick()
+{
+	if (!geometry_autosave.enabled) return;
+
+	const Uint32 ticks = SDL_GetTicks();
+	if (ticks - geometry_autosave.last_ticks < GEOMETRY_AUTOSAVE_INTERVAL) return;
+	geometry_autosave.last_ticks = ticks;
+
+	// writer thread couldn't write something (or the journal grew too big), so it has to be rewritten
+	LOCK(geometry_autosave);
+	if (geometry_autosave.failed || geometry_autosave.compact) geometry_autosave.snapshot = true;
+	geometry_autosave.failed = false;
+	geometry_autosave.compact = false;
+	UNLOCK(geometry_autosave);
+
+	LOCK(geometry)
+	{
+		if (geometry_autosave.snapshot || geometry_version() != geometry_autosave.version)
+		{
+			geometry_autosave_save();
+		}
+	}
+	UNLOCK(geometry);
+}
+
+// stop the writer thread and delete the journal
+void geometry_autosave_release()
+{
+	if (!geometry_autosave.enabled) return;
+
+	LOCK(geometry_autosave);
+	geometry_autosave.terminate = true;
+	pthread_cond_signal(&geometry_autosave.condition);
+	UNLOCK(geometry_autosave);
+
+	pthread_join(geometry_autosave.thread, NULL);
+	pthread_cond_destroy(&geometry_autosave.condition);
+	FREE(geometry_autosave.filename);
+	geometry_autosave.filename = NULL;
+	geometry_autosave.enabled = false;
+}
+
+// * recovery *
+
+// apply single record
+// expects LOCK(geometry)
+static void geometry_autosave_replay(const Geometry_Autosave_Record * record)
+{
+	const bool deleted = (record->flags & GEOMETRY_AUTOSAVE_DELETED) != 0;
+	const char * const payload = (const char *)(record + 1);
+	const size_t id = (size_t)record->id;
+
+	// items are created one after another, so ids never skip past the end of the arrays
+	switch (record->type)
+	{
+		case GEOMETRY_AUTOSAVE_RESET:
+		{
+			geometry_release();
+			break;
+		}
+
+		case GEOMETRY_AUTOSAVE_VERTEX:
+		{
+			if (id > vertices.count || (!deleted && record->size < sizeof(Geometry_Project_Vertex))) break;
+			DYN(vertices, id);
+			Vertex * const vertex = vertices.data + id;
+			if (deleted)
+			{
+				vertex->set = false;
+				break;
+			}
+
+			const Geometry_Project_Vertex * const data = (const Geometry_Project_Vertex *)payload;
+			vertex->x = data->x;
+			vertex->y = data->y;
+			vertex->z = data->z;
+			vertex->reconstructed = data->reconstructed != 0;
+			switch (data->vertex_type)
+			{
+				case GEOMETRY_VERTEX_AUTO: vertex->vertex_type = GEOMETRY_VERTEX_AUTO; break;
+				case GEOMETRY_VERTEX_EQUIVALENCE: vertex->vertex_type = GEOMETRY_VERTEX_EQUIVALENCE; break;
+				case GEOMETRY_VERTEX_USER: vertex->vertex_type = GEOMETRY_VERTEX_USER; break;
+			}
+			break;
+		}
+
+		case GEOMETRY_AUTOSAVE_POINT:
+		{
+			const size_t shot_id = (size_t)record->shot_id;
+			if (!IS_SET(shots, shot_id)) break;
+			Points & points = shots.data[shot_id].points;
+			if (id > points.count || (!deleted && record->size < sizeof(Geometry_Project_Point))) break;
+			DYN(points, id);
+			Point * const point = points.data + id;
+			if (deleted)
+			{
+				point->set = false;
+				break;
+			}
+
+			const Geometry_Project_Point * const data = (const Geometry_Project_Point *)payload;
+			point->x = data->x;
+			point->y = data->y;
+			point->vertex = (size_t)data->vertex;
+			break;
+		}
+
+		case GEOMETRY_AUTOSAVE_POLYGON:
+		{
+			if (id > polygons.count || record->size % sizeof(unsigned long long) != 0) break;
+			DYN(polygons, id);
+			Polygon_3d * const polygon = polygons.data + id;
+			if (deleted)
+			{
+				DYN_FREE(polygon->vertices);
+				polygon->set = false;
+				break;
+			}
+
+			const unsigned long long * const data = (const unsigned long long *)payload;
+			const size_t count = (size_t)(record->size / sizeof(unsigned long long));
+			polygon->vertices.count = 0;
+			if (!DYN_RESERVE(polygon->vertices, count)) break;
+			for (size_t i = 0; i < count; i++)
+			{
+				polygon->vertices.data[i].set = true;
+				polygon->vertices.data[i].value = (size_t)data[i];
+			}
+			polygon->vertices.count = count;
+			break;
+		}
+
+		case GEOMETRY_AUTOSAVE_SHOT:
+		{
+			if (id > shots.count || (!deleted && record->size < sizeof(Geometry_Project_Shot))) break;
+			DYN(shots, id);
+			Shot * const shot = shots.data + id;
+			if (deleted)
+			{
+				DYN_FREE(shot->points);
+				shot->set = false;
+				break;
+			}
+
+			// strings have to be terminated within the record
+			const Geometry_Project_Shot * const data = (const Geometry_Project_Shot *)payload;
+			const char * const strings = payload + sizeof(Geometry_Project_Shot);
+			const size_t strings_size = (size_t)record->size - sizeof(Geometry_Project_Shot);
+			if (
+				strings_size == 0 || strings[strings_size - 1] != '\0' ||
+				data->image_filename >= strings_size || data->name >= strings_size
+			)
+			{
+				break;
+			}
+
+			shot->f = data->f;
+			shot->film_back = data->film_back;
+			shot->fovx = data->fovx;
+			shot->fovy = data->fovy;
+			shot->pp_x = data->pp_x;
+			shot->pp_y = data->pp_y;
+			shot->resected = data->resected != 0;
+			shot->width = data->width;
+			shot->height = data->height;
+			FREE(shot->image_filename);
+			FREE(shot->name);
+			shot->image_filename = strdup(strings + data->image_filename);
+			shot->name = strdup(strings + data->name);
+
+			switch (data->info_status)
+			{
+				case GEOMETRY_INFO_DEDUCED: shot->info_status = GEOMETRY_INFO_DEDUCED; break;
+				case GEOMETRY_INFO_LOADED: shot->info_status = GEOMETRY_INFO_LOADED; break;
+				case GEOMETRY_INFO_NOT_LOADED: shot->info_status = GEOMETRY_INFO_NOT_LOADED; break;
+			}
+
+			if (data->calibrated)
+			{
+				shot->calibrated = true;
+				if (!shot->projection) geometry_shot_new_calibration_containers(id);
+				for (int k = 0; k < 12; k++) OPENCV_ELEM(shot->projection, k / 4, k % 4) = data->P[k];
+				geometry_calibration_from_P(id);
+			}
+			else
+			{
+				// calibration might have been dropped after the snapshot
+				geometry_release_shot_calibration(id);
+			}
+			break;
+		}
+	}
+}
+
+// rebuild incidence of replayed vertices (points of vertices which no longer exist are dropped)
+// expects LOCK(geometry)
+static void geometry_autosave_build_incidence()
+{
+	for ALL(vertices_incidence, i)
+	{
+		DYN_FREE(vertices_incidence.data[i].shot_point_ids);
+	}
+	DYN_FREE(vertices_incidence);
+
+	if (!DYN_RESERVE(vertices_incidence, vertices.count))
+	{
+		core_state.error = CORE_ERROR_OUT_OF_MEMORY;
+		return;
+	}
+
+	for ALL(vertices, i) DYN(vertices_incidence, i);
+	vertices_incidence.count = vertices.count;
+
+	for ALL(shots, i)
+	{
+		for ALL(shots.data[i].points, j)
+		{
+			Point * const point = shots.data[i].points.data + j;
+			if (!IS_SET(vertices, point->vertex))
+			{
+				point->set = false;
+				continue;
+			}
+
+			Double_Indices & ids = vertices_incidence.data[point->vertex].shot_point_ids;
+			ADD(ids);
+			LAST(ids).primary = i;
+			LAST(ids).secondary = j;
+		}
+	}
+}
+
+// replay journal into (released) geometry
+bool geometry_autosave_recover(const char * filename)
+{
+	Filesystem_Mapping mapping;
+	if (!interface_filesystem_map_file(filename, &mapping))
+	{
+		printf("Unable to open file for reading.\n");
+		return false;
+	}
+
+	const Geometry_Project_Header * const header = (const Geometry_Project_Header *)mapping.data;
+	if (mapping.size < sizeof(Geometry_Project_Header) || memcmp(header->magic, GEOMETRY_AUTOSAVE_MAGIC, sizeof(header->magic)) != 0)
+	{
+		printf("Invalid header.\n");
+		interface_filesystem_unmap_file(&mapping);
+		return false;
+	}
+
+	if (header->byte_order != GEOMETRY_PROJECT_BYTE_ORDER || header->version > GEOMETRY_AUTOSAVE_VERSION)
+	{
+		printf("Journal was written by unsupported version.\n");
+		interface_filesystem_unmap_file(&mapping);
+		return false;
+	}
+
+	// replay committed batches (the last one might have been cut short by the crash)
+	const char * const data = (const char *)mapping.data;
+	size_t position = sizeof(Geometry_Project_Header), batches = 0;
+	while (true)
+	{
+		// find the commit record and check the batch
+		size_t end = position, next = 0;
+		while (mapping.size - end >= sizeof(Geometry_Autosave_Record))
+		{
+			const Geometry_Autosave_Record * const record = (const Geometry_Autosave_Record *)(data + end);
+			const unsigned long long padded = (record->size + 7) / 8 * 8;
+			if (record->size > mapping.size || padded > mapping.size - end - sizeof(Geometry_Autosave_Record)) break;
+
+			if (record->type == GEOMETRY_AUTOSAVE_COMMIT)
+			{
+				unsigned long long checksum = 0;
+				if (record->size == sizeof(checksum)) memcpy(&checksum, record + 1, sizeof(checksum));
+				if (checksum == geometry_autosave_checksum(data + position, end - position))
+				{
+					next = end + sizeof(Geometry_Autosave_Record) + (size_t)padded;
+				}
+				break;
+			}
+
+			end += sizeof(Geometry_Autosave_Record) + (size_t)padded;
+		}
+
+		if (!next) break;
+
+		while (position < end)
+		{
+			const Geometry_Autosave_Record * const record = (const Geometry_Autosave_Record *)(data + position);
+			geometry_autosave_replay(record);
+			position += sizeof(Geometry_Autosave_Record) + (size_t)((record->size + 7) / 8 * 8);
+		}
+
+		position = next;
+		batches++;
+	}
+
+	interface_filesystem_unmap_file(&mapping);
+
+	if (batches == 0)
+	{
+		printf("Journal doesn't contain anything to recover.\n");
+		return false;
+	}
+
+	geometry_autosave_build_incidence();
+	geometry_changed_all();
+	return true;
+}
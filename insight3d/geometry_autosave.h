@@ -0,0 +1,48 @@
+#ifndef __GEOMETRY_AUTOSAVE
+#define __GEOMETRY_AUTOSAVE
+
+#include "core_state.h"
+#include "interface_filesystem.h"
+#include "geometry_structures.h"
+#include "geometry_routines.h"
+#include "geometry_project_format.h"
+
+// autosave keeps a journal of edits next to the project (or in untitled.autosave if the project
+// hasn't been saved yet); every few seconds the items recorded in the change journal since the
+// last autosave are copied and handed to a writer thread, which serializes them and appends them
+// to the file, so the ui never waits for the encoding or the disk; when the journal grows bigger
+// than the state it describes (or the change journal doesn't reach back far enough), it's
+// rewritten as a snapshot of the whole state
+
+// ms between autosaves
+const Uint32 GEOMETRY_AUTOSAVE_INTERVAL = 2000;
+
+// journal is compacted when the records appended after the snapshot get bigger than the
+// snapshot and this
+const size_t GEOMETRY_AUTOSAVE_COMPACTION_SIZE = 1 << 20;
+
+// extension of the journal and of the journal left behind by previous session
+const char * const GEOMETRY_AUTOSAVE_EXTENSION = ".autosave";
+const char * const GEOMETRY_AUTOSAVE_RECOVERED_EXTENSION = ".recovered";
+
+// start writer thread and journal of untitled project (does nothing when running headless)
+bool geometry_autosave_initialize();
+
+// journal the project saved under given filename (NULL if it doesn't have any) from now on;
+// journal of the previous project is deleted, journal left at the new location by a session
+// which didn't finish is kept with GEOMETRY_AUTOSAVE_RECOVERED_EXTENSION
+// obtains LOCK(geometry)
+void geometry_autosave_start(const char * project_filename);
+
+// autosave changes if it's time to do so, called periodically from the main loop
+// obtains LOCK(geometry)
+void geometry_autosave_tick();
+
+// replay journal into (released) geometry, returns false if there was nothing to recover
+// expects LOCK(geometry)
+bool geometry_autosave_recover(const char * filename);
+
+// stop the writer thread and delete the journal (everything went fine)
+void geometry_autosave_release();
+
+#endif
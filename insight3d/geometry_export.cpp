@@ -3,7 +3,12 @@
 // save current application state
 bool geometry_save(const char * filename)
 {
-	std::ofstream out(filename);
+	if (interface_filesystem_has_extension(filename, GEOMETRY_PROJECT_BINARY_EXTENSION))
+	{
+		return geometry_save_binary(filename);
+	}
+
+	Output_File * out = output_open(filename, true);
 
 	if (!out) 
 	{
@@ -12,7 +17,7 @@ bool geometry_save(const char * filename)
 	}
 
 	// header
-	out << "insight3d data file" << std::endl;
+	output_string(out, "insight3d data file\n");
 
 	// refactor vertices 
 	size_t * vertices_reindex = ALLOC(size_t, vertices.count);
@@ -25,12 +30,23 @@ bool geometry_save(const char * filename)
 	}
 
 	// dump vertices 
-	out << "vertices " << vertices_count << std::endl;
+	output_string(out, "vertices ");
+	output_size(out, vertices_count);
+	output_char(out, '\n');
 	for ALL(vertices, i) 
 	{
 		const Vertex * const vertex = vertices.data + i; 
 
-		out << vertex->x << " " << vertex->y << " " << vertex->z << " " << vertex->reconstructed << " " << vertex->vertex_type << std::endl;
+		output_double(out, vertex->x);
+		output_char(out, ' ');
+		output_double(out, vertex->y);
+		output_char(out, ' ');
+		output_double(out, vertex->z);
+		output_char(out, ' ');
+		output_int(out, vertex->reconstructed);
+		output_char(out, ' ');
+		output_int(out, vertex->vertex_type);
+		output_char(out, '\n');
 	}
 
 	// prepare polygons 
@@ -41,16 +57,18 @@ bool geometry_save(const char * filename)
 	}
 
 	// dump polygons 
-	out << "polygons " << polygons_count << std::endl; 
+	output_string(out, "polygons ");
+	output_size(out, polygons_count);
+	output_char(out, '\n');
 	for ALL(polygons, i) 
 	{
-		const Polygon_3d * const polygon = polygons.data + i; 
 		for ALL(polygons.data[i].vertices, j) 
 		{
-			out << vertices_reindex[polygons.data[i].vertices.data[j].value] << " ";
+			output_size(out, vertices_reindex[polygons.data[i].vertices.data[j].value]);
+			output_char(out, ' ');
 		}
 
-		out << "-1" << std::endl;
+		output_string(out, "-1\n");
 	}
 
 	// prepare shots
@@ -61,24 +79,38 @@ bool geometry_save(const char * filename)
 	}
 
 	// shots 
-	out << "shots " << shots_count << std::endl;
+	output_string(out, "shots ");
+	output_size(out, shots_count);
+	output_char(out, '\n');
 	for ALL(shots, i) 
 	{
 		const Shot * const shot = shots.data + i; 
-		out 
-			<< shot->calibrated << " "
-			<< shot->f << " "
-			<< shot->film_back << " "
-			<< shot->fovx << " "
-			<< shot->fovy << " "
-			<< shot->height << " "
-			<< "\"" << shot->image_filename << "\" "
-			<< shot->info_status << " "
-			<< "\"" << shot->name << "\" "
-			<< shot->pp_x << " "
-			<< shot->pp_y << " "
-			<< shot->resected << " "
-			<< shot->width << " ";
+		output_int(out, shot->calibrated);
+		output_char(out, ' ');
+		output_double(out, shot->f);
+		output_char(out, ' ');
+		output_double(out, shot->film_back);
+		output_char(out, ' ');
+		output_double(out, shot->fovx);
+		output_char(out, ' ');
+		output_double(out, shot->fovy);
+		output_char(out, ' ');
+		output_int(out, shot->height);
+		output_string(out, " \"");
+		output_string(out, shot->image_filename);
+		output_string(out, "\" ");
+		output_int(out, shot->info_status);
+		output_string(out, " \"");
+		output_string(out, shot->name);
+		output_string(out, "\" ");
+		output_double(out, shot->pp_x);
+		output_char(out, ' ');
+		output_double(out, shot->pp_y);
+		output_char(out, ' ');
+		output_int(out, shot->resected);
+		output_char(out, ' ');
+		output_int(out, shot->width);
+		output_char(out, ' ');
 
 		for (int ki = 0; ki < 3; ki++) 
 		{
@@ -86,16 +118,17 @@ bool geometry_save(const char * filename)
 			{
 				if (shot->projection) 
 				{
-					out << OPENCV_ELEM(shot->projection, ki, kj) << " ";
+					output_double(out, OPENCV_ELEM(shot->projection, ki, kj));
+					output_char(out, ' ');
 				}
 				else
 				{
-					out << "0 "; // note that projection matrices of finite cameras must have rank 3 and thus this is clean
+					output_string(out, "0 "); // note that projection matrices of finite cameras must have rank 3 and thus this is clean
 				}
 			}
 		}
 
-		out << std::endl;
+		output_char(out, '\n');
 
 		// prepare points 
 		size_t points_count = 0;
@@ -105,41 +138,237 @@ bool geometry_save(const char * filename)
 		}
 
 		// dump points
-		out << "points " << points_count << std::endl;
+		output_string(out, "points ");
+		output_size(out, points_count);
+		output_char(out, '\n');
 		for ALL(shot->points, j)
 		{
 			const Point * const point = shot->points.data + j; 
-			out 
-				<< point->x << " "
-				<< point->y << " "
-				<< vertices_reindex[point->vertex] << std::endl;
+			output_double(out, point->x);
+			output_char(out, ' ');
+			output_double(out, point->y);
+			output_char(out, ' ');
+			output_size(out, vertices_reindex[point->vertex]);
+			output_char(out, '\n');
 		}
 	}
 
 	// write checksum 
-	out << "checksum " << (vertices_count + polygons_count) % 1000 << std::endl;
+	output_string(out, "checksum ");
+	output_size(out, (vertices_count + polygons_count) % 1000);
+	output_char(out, '\n');
+
+	FREE(vertices_reindex);
+
+	if (!output_close(out))
+	{
+		printf("Error while writing project.\n");
+		return false;
+	}
+
+	return true;
+}
+
+// write header of binary project section, payload has to follow 
+static void geometry_save_binary_section(Output_File * out, const unsigned int tag, const size_t item_size, const size_t count)
+{
+	Geometry_Project_Section section;
+	section.tag = tag; 
+	section.item_size = (unsigned int)item_size; 
+	section.count = count; 
+	section.size = item_size * count; 
+	output_write(out, &section, sizeof(section));
+}
+
+// pad section payload to 8 bytes 
+static void geometry_save_binary_padding(Output_File * out, const size_t size)
+{
+	const char zeros[8] = { 0 };
+	if (size % 8) output_write(out, zeros, 8 - size % 8);
+}
+
+// save current application state in binary format
+bool geometry_save_binary(const char * filename)
+{
+	Output_File * out = output_open(filename, true);
+
+	if (!out) 
+	{
+		printf("Unable to open file for writing.\n");
+		return false;
+	}
+
+	// refactor vertices 
+	size_t * vertices_reindex = ALLOC(size_t, vertices.count + 1);
+	size_t vertices_count = 0;
+	memset(vertices_reindex, 0, sizeof(size_t) * vertices.count);
+
+	for ALL(vertices, i) 
+	{
+		vertices_reindex[i] = vertices_count++;
+	}
+
+	// count everything 
+	size_t polygons_count = 0, polygon_vertices_count = 0, shots_count = 0, points_count = 0, strings_size = 0;
+	for ALL(polygons, i) 
+	{
+		polygons_count++;
+		for ALL(polygons.data[i].vertices, j) polygon_vertices_count++;
+	}
+
+	for ALL(shots, i) 
+	{
+		const Shot * const shot = shots.data + i;
+		shots_count++;
+		strings_size += strlen(shot->image_filename ? shot->image_filename : "") + 1 + strlen(shot->name ? shot->name : "") + 1;
+		for ALL(shot->points, j) points_count++;
+	}
+
+	// header 
+	Geometry_Project_Header header; 
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, GEOMETRY_PROJECT_MAGIC, sizeof(header.magic));
+	header.version = GEOMETRY_PROJECT_VERSION;
+	header.byte_order = GEOMETRY_PROJECT_BYTE_ORDER; 
+	header.sections_count = 6; 
+	output_write(out, &header, sizeof(header));
+
+	// strings (names of shots and their images)
+	geometry_save_binary_section(out, GEOMETRY_PROJECT_STRINGS, 1, strings_size);
+	for ALL(shots, i) 
+	{
+		const char * const image_filename = shots.data[i].image_filename ? shots.data[i].image_filename : "";
+		const char * const name = shots.data[i].name ? shots.data[i].name : "";
+		output_write(out, image_filename, strlen(image_filename) + 1);
+		output_write(out, name, strlen(name) + 1);
+	}
+	geometry_save_binary_padding(out, strings_size);
+
+	// vertices 
+	geometry_save_binary_section(out, GEOMETRY_PROJECT_VERTICES, sizeof(Geometry_Project_Vertex), vertices_count);
+	for ALL(vertices, i) 
+	{
+		const Vertex * const vertex = vertices.data + i; 
+		Geometry_Project_Vertex record; 
+		record.x = vertex->x; 
+		record.y = vertex->y; 
+		record.z = vertex->z; 
+		record.reconstructed = vertex->reconstructed; 
+		record.vertex_type = vertex->vertex_type;
+		output_write(out, &record, sizeof(record));
+	}
+
+	// polygons 
+	unsigned long long first = 0;
+	geometry_save_binary_section(out, GEOMETRY_PROJECT_POLYGONS, sizeof(unsigned long long), polygons_count + 1);
+	for ALL(polygons, i) 
+	{
+		output_write(out, &first, sizeof(first));
+		for ALL(polygons.data[i].vertices, j) first++;
+	}
+	output_write(out, &first, sizeof(first));
+
+	geometry_save_binary_section(out, GEOMETRY_PROJECT_POLYGON_VERTICES, sizeof(unsigned long long), polygon_vertices_count);
+	for ALL(polygons, i) 
+	{
+		for ALL(polygons.data[i].vertices, j) 
+		{
+			const unsigned long long vertex_id = vertices_reindex[polygons.data[i].vertices.data[j].value];
+			output_write(out, &vertex_id, sizeof(vertex_id));
+		}
+	}
+
+	// shots 
+	unsigned long long string = 0; 
+	first = 0;
+	geometry_save_binary_section(out, GEOMETRY_PROJECT_SHOTS, sizeof(Geometry_Project_Shot), shots_count);
+	for ALL(shots, i) 
+	{
+		const Shot * const shot = shots.data + i; 
+		Geometry_Project_Shot record; 
+		memset(&record, 0, sizeof(record));
+
+		record.f = shot->f; 
+		record.film_back = shot->film_back; 
+		record.fovx = shot->fovx; 
+		record.fovy = shot->fovy; 
+		record.pp_x = shot->pp_x; 
+		record.pp_y = shot->pp_y; 
+		record.width = shot->width; 
+		record.height = shot->height; 
+		record.calibrated = shot->calibrated; 
+		record.resected = shot->resected; 
+		record.info_status = shot->info_status;
+
+		if (shot->projection) 
+		{
+			for (int k = 0; k < 12; k++) record.P[k] = OPENCV_ELEM(shot->projection, k / 4, k % 4);
+		}
+
+		record.image_filename = string; 
+		string += strlen(shot->image_filename ? shot->image_filename : "") + 1; 
+		record.name = string; 
+		string += strlen(shot->name ? shot->name : "") + 1; 
+
+		record.points_first = first;
+		for ALL(shot->points, j) record.points_count++; 
+		first += record.points_count;
+
+		output_write(out, &record, sizeof(record));
+	}
+
+	// points 
+	geometry_save_binary_section(out, GEOMETRY_PROJECT_POINTS, sizeof(Geometry_Project_Point), points_count);
+	for ALL(shots, i) 
+	{
+		for ALL(shots.data[i].points, j) 
+		{
+			const Point * const point = shots.data[i].points.data + j; 
+			Geometry_Project_Point record; 
+			record.x = point->x; 
+			record.y = point->y; 
+			record.vertex = vertices_reindex[point->vertex]; 
+			output_write(out, &record, sizeof(record));
+		}
+	}
 
-	out.close();
 	FREE(vertices_reindex);
 
+	if (!output_close(out)) 
+	{
+		printf("Error while writing project.\n");
+		return false;
+	}
+
 	return true;
 }
 
+// write three numbers separated by separator and followed by end 
+static void geometry_export_triple(Output_File * out, const double a, const double b, const double c, const char separator, const char * end)
+{
+	output_double(out, a);
+	output_char(out, separator);
+	output_double(out, b);
+	output_char(out, separator);
+	output_double(out, c);
+	output_string(out, end);
+}
+
 // export the scene and polygons into VRML
 bool geometry_export_vrml(const char * filename, Vertices & vertices, Polygons_3d & polygons, bool export_vertices /*= true*/, bool export_polygons /*= true*/, size_t restrict_vertices_by_group /*= 0*/)
 {
 	// open file for output 
-	std::ofstream vrml_output(filename); 
+	Output_File * vrml_output = output_open(filename, true); 
 	if (!vrml_output) 
 	{
 		core_state.error = CORE_ERROR_UNABLE_TO_OPEN_FILE;
 		return false; 
 	}
-	vrml_output.precision(9);
+	output_set_precision(vrml_output, 9);
 
 	// write vrml header 
-	vrml_output << "#VRML V2.0 utf8" << std::endl; 
-	vrml_output << "NavigationInfo {type [\"EXAMINE\", \"ANY\"]}" << std::endl;
+	output_string(vrml_output, "#VRML V2.0 utf8\n"); 
+	output_string(vrml_output, "NavigationInfo {type [\"EXAMINE\", \"ANY\"]}\n");
 
 	// * export data *
 	
@@ -147,7 +376,7 @@ bool geometry_export_vrml(const char * filename, Vertices & vertices, Polygons_3
 	if (export_vertices) 
 	{
 		// vertices header
-		vrml_output << "Group { children [ Shape { geometry PointSet { coord Coordinate {point [" << std::endl;
+		output_string(vrml_output, "Group { children [ Shape { geometry PointSet { coord Coordinate {point [\n");
 
 		// dump all vertices as point cloud 
 		for ALL(vertices, i) 
@@ -155,11 +384,11 @@ bool geometry_export_vrml(const char * filename, Vertices & vertices, Polygons_3
 			const Vertex * vertex = vertices.data + i; 
 			if (!vertex->reconstructed) continue;
 			if (restrict_vertices_by_group && vertex->group != restrict_vertices_by_group) continue; 
-			vrml_output << -visualization_normalize(vertex->x, X) << " " << -visualization_normalize(vertex->y, Y) << " " << visualization_normalize(vertex->z, Z) << std::endl;
+			geometry_export_triple(vrml_output, -visualization_normalize(vertex->x, X), -visualization_normalize(vertex->y, Y), visualization_normalize(vertex->z, Z), ' ', "\n");
 		}
 
 		// separate coordinates from colors
-		vrml_output << "] } color Color { color [ " << std::endl;
+		output_string(vrml_output, "] } color Color { color [ \n");
 		
 		for ALL(vertices, i) 
 		{
@@ -172,31 +401,30 @@ bool geometry_export_vrml(const char * filename, Vertices & vertices, Polygons_3
 				inside_interval(vertex->color[2], 0, 1)
 			)
 			{
-				vrml_output 
-					<< vertex->color[0] << " " 
-					<< vertex->color[1] << " "
-					<< vertex->color[2] << std::endl; 
+				geometry_export_triple(vrml_output, vertex->color[0], vertex->color[1], vertex->color[2], ' ', "\n"); 
 			}
 			else
 			{
-				vrml_output << "1 1 1" << std::endl;
+				output_string(vrml_output, "1 1 1\n");
 			}
 		}
 
-		vrml_output << "] } } } ] }" << std::endl; 
+		output_string(vrml_output, "] } } } ] }\n"); 
 	}
 
 	// polygons 
 	if (export_polygons) 
 	{
-		vrml_output << "Group { children [" << std::endl;
-		vrml_output << "DEF exported_model Shape " << std::endl;
-		vrml_output << "{ " << std::endl;
-		vrml_output << "    geometry IndexedFaceSet " << std::endl;
-		vrml_output << "    { " << std::endl;
-		vrml_output << "        coord Coordinate " << std::endl;
-		vrml_output << "        { " << std::endl;
-		vrml_output << "            point [ " << std::endl;
+		output_string(vrml_output, 
+			"Group { children [\n"
+			"DEF exported_model Shape \n"
+			"{ \n"
+			"    geometry IndexedFaceSet \n"
+			"    { \n"
+			"        coord Coordinate \n"
+			"        { \n"
+			"            point [ \n"
+		);
 		
 		// reindex vertices
 		bool * used = ALLOC(bool, vertices.count);
@@ -221,63 +449,82 @@ bool geometry_export_vrml(const char * filename, Vertices & vertices, Polygons_3
 			if (!used[i]) continue;
 			
 			ids[i] = count++;
-			vrml_output << -visualization_normalize(vertex->x, X) << " " << -visualization_normalize(vertex->y, Y) << " " << visualization_normalize(vertex->z, Z) << std::endl;
+			geometry_export_triple(vrml_output, -visualization_normalize(vertex->x, X), -visualization_normalize(vertex->y, Y), visualization_normalize(vertex->z, Z), ' ', "\n");
 		}
 
-		vrml_output << "            ]" << std::endl;
-		vrml_output << "        } " << std::endl;
-		vrml_output << "        coordIndex [ "; 
+		output_string(vrml_output, 
+			"            ]\n"
+			"        } \n"
+			"        coordIndex [ "
+		); 
 	
 		for ALL(polygons, i)
 		{
 			for ALL(polygons.data[i].vertices, j)
 			{
-				vrml_output << ids[polygons.data[i].vertices.data[j].value] << " ";
+				output_size(vrml_output, ids[polygons.data[i].vertices.data[j].value]);
+				output_char(vrml_output, ' ');
 			}
 
-			vrml_output << "-1 " << std::endl;
+			output_string(vrml_output, "-1 \n");
 		}
 
 		FREE(ids);
 		FREE(used);
 		
-		vrml_output << "        ] " << std::endl; 
-		vrml_output << "        color Color { " << std::endl; 
-		vrml_output << "            color [  " << std::endl; 
+		output_string(vrml_output, 
+			"        ] \n"
+			"        color Color { \n"
+			"            color [  \n"
+		); 
 		
 		for ALL(vertices, i)
 		{
 			const Vertex * const vertex = vertices.data + i;
 			if (!vertex->reconstructed) continue;
-			vrml_output << vertex->color[0] << " " << vertex->color[1] << " " << vertex->color[2] << " ";
+			geometry_export_triple(vrml_output, vertex->color[0], vertex->color[1], vertex->color[2], ' ', " ");
 		}
 
-		vrml_output << std::endl;
-		vrml_output << "            ] " << std::endl;
-		vrml_output << "        } " << std::endl;
-		vrml_output << "        colorPerVertex TRUE" << std::endl; 
-		vrml_output << "        solid FALSE" << std::endl; 
-		vrml_output << "    } " << std::endl;
-		vrml_output << "    appearance DEF my_polygons Appearance { material Material { diffuseColor .5 .5 .5 specularColor .3 .3 .3 emissiveColor .5 .5 .5 ambientIntensity .05 shininess .05 } } " << std::endl;
-		vrml_output << "} ] }" << std::endl;
+		output_string(vrml_output, 
+			"\n"
+			"            ] \n"
+			"        } \n"
+			"        colorPerVertex TRUE\n"
+			"        solid FALSE\n"
+			"    } \n"
+			"    appearance DEF my_polygons Appearance { material Material { diffuseColor .5 .5 .5 specularColor .3 .3 .3 emissiveColor .5 .5 .5 ambientIntensity .05 shininess .05 } } \n"
+			"} ] }\n"
+		);
 	}
 
-	vrml_output.close();
-	return true;
+	return output_close(vrml_output);
 }
 
 // export scene into Sandy3D ActionScript file
 bool geometry_export_sandy3d(const char * filename, Vertices & vertices, Polygons_3d & polygons, bool export_vertices)
 {
 	// open file for output 
-	std::ofstream as_output(filename), stars_output((std::string(filename) + ".stars.txt").c_str()); // todo remove point cloud extraction for release
+	Output_File 
+		* as_output = output_open(filename), 
+		* stars_output = NULL; 
 
 	if (!as_output) 
 	{
 		core_state.error = CORE_ERROR_UNABLE_TO_OPEN_FILE;
 		return false; 
 	}
-	as_output.precision(9);
+	output_set_precision(as_output, 9);
+
+	// todo remove point cloud extraction for release
+	if (export_vertices) 
+	{
+		char * stars_filename = ALLOC(char, strlen(filename) + strlen(".stars.txt") + 1);
+		strcpy(stars_filename, filename);
+		strcat(stars_filename, ".stars.txt");
+		stars_output = output_open(stars_filename);
+		FREE(stars_filename);
+		if (stars_output) output_set_precision(stars_output, 9);
+	}
 
 	// class name 
 	char 
@@ -289,42 +536,49 @@ bool geometry_export_sandy3d(const char * filename, Vertices & vertices, Polygon
 	// * export data *
 
 	// write sandy header 
-	as_output << "package" << std::endl;
-	as_output << "{" << std::endl;
-	as_output << "import sandy.primitive.Primitive3D;" << std::endl << std::endl;
-
-	as_output << "import sandy.core.scenegraph.Geometry3D;" << std::endl;
-	as_output << "import sandy.core.scenegraph.Shape3D;" << std::endl;
-	as_output << "public class " << class_name << " extends Shape3D implements Primitive3D" << std::endl;
-	as_output << "{" << std::endl;
-	as_output << "private var l:Geometry3D ;" << std::endl;
-	as_output << "private function v(x:Number,y:Number,z:Number):void" << std::endl;
-	as_output << "{" << std::endl;
-	as_output << "l.setVertex(l.getNextVertexID(),x,y,z );" << std::endl;
-	as_output << "}" << std::endl;
-	as_output << "private function vn(nx:Number,ny:Number,nz:Number):void" << std::endl;
-	as_output << "{" << std::endl;
-	as_output << "l.setVertexNormal(l.getNextVertexNormalID(),nx,ny,nz );" << std::endl;
-	as_output << "}" << std::endl;
-	as_output << "private function uv(u:Number,v:Number):void" << std::endl;
-	as_output << "{" << std::endl;
-	as_output << "l.setUVCoords(l.getNextUVCoordID(),u,v);" << std::endl;
-	as_output << "}" << std::endl;
-	as_output << "private function f(vn0:int, vn1:int, vn2:int, uvn0:int, uvn1:int,uvn2:int):void" << std::endl;
-	as_output << "{" << std::endl;
-	as_output << "l.setFaceVertexIds(l.getNextFaceID(), vn0, vn1,vn2);" << std::endl;
-	as_output << "l.setFaceUVCoordsIds( l.getNextFaceUVCoordID(), uvn0,uvn1,uvn2);" << std::endl;
-	as_output << "}" << std::endl;
-	as_output << "public function " << class_name << "( p_Name:String=null )" << std::endl;
-	as_output << "{" << std::endl;
-	as_output << "super( p_Name ) ;" << std::endl << std::endl;
-
-	as_output << "geometry = generate() ;" << std::endl;
-	as_output << "}" << std::endl << std::endl;
-
-	as_output << "public function generate(... arguments):Geometry3D" << std::endl;
-	as_output << "{" << std::endl;
-	as_output << "l = new Geometry3D();	" << std::endl;
+	output_string(as_output, 
+		"package\n"
+		"{\n"
+		"import sandy.primitive.Primitive3D;\n\n"
+		"import sandy.core.scenegraph.Geometry3D;\n"
+		"import sandy.core.scenegraph.Shape3D;\n"
+		"public class "
+	);
+	output_string(as_output, class_name);
+	output_string(as_output, 
+		" extends Shape3D implements Primitive3D\n"
+		"{\n"
+		"private var l:Geometry3D ;\n"
+		"private function v(x:Number,y:Number,z:Number):void\n"
+		"{\n"
+		"l.setVertex(l.getNextVertexID(),x,y,z );\n"
+		"}\n"
+		"private function vn(nx:Number,ny:Number,nz:Number):void\n"
+		"{\n"
+		"l.setVertexNormal(l.getNextVertexNormalID(),nx,ny,nz );\n"
+		"}\n"
+		"private function uv(u:Number,v:Number):void\n"
+		"{\n"
+		"l.setUVCoords(l.getNextUVCoordID(),u,v);\n"
+		"}\n"
+		"private function f(vn0:int, vn1:int, vn2:int, uvn0:int, uvn1:int,uvn2:int):void\n"
+		"{\n"
+		"l.setFaceVertexIds(l.getNextFaceID(), vn0, vn1,vn2);\n"
+		"l.setFaceUVCoordsIds( l.getNextFaceUVCoordID(), uvn0,uvn1,uvn2);\n"
+		"}\n"
+		"public function "
+	);
+	output_string(as_output, class_name);
+	output_string(as_output, 
+		"( p_Name:String=null )\n"
+		"{\n"
+		"super( p_Name ) ;\n\n"
+		"geometry = generate() ;\n"
+		"}\n\n"
+		"public function generate(... arguments):Geometry3D\n"
+		"{\n"
+		"l = new Geometry3D();	\n"
+	);
 
 	// * export polygons *
 
@@ -352,25 +606,26 @@ bool geometry_export_sandy3d(const char * filename, Vertices & vertices, Polygon
 		if (!used[i]) continue;
 		
 		ids[i] = count++;
-		as_output << "v(" << -100 * visualization_normalize(vertex->x, X) << "," << 100 * visualization_normalize(vertex->y, Y) << "," << 100 * visualization_normalize(vertex->z, Z) << ");" << std::endl;
+		output_string(as_output, "v(");
+		geometry_export_triple(as_output, -100 * visualization_normalize(vertex->x, X), 100 * visualization_normalize(vertex->y, Y), 100 * visualization_normalize(vertex->z, Z), ',', ");\n");
 	}
 
 	// output polygons
 	for ALL(polygons, i)
 	{
 		size_t count = 0;
-		as_output << "l.setFaceVertexIds(l.getNextFaceID(), ";
+		output_string(as_output, "l.setFaceVertexIds(l.getNextFaceID(), ");
 		for ALL(polygons.data[i].vertices, j)
 		{
-			if (count > 0) as_output << ",";
-			as_output << ids[polygons.data[i].vertices.data[j].value];
+			if (count > 0) output_char(as_output, ',');
+			output_size(as_output, ids[polygons.data[i].vertices.data[j].value]);
 			count++;
 		}
-		as_output << ");" << std::endl;
+		output_string(as_output, ");\n");
 	}
 
 	// export pointcloud 
-	if (export_vertices) 
+	if (stars_output) 
 	{
 		/*const double point_size = 1.3;
 
@@ -389,10 +644,15 @@ bool geometry_export_sandy3d(const char * filename, Vertices & vertices, Polygon
 		for ALL(vertices, i) 
 		{
 			const Vertex * const vertex = vertices.data + i;
-			stars_output << "sf.stars.push(new Vertex (" << -100 * visualization_normalize(vertex->x, X) << "," << 100 * visualization_normalize(vertex->y, Y) << "," << 100 * visualization_normalize(vertex->z, Z) << "));" << std::endl;
-			stars_output << "sf.starColors.push(0xff000000 + " << (int)(255 * vertex->color[0]) * 0x010000 + (int)(255 * vertex->color[1]) * 0x0100 + (int)(255 * vertex->color[2]) << ");" << std::endl;
+			output_string(stars_output, "sf.stars.push(new Vertex (");
+			geometry_export_triple(stars_output, -100 * visualization_normalize(vertex->x, X), 100 * visualization_normalize(vertex->y, Y), 100 * visualization_normalize(vertex->z, Z), ',', "));\n");
+			output_string(stars_output, "sf.starColors.push(0xff000000 + ");
+			output_int(stars_output, (int)(255 * vertex->color[0]) * 0x010000 + (int)(255 * vertex->color[1]) * 0x0100 + (int)(255 * vertex->color[2]));
+			output_string(stars_output, ");\n");
 			// stars_output << "sf.starColors.push(0xffff0000);" << std::endl;
 		}
+
+		output_close(stars_output);
 	}
 
 	// release resources 
@@ -401,13 +661,14 @@ bool geometry_export_sandy3d(const char * filename, Vertices & vertices, Polygon
 	FREE(class_name);
 
 	// write footer
-	as_output << "return (l);" << std::endl;
-	as_output << "}" << std::endl;
-	as_output << "}" << std::endl;
-	as_output << "}" << std::endl;
-	as_output.close();
-
-	return true;
+	output_string(as_output, 
+		"return (l);\n"
+		"}\n"
+		"}\n"
+		"}\n"
+	);
+
+	return output_close(as_output);
 }
 
 // debugging export for calibration into VRLM
@@ -416,21 +677,21 @@ bool geometry_export_vrml_calibration(const char * filename, Calibration &calibr
 	Calibration_Vertices * const vertices = &calibration.Xs;
 	
 	// open file for output 
-	std::ofstream vrml_output(filename); 
+	Output_File * vrml_output = output_open(filename); 
 	if (!vrml_output) 
 	{
 		core_state.error = CORE_ERROR_UNABLE_TO_OPEN_FILE;
 		return false; 
 	}
-	vrml_output.precision(16);
+	output_set_precision(vrml_output, 16);
 
 	// write vrml header 
-	vrml_output << "#VRML V2.0 utf8" << std::endl; 
+	output_string(vrml_output, "#VRML V2.0 utf8\n"); 
 
 	// * export data *
 	
 	// vertices header
-	vrml_output << "Group { children [ Shape { geometry PointSet { coord Coordinate {point [" << std::endl;
+	output_string(vrml_output, "Group { children [ Shape { geometry PointSet { coord Coordinate {point [\n");
 
 	// dump all vertices as point cloud 
 	for ALL(*vertices, i) 
@@ -444,7 +705,7 @@ bool geometry_export_vrml_calibration(const char * filename, Calibration &calibr
 				x = -OPENCV_ELEM(vertex->X, 0, 0) / w,
 				y = -OPENCV_ELEM(vertex->X, 1, 0) / w, 
 				z = OPENCV_ELEM(vertex->X, 2, 0) / w;
-			vrml_output << x << " " << y << " " << z << " " << std::endl; 
+			geometry_export_triple(vrml_output, x, y, z, ' ', " \n"); 
 
 			/* 
 			// debug - used to indicate plane at infinity in the dataset
@@ -475,31 +736,63 @@ bool geometry_export_vrml_calibration(const char * filename, Calibration &calibr
 	}
 
 	// vertices footer
-	vrml_output << "] } } } ] }" << std::endl; 
+	output_string(vrml_output, "] } } } ] }\n"); 
 
-	vrml_output.close();
-	return true;
+	return output_close(vrml_output);
+}
+
+// xml attribute value with special characters escaped
+static void geometry_export_xml_string(Output_File * out, const char * s)
+{
+	while (*s)
+	{
+		const size_t plain = strcspn(s, "&<>\"");
+		output_write(out, s, plain);
+		s += plain;
+
+		switch (*s)
+		{
+			case '&': output_string(out, "&amp;"); break;
+			case '<': output_string(out, "&lt;"); break;
+			case '>': output_string(out, "&gt;"); break;
+			case '"': output_string(out, "&quot;"); break;
+			default: return;
+		}
+
+		s++;
+	}
+}
+
+// write numeric attribute ' name="value"' (output_printf would follow the locale)
+static void geometry_export_xml_attribute(Output_File * out, const char * name, const double value)
+{
+	output_char(out, ' ');
+	output_string(out, name);
+	output_string(out, "=\"");
+	output_double(out, value);
+	output_char(out, '"');
 }
 
 // exports calibration into RealVIZ exchange format supported by both ImageModeler and MatchMover
 bool geometry_export_rzml(const char * filename, Shots & shots)
 {
 	// open file for output 
-	std::ofstream rzml_output(filename); 
+	Output_File * rzml_output = output_open(filename, true); 
 	if (!rzml_output) 
 	{
 		core_state.error = CORE_ERROR_UNABLE_TO_OPEN_FILE;
 		return false;
 	}
 
-	rzml_output.precision(9);
-
 	// write header 
-	rzml_output << "<?xml version=\"1.0\" encoding=\"ISO-8859-1\" standalone=\"yes\"?>" << std::endl; 
+	output_set_precision(rzml_output, 9);
+	output_string(rzml_output, "<?xml version=\"1.0\" encoding=\"ISO-8859-1\" standalone=\"yes\"?>\n"); 
 	char * s = interface_filesystem_realviz_filename(filename); 
-	rzml_output << "<RZML v=\"1.3.0\" app=\"ib3dms\" path=\"" << s << "\">" << std::endl;
+	output_string(rzml_output, "<RZML v=\"1.3.0\" app=\"ib3dms\" path=\"");
+	geometry_export_xml_string(rzml_output, s);
+	output_string(rzml_output, "\">\n");
 	FREE(s);
-	rzml_output << "\t<EXPORT ulin=\"cm\"/>" << std::endl;
+	output_string(rzml_output, "\t<EXPORT ulin=\"cm\"/>\n");
 
 	// go through all shots and export their data
 	bool first = true; 
@@ -510,51 +803,815 @@ bool geometry_export_rzml(const char * filename, Shots & shots)
 
 		if (first) 
 		{
-			rzml_output 
-				<< "\t<CINF i=\"1\" n=\"Camera 01\" sw=\"" 
-				<< shot->width 
-				<< "\" sh=\"" 
-				<< shot->height 
-				<< "\" fbw=\"" 
-				<< shot->film_back 
-				<< "\" fbh=\"" 
-				<< shot->film_back 
-				<< "\" fovs=\"k\" fovx=\"" 
-				<< shot->fovx
-				<< "\"/>" << std::endl;
+			output_printf(rzml_output, "\t<CINF i=\"1\" n=\"Camera 01\" sw=\"%d\" sh=\"%d\"", shot->width, shot->height);
+			geometry_export_xml_attribute(rzml_output, "fbw", shot->film_back);
+			geometry_export_xml_attribute(rzml_output, "fbh", shot->film_back);
+			output_string(rzml_output, " fovs=\"k\"");
+			geometry_export_xml_attribute(rzml_output, "fovx", shot->fovx);
+			output_string(rzml_output, "/>\n");
 			first = false; 
 		}
 
 		s = interface_filesystem_realviz_filename(shot->image_filename);
 
 		// shot tag
-		rzml_output
-			<< "\t<SHOT i=\"" << realviz_id << "\" n=\"" << shot->name << "\" ci=\"1\" w=\"" << shot->width << "\" h=\"" << shot->height << "\">" << std::endl;
+		output_printf(rzml_output, "\t<SHOT i=\"%u\" n=\"", (unsigned int)realviz_id);
+		geometry_export_xml_string(rzml_output, shot->name ? shot->name : "");
+		output_printf(rzml_output, "\" ci=\"1\" w=\"%d\" h=\"%d\">\n", shot->width, shot->height);
 
 		// calibration data 
 		if (shot->calibrated)
 		{
-			rzml_output 
-				<< "\t\t<CFRM cf=\"1\" fovx=\"" << shot->fovx << "\" pr=\"1.00048852\">" << std::endl
-				<< "\t\t\t<T x=\"" << OPENCV_ELEM(shot->translation, 0, 0) << "\" y=\"" << OPENCV_ELEM(shot->translation, 1, 0) << "\" z=\"" << OPENCV_ELEM(shot->translation, 2, 0) << "\"/>" << std::endl
-				<< "\t\t\t<R x=\"" << rad2deg(shot->R_euler[0]) << "\" y=\"" << rad2deg(shot->R_euler[1]) << "\" z=\"" << rad2deg(shot->R_euler[2]) << "\"/>" << std::endl
-				<< "\t\t</CFRM>" << std::endl;
+			output_string(rzml_output, "\t\t<CFRM cf=\"1\"");
+			geometry_export_xml_attribute(rzml_output, "fovx", shot->fovx);
+			output_string(rzml_output, " pr=\"1.00048852\">\n\t\t\t<T");
+			geometry_export_xml_attribute(rzml_output, "x", OPENCV_ELEM(shot->translation, 0, 0));
+			geometry_export_xml_attribute(rzml_output, "y", OPENCV_ELEM(shot->translation, 1, 0));
+			geometry_export_xml_attribute(rzml_output, "z", OPENCV_ELEM(shot->translation, 2, 0));
+			output_string(rzml_output, "/>\n\t\t\t<R");
+			geometry_export_xml_attribute(rzml_output, "x", rad2deg(shot->R_euler[0]));
+			geometry_export_xml_attribute(rzml_output, "y", rad2deg(shot->R_euler[1]));
+			geometry_export_xml_attribute(rzml_output, "z", rad2deg(shot->R_euler[2]));
+			output_string(rzml_output, "/>\n\t\t</CFRM>\n");
 		}
 
 		// image plane 
-		rzml_output
-			<< "\t\t<IPLN img=\"" << s << "\">" << std::endl
-			<< "\t\t<IFRM/>" << std::endl
-			<< "\t\t</IPLN>" << std::endl;
+		output_string(rzml_output, "\t\t<IPLN img=\"");
+		geometry_export_xml_string(rzml_output, s);
+		output_string(rzml_output, "\">\n\t\t<IFRM/>\n\t\t</IPLN>\n");
 
 		// finalize shot
-		rzml_output << "\t</SHOT>" << std::endl; 
+		output_string(rzml_output, "\t</SHOT>\n"); 
 		FREE(s);
 		realviz_id++;
 	}
 
-	rzml_output << "</RZML>";
-	rzml_output.close();
+	output_string(rzml_output, "</RZML>");
+
+	return output_close(rzml_output);
+}
+
+// export reconstructed vertices (with normals, colors and groups) into binary PLY
+bool geometry_export_ply(const char * filename, Vertices & vertices)
+{
+	// we need to know the count before writing the header
+	size_t count = 0;
+	for ALL(vertices, i) 
+	{
+		if (vertices.data[i].reconstructed) count++;
+	}
+
+	Output_File * ply_output = output_open(filename, true); 
+	if (!ply_output) 
+	{
+		core_state.error = CORE_ERROR_UNABLE_TO_OPEN_FILE;
+		return false;
+	}
+
+	// records are written in machine's byte order, the header says which one it is
+	const unsigned int byte_order = 1;
+	output_string(ply_output, "ply\nformat ");
+	output_string(ply_output, *(const unsigned char *)&byte_order ? "binary_little_endian" : "binary_big_endian");
+	output_string(ply_output, " 1.0\ncomment insight3d point cloud\nelement vertex ");
+	output_size(ply_output, count);
+	output_string(ply_output, 
+		"\n"
+		"property double x\n"
+		"property double y\n"
+		"property double z\n"
+		"property float nx\n"
+		"property float ny\n"
+		"property float nz\n"
+		"property uchar red\n"
+		"property uchar green\n"
+		"property uchar blue\n"
+		"property uint group\n"
+		"end_header\n"
+	);
+
+	// one packed record per vertex 
+	for ALL(vertices, i) 
+	{
+		const Vertex * const vertex = vertices.data + i; 
+		if (!vertex->reconstructed) continue;
+
+		unsigned char record[3 * sizeof(double) + 3 * sizeof(float) + 3 + sizeof(unsigned int)], * p = record;
+		const double position[3] = { vertex->x, vertex->y, vertex->z };
+		const float normal[3] = { (float)vertex->nx, (float)vertex->ny, (float)vertex->nz };
+		const unsigned int group = (unsigned int)vertex->group;
+		memcpy(p, position, sizeof(position));
+		p += sizeof(position);
+		memcpy(p, normal, sizeof(normal));
+		p += sizeof(normal);
+
+		for (int k = 0; k < 3; k++) 
+		{
+			const float c = vertex->color[k] < 0 ? 0 : vertex->color[k] > 1 ? 1 : vertex->color[k];
+			*p++ = (unsigned char)(255 * c + 0.5f);
+		}
+
+		memcpy(p, &group, sizeof(group));
+		output_write(ply_output, record, sizeof(record));
+	}
+
+	return output_close(ply_output);
+}
+
+// * mesh export (obj, gltf) *
+
+// textures of polygons are copied into one atlas image of at most this size (shrunk if they don't fit)
+static const int GEOMETRY_EXPORT_ATLAS_MAX_SIZE = 8192;
+static const int GEOMETRY_EXPORT_ATLAS_GUTTER = 2;   // pixels copied around each texture to avoid bleeding
+static const int GEOMETRY_EXPORT_ATLAS_BLANK = 4;    // white square in the corner, textures untextured polygons in gltf
+
+// polygon's texture in the atlas
+struct Geometry_Export_Texture
+{
+	size_t shot_id;
+	double x1, y1, x2, y2;          // copied rectangle of shot's image (relative coordinates, gutter included)
+	double tx1, ty1, tx2, ty2;      // rectangle spanned by polygon's texture coordinates
+	int width, height;              // size of the copied rectangle in pixels
+	int x, y, packed_width, packed_height; // place in the atlas
+};
+
+// exported polygon
+struct Geometry_Export_Face
+{
+	size_t first, count;            // range of corners
+	size_t texture;                 // SIZE_MAX if untextured
+};
+
+// mesh collected from polygons in one pass, vertices are reindexed in order of first use
+struct Geometry_Export_Mesh
+{
+	size_t * ids;                   // output index of each vertex (SIZE_MAX if it isn't used)
+	double * positions;             // 3 per output vertex
+	size_t vertices_count, positions_allocated;
+
+	size_t * corners;               // output vertex of each corner
+	double * texture_coords;        // polygon's texture coordinates of each corner
+	size_t corners_count, corners_allocated, texture_coords_allocated;
+
+	Geometry_Export_Face * faces;
+	size_t faces_count, faces_allocated;
+
+	Geometry_Export_Texture * textures;
+	size_t textures_count, textures_allocated;
+
+	int atlas_width, atlas_height;  // 0 if nothing is textured
+};
+
+// make sure that the buffer can hold given number of items
+template<typename T> static bool geometry_export_reserve(T * & data, size_t & allocated, const size_t count)
+{
+	if (count <= allocated) return true;
+	size_t size = allocated ? allocated : 256;
+	while (size < count) size *= 2;
+	T * const resized = (T *)realloc(data, size * sizeof(T));
+	if (!resized) return false;
+	data = resized;
+	allocated = size;
+	return true;
+}
+
+static void geometry_export_mesh_free(Geometry_Export_Mesh & mesh)
+{
+	FREE(mesh.ids);
+	FREE(mesh.positions);
+	FREE(mesh.corners);
+	FREE(mesh.texture_coords);
+	FREE(mesh.faces);
+	FREE(mesh.textures);
+	memset(&mesh, 0, sizeof(mesh));
+}
+
+// find out which part of which image the polygon's texture comes from 
+static bool geometry_export_mesh_texture(const Polygon_3d * const polygon, const size_t corners_count, Geometry_Export_Texture & texture)
+{
+	if (!polygon->texture_coords || !image_loader_nonempty_handle(polygon->image_loader_request)) return false;
+	if (!image_loader_get_region(polygon->image_loader_request, &texture.shot_id, &texture.tx1, &texture.ty1, &texture.tx2, &texture.ty2)) return false;
+	if (!validate_shot(texture.shot_id) || texture.tx2 <= texture.tx1 || texture.ty2 <= texture.ty1 || corners_count < 3) return false;
+
+	// size of the image (read from header if it isn't known yet)
+	const Shot * const shot = shots.data + texture.shot_id;
+	int width = shot->width, height = shot->height;
+	if (shot->info_status < GEOMETRY_INFO_DEDUCED || width <= 0 || height <= 0)
+	{
+		Image_Info info;
+		if (!shot->image_filename || !image_info_probe(shot->image_filename, info)) return false;
+		width = info.width;
+		height = info.height;
+	}
+
+	// pixels covered by the texture and the gutter
+	int x1 = (int)floor(texture.tx1 * width) - GEOMETRY_EXPORT_ATLAS_GUTTER, x2 = (int)ceil(texture.tx2 * width) + GEOMETRY_EXPORT_ATLAS_GUTTER;
+	int y1 = (int)floor(texture.ty1 * height) - GEOMETRY_EXPORT_ATLAS_GUTTER, y2 = (int)ceil(texture.ty2 * height) + GEOMETRY_EXPORT_ATLAS_GUTTER;
+	if (x1 < 0) x1 = 0;
+	if (y1 < 0) y1 = 0;
+	if (x2 > width) x2 = width;
+	if (y2 > height) y2 = height;
+	if (x2 <= x1 || y2 <= y1) return false;
+
+	texture.x1 = x1 / (double)width;
+	texture.y1 = y1 / (double)height;
+	texture.x2 = x2 / (double)width;
+	texture.y2 = y2 / (double)height;
+	texture.width = x2 - x1;
+	texture.height = y2 - y1;
+	return true;
+}
+
+// collect polygons, their vertices and textures
+static bool geometry_export_mesh_collect(Geometry_Export_Mesh & mesh, const Vertices & vertices, const Polygons_3d & polygons)
+{
+	memset(&mesh, 0, sizeof(mesh));
+	mesh.ids = ALLOC(size_t, vertices.count + 1);
+	if (!mesh.ids) return false;
+	memset(mesh.ids, 0xff, sizeof(size_t) * (vertices.count + 1));
+
+	for ALL(polygons, i)
+	{
+		const Polygon_3d * const polygon = polygons.data + i;
+
+		// polygons with vertices which weren't reconstructed can't be exported
+		size_t count = 0;
+		bool complete = true;
+		for ALL(polygon->vertices, j)
+		{
+			const size_t vertex_id = polygon->vertices.data[j].value;
+			if (!validate_vertex(vertex_id) || !vertices.data[vertex_id].reconstructed) complete = false;
+			count++;
+		}
+		if (!complete || count < 3) continue;
+
+		if (
+			!geometry_export_reserve(mesh.faces, mesh.faces_allocated, mesh.faces_count + 1) ||
+			!geometry_export_reserve(mesh.corners, mesh.corners_allocated, mesh.corners_count + count) ||
+			!geometry_export_reserve(mesh.texture_coords, mesh.texture_coords_allocated, 2 * (mesh.corners_count + count)) ||
+			!geometry_export_reserve(mesh.textures, mesh.textures_allocated, mesh.textures_count + 1) ||
+			!geometry_export_reserve(mesh.positions, mesh.positions_allocated, 3 * (mesh.vertices_count + count))
+		)
+		{
+			geometry_export_mesh_free(mesh);
+			return false;
+		}
+
+		Geometry_Export_Face * const face = mesh.faces + mesh.faces_count++;
+		face->first = mesh.corners_count;
+		face->count = count;
+		face->texture = SIZE_MAX;
+		if (geometry_export_mesh_texture(polygon, count, mesh.textures[mesh.textures_count]))
+		{
+			face->texture = mesh.textures_count++;
+		}
+
+		size_t n = 0;
+		for ALL(polygon->vertices, j)
+		{
+			const size_t vertex_id = polygon->vertices.data[j].value;
+
+			// vertex is written when it's first used
+			if (mesh.ids[vertex_id] == SIZE_MAX)
+			{
+				const Vertex * const vertex = vertices.data + vertex_id;
+				double * const position = mesh.positions + 3 * mesh.vertices_count;
+				position[0] = -visualization_normalize(vertex->x, X);
+				position[1] = -visualization_normalize(vertex->y, Y);
+				position[2] = visualization_normalize(vertex->z, Z);
+				mesh.ids[vertex_id] = mesh.vertices_count++;
+			}
+
+			mesh.corners[mesh.corners_count] = mesh.ids[vertex_id];
+			mesh.texture_coords[2 * mesh.corners_count + 0] = face->texture != SIZE_MAX ? polygon->texture_coords[2 * n + 0] : 0;
+			mesh.texture_coords[2 * mesh.corners_count + 1] = face->texture != SIZE_MAX ? polygon->texture_coords[2 * n + 1] : 0;
+			mesh.corners_count++;
+			n++;
+		}
+	}
 
 	return true;
 }
+
+// sort textures by height (tallest first) and by shot
+static int geometry_export_compare_height(const void * a, const void * b)
+{
+	const int ha = (*(const Geometry_Export_Texture * const *)a)->height, hb = (*(const Geometry_Export_Texture * const *)b)->height;
+	return ha > hb ? -1 : ha < hb ? 1 : 0;
+}
+
+static int geometry_export_compare_shot(const void * a, const void * b)
+{
+	const size_t sa = (*(const Geometry_Export_Texture * const *)a)->shot_id, sb = (*(const Geometry_Export_Texture * const *)b)->shot_id;
+	return sa < sb ? -1 : sa > sb ? 1 : 0;
+}
+
+// place textures on shelves of the atlas, shrinking them until they fit
+static bool geometry_export_mesh_pack(Geometry_Export_Mesh & mesh, Geometry_Export_Texture ** order)
+{
+	qsort(order, mesh.textures_count, sizeof(Geometry_Export_Texture *), geometry_export_compare_height);
+
+	double scale = 1;
+	for (int attempt = 0; attempt < 32; attempt++, scale *= 0.8)
+	{
+		// scaled sizes and the width of the atlas (power of two holding their area)
+		double area = GEOMETRY_EXPORT_ATLAS_BLANK * GEOMETRY_EXPORT_ATLAS_BLANK;
+		int widest = GEOMETRY_EXPORT_ATLAS_BLANK;
+		for (size_t i = 0; i < mesh.textures_count; i++)
+		{
+			Geometry_Export_Texture * const texture = order[i];
+			texture->packed_width = (int)(scale * texture->width);
+			texture->packed_height = (int)(scale * texture->height);
+			if (texture->packed_width < 1) texture->packed_width = 1;
+			if (texture->packed_height < 1) texture->packed_height = 1;
+			area += texture->packed_width * (double)texture->packed_height;
+			if (texture->packed_width > widest) widest = texture->packed_width;
+		}
+
+		int width = 64;
+		while (width < GEOMETRY_EXPORT_ATLAS_MAX_SIZE && (width < widest || (double)width * width < area)) width *= 2;
+		if (widest > width) continue;
+
+		// shelves (the blank square starts the first one)
+		int shelf_x = GEOMETRY_EXPORT_ATLAS_BLANK, shelf_y = 0, shelf_height = GEOMETRY_EXPORT_ATLAS_BLANK;
+		for (size_t i = 0; i < mesh.textures_count; i++)
+		{
+			Geometry_Export_Texture * const texture = order[i];
+			if (shelf_x + texture->packed_width > width)
+			{
+				shelf_y += shelf_height;
+				shelf_x = 0;
+				shelf_height = 0;
+			}
+
+			texture->x = shelf_x;
+			texture->y = shelf_y;
+			shelf_x += texture->packed_width;
+			if (texture->packed_height > shelf_height) shelf_height = texture->packed_height;
+		}
+
+		const int height = (shelf_y + shelf_height + 3) & ~3;
+		if (height <= GEOMETRY_EXPORT_ATLAS_MAX_SIZE)
+		{
+			mesh.atlas_width = width;
+			mesh.atlas_height = height;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// copy textures from images into the atlas and save it, every image is loaded just once
+// obtains LOCK_RW(opencv)
+static bool geometry_export_mesh_atlas(Geometry_Export_Mesh & mesh, const char * atlas_filename)
+{
+	mesh.atlas_width = mesh.atlas_height = 0;
+	if (mesh.textures_count == 0) return false;
+
+	Geometry_Export_Texture ** const order = ALLOC(Geometry_Export_Texture *, mesh.textures_count);
+	if (!order) return false;
+	for (size_t i = 0; i < mesh.textures_count; i++) order[i] = mesh.textures + i;
+
+	if (!geometry_export_mesh_pack(mesh, order))
+	{
+		FREE(order);
+		return false;
+	}
+
+	qsort(order, mesh.textures_count, sizeof(Geometry_Export_Texture *), geometry_export_compare_shot);
+
+	bool saved = false;
+	LOCK_RW(opencv)
+	{
+		IplImage * atlas = cvCreateImage(cvSize(mesh.atlas_width, mesh.atlas_height), IPL_DEPTH_8U, 3);
+		cvSet(atlas, cvScalar(128, 128, 128));
+		cvSetImageROI(atlas, cvRect(0, 0, GEOMETRY_EXPORT_ATLAS_BLANK, GEOMETRY_EXPORT_ATLAS_BLANK));
+		cvSet(atlas, cvScalar(255, 255, 255));
+		cvResetImageROI(atlas);
+
+		for (size_t i = 0; i < mesh.textures_count; )
+		{
+			// textures coming from this image
+			const size_t shot_id = order[i]->shot_id;
+			size_t end = i;
+			while (end < mesh.textures_count && order[end]->shot_id == shot_id) end++;
+
+			IplImage * image = cvLoadImage(shots.data[shot_id].image_filename, 1);
+			if (!image)
+			{
+				printf("Unable to load image '%s', its textures are left out.\n", shots.data[shot_id].image_filename);
+				i = end;
+				continue;
+			}
+
+			for (; i < end; i++)
+			{
+				const Geometry_Export_Texture * const texture = order[i];
+				int x1 = (int)floor(texture->x1 * image->width + 0.5), y1 = (int)floor(texture->y1 * image->height + 0.5);
+				int x2 = (int)floor(texture->x2 * image->width + 0.5), y2 = (int)floor(texture->y2 * image->height + 0.5);
+				if (x2 > image->width) x2 = image->width;
+				if (y2 > image->height) y2 = image->height;
+				if (x2 <= x1 || y2 <= y1) continue;
+
+				cvSetImageROI(image, cvRect(x1, y1, x2 - x1, y2 - y1));
+				cvSetImageROI(atlas, cvRect(texture->x, texture->y, texture->packed_width, texture->packed_height));
+				cvResize(image, atlas, CV_INTER_AREA);
+			}
+
+			cvResetImageROI(atlas);
+			cvReleaseImage(&image);
+		}
+
+		saved = cvSaveImage(atlas_filename, atlas) != 0;
+		cvReleaseImage(&atlas);
+	}
+	UNLOCK_RW(opencv);
+
+	FREE(order);
+	if (!saved) mesh.atlas_width = mesh.atlas_height = 0;
+	return saved;
+}
+
+// atlas coordinates of corner (relative, origin in the top left corner)
+static void geometry_export_mesh_uv(const Geometry_Export_Mesh & mesh, const Geometry_Export_Face * const face, const size_t corner, double & u, double & v)
+{
+	if (face->texture == SIZE_MAX || !mesh.atlas_width)
+	{
+		u = v = 0.5 * GEOMETRY_EXPORT_ATLAS_BLANK;
+	}
+	else
+	{
+		const Geometry_Export_Texture * const texture = mesh.textures + face->texture;
+		const double 
+			x = texture->tx1 + mesh.texture_coords[2 * corner + 0] * (texture->tx2 - texture->tx1),
+			y = texture->ty1 + mesh.texture_coords[2 * corner + 1] * (texture->ty2 - texture->ty1);
+		u = texture->x + (x - texture->x1) / (texture->x2 - texture->x1) * texture->packed_width;
+		v = texture->y + (y - texture->y1) / (texture->y2 - texture->y1) * texture->packed_height;
+	}
+
+	u /= mesh.atlas_width ? mesh.atlas_width : 1;
+	v /= mesh.atlas_height ? mesh.atlas_height : 1;
+}
+
+// filename with extension replaced (has to be freed)
+static char * geometry_export_sibling_filename(const char * filename, const char * suffix)
+{
+	size_t length = strlen(filename);
+	const char * const dot = strrchr(filename, '.');
+	if (dot && !strpbrk(dot, FILESYSTEM_PATH_SEPARATORS)) length = dot - filename;
+
+	char * const sibling = ALLOC(char, length + strlen(suffix) + 1);
+	memcpy(sibling, filename, length);
+	strcpy(sibling + length, suffix);
+	return sibling;
+}
+
+// check that there's something to export (frees the mesh if there isn't)
+static bool geometry_export_mesh_check(Geometry_Export_Mesh & mesh)
+{
+	if (mesh.faces_count > 0) return true;
+
+	printf("Nothing to export, no polygon has all of its vertices reconstructed.\n");
+	geometry_export_mesh_free(mesh);
+	return false;
+}
+
+// export polygons into Wavefront OBJ with material library and texture atlas next to it
+// obtains LOCK_RW(opencv)
+bool geometry_export_obj(const char * filename, Vertices & vertices, Polygons_3d & polygons)
+{
+	Geometry_Export_Mesh mesh;
+	if (!geometry_export_mesh_collect(mesh, vertices, polygons)) 
+	{
+		core_state.error = CORE_ERROR_OUT_OF_MEMORY;
+		return false;
+	}
+
+	// nothing to export
+	if (!geometry_export_mesh_check(mesh)) return false;
+
+	char * const mtl_filename = geometry_export_sibling_filename(filename, ".mtl");
+	char * const atlas_filename = geometry_export_sibling_filename(filename, "_atlas.png");
+	const bool textured = geometry_export_mesh_atlas(mesh, atlas_filename);
+
+	// materials 
+	Output_File * mtl_output = output_open(mtl_filename);
+	Output_File * obj_output = mtl_output ? output_open(filename, true) : NULL;
+	if (!obj_output)
+	{
+		if (mtl_output) output_close(mtl_output);
+		FREE(mtl_filename);
+		FREE(atlas_filename);
+		geometry_export_mesh_free(mesh);
+		core_state.error = CORE_ERROR_UNABLE_TO_OPEN_FILE;
+		return false;
+	}
+
+	output_string(mtl_output, "# insight3d materials\nnewmtl untextured\nKa 0.5 0.5 0.5\nKd 0.5 0.5 0.5\nKs 0 0 0\nillum 1\n");
+	if (textured)
+	{
+		char * const atlas_name = interface_filesystem_extract_filename(atlas_filename);
+		output_string(mtl_output, "newmtl atlas\nKa 1 1 1\nKd 1 1 1\nKs 0 0 0\nillum 1\nmap_Kd ");
+		output_string(mtl_output, atlas_name);
+		output_char(mtl_output, '\n');
+		FREE(atlas_name);
+	}
+	const bool mtl_written = output_close(mtl_output);
+
+	// geometry 
+	output_set_precision(obj_output, 9);
+	char * const mtl_name = interface_filesystem_extract_filename(mtl_filename);
+	output_string(obj_output, "# insight3d mesh\nmtllib ");
+	output_string(obj_output, mtl_name);
+	output_char(obj_output, '\n');
+	FREE(mtl_name);
+
+	for (size_t i = 0; i < mesh.vertices_count; i++)
+	{
+		output_string(obj_output, "v ");
+		geometry_export_triple(obj_output, mesh.positions[3 * i + 0], mesh.positions[3 * i + 1], mesh.positions[3 * i + 2], ' ', "\n");
+	}
+
+	// texture coordinates of textured corners (obj has origin in the bottom left corner)
+	for (size_t i = 0; textured && i < mesh.faces_count; i++)
+	{
+		const Geometry_Export_Face * const face = mesh.faces + i;
+		if (face->texture == SIZE_MAX) continue;
+
+		for (size_t k = face->first; k < face->first + face->count; k++)
+		{
+			double u, v;
+			geometry_export_mesh_uv(mesh, face, k, u, v);
+			output_string(obj_output, "vt ");
+			output_double(obj_output, u);
+			output_char(obj_output, ' ');
+			output_double(obj_output, 1 - v);
+			output_char(obj_output, '\n');
+		}
+	}
+
+	// faces grouped by material (obj indices start at 1)
+	size_t texture_coord = 1;
+	for (int material = textured ? 1 : 0; material >= 0; material--)
+	{
+		output_string(obj_output, material ? "usemtl atlas\n" : "usemtl untextured\n");
+		for (size_t i = 0; i < mesh.faces_count; i++)
+		{
+			const Geometry_Export_Face * const face = mesh.faces + i;
+			const bool face_textured = textured && face->texture != SIZE_MAX;
+			if (face_textured != (material == 1)) continue;
+
+			output_char(obj_output, 'f');
+			for (size_t k = face->first; k < face->first + face->count; k++)
+			{
+				output_char(obj_output, ' ');
+				output_size(obj_output, mesh.corners[k] + 1);
+				if (face_textured)
+				{
+					output_char(obj_output, '/');
+					output_size(obj_output, texture_coord++);
+				}
+			}
+			output_char(obj_output, '\n');
+		}
+	}
+
+	FREE(mtl_filename);
+	FREE(atlas_filename);
+	geometry_export_mesh_free(mesh);
+	return output_close(obj_output) && mtl_written;
+}
+
+// text composed in memory (glb header holds length of the json before the json itself)
+struct Geometry_Export_Text
+{
+	char * data;
+	size_t length, allocated;
+	bool failed;
+};
+
+static void geometry_export_text(Geometry_Export_Text & text, const char * format, ...)
+{
+	va_list arguments;
+	va_start(arguments, format);
+	va_list copy;
+	va_copy(copy, arguments);
+	const int length = vsnprintf(NULL, 0, format, copy);
+	va_end(copy);
+
+	if (length < 0 || !geometry_export_reserve(text.data, text.allocated, text.length + length + 1))
+	{
+		text.failed = true;
+	}
+	else
+	{
+		vsnprintf(text.data + text.length, length + 1, format, arguments);
+		text.length += length;
+	}
+	va_end(arguments);
+}
+
+// append string in quotes, escaping what json needs escaped
+static void geometry_export_text_json_string(Geometry_Export_Text & text, const char * s)
+{
+	geometry_export_text(text, "\"");
+	for (; *s; s++)
+	{
+		if (*s == '"' || *s == '\\') geometry_export_text(text, "\\%c", *s);
+		else if ((unsigned char)*s >= 32) geometry_export_text(text, "%c", *s);
+	}
+	geometry_export_text(text, "\"");
+}
+
+// append three numbers separated by commas
+static void geometry_export_text_triple(Geometry_Export_Text & text, const double * values)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		char number[32];
+		output_format_double(number, (float)values[i]);
+		geometry_export_text(text, i ? ",%s" : "%s", number);
+	}
+}
+
+// export polygons into binary glTF (.glb), the texture atlas is saved next to it 
+// obtains LOCK_RW(opencv)
+bool geometry_export_gltf(const char * filename, Vertices & vertices, Polygons_3d & polygons)
+{
+	Geometry_Export_Mesh mesh;
+	if (!geometry_export_mesh_collect(mesh, vertices, polygons)) 
+	{
+		core_state.error = CORE_ERROR_OUT_OF_MEMORY;
+		return false;
+	}
+
+	// gltf doesn't allow empty accessors, so there would be no valid file to write
+	if (!geometry_export_mesh_check(mesh)) return false;
+
+	char * const atlas_filename = geometry_export_sibling_filename(filename, "_atlas.png");
+	const bool textured = geometry_export_mesh_atlas(mesh, atlas_filename);
+
+	// gltf vertices: untextured polygons share them, corners of textured ones have their own
+	size_t * const shared = ALLOC(size_t, mesh.vertices_count + 1);
+	float * const positions = ALLOC(float, 3 * (mesh.corners_count + 1));
+	float * const uvs = ALLOC(float, 2 * (mesh.corners_count + 1));
+	unsigned int * const indices = ALLOC(unsigned int, 3 * (mesh.corners_count + 1));
+	if (!shared || !positions || !uvs || !indices)
+	{
+		FREE(shared);
+		FREE(positions);
+		FREE(uvs);
+		FREE(indices);
+		FREE(atlas_filename);
+		geometry_export_mesh_free(mesh);
+		core_state.error = CORE_ERROR_OUT_OF_MEMORY;
+		return false;
+	}
+	memset(shared, 0xff, sizeof(size_t) * (mesh.vertices_count + 1));
+
+	size_t count = 0, indices_count = 0;
+	double min[3] = { 0, 0, 0 }, max[3] = { 0, 0, 0 };
+	size_t * const loop = mesh.corners; // corners are replaced by gltf vertices as we go
+	for (size_t i = 0; i < mesh.faces_count; i++)
+	{
+		const Geometry_Export_Face * const face = mesh.faces + i;
+		const bool face_textured = textured && face->texture != SIZE_MAX;
+
+		for (size_t k = face->first; k < face->first + face->count; k++)
+		{
+			const size_t vertex = mesh.corners[k];
+			if (!face_textured && shared[vertex] != SIZE_MAX)
+			{
+				loop[k] = shared[vertex];
+				continue;
+			}
+
+			double u, v;
+			geometry_export_mesh_uv(mesh, face, k, u, v);
+			uvs[2 * count + 0] = (float)u;
+			uvs[2 * count + 1] = (float)v;
+			for (int j = 0; j < 3; j++)
+			{
+				const double p = mesh.positions[3 * vertex + j];
+				positions[3 * count + j] = (float)p;
+				if (count == 0 || p < min[j]) min[j] = p;
+				if (count == 0 || p > max[j]) max[j] = p;
+			}
+
+			if (!face_textured) shared[vertex] = count;
+			loop[k] = count++;
+		}
+
+		// polygons are triangulated as fans
+		for (size_t k = face->first + 1; k + 1 < face->first + face->count; k++)
+		{
+			indices[indices_count++] = (unsigned int)loop[face->first];
+			indices[indices_count++] = (unsigned int)loop[k];
+			indices[indices_count++] = (unsigned int)loop[k + 1];
+		}
+	}
+
+	// glb is little endian
+	const unsigned int byte_order = 1;
+	if (!*(const unsigned char *)&byte_order)
+	{
+		unsigned char * const data[3] = { (unsigned char *)positions, (unsigned char *)uvs, (unsigned char *)indices };
+		const size_t sizes[3] = { 3 * count, 2 * count, indices_count };
+		for (int j = 0; j < 3; j++)
+		{
+			for (size_t k = 0; k < sizes[j]; k++)
+			{
+				unsigned char * const p = data[j] + 4 * k, t0 = p[0], t1 = p[1];
+				p[0] = p[3]; p[1] = p[2]; p[2] = t1; p[3] = t0;
+			}
+		}
+	}
+
+	// json describing the buffer, which holds positions, indices and texture coordinates (in this order)
+	const size_t positions_size = 12 * count, indices_size = 4 * indices_count, uvs_size = textured ? 8 * count : 0;
+	Geometry_Export_Text json;
+	memset(&json, 0, sizeof(json));
+	geometry_export_text(json, 
+		"{\"asset\":{\"version\":\"2.0\",\"generator\":\"insight3d\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+		"\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0%s},\"indices\":1,\"material\":0,\"mode\":4}]}],", 
+		textured ? ",\"TEXCOORD_0\":2" : ""
+	);
+
+	if (textured)
+	{
+		char * const atlas_name = interface_filesystem_extract_filename(atlas_filename);
+		geometry_export_text(json, 
+			"\"materials\":[{\"pbrMetallicRoughness\":{\"baseColorTexture\":{\"index\":0},\"metallicFactor\":0},\"doubleSided\":true}],"
+			"\"textures\":[{\"source\":0,\"sampler\":0}],\"samplers\":[{\"magFilter\":9729,\"minFilter\":9729}],\"images\":[{\"uri\":"
+		);
+		geometry_export_text_json_string(json, atlas_name);
+		geometry_export_text(json, "}],");
+		FREE(atlas_name);
+	}
+	else
+	{
+		geometry_export_text(json, "\"materials\":[{\"pbrMetallicRoughness\":{\"baseColorFactor\":[0.5,0.5,0.5,1],\"metallicFactor\":0},\"doubleSided\":true}],");
+	}
+
+	geometry_export_text(json, 
+		"\"buffers\":[{\"byteLength\":%lu}],\"bufferViews\":["
+		"{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%lu,\"target\":34962},"
+		"{\"buffer\":0,\"byteOffset\":%lu,\"byteLength\":%lu,\"target\":34963}", 
+		(unsigned long)(positions_size + indices_size + uvs_size), (unsigned long)positions_size, 
+		(unsigned long)positions_size, (unsigned long)indices_size
+	);
+	if (textured) 
+	{
+		geometry_export_text(json, ",{\"buffer\":0,\"byteOffset\":%lu,\"byteLength\":%lu,\"target\":34962}", (unsigned long)(positions_size + indices_size), (unsigned long)uvs_size);
+	}
+
+	geometry_export_text(json, "],\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":%lu,\"type\":\"VEC3\",\"min\":[", (unsigned long)count);
+	geometry_export_text_triple(json, min);
+	geometry_export_text(json, "],\"max\":[");
+	geometry_export_text_triple(json, max);
+	geometry_export_text(json, "]},{\"bufferView\":1,\"componentType\":5125,\"count\":%lu,\"type\":\"SCALAR\"}", (unsigned long)indices_count);
+	if (textured) 
+	{
+		geometry_export_text(json, ",{\"bufferView\":2,\"componentType\":5126,\"count\":%lu,\"type\":\"VEC2\"}", (unsigned long)count);
+	}
+	geometry_export_text(json, "]}");
+
+	// container: header, json chunk (padded with spaces) and binary chunk
+	Output_File * const glb_output = json.failed ? NULL : output_open(filename, true);
+	bool ok = glb_output != NULL;
+	if (ok)
+	{
+		const size_t json_size = (json.length + 3) & ~(size_t)3, bin_size = positions_size + indices_size + uvs_size;
+		const unsigned int header[7] = { 
+			0x46546c67, 2, (unsigned int)(12 + 8 + json_size + 8 + bin_size), // magic "glTF", version, length
+			(unsigned int)json_size, 0x4e4f534a,                              // "JSON" chunk 
+			(unsigned int)bin_size, 0x004e4942                                // "BIN" chunk
+		};
+
+		unsigned char bytes[sizeof(header)];
+		for (int j = 0; j < 7; j++)
+		{
+			for (int k = 0; k < 4; k++) bytes[4 * j + k] = (unsigned char)(header[j] >> (8 * k));
+		}
+
+		output_write(glb_output, bytes, 20);
+		output_write(glb_output, json.data, json.length);
+		output_write(glb_output, "   ", json_size - json.length);
+		output_write(glb_output, bytes + 20, 8);
+		output_write(glb_output, positions, positions_size);
+		output_write(glb_output, indices, indices_size);
+		output_write(glb_output, uvs, uvs_size);
+		ok = output_close(glb_output);
+	}
+
+	FREE(json.data);
+	FREE(shared);
+	FREE(positions);
+	FREE(uvs);
+	FREE(indices);
+	FREE(atlas_filename);
+	geometry_export_mesh_free(mesh);
+
+	if (!ok) core_state.error = json.failed ? CORE_ERROR_OUT_OF_MEMORY : CORE_ERROR_UNABLE_TO_OPEN_FILE;
+	return ok;
+}
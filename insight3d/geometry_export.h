@@ -2,15 +2,20 @@
 #define __GEOMETRY_EXPORT
 
 #include "interface_filesystem.h"
+#include "core_output.h"
 #include "core_math_routines.h"
 #include "geometry_structures.h"
+#include "geometry_project_format.h"
 #include "ui_visualization.h"
-#include <fstream> 
-#include <string>
+#include "core_image_loader.h"
+#include "core_image_info.h"
 
-// save insight3d project
+// save insight3d project (in binary format if filename has GEOMETRY_PROJECT_BINARY_EXTENSION)
 bool geometry_save(const char * filename);
 
+// save insight3d project in binary format 
+bool geometry_save_binary(const char * filename);
+
 // export scene into VRML
 bool geometry_export_vrml(const char * filename, Vertices & vertices, Polygons_3d & polygons, bool export_vertices = false, bool export_polygons = true, size_t restrict_vertices_by_group = 0);
 
@@ -23,4 +28,13 @@ bool geometry_export_vrml_calibration(const char * filename, Calibration &calibr
 // exports calibration into RealVIZ exchange format supported by both ImageModeler and MatchMover
 bool geometry_export_rzml(const char * filename, Shots & shots);
 
+// export reconstructed vertices (with normals, colors and groups) into binary PLY
+bool geometry_export_ply(const char * filename, Vertices & vertices);
+
+// export polygons into Wavefront OBJ (with .mtl file) or binary glTF; extracted textures are packed 
+// into one atlas saved next to the model as <name>_atlas.png (every image is loaded only once)
+// obtains LOCK_RW(opencv)
+bool geometry_export_obj(const char * filename, Vertices & vertices, Polygons_3d & polygons);
+bool geometry_export_gltf(const char * filename, Vertices & vertices, Polygons_3d & polygons);
+
 #endif
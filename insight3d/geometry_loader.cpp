@@ -2,29 +2,301 @@
 
 /* loader constants */ 
 
-// xml elements
-/*const xmlChar * XML_ELEM_SHOT = xmlCharStrdup("SHOT"); 
-const xmlChar * XML_ELEM_TRANSLATION = xmlCharStrdup("T");
-const xmlChar * XML_ELEM_ROTATION = xmlCharStrdup("R");
-const xmlChar * XML_ELEM_CAMERA = xmlCharStrdup("CINF"); 
-const xmlChar * XML_ELEM_FRAME = xmlCharStrdup("CFRM");
-const xmlChar * XML_ELEM_IMAGE_PLANE = xmlCharStrdup("IPLN");
-const xmlChar * XML_ELEM_VERTEX = xmlCharStrdup("P");
-
-// xml attributes
-const xmlChar * XML_ATTR_NAME = xmlCharStrdup("n"); 
-const xmlChar * XML_ATTR_WIDTH = xmlCharStrdup("w");
-const xmlChar * XML_ATTR_HEIGHT = xmlCharStrdup("h");
-const xmlChar * XML_ATTR_X = xmlCharStrdup("x");
-const xmlChar * XML_ATTR_Y = xmlCharStrdup("y");
-const xmlChar * XML_ATTR_Z = xmlCharStrdup("z");
-const xmlChar * XML_ATTR_FOVX = xmlCharStrdup("fovx");
-const xmlChar * XML_ATTR_FILM_BACK = xmlCharStrdup("fbh");
-const xmlChar * XML_ATTR_IMAGE = xmlCharStrdup("img");*/
+// elements and attributes of RealVIZ xml files we understand (names are interned when they're 
+// read, so that the rest of the reader compares numbers)
+enum GEOMETRY_LOADER_RZML_ELEMENT
+{ 
+	GEOMETRY_LOADER_RZML_UNKNOWN_ELEMENT, 
+	GEOMETRY_LOADER_RZML_SHOT, 
+	GEOMETRY_LOADER_RZML_TRANSLATION, 
+	GEOMETRY_LOADER_RZML_ROTATION, 
+	GEOMETRY_LOADER_RZML_CAMERA, 
+	GEOMETRY_LOADER_RZML_FRAME, 
+	GEOMETRY_LOADER_RZML_IMAGE_PLANE, 
+	GEOMETRY_LOADER_RZML_VERTEX, 
+	GEOMETRY_LOADER_RZML_ELEMENTS_COUNT
+};
+
+static const char * const geometry_loader_rzml_elements[GEOMETRY_LOADER_RZML_ELEMENTS_COUNT] = { "", "SHOT", "T", "R", "CINF", "CFRM", "IPLN", "P" };
+
+enum GEOMETRY_LOADER_RZML_ATTRIBUTE
+{
+	GEOMETRY_LOADER_RZML_UNKNOWN_ATTRIBUTE, 
+	GEOMETRY_LOADER_RZML_NAME, 
+	GEOMETRY_LOADER_RZML_WIDTH, 
+	GEOMETRY_LOADER_RZML_HEIGHT, 
+	GEOMETRY_LOADER_RZML_X,                  // x, y and z have to follow each other
+	GEOMETRY_LOADER_RZML_Y, 
+	GEOMETRY_LOADER_RZML_Z, 
+	GEOMETRY_LOADER_RZML_FOVX, 
+	GEOMETRY_LOADER_RZML_FILM_BACK, 
+	GEOMETRY_LOADER_RZML_IMAGE, 
+	GEOMETRY_LOADER_RZML_ATTRIBUTES_COUNT
+};
+
+static const char * const geometry_loader_rzml_attributes[GEOMETRY_LOADER_RZML_ATTRIBUTES_COUNT] = { "", "n", "w", "h", "x", "y", "z", "fovx", "fbh", "img" };
+
+// find section of mapped binary project, returns its payload (NULL if it's missing or malformed)
+static const unsigned char * geometry_load_binary_section(const Filesystem_Mapping & mapping, const unsigned int tag, const size_t item_size, size_t & count)
+{
+	const Geometry_Project_Header * const header = (const Geometry_Project_Header *)mapping.data;
+	size_t position = sizeof(Geometry_Project_Header);
+	count = 0;
+
+	for (unsigned int i = 0; i < header->sections_count; i++)
+	{
+		if (mapping.size - position < sizeof(Geometry_Project_Section)) return NULL;
+		const Geometry_Project_Section * const section = (const Geometry_Project_Section *)(mapping.data + position);
+		position += sizeof(Geometry_Project_Section);
+
+		// payload has to fit into the file
+		const unsigned long long padded = (section->size + 7) / 8 * 8;
+		if (section->size > mapping.size || padded > mapping.size - position) return NULL;
+
+		if (section->tag == tag)
+		{
+			// (multiplying count by item size could overflow)
+			if (section->item_size != item_size || section->size % item_size != 0 || section->count != section->size / item_size) return NULL;
+			count = (size_t)section->count;
+			return mapping.data + position;
+		}
+
+		position += (size_t)padded;
+	}
+
+	return NULL;
+}
+
+// load project saved in binary format 
+// arrays are checked first and then copied in bulk, so that we don't end up with half loaded project
+static bool geometry_load_project_binary(const Filesystem_Mapping & mapping)
+{
+	// check the header
+	const Geometry_Project_Header * const header = (const Geometry_Project_Header *)mapping.data;
+	if (mapping.size < sizeof(Geometry_Project_Header) || memcmp(header->magic, GEOMETRY_PROJECT_MAGIC, sizeof(header->magic)) != 0)
+	{
+		printf("Invalid header.\n");
+		return false;
+	}
+
+	if (header->byte_order != GEOMETRY_PROJECT_BYTE_ORDER || header->version > GEOMETRY_PROJECT_VERSION)
+	{
+		printf("Project was saved in unsupported version of binary format.\n");
+		return false;
+	}
+
+	// find all sections 
+	size_t strings_size, vertices_count, polygons_count, polygon_vertices_count, shots_count, points_count;
+	const char * const strings = (const char *)geometry_load_binary_section(mapping, GEOMETRY_PROJECT_STRINGS, 1, strings_size);
+	const Geometry_Project_Vertex * const records = (const Geometry_Project_Vertex *)geometry_load_binary_section(mapping, GEOMETRY_PROJECT_VERTICES, sizeof(Geometry_Project_Vertex), vertices_count);
+	const unsigned long long * const polygons_first = (const unsigned long long *)geometry_load_binary_section(mapping, GEOMETRY_PROJECT_POLYGONS, sizeof(unsigned long long), polygons_count);
+	const unsigned long long * const polygon_vertices = (const unsigned long long *)geometry_load_binary_section(mapping, GEOMETRY_PROJECT_POLYGON_VERTICES, sizeof(unsigned long long), polygon_vertices_count);
+	const Geometry_Project_Shot * const shot_records = (const Geometry_Project_Shot *)geometry_load_binary_section(mapping, GEOMETRY_PROJECT_SHOTS, sizeof(Geometry_Project_Shot), shots_count);
+	const Geometry_Project_Point * const point_records = (const Geometry_Project_Point *)geometry_load_binary_section(mapping, GEOMETRY_PROJECT_POINTS, sizeof(Geometry_Project_Point), points_count);
+
+	if (!strings || !records || !polygons_first || !polygon_vertices || !shot_records || !point_records || polygons_count == 0)
+	{
+		printf("Project file is damaged (missing section).\n");
+		return false;
+	}
+
+	// check references 
+	bool valid = (strings_size == 0 || strings[strings_size - 1] == '\0') && polygons_first[polygons_count - 1] == polygon_vertices_count;
+	for (size_t i = 0; valid && i + 1 < polygons_count; i++) 
+	{
+		valid = polygons_first[i] <= polygons_first[i + 1];
+	}
+
+	for (size_t i = 0; valid && i < polygon_vertices_count; i++) 
+	{
+		valid = polygon_vertices[i] < vertices_count;
+	}
+
+	for (size_t i = 0; valid && i < shots_count; i++) 
+	{
+		const Geometry_Project_Shot * const record = shot_records + i;
+		valid = 
+			record->image_filename < strings_size && record->name < strings_size && 
+			record->points_first <= points_count && record->points_count <= points_count - record->points_first
+		;
+	}
+
+	for (size_t i = 0; valid && i < points_count; i++) 
+	{
+		valid = point_records[i].vertex < vertices_count;
+	}
+
+	if (!valid)
+	{
+		printf("Project file is damaged (invalid reference).\n");
+		return false;
+	}
+
+	// vertices (new ones are appended to the existing, just like with geometry_new_vertex)
+	const size_t base = vertices.count;
+	if (!DYN_RESERVE(vertices, base + vertices_count) || !DYN_RESERVE(vertices_incidence, base + vertices_count))
+	{
+		core_state.error = CORE_ERROR_OUT_OF_MEMORY;
+		return false;
+	}
+
+	for (size_t i = 0; i < vertices_count; i++)
+	{
+		Vertex * const vertex = vertices.data + base + i;
+		memset(vertex, 0, sizeof(Vertex));
+		vertex->set = true;
+		vertex->x = records[i].x;
+		vertex->y = records[i].y;
+		vertex->z = records[i].z;
+		vertex->reconstructed = records[i].reconstructed != 0;
+		switch (records[i].vertex_type)
+		{
+			case GEOMETRY_VERTEX_AUTO: vertex->vertex_type = GEOMETRY_VERTEX_AUTO; break;
+			case GEOMETRY_VERTEX_EQUIVALENCE: vertex->vertex_type = GEOMETRY_VERTEX_EQUIVALENCE; break;
+			case GEOMETRY_VERTEX_USER: vertex->vertex_type = GEOMETRY_VERTEX_USER; break;
+		}
+
+		Vertex_Incidence * const incidence = vertices_incidence.data + base + i;
+		if (!incidence->set)
+		{
+			memset(incidence, 0, sizeof(Vertex_Incidence));
+			incidence->set = true;
+		}
+	}
+
+	vertices.count = base + vertices_count;
+	if (vertices_incidence.count < vertices.count) vertices_incidence.count = vertices.count;
+
+	// polygons
+	for (size_t i = 0; i + 1 < polygons_count; i++)
+	{
+		size_t polygon_id;
+		geometry_new_polygon(polygon_id);
+		Indices * const ids = &polygons.data[polygon_id].vertices;
+		const size_t count = (size_t)(polygons_first[i + 1] - polygons_first[i]);
+		if (!DYN_RESERVE(*ids, count))
+		{
+			core_state.error = CORE_ERROR_OUT_OF_MEMORY;
+			return false;
+		}
+
+		for (size_t j = 0; j < count; j++)
+		{
+			ids->data[j].set = true;
+			ids->data[j].value = base + (size_t)polygon_vertices[polygons_first[i] + j];
+		}
+
+		ids->count = count;
+	}
+
+	// shots and their points 
+	size_t * const occurrences = ALLOC(size_t, vertices_count + 1);
+	memset(occurrences, 0, sizeof(size_t) * (vertices_count + 1));
+	for (size_t i = 0; i < points_count; i++) occurrences[point_records[i].vertex]++;
+
+	for (size_t i = 0; i < vertices_count; i++)
+	{
+		Double_Indices * const ids = &vertices_incidence.data[base + i].shot_point_ids;
+		DYN_RESERVE(*ids, ids->count + occurrences[i]);
+	}
+
+	FREE(occurrences);
+
+	for (size_t i = 0; i < shots_count; i++)
+	{
+		const Geometry_Project_Shot * const record = shot_records + i;
+		size_t shot_id;
+		geometry_new_shot(shot_id);
+
+		Shot * const shot = shots.data + shot_id;
+		shot->calibrated = record->calibrated != 0;
+		shot->f = record->f;
+		shot->film_back = record->film_back;
+		shot->fovx = record->fovx;
+		shot->fovy = record->fovy;
+		shot->pp_x = record->pp_x;
+		shot->pp_y = record->pp_y;
+		shot->resected = record->resected != 0;
+		shot->width = record->width;
+		shot->height = record->height;
+		shot->image_filename = strdup(strings + record->image_filename);
+		shot->name = strdup(strings + record->name);
+
+		switch (record->info_status) 
+		{
+			case GEOMETRY_INFO_DEDUCED: shot->info_status = GEOMETRY_INFO_DEDUCED; break;
+			case GEOMETRY_INFO_LOADED: shot->info_status = GEOMETRY_INFO_LOADED; break;
+			case GEOMETRY_INFO_NOT_LOADED: shot->info_status = GEOMETRY_INFO_NOT_LOADED; break;
+		}
+
+		if (shot->calibrated)
+		{
+			shot->projection = opencv_create_matrix(3, 4);
+			for (int k = 0; k < 12; k++) OPENCV_ELEM(shot->projection, k / 4, k % 4) = record->P[k];
+			shot->rotation = opencv_create_matrix(3, 3);
+			shot->internal_calibration = opencv_create_matrix(3, 3);
+			shot->translation = opencv_create_matrix(3, 1);
+			geometry_calibration_from_P(shot_id);
+		}
+
+		// copy its points and register them in the incidence 
+		const size_t count = (size_t)record->points_count;
+		if (!DYN_RESERVE(shot->points, count))
+		{
+			core_state.error = CORE_ERROR_OUT_OF_MEMORY;
+			return false;
+		}
+
+		const Geometry_Project_Point * const point_record = point_records + record->points_first;
+		for (size_t j = 0; j < count; j++)
+		{
+			const size_t vertex_id = base + (size_t)point_record[j].vertex;
+			Point * const point = shot->points.data + j;
+			point->set = true;
+			point->x = point_record[j].x;
+			point->y = point_record[j].y;
+			point->vertex = vertex_id;
+
+			Double_Indices * const ids = &vertices_incidence.data[vertex_id].shot_point_ids;
+			Double_Index * const id = ids->data + ids->count++;
+			id->set = true;
+			id->primary = shot_id;
+			id->secondary = j;
+		}
+
+		shot->points.count = count;
+	}
+
+	geometry_changed_all();
+	return true;
+}
 
 // load project 
 bool geometry_load_project(const char * filename)
 {
+	// binary projects are recognized by their header 
+	FILE * probe = fopen(filename, "rb");
+	if (probe) 
+	{
+		char magic[sizeof(GEOMETRY_PROJECT_MAGIC)];
+		const bool binary = fread(magic, 1, sizeof(magic), probe) == sizeof(magic) && memcmp(magic, GEOMETRY_PROJECT_MAGIC, sizeof(magic)) == 0;
+		fclose(probe);
+
+		if (binary) 
+		{
+			Filesystem_Mapping mapping;
+			if (!interface_filesystem_map_file(filename, &mapping)) 
+			{
+				printf("Unable to open file for reading.\n");
+				return false;
+			}
+
+			const bool loaded = geometry_load_project_binary(mapping);
+			interface_filesystem_unmap_file(&mapping);
+			return loaded;
+		}
+	}
+
 	// open the file 
 	std::ifstream in(filename);
 
@@ -202,338 +474,530 @@ bool geometry_load_project(const char * filename)
 		}
 	}
 
+	geometry_changed_all();
 	return true;
 }
 
-// process loaded data (compute focal length from fov, assemble projection matrices, ...)
-// note isn't this redundant? look at geometry_routines
-void geometry_process_data(Shots shots)
+// results of post processing of one shot (computed by worker threads, which don't touch opencv)
+struct Geometry_Process_Data_Shot
 {
-	// process all shot information 
-	for ALL(shots, i)
-	{
-		Shot * const shot = shots.data + i; 
-		if (!shot->calibrated) continue;
+	double f;
+	double K[9], R[9], P[12];
+	double R_euler[3];
+	double H[9];                        // rectifying homography (if there is one)
+	bool processed, rectified;
+};
+
+// slice of shots processed by one thread
+struct Geometry_Process_Data_Work
+{
+	const Shots * shots;
+	Geometry_Process_Data_Shot * results;
+	size_t from, to;
+	pthread_t thread;
+};
 
-		// either focal length or filed of view must be specified 
-		if ((shot->f == 0) && (shot->fovx)) {}
+static const int GEOMETRY_PROCESS_DATA_MAX_THREADS = 32;
+static const size_t GEOMETRY_PROCESS_DATA_MIN_SHOTS = 64; // shots per thread
 
-		// calculate focal length from field of view
-		if (shot->f == 0)
+// product of 3x3 matrices (row-major)
+static void geometry_process_data_mul_3x3(const double * A, const double * B, double * C)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
 		{
-			shot->f = 0.5 * shot->width / tan(0.5 * deg2rad(shot->fovx));
+			C[3 * i + j] = A[3 * i + 0] * B[0 + j] + A[3 * i + 1] * B[3 + j] + A[3 * i + 2] * B[6 + j];
 		}
+	}
+}
 
-		// convert translation vector to opencv
-		LOCK_RW(opencv)
-		{
-			shot->translation = opencv_create_vector(shot->T, 3); 
+// compute calibration and projection matrices of shots in the slice 
+// (same as assembling them with opencv_create_rotation_matrix_from_euler and 
+// geometry_calibration_from_decomposed_matrices)
+static void * geometry_process_data_function(void * arg)
+{
+	Geometry_Process_Data_Work * const work = (Geometry_Process_Data_Work *)arg;
 
-			// compute rotation matrix
-			shot->rotation = opencv_create_rotation_matrix_from_euler(shots.data[i].R_euler);
-			// printf("%d\n", i); 
-			// opencv_debug("Rotation matrix", shot->rotation);
+	for (size_t i = work->from; i < work->to; i++)
+	{
+		const Shot * const shot = work->shots->data + i;
+		Geometry_Process_Data_Shot * const result = work->results + i;
+		result->processed = false;
+		result->rectified = false;
+		if (!shot->set || !shot->calibrated) continue;
 
-			// build calibration matrix
-			shot->internal_calibration = opencv_create_matrix(3, 3);
-			OPENCV_ELEM(shot->internal_calibration, 0, 0) = shot->f; 
-			OPENCV_ELEM(shot->internal_calibration, 1, 1) = shot->f; 
-			OPENCV_ELEM(shot->internal_calibration, 0, 2) = shot->pp_x; // shot->width / 2.0; 
-			OPENCV_ELEM(shot->internal_calibration, 1, 2) = shot->pp_y; // shot->height / 2.0; 
-			OPENCV_ELEM(shot->internal_calibration, 2, 2) = 1; 
+		// calculate focal length from field of view
+		result->f = shot->f == 0 ? 0.5 * shot->width / tan(0.5 * deg2rad(shot->fovx)) : shot->f;
+
+		// rotation matrix from euler angles
+		const double ax = -shot->R_euler[0] - OPENCV_PI, ay = -shot->R_euler[1], az = -shot->R_euler[2];
+		const double Rx[9] = { 1, 0, 0, 0, cos(ax), -sin(ax), 0, sin(ax), cos(ax) };
+		const double Ry[9] = { cos(ay), 0, sin(ay), 0, 1, 0, -sin(ay), 0, cos(ay) };
+		const double Rz[9] = { cos(az), -sin(az), 0, sin(az), cos(az), 0, 0, 0, 1 };
+		double temp[9];
+		geometry_process_data_mul_3x3(Rx, Ry, temp);
+		geometry_process_data_mul_3x3(temp, Rz, result->R);
+
+		// calibration matrix
+		double * const K = result->K;
+		memset(K, 0, sizeof(result->K));
+		K[0] = result->f;
+		K[4] = result->f;
+		K[2] = shot->pp_x;
+		K[5] = shot->pp_y;
+		K[8] = 1;
+
+		// projection matrix P = KR [I | -T]
+		double M[9];
+		geometry_process_data_mul_3x3(K, result->R, M);
+		for (int j = 0; j < 3; j++)
+		{
+			for (int k = 0; k < 3; k++) result->P[4 * j + k] = M[3 * j + k];
+			result->P[4 * j + 3] = M[3 * j + 0] * -shot->T[0] + M[3 * j + 1] * -shot->T[1] + M[3 * j + 2] * -shot->T[2];
 		}
-		UNLOCK_RW(opencv);
 
-		// finally assemble projection matrix 
-		geometry_calibration_from_decomposed_matrices(i);
+		// euler angles for OpenGL
+		CvMat R = cvMat(3, 3, CV_64F, result->R);
+		opencv_rotation_matrix_to_angles(&R, result->R_euler[0], result->R_euler[1], result->R_euler[2]);
+		result->R_euler[0] = -(result->R_euler[0] + OPENCV_PI);
+		if (result->R_euler[0] > 2 * OPENCV_PI) result->R_euler[0] -= 2 * OPENCV_PI;
+		result->R_euler[1] = -(result->R_euler[1]);
+		result->R_euler[2] = -(result->R_euler[2]);
 
-		// debug
 		// specific 
-		// check whether we have rectifying homography and apply it's inverse 
-		// to the camera
-		std::ifstream H((std::string(shot->image_filename) + ".H.txt").c_str());
-		if (H)
+		// check whether we have rectifying homography, its inverse is applied to the camera
+		if (shot->image_filename)
 		{
-			LOCK_RW(opencv) 
+			char * const filename = ALLOC(char, strlen(shot->image_filename) + 7);
+			strcpy(filename, shot->image_filename);
+			strcat(filename, ".H.txt");
+			FILE * const H = fopen(filename, "r");
+			FREE(filename);
+
+			if (H)
 			{
-				printf("~");
-				CvMat * M = opencv_create_matrix(3, 3), * M_inv = opencv_create_matrix(3, 3); 
+				result->rectified = true;
+				for (int k = 0; k < 9; k++) 
+				{
+					if (fscanf(H, "%lf", result->H + k) != 1) result->rectified = false;
+				}
+				fclose(H);
+			}
+		}
+
+		result->processed = true;
+	}
+
+	return NULL;
+}
+
+// process loaded data (compute focal length from fov, assemble projection matrices, ...)
+// the matrices are computed in parallel and only handed over to opencv at the end 
+// note isn't this redundant? look at geometry_routines
+void geometry_process_data(Shots shots)
+{
+	if (shots.count == 0) return;
+
+	Geometry_Process_Data_Shot * const results = ALLOC(Geometry_Process_Data_Shot, shots.count);
+	if (!results)
+	{
+		core_state.error = CORE_ERROR_OUT_OF_MEMORY;
+		return;
+	}
+
+	// split shots among threads (this one takes the first slice)
+	int count = parser_processors();
+	if (count > GEOMETRY_PROCESS_DATA_MAX_THREADS) count = GEOMETRY_PROCESS_DATA_MAX_THREADS;
+	if ((size_t)count > shots.count / GEOMETRY_PROCESS_DATA_MIN_SHOTS + 1) count = (int)(shots.count / GEOMETRY_PROCESS_DATA_MIN_SHOTS + 1);
 
-				H >> OPENCV_ELEM(M, 0, 0);
-				H >> OPENCV_ELEM(M, 0, 1);
-				H >> OPENCV_ELEM(M, 0, 2);
+	Geometry_Process_Data_Work work[GEOMETRY_PROCESS_DATA_MAX_THREADS];
+	bool threaded[GEOMETRY_PROCESS_DATA_MAX_THREADS];
+	for (int i = 0; i < count; i++)
+	{
+		work[i].shots = &shots;
+		work[i].results = results;
+		work[i].from = shots.count * i / count;
+		work[i].to = shots.count * (i + 1) / count;
+		threaded[i] = i > 0 && pthread_create(&work[i].thread, NULL, geometry_process_data_function, work + i) == 0;
+	}
 
-				H >> OPENCV_ELEM(M, 1, 0);
-				H >> OPENCV_ELEM(M, 1, 1);
-				H >> OPENCV_ELEM(M, 1, 2);
+	geometry_process_data_function(work);
+	for (int i = 1; i < count; i++)
+	{
+		if (threaded[i]) pthread_join(work[i].thread, NULL); else geometry_process_data_function(work + i);
+	}
 
-				H >> OPENCV_ELEM(M, 2, 0);
-				H >> OPENCV_ELEM(M, 2, 1);
-				H >> OPENCV_ELEM(M, 2, 2);
-				
+	// create the matrices 
+	LOCK_RW(opencv)
+	{
+		for (size_t i = 0; i < shots.count; i++)
+		{
+			Geometry_Process_Data_Shot * const result = results + i;
+			if (!result->processed) continue;
+			Shot * const shot = shots.data + i;
+
+			shot->f = result->f;
+			shot->translation = opencv_create_vector(shot->T, 3);
+			shot->rotation = opencv_create_matrix(3, 3, result->R);
+			shot->internal_calibration = opencv_create_matrix(3, 3, result->K);
+			shot->projection = opencv_create_matrix(3, 4, result->P);
+			shot->R_euler[0] = result->R_euler[0];
+			shot->R_euler[1] = result->R_euler[1];
+			shot->R_euler[2] = result->R_euler[2];
+			shot->T[3] = 1.0;
+
+			if (result->rectified)
+			{
+				printf("~");
+				CvMat * M = opencv_create_matrix(3, 3, result->H), * M_inv = opencv_create_matrix(3, 3); 
 				cvInvert(M, M_inv, CV_SVD);
 				cvMatMul(M_inv, shot->projection, shot->projection);
 
 				cvReleaseMat(&M);
 				cvReleaseMat(&M_inv);
 			}
-			UNLOCK_RW(opencv);
 		}
 	}
+	UNLOCK_RW(opencv);
+
+	FREE(results);
 }
 
-// SAX callbacks
-/*void geometry_loader_SAX_start_element(geometry_loader_SAX_state * state, const xmlChar * name, const xmlChar ** attrs)
+// state of RealVIZ xml reader 
+struct Geometry_Loader_Rzml_State
 {
-	if (xmlStrcmp(name, XML_ELEM_SHOT) == 0)
-	{
-		// image shot
-
-		// initialize new shot structure
-		size_t new_shot_id; 
-		geometry_new_shot(new_shot_id); // {}
-		state->current_shot = state->shots->data + new_shot_id;
+	char * directory;        // relative image paths are relative to the file
+	Shot * shot;             // shot being read (NULL outside of SHOT element)
+	double film_back;        // film back of the camera 
+	double vertex[3];        // vertex being read
+};
+
+// characters of element and attribute names 
+static inline bool geometry_loader_rzml_name_char(const char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == ':' || c == '-' || c == '.';
+}
 
-		// save information from the shot tag 
-		const xmlChar ** attr = attrs; 
+static inline bool geometry_loader_rzml_space(const char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
 
-		while (*attr != NULL) 
-		{
-			// read the attribute value 
-			const xmlChar * value = *(attr + 1);
-			if (value == NULL) { return; }  // {} 
+// find name among the known ones (0 if it isn't any of them)
+static int geometry_loader_rzml_intern(const char * const names[], const int count, const char * name, const size_t length)
+{
+	for (int i = 1; i < count; i++)
+	{
+		if (strncmp(names[i], name, length) == 0 && names[i][length] == '\0') return i;
+	}
 
-			// process attributes 
+	return 0;
+}
 
-			// todo save shots name and use it instead of it's filename
-			if (xmlStrcmp(*attr, XML_ATTR_NAME) == 0) state->current_shot->name = (char *)xmlStrdup(value); // note conversion
-			// width
-			else if (xmlStrcmp(*attr, XML_ATTR_WIDTH) == 0) 
-			{
-				state->current_shot->width = atoi((char *)value); // note conversion
+// attribute value as string with entities resolved (has to be freed)
+static char * geometry_loader_rzml_string(const char * value, const size_t length)
+{
+	static const char * const entities[][2] = { { "&amp;", "&" }, { "&lt;", "<" }, { "&gt;", ">" }, { "&quot;", "\"" }, { "&apos;", "'" } };
 
-				if (state->current_shot->pp_x == 0) 
-				{
-					state->current_shot->pp_x = state->current_shot->width / 2;
-				}
-			}
-			// height
-			else if (xmlStrcmp(*attr, XML_ATTR_HEIGHT) == 0)
+	char * const s = ALLOC(char, length + 1), * q = s;
+	const char * p = value, * const end = value + length;
+	while (p < end)
+	{
+		bool resolved = false;
+		if (*p == '&')
+		{
+			for (int k = 0; k < 5 && !resolved; k++)
 			{
-				state->current_shot->height = atoi((char *)value); // note conversion
-
-				if (state->current_shot->pp_y == 0) 
+				const size_t entity_length = strlen(entities[k][0]);
+				if ((size_t)(end - p) >= entity_length && memcmp(p, entities[k][0], entity_length) == 0)
 				{
-					state->current_shot->pp_y = state->current_shot->height / 2;
+					*q++ = entities[k][1][0];
+					p += entity_length;
+					resolved = true;
 				}
 			}
-			// else: unknown attribute, not necessarily a problem 
-
-			// move on to next attribute
-			attr += 2; 
 		}
-	}
-	else if (xmlStrcmp(name, XML_ELEM_TRANSLATION) == 0)
-	{
-		// camera translation 
-		const xmlChar ** attr = attrs; 
 
-		// mark as calibrated
-		if (attr) state->current_shot->calibrated = true;
+		if (!resolved) *q++ = *p++;
+	}
 
-		while (*attr != NULL) 
-		{
-			// read the attribute value 
-			const xmlChar * value = *(attr + 1);
-			if (value == NULL) { return; }  // {} 
+	*q = '\0';
+	return s;
+}
 
-			// process attributes 
+// attribute value as number (0 if it isn't one)
+static double geometry_loader_rzml_number(const char * value, const size_t length)
+{
+	const char * p = value, * const end = value + length;
+	double number = 0;
+	parser_skip_spaces(p, end);
+	return parser_double(p, end, number) ? number : 0;
+}
 
-			// x coordinate
-			if (xmlStrcmp(*attr, XML_ATTR_X) == 0) state->current_shot->T[0] = atof((char *)value); // note conversion
-			// y coordinate
-			else if (xmlStrcmp(*attr, XML_ATTR_Y) == 0) state->current_shot->T[1] = atof((char *)value); // note conversion
-			// z coordinate
-			else if (xmlStrcmp(*attr, XML_ATTR_Z) == 0) state->current_shot->T[2] = atof((char *)value); // note conversion
+// beginning of element 
+static void geometry_loader_rzml_start_element(Geometry_Loader_Rzml_State & state, const int element)
+{
+	switch (element) 
+	{
+		case GEOMETRY_LOADER_RZML_SHOT:
+		{
+			size_t shot_id;
+			geometry_new_shot(shot_id);
+			state.shot = shots.data + shot_id;
+			break;
+		}
 
-			// we're using homogeneous coordinates 
-			state->current_shot->T[3] = 1.0; 
+		case GEOMETRY_LOADER_RZML_TRANSLATION: 
+		case GEOMETRY_LOADER_RZML_ROTATION: 
+		{
+			// mark as calibrated
+			if (state.shot) state.shot->calibrated = true;
+			break;
+		}
 
-			// move on to next attribute
-			attr += 2; 
+		case GEOMETRY_LOADER_RZML_VERTEX: 
+		{
+			state.vertex[0] = state.vertex[1] = state.vertex[2] = 0;
+			break;
 		}
 	}
-	else if (xmlStrcmp(name, XML_ELEM_ROTATION) == 0)
-	{
-		// camera rotation (euler angles)
-		const xmlChar ** attr = attrs; 
+}
 
-		// mark as calibrated
-		if (attr) state->current_shot->calibrated = true;
+// attribute of element 
+static void geometry_loader_rzml_attribute(Geometry_Loader_Rzml_State & state, const int element, const int attribute, const char * value, const size_t length)
+{
+	Shot * const shot = state.shot;
+	if (!shot && element != GEOMETRY_LOADER_RZML_CAMERA && element != GEOMETRY_LOADER_RZML_VERTEX) return;
 
-		while (*attr != NULL) 
+	switch (element)
+	{
+		case GEOMETRY_LOADER_RZML_SHOT:
 		{
-			// read the attribute value 
-			const xmlChar * value = *(attr + 1);
-			if (value == NULL) { return; }  // {} 
-
-			// process attributes 
-
-			// x angle 
-			if (xmlStrcmp(*attr, XML_ATTR_X) == 0) state->current_shot->R_euler[0] = deg2rad(atof((char *)value)); // note conversion
-			// y angle
-			else if (xmlStrcmp(*attr, XML_ATTR_Y) == 0) state->current_shot->R_euler[1] = deg2rad(atof((char *)value)); // note conversion
-			// z angle
-			else if (xmlStrcmp(*attr, XML_ATTR_Z) == 0) state->current_shot->R_euler[2] = deg2rad(atof((char *)value)); // note conversion
-
-			// move on to next attribute
-			attr += 2; 
+			if (attribute == GEOMETRY_LOADER_RZML_NAME) 
+			{
+				FREE(shot->name);
+				shot->name = geometry_loader_rzml_string(value, length);
+			}
+			else if (attribute == GEOMETRY_LOADER_RZML_WIDTH)
+			{
+				shot->width = (int)geometry_loader_rzml_number(value, length);
+				if (shot->pp_x == 0) shot->pp_x = shot->width / 2;
+			}
+			else if (attribute == GEOMETRY_LOADER_RZML_HEIGHT)
+			{
+				shot->height = (int)geometry_loader_rzml_number(value, length);
+				if (shot->pp_y == 0) shot->pp_y = shot->height / 2;
+			}
+			break;
 		}
-	}
-	else if (xmlStrcmp(name, XML_ELEM_FRAME) == 0)
-	{
-		// frame info (contains field of view)
-		const xmlChar ** attr = attrs; 
 
-		while (*attr != NULL) 
+		case GEOMETRY_LOADER_RZML_TRANSLATION:
+		case GEOMETRY_LOADER_RZML_ROTATION:
+		case GEOMETRY_LOADER_RZML_VERTEX:
 		{
-			// read the attribute value 
-			const xmlChar * value = *(attr + 1);
-			if (value == NULL) { return; }  // {} 
+			if (attribute != GEOMETRY_LOADER_RZML_X && attribute != GEOMETRY_LOADER_RZML_Y && attribute != GEOMETRY_LOADER_RZML_Z) break;
+			const int axis = attribute - GEOMETRY_LOADER_RZML_X;
+			const double number = geometry_loader_rzml_number(value, length);
 
-			// process attributes 
-
-			// fovx angle 
-			if (xmlStrcmp(*attr, XML_ATTR_FOVX) == 0) state->current_shot->fovx = atof((char *)value); // note conversion
-
-			// move on to next attribute
-			attr += 2; 
+			if (element == GEOMETRY_LOADER_RZML_TRANSLATION) 
+			{
+				// we're using homogeneous coordinates 
+				shot->T[axis] = number;
+				shot->T[3] = 1.0;
+			}
+			else if (element == GEOMETRY_LOADER_RZML_ROTATION) 
+			{
+				shot->R_euler[axis] = deg2rad(number);
+			}
+			else
+			{
+				state.vertex[axis] = number;
+			}
+			break;
 		}
-	}
-	else if (xmlStrcmp(name, XML_ELEM_IMAGE_PLANE) == 0)
-	{
-		// frame info (contains field of view)
-		const xmlChar ** attr = attrs; 
 
-		while (*attr != NULL) 
+		case GEOMETRY_LOADER_RZML_FRAME:
 		{
-			// read the attribute value 
-			const xmlChar * value = *(attr + 1);
-			if (value == NULL) { return; }  // {} 
-
-			// process attributes 
+			if (attribute == GEOMETRY_LOADER_RZML_FOVX) shot->fovx = geometry_loader_rzml_number(value, length);
+			break;
+		}
 
+		case GEOMETRY_LOADER_RZML_IMAGE_PLANE:
+		{
 			// image filename (with path)
-			// note this shots attribute is set also in shot tag, but it will be overwritten in case it is also in ipln tag
-			if (xmlStrcmp(*attr, XML_ATTR_IMAGE) == 0) 
-				state->current_shot->image_filename = interface_filesystem_cleanup_filename((char *)value, state->directory); // note conversion
+			if (attribute == GEOMETRY_LOADER_RZML_IMAGE) 
+			{
+				char * const filename = geometry_loader_rzml_string(value, length);
+				FREE(shot->image_filename);
+				shot->image_filename = interface_filesystem_cleanup_filename(filename, state.directory);
+				FREE(filename);
+			}
+			break;
+		}
 
-			// move on to next attribute
-			attr += 2; 
+		case GEOMETRY_LOADER_RZML_CAMERA:
+		{
+			if (attribute == GEOMETRY_LOADER_RZML_FILM_BACK) state.film_back = geometry_loader_rzml_number(value, length);
+			break;
 		}
 	}
-	else if (xmlStrcmp(name, XML_ELEM_CAMERA) == 0)
-	{
-		// frame info (contains field of view)
-		const xmlChar ** attr = attrs; 
+}
 
-		while (*attr != NULL) 
+// end of element 
+static void geometry_loader_rzml_end_element(Geometry_Loader_Rzml_State & state, const int element)
+{
+	if (element == GEOMETRY_LOADER_RZML_VERTEX)
+	{
+		size_t vertex_id;
+		geometry_new_vertex(vertex_id);
+		Vertex * const vertex = vertices.data + vertex_id;
+		vertex->x = state.vertex[0];
+		vertex->y = state.vertex[1];
+		vertex->z = state.vertex[2];
+		vertex->reconstructed = true;
+	}
+	else if (element == GEOMETRY_LOADER_RZML_SHOT && state.shot)
+	{
+		// if no name for this shot was submitted, use it's filename without directory path
+		if (!state.shot->name && state.shot->image_filename)
 		{
-			// read the attribute value 
-			const xmlChar * value = *(attr + 1);
-			if (value == NULL) { return; }  // {} 
+			state.shot->name = interface_filesystem_extract_filename(state.shot->image_filename);
+		}
 
-			// process attributes 
+		if (state.shot->film_back == 0) state.shot->film_back = state.film_back;
+		state.shot = NULL;
+	}
+}
 
-			// film back size
-			if (xmlStrcmp(*attr, XML_ATTR_FILM_BACK) == 0) state->first_film_back = atof((char *)value); // note conversion
+// load data from realviz xml file (.rzml, .rzi)
+// the mapped file is scanned in place, vertices (P elements) end up in global vertices 
+// note the same inconsistency as in geometry_loader_ifl
+bool geometry_loader_rzml(const char * rzml_filename)
+{
+	Filesystem_Mapping mapping;
+	if (!interface_filesystem_map_file(rzml_filename, &mapping)) 
+	{
+		printf("Unable to open file for reading.\n");
+		return false;
+	}
 
-			// move on to next attribute
-			attr += 2; 
-		}
+	const char * const data = (const char *)mapping.data, * const end = data + mapping.size;
+
+	// count shots and vertices first, so that they're allocated at once 
+	size_t shots_count = 0, vertices_count = 0;
+	for (const char * p = data; (p = (const char *)memchr(p, '<', end - p)) != NULL; p++)
+	{
+		if (end - p > 5 && memcmp(p + 1, "SHOT", 4) == 0 && !geometry_loader_rzml_name_char(p[5])) shots_count++;
+		else if (end - p > 2 && p[1] == 'P' && !geometry_loader_rzml_name_char(p[2])) vertices_count++;
 	}
-	else if (xmlStrcmp(name, XML_ELEM_VERTEX) == 0) 
+
+	if (
+		!DYN_RESERVE(shots, shots.count + shots_count) || 
+		!DYN_RESERVE(vertices, vertices.count + vertices_count) || 
+		!DYN_RESERVE(vertices_incidence, vertices.count + vertices_count)
+	)
 	{
-		// vertex 
-		const xmlChar ** attr = attrs; 
-		double x = 0, y = 0, z = 0; 
+		interface_filesystem_unmap_file(&mapping);
+		core_state.error = CORE_ERROR_OUT_OF_MEMORY;
+		return false;
+	}
+
+	Geometry_Loader_Rzml_State state;
+	memset(&state, 0, sizeof(state));
+	state.directory = interface_filesystem_dirpath(rzml_filename);
 
-		while (*attr != NULL) 
+	const char * p = data;
+	while ((p = (const char *)memchr(p, '<', end - p)) != NULL && ++p < end)
+	{
+		// skip comments, declarations and processing instructions 
+		if (*p == '!' || *p == '?')
 		{
-			// read the attribute value 
-			const xmlChar * value = *(attr + 1);
-			if (value == NULL) { return; }  // {} 
+			const char * const terminator = end - p >= 3 && memcmp(p, "!--", 3) == 0 ? "-->" : ">";
+			const size_t terminator_length = strlen(terminator);
+			while (p < end && (size_t)(end - p) >= terminator_length && memcmp(p, terminator, terminator_length) != 0) p++;
+			continue;
+		}
 
-			// process attributes 
+		const bool closing = *p == '/';
+		if (closing) p++;
 
-			// x coordinate 
-			if (xmlStrcmp(*attr, XML_ATTR_X) == 0) x = atof((char *)value); // note conversion
-			// y coordinate 
-			else if (xmlStrcmp(*attr, XML_ATTR_Y) == 0) y = atof((char *)value); // note conversion
-			// z coordinate 
-			else if (xmlStrcmp(*attr, XML_ATTR_Z) == 0) z = atof((char *)value); // note conversion
+		const char * const name = p;
+		while (p < end && geometry_loader_rzml_name_char(*p)) p++;
+		const int element = geometry_loader_rzml_intern(geometry_loader_rzml_elements, GEOMETRY_LOADER_RZML_ELEMENTS_COUNT, name, p - name);
 
-			// move on to next attribute
-			attr += 2; 
+		if (closing)
+		{
+			geometry_loader_rzml_end_element(state, element);
+			continue;
 		}
 
-		// add vertex
-		ADD(*(state->vertices)); 
-		LAST(*(state->vertices)).x = x; 
-		LAST(*(state->vertices)).y = y; 
-		LAST(*(state->vertices)).z = z; 
-		LAST(*(state->vertices)).reconstructed = true;
-	}
-}
+		geometry_loader_rzml_start_element(state, element);
 
-void geometry_loader_SAX_end_element(geometry_loader_SAX_state * state, const xmlChar * name)
-{
-	if (xmlStrcmp(name, XML_ELEM_SHOT) == 0)
-	{
-		// if no name for this shot was submitted, use it's filename without directory path
-		if (!state->current_shot->name && state->current_shot->image_filename)
+		// attributes 
+		bool empty = false;
+		while (p < end)
 		{
-			state->current_shot->name = interface_filesystem_extract_filename(state->current_shot->image_filename);
-		}
-	}
-}
+			while (p < end && geometry_loader_rzml_space(*p)) p++;
+			if (p >= end) break;
 
-void geometry_loader_SAX_characters(geometry_loader_SAX_state * state, const xmlChar * cdata, int len)
-{
-}*/
+			if (*p == '>') 
+			{
+				p++;
+				break;
+			}
 
-// load data from realviz xml file // todo probably rename this function to reflect that it loads .rzml, .rzi files
-/*void geometry_loader(const char * xml_filename, Shots & shots)
-{
-	// initialization
-	xmlSAXHandler handler; 
-	geometry_loader_SAX_state * state = ALLOC(geometry_loader_SAX_state, 1);
-	memset(&handler, 0, sizeof(handler)); 
-	memset(state, 0, sizeof(geometry_loader_SAX_state));
-	state->filename = strdup(xml_filename);
-	state->directory = interface_filesystem_dirpath(state->filename);
+			if (*p == '/')
+			{
+				empty = true;
+				p++;
+				continue;
+			}
+
+			const char * const attribute_name = p;
+			while (p < end && geometry_loader_rzml_name_char(*p)) p++;
+			const size_t attribute_length = p - attribute_name;
+			if (attribute_length == 0) 
+			{
+				p++;
+				continue;
+			}
+
+			while (p < end && geometry_loader_rzml_space(*p)) p++;
+			if (p >= end || *p != '=') continue;
+			p++;
+			while (p < end && geometry_loader_rzml_space(*p)) p++;
+			if (p >= end || (*p != '"' && *p != '\'')) continue;
+
+			const char quote = *p++;
+			const char * const value = p;
+			p = (const char *)memchr(p, quote, end - p);
+			if (!p) 
+			{
+				p = end;
+				break;
+			}
+
+			const int attribute = geometry_loader_rzml_intern(geometry_loader_rzml_attributes, GEOMETRY_LOADER_RZML_ATTRIBUTES_COUNT, attribute_name, attribute_length);
+			if (attribute) geometry_loader_rzml_attribute(state, element, attribute, value, p - value);
+			p++;
+		}
 
-	// state setup 
-	state->shots = &shots; 
-	state->vertices = &vertices;
+		if (empty) geometry_loader_rzml_end_element(state, element);
+	}
 
-	// register callbacks to SAX parser
-	handler.startElement = (startElementSAXFunc)geometry_loader_SAX_start_element;
-	handler.endElement = (endElementSAXFunc)geometry_loader_SAX_end_element;
-	handler.characters = (charactersSAXFunc)geometry_loader_SAX_characters;
+	// file might have been cut short
+	if (state.shot) geometry_loader_rzml_end_element(state, GEOMETRY_LOADER_RZML_SHOT);
 
-	// open xml file using SAX parser 
-	xmlSAXUserParseFile(&handler, state, xml_filename);
+	interface_filesystem_unmap_file(&mapping);
+	FREE(state.directory);
 
 	// process loaded data (compute remaining values)
-	shots.count = state->shots->count; 
 	geometry_process_data(shots);
+	geometry_changed_all();
 
-	// free resources 
-	free(state->filename); 
-	FREE(state->directory);
-	FREE(state); 
-}*/
+	return true;
+}
 
 // load data from realviz rz3 file
 bool geometry_loader_rz3(const char * xml_filename, Shots & shots)
@@ -601,23 +1065,330 @@ bool geometry_loader_rz3(const char * xml_filename, Shots & shots)
 
 	// data post processing 
 	geometry_process_data(shots);
+	geometry_changed_all();
+}
+
+// map text file and parse it as a table of numbers, returns false if it can't be read
+static bool geometry_loader_table(const char * filename, const int columns, Parser_Table & table)
+{
+	Filesystem_Mapping mapping;
+	if (!interface_filesystem_map_file(filename, &mapping)) 
+	{
+		// empty files can't be mapped, but they're fine
+		FILE * f = fopen(filename, "rb");
+		if (!f) return false;
+		fclose(f);
+
+		memset(&table, 0, sizeof(table));
+		table.columns = columns;
+		table.complete = true;
+		return true;
+	}
+
+	const bool parsed = parser_table((const char *)mapping.data, mapping.size, columns, table);
+	interface_filesystem_unmap_file(&mapping);
+
+	if (!parsed) core_state.error = CORE_ERROR_OUT_OF_MEMORY;
+	return parsed;
 }
 
 // load 3d vertices from text file (one vertex per line: <x> <y> <z>); returns true on success // note previously we had vertex_id on the begining of the line
 bool geometry_loader_vertices(const char * txt_filename, Vertices & vertices, size_t group /*= 0*/) 
 {
-	// Open the file.
-			std::ifstream input_vertices(txt_filename);
-	// If opening succeeded,
-			if (input_vertices) {
-	// read all it's lines
-			size_t vertex_input_id = 0; double x, y, z; while (input_vertices >> x >> y >> z) {
-	// and interpret each as a vertex which is then added to array vertices.
-			ADD(vertices); LAST(vertices).x = x; LAST(vertices).y = y; LAST(vertices).z = z;
-	// Also set vertex's group to the value passed in function parameter group.
-			LAST(vertices).group = group; LAST(vertices).reconstructed = true; } return true; // todo check bounds
-	// But if the file couldn't be opened, return false.
-			} else { return false; }
+	Parser_Table table;
+	if (!geometry_loader_table(txt_filename, 3, table)) return false;
+
+	// make room for all of them at once 
+	if (!DYN_RESERVE(vertices, vertices.count + table.rows))
+	{
+		parser_table_free(table);
+		core_state.error = CORE_ERROR_OUT_OF_MEMORY;
+		return false;
+	}
+
+	for (size_t i = 0; i < table.rows; i++) 
+	{
+		const double * const row = table.values + 3 * i;
+		Vertex * const vertex = vertices.data + vertices.count++;
+		if (!vertex->set) memset(vertex, 0, sizeof(Vertex));
+		vertex->set = true;
+		vertex->x = row[0];
+		vertex->y = row[1];
+		vertex->z = row[2];
+		vertex->group = group;
+		vertex->reconstructed = true;
+	}
+
+	parser_table_free(table);
+	geometry_changed_all();
+	return true; 
+}
+
+// types of PLY properties 
+enum GEOMETRY_LOADER_PLY_TYPE
+{
+	GEOMETRY_LOADER_PLY_INT8, GEOMETRY_LOADER_PLY_UINT8, GEOMETRY_LOADER_PLY_INT16, GEOMETRY_LOADER_PLY_UINT16, 
+	GEOMETRY_LOADER_PLY_INT32, GEOMETRY_LOADER_PLY_UINT32, GEOMETRY_LOADER_PLY_FLOAT32, GEOMETRY_LOADER_PLY_FLOAT64, 
+	GEOMETRY_LOADER_PLY_TYPES_COUNT
+};
+
+static const char * const geometry_loader_ply_type_names[GEOMETRY_LOADER_PLY_TYPES_COUNT][2] = {
+	{ "char", "int8" }, { "uchar", "uint8" }, { "short", "int16" }, { "ushort", "uint16" }, 
+	{ "int", "int32" }, { "uint", "uint32" }, { "float", "float32" }, { "double", "float64" }
+};
+
+static const size_t geometry_loader_ply_type_sizes[GEOMETRY_LOADER_PLY_TYPES_COUNT] = { 1, 1, 2, 2, 4, 4, 4, 8 };
+
+// vertex fields PLY properties can be stored into 
+enum GEOMETRY_LOADER_PLY_FIELD
+{
+	GEOMETRY_LOADER_PLY_X, GEOMETRY_LOADER_PLY_Y, GEOMETRY_LOADER_PLY_Z, 
+	GEOMETRY_LOADER_PLY_NX, GEOMETRY_LOADER_PLY_NY, GEOMETRY_LOADER_PLY_NZ, 
+	GEOMETRY_LOADER_PLY_RED, GEOMETRY_LOADER_PLY_GREEN, GEOMETRY_LOADER_PLY_BLUE, 
+	GEOMETRY_LOADER_PLY_GROUP, GEOMETRY_LOADER_PLY_FIELDS_COUNT, GEOMETRY_LOADER_PLY_IGNORED = GEOMETRY_LOADER_PLY_FIELDS_COUNT
+};
+
+static const char * const geometry_loader_ply_field_names[GEOMETRY_LOADER_PLY_FIELDS_COUNT] = {
+	"x", "y", "z", "nx", "ny", "nz", "red", "green", "blue", "group"
+};
+
+const int GEOMETRY_LOADER_PLY_MAX_PROPERTIES = 64;
+
+// property of vertex element
+struct Geometry_Loader_Ply_Property
+{
+	GEOMETRY_LOADER_PLY_TYPE type;
+	int field;
+};
+
+// read binary PLY value, swapping bytes if the file has different byte order
+static double geometry_loader_ply_value(const unsigned char * p, const GEOMETRY_LOADER_PLY_TYPE type, const bool swap)
+{
+	unsigned char b[8];
+	const size_t size = geometry_loader_ply_type_sizes[type];
+	for (size_t i = 0; i < size; i++) b[i] = swap ? p[size - 1 - i] : p[i];
+
+	switch (type) 
+	{
+		case GEOMETRY_LOADER_PLY_INT8: return (signed char)b[0];
+		case GEOMETRY_LOADER_PLY_UINT8: return b[0];
+		case GEOMETRY_LOADER_PLY_INT16: { short v; memcpy(&v, b, 2); return v; }
+		case GEOMETRY_LOADER_PLY_UINT16: { unsigned short v; memcpy(&v, b, 2); return v; }
+		case GEOMETRY_LOADER_PLY_INT32: { int v; memcpy(&v, b, 4); return v; }
+		case GEOMETRY_LOADER_PLY_UINT32: { unsigned int v; memcpy(&v, b, 4); return v; }
+		case GEOMETRY_LOADER_PLY_FLOAT32: { float v; memcpy(&v, b, 4); return v; }
+		case GEOMETRY_LOADER_PLY_FLOAT64: { double v; memcpy(&v, b, 8); return v; }
+		default: return 0;
+	}
+}
+
+// store property value into vertex 
+static void geometry_loader_ply_store(Vertex * const vertex, const Geometry_Loader_Ply_Property & property, const double value)
+{
+	// integer colors are scaled to [0, 1]
+	double color = value;
+	if (property.type == GEOMETRY_LOADER_PLY_UINT16 || property.type == GEOMETRY_LOADER_PLY_INT16) color /= 65535;
+	else if (property.type < GEOMETRY_LOADER_PLY_FLOAT32) color /= 255;
+
+	switch (property.field) 
+	{
+		case GEOMETRY_LOADER_PLY_X: vertex->x = value; break;
+		case GEOMETRY_LOADER_PLY_Y: vertex->y = value; break;
+		case GEOMETRY_LOADER_PLY_Z: vertex->z = value; break;
+		case GEOMETRY_LOADER_PLY_NX: vertex->nx = value; break;
+		case GEOMETRY_LOADER_PLY_NY: vertex->ny = value; break;
+		case GEOMETRY_LOADER_PLY_NZ: vertex->nz = value; break;
+		case GEOMETRY_LOADER_PLY_RED: vertex->color[0] = (float)color; break;
+		case GEOMETRY_LOADER_PLY_GREEN: vertex->color[1] = (float)color; break;
+		case GEOMETRY_LOADER_PLY_BLUE: vertex->color[2] = (float)color; break;
+		case GEOMETRY_LOADER_PLY_GROUP: vertex->group = value > 0 ? (size_t)value : 0; break;
+	}
+}
+
+// load vertices from PLY file (binary or ascii; positions, normals, colors and groups if present) 
+// note vertices are read straight from the mapped file, only the vertex element is used 
+bool geometry_loader_ply(const char * ply_filename, Vertices & vertices, size_t group /*= 0*/, const size_t groups_count /*= 1*/)
+{
+	Filesystem_Mapping mapping;
+	if (!interface_filesystem_map_file(ply_filename, &mapping)) 
+	{
+		core_state.error = CORE_ERROR_UNABLE_TO_OPEN_FILE;
+		return false;
+	}
+
+	const char * p = (const char *)mapping.data, * const end = p + mapping.size;
+
+	// * parse header * 
+	enum { ASCII, LITTLE_ENDIAN_BINARY, BIG_ENDIAN_BINARY } format = ASCII;
+	Geometry_Loader_Ply_Property properties[GEOMETRY_LOADER_PLY_MAX_PROPERTIES];
+	int properties_count = 0;
+	size_t vertices_count = 0, skip_lines = 0, skip_bytes = 0, record_size = 0, element_count = 0;
+	bool in_vertex = false, vertex_found = false, header_ok = false, skippable = true;
+	bool valid = end - p >= 4 && memcmp(p, "ply", 3) == 0 && (p[3] == '\n' || p[3] == '\r');
+
+	while (valid && p < end) 
+	{
+		// copy the line 
+		char line[256];
+		const char * line_end = (const char *)memchr(p, '\n', end - p);
+		if (!line_end) line_end = end;
+		size_t length = line_end - p;
+		if (length >= sizeof(line)) length = sizeof(line) - 1;
+		memcpy(line, p, length);
+		line[length] = '\0';
+		if (length > 0 && line[length - 1] == '\r') line[length - 1] = '\0';
+		p = line_end < end ? line_end + 1 : end;
+
+		char keyword[32], a[32], b[32], c[32];
+		unsigned long long n;
+		if (sscanf(line, "%31s", keyword) != 1) continue;
+
+		if (strcmp(keyword, "end_header") == 0)
+		{
+			header_ok = true;
+			break;
+		}
+		else if (strcmp(keyword, "format") == 0 && sscanf(line, "%*s %31s", a) == 1) 
+		{
+			if (strcmp(a, "ascii") == 0) format = ASCII;
+			else if (strcmp(a, "binary_little_endian") == 0) format = LITTLE_ENDIAN_BINARY;
+			else if (strcmp(a, "binary_big_endian") == 0) format = BIG_ENDIAN_BINARY;
+			else valid = false;
+		}
+		else if (strcmp(keyword, "element") == 0 && sscanf(line, "%*s %31s %llu", a, &n) == 2) 
+		{
+			// elements before vertices have to be skipped
+			if (!vertex_found && !in_vertex) 
+			{
+				skip_lines += element_count; 
+				skip_bytes += element_count * record_size;
+			}
+
+			in_vertex = !vertex_found && strcmp(a, "vertex") == 0;
+			if (in_vertex) vertices_count = (size_t)n;
+			vertex_found = vertex_found || in_vertex;
+			element_count = (size_t)n;
+			record_size = 0;
+		}
+		else if (strcmp(keyword, "property") == 0 && sscanf(line, "%*s %31s %31s %31s", a, b, c) >= 2) 
+		{
+			// lists have variable size, we can't skip over them in binary files
+			if (strcmp(a, "list") == 0) 
+			{
+				if (in_vertex) valid = false; 
+				else if (!vertex_found) skippable = false;
+				continue;
+			}
+
+			int type = 0;
+			while (type < GEOMETRY_LOADER_PLY_TYPES_COUNT && strcmp(a, geometry_loader_ply_type_names[type][0]) != 0 && strcmp(a, geometry_loader_ply_type_names[type][1]) != 0) type++;
+			if (type == GEOMETRY_LOADER_PLY_TYPES_COUNT) 
+			{
+				valid = false;
+				continue;
+			}
+
+			record_size += geometry_loader_ply_type_sizes[type];
+			if (!in_vertex) continue;
+
+			if (properties_count == GEOMETRY_LOADER_PLY_MAX_PROPERTIES) 
+			{
+				valid = false;
+				continue;
+			}
+
+			Geometry_Loader_Ply_Property * const property = properties + properties_count++;
+			property->type = (GEOMETRY_LOADER_PLY_TYPE)type;
+			property->field = 0;
+			while (property->field < GEOMETRY_LOADER_PLY_FIELDS_COUNT && strcmp(b, geometry_loader_ply_field_names[property->field]) != 0) property->field++;
+
+			// some programs call colors diffuse_red, ...
+			if (strcmp(b, "diffuse_red") == 0) property->field = GEOMETRY_LOADER_PLY_RED;
+			if (strcmp(b, "diffuse_green") == 0) property->field = GEOMETRY_LOADER_PLY_GREEN;
+			if (strcmp(b, "diffuse_blue") == 0) property->field = GEOMETRY_LOADER_PLY_BLUE;
+		}
+	}
+
+	valid = valid && header_ok && vertex_found && (format == ASCII || skippable);
+	if (!valid)
+	{
+		printf("Unsupported or damaged PLY file.\n");
+		interface_filesystem_unmap_file(&mapping);
+		return false;
+	}
+
+	// size of binary vertex record 
+	size_t vertex_size = 0;
+	for (int i = 0; i < properties_count; i++) vertex_size += geometry_loader_ply_type_sizes[properties[i].type];
+
+	// skip elements stored before vertices 
+	if (format == ASCII) 
+	{
+		for (size_t i = 0; i < skip_lines; i++) parser_skip_line(p, end);
+	}
+	else 
+	{
+		if (skip_bytes > (size_t)(end - p)) p = end; else p += skip_bytes;
+		if (vertex_size == 0 || (size_t)(end - p) / vertex_size < vertices_count) 
+		{
+			printf("PLY file is truncated.\n");
+			interface_filesystem_unmap_file(&mapping);
+			return false;
+		}
+	}
+
+	// make room for all of them at once 
+	if (!DYN_RESERVE(vertices, vertices.count + vertices_count))
+	{
+		interface_filesystem_unmap_file(&mapping);
+		core_state.error = CORE_ERROR_OUT_OF_MEMORY;
+		return false;
+	}
+
+	const unsigned int byte_order = 1;
+	const bool little_endian_machine = *(const unsigned char *)&byte_order == 1;
+	const bool swap = format != ASCII && (format == LITTLE_ENDIAN_BINARY) != little_endian_machine;
+	bool complete = true;
+
+	for (size_t i = 0; i < vertices_count && complete; i++) 
+	{
+		Vertex * const vertex = vertices.data + vertices.count;
+		if (!vertex->set) memset(vertex, 0, sizeof(Vertex));
+		vertex->set = true;
+		vertex->reconstructed = true;
+		vertex->group = group; // unless the file has groups
+
+		for (int j = 0; j < properties_count; j++) 
+		{
+			double value;
+			if (format == ASCII) 
+			{
+				while (p < end && isspace((unsigned char)*p)) p++;
+				if (!parser_double(p, end, value)) 
+				{
+					complete = false;
+					break;
+				}
+			}
+			else
+			{
+				value = geometry_loader_ply_value((const unsigned char *)p, properties[j].type, swap);
+				p += geometry_loader_ply_type_sizes[properties[j].type];
+			}
+
+			geometry_loader_ply_store(vertex, properties[j], value);
+		}
+
+		if (vertex->group >= groups_count) vertex->group = group;
+
+		if (complete) vertices.count++;
+	}
+
+	interface_filesystem_unmap_file(&mapping);
+
+	if (!complete) printf("PLY file is truncated.\n");
+	geometry_changed_all();
+	return true;
 }
 
 // load 2d points from text file (one point per line: <picture_no> <vertex_no> <credibility> <x> <y> <...>); returns true on success
@@ -721,11 +1492,85 @@ bool geometry_loader_contours(const char * txt_filename, Shots & shots)
 	return false;
 }
 
+// shots indexed by filename (without path), so that we don't have to compare names with all shots 
+struct Geometry_Loader_Names
+{
+	size_t * slots; // shot id + 1 (0 means empty slot)
+	size_t mask;
+};
+
+// filename without path (points into the string)
+static const char * geometry_loader_basename(const char * filename)
+{
+	const char * name = filename;
+	for (const char * p = filename; *p; p++) 
+	{
+		if (strchr(FILESYSTEM_PATH_SEPARATORS, *p)) name = p + 1;
+	}
+
+	return name;
+}
+
+static size_t geometry_loader_hash(const char * s)
+{
+	size_t hash = 2166136261u;
+	while (*s) hash = (hash ^ (unsigned char)*s++) * 16777619u;
+	return hash;
+}
+
+// find shot by name 
+static bool geometry_loader_names_find(const Geometry_Loader_Names & names, const Shots & shots, const char * filename, size_t & shot_id)
+{
+	const char * const name = geometry_loader_basename(filename);
+	for (size_t slot = geometry_loader_hash(name) & names.mask; names.slots[slot]; slot = (slot + 1) & names.mask)
+	{
+		shot_id = names.slots[slot] - 1;
+		if (strcmp(geometry_loader_basename(shots.data[shot_id].name), name) == 0) return true;
+	}
+
+	return false;
+}
+
+// index names of all shots (the first one wins if there are more shots with the same name)
+static void geometry_loader_names_build(Geometry_Loader_Names & names, const Shots & shots)
+{
+	size_t size = 16; 
+	while (size < 2 * shots.count) size *= 2;
+	names.mask = size - 1;
+	names.slots = ALLOC(size_t, size);
+	memset(names.slots, 0, sizeof(size_t) * size);
+
+	for ALL(shots, i) 
+	{
+		if (!shots.data[i].name) continue;
+		const char * const name = geometry_loader_basename(shots.data[i].name);
+		size_t slot = geometry_loader_hash(name) & names.mask, shot_id;
+		if (geometry_loader_names_find(names, shots, name, shot_id)) continue;
+		while (names.slots[slot]) slot = (slot + 1) & names.mask;
+		names.slots[slot] = i + 1;
+	}
+}
+
+// index shot added after the names were built (the index is rebuilt when it gets too full)
+static void geometry_loader_names_add(Geometry_Loader_Names & names, const Shots & shots, const size_t shot_id)
+{
+	if (2 * shots.count > names.mask + 1)
+	{
+		FREE(names.slots);
+		geometry_loader_names_build(names, shots);
+		return;
+	}
+
+	size_t slot = geometry_loader_hash(geometry_loader_basename(shots.data[shot_id].name)) & names.mask;
+	while (names.slots[slot]) slot = (slot + 1) & names.mask;
+	names.slots[slot] = shot_id + 1;
+}
+
 // load points from text files
 bool geometry_loader_points(const char * pictures_filename, const char * tracks_filename, Shots & shots, Vertices & vertices, size_t group /*= 0*/)
 {
 	// open file 
-	std::ifstream input_pictures(pictures_filename), input_tracks(tracks_filename); 
+	std::ifstream input_pictures(pictures_filename); 
 
 	// tracks were maybe generated for different set of images, we want to import
 	// only the pictures in our database of shots
@@ -737,80 +1582,252 @@ bool geometry_loader_points(const char * pictures_filename, const char * tracks_
 		size_t track_picture_id = 0; 
 		DYN_INIT(index_in_shots);
 		std::string picture_filename; 
+		Geometry_Loader_Names names;
+		geometry_loader_names_build(names, shots);
 
 		while (input_pictures >> picture_filename) 
 		{
-			// find this picture in shots
-			for ALL(shots, i) 
+			// find this picture in shots and save it's index 
+			size_t shot_id;
+			if (geometry_loader_names_find(names, shots, picture_filename.c_str(), shot_id)) 
 			{
-				// if it is there, save it's index
-				if (interface_filesystem_compare_filenames(picture_filename.c_str(), shots.data[i].name)) 
-				{
-					DYN(index_in_shots, track_picture_id);
-					index_in_shots.data[track_picture_id].value = i; 
-					break; 
-				}
+				DYN(index_in_shots, track_picture_id);
+				index_in_shots.data[track_picture_id].value = shot_id; 
 			}
 
 			track_picture_id++; 
 		}
+
+		FREE(names.slots);
 	}
 	else
 	{
-		DYN_FREE(index_in_shots);
 		return false;
 	}
 
-	// load tracks 
+	// parse tracks (one point per line: <picture_id> <track_id> <x> <y>)
+	Parser_Table table;
+	if (!geometry_loader_table(tracks_filename, 4, table))
+	{
+		DYN_FREE(index_in_shots);
+		return false; 
+	}
+
+	// first pass - drop points on pictures we don't have and count what we'll need 
 	const size_t vertices_offset = vertices.count; 
+	size_t tracks_count = 0, accepted = 0;
+	size_t * shot_points = ALLOC(size_t, shots.count + 1);
+	memset(shot_points, 0, sizeof(size_t) * (shots.count + 1));
 
-	if (input_tracks)
+	for (size_t i = 0; i < table.rows; i++) 
 	{
-		size_t picture_id, track_id; 
-		double x, y; 
-		size_t t = 0;
-
-		while (input_tracks >> picture_id >> track_id >> x >> y)
+		double * const row = table.values + 4 * i;
+		const double picture_id = row[0], track_id = row[1];
+
+		// skip track if it's picture isn't in our sequence
+		if (
+			picture_id < 0 || picture_id != floor(picture_id) || picture_id >= index_in_shots.count || 
+			track_id < 0 || track_id != floor(track_id) || track_id >= (double)(SIZE_MAX / 2) || 
+			!IS_SET(index_in_shots, (size_t)picture_id)
+		)
 		{
-			// skip track if it's picture isn't in our sequence
-			if (!IS_SET(index_in_shots, picture_id)) continue;
+			row[0] = -1;
+			continue;
+		}
 
-			// create vertex for this point (does nothing if it already exists)
-			const size_t vertex_id = vertices_offset + track_id;
-			if (t++ % 10000 == 0)
-			{
-				// debug
-				printf("vertices: accessing %d, count %d, allocated %d\n", vertex_id, vertices.count, vertices.allocated);
-			}
-			DYN(vertices, vertex_id); 
-			vertices.data[vertex_id].group = group;
-			vertices.data[vertex_id].vertex_type = GEOMETRY_VERTEX_AUTO;
+		const size_t shot_id = index_in_shots.data[(size_t)picture_id].value; 
+		ASSERT_IS_SET(shots, shot_id);
+		shot_points[shot_id]++;
+		if ((size_t)track_id >= tracks_count) tracks_count = (size_t)track_id + 1;
+		accepted++;
+	}
 
-			// save point information
-			ASSERT_IS_SET(shots, index_in_shots.data[picture_id].value);
-			const size_t shot_id = index_in_shots.data[picture_id].value; 
-			ADD(shots.data[shot_id].points);
-			LAST(shots.data[shot_id].points).x = x / shots.data[shot_id].width; 
-			LAST(shots.data[shot_id].points).y = y / shots.data[shot_id].height; 
-			LAST(shots.data[shot_id].points).vertex = vertex_id;
-			geometry_point_vertex_incidence(shot_id, LAST_INDEX(shots.data[shot_id].points), vertex_id);
-		}
+	// size everything up front 
+	size_t * track_points = ALLOC(size_t, tracks_count + 1);
+	memset(track_points, 0, sizeof(size_t) * (tracks_count + 1));
+	for (size_t i = 0; i < table.rows; i++) 
+	{
+		if (table.values[4 * i] >= 0) track_points[(size_t)table.values[4 * i + 1]]++;
 	}
-	else
+
+	bool ok = 
+		DYN_RESERVE(vertices, vertices_offset + tracks_count) && 
+		DYN_RESERVE(vertices_incidence, vertices_offset + tracks_count)
+	;
+
+	for ALL(shots, i) 
+	{
+		if (shot_points[i]) ok = ok && DYN_RESERVE(shots.data[i].points, shots.data[i].points.count + shot_points[i]);
+	}
+
+	for (size_t i = 0; ok && i < tracks_count; i++) 
+	{
+		if (!track_points[i]) continue;
+		Vertex_Incidence * const incidence = vertices_incidence.data + vertices_offset + i;
+		if (!incidence->set) memset(incidence, 0, sizeof(Vertex_Incidence));
+		incidence->set = true;
+		ok = DYN_RESERVE(incidence->shot_point_ids, incidence->shot_point_ids.count + track_points[i]);
+	}
+
+	FREE(track_points);
+	FREE(shot_points);
+
+	if (!ok) 
 	{
+		parser_table_free(table);
 		DYN_FREE(index_in_shots);
-		return false; 
+		core_state.error = CORE_ERROR_OUT_OF_MEMORY;
+		return false;
+	}
+
+	// second pass - create vertices and points 
+	for (size_t i = 0; i < table.rows; i++) 
+	{
+		const double * const row = table.values + 4 * i;
+		if (row[0] < 0) continue;
+
+		// create vertex for this point (does nothing if it already exists)
+		const size_t vertex_id = vertices_offset + (size_t)row[1];
+		Vertex * const vertex = vertices.data + vertex_id;
+		if (!vertex->set) memset(vertex, 0, sizeof(Vertex));
+		vertex->set = true;
+		vertex->group = group;
+		vertex->vertex_type = GEOMETRY_VERTEX_AUTO;
+		if (vertices.count <= vertex_id) vertices.count = vertex_id + 1;
+		if (vertices_incidence.count <= vertex_id) vertices_incidence.count = vertex_id + 1;
+
+		// save point information
+		const size_t shot_id = index_in_shots.data[(size_t)row[0]].value; 
+		Shot * const shot = shots.data + shot_id;
+		const size_t point_id = shot->points.count++;
+		Point * const point = shot->points.data + point_id;
+		if (!point->set) memset(point, 0, sizeof(Point));
+		point->set = true;
+		point->x = row[2] / shot->width; 
+		point->y = row[3] / shot->height; 
+		point->vertex = vertex_id;
+
+		// and it's incidence with the vertex
+		Double_Indices * const ids = &vertices_incidence.data[vertex_id].shot_point_ids;
+		Double_Index * const id = ids->data + ids->count++;
+		id->set = true;
+		id->primary = shot_id;
+		id->secondary = point_id;
+	}
+
+	if (!table.complete) 
+	{
+		printf("Tracks file contains malformed line, loaded %u points before it.\n", (unsigned int)accepted);
 	}
 
+	parser_table_free(table);
 	DYN_FREE(index_in_shots);
+	geometry_changed_all();
 	return true;
 }
 
-// add another image to the sequence 
-bool geometry_loader_add_shot(const char * filename) // note that we're being inconsistent here by not passing reference to shots structure, but we can't do that since we manipulate it by geometry_new_shot - isn't this a bigger problem? 
+// image headers probed by one thread
+struct Geometry_Loader_Probe_Work
+{
+	const Shots * shots;
+	Image_Info * infos;
+	bool * probed;
+	size_t from, to;
+	pthread_t thread;
+};
+
+static const int GEOMETRY_LOADER_PROBE_MAX_THREADS = 32;
+static const size_t GEOMETRY_LOADER_PROBE_MIN_SHOTS = 8; // shots per thread (reading headers mostly waits for the disk)
+
+// read headers of images in the slice
+static void * geometry_loader_probe_function(void * arg)
+{
+	Geometry_Loader_Probe_Work * const work = (Geometry_Loader_Probe_Work *)arg;
+
+	for (size_t i = work->from; i < work->to; i++)
+	{
+		const Shot * const shot = work->shots->data + i;
+		work->probed[i - work->from] = 
+			shot->set && shot->image_filename && shot->info_status < GEOMETRY_INFO_LOADED && 
+			image_info_probe(shot->image_filename, work->infos[i - work->from])
+		;
+	}
+
+	return NULL;
+}
+
+// read image size and camera optics of shots from first_shot on from image headers 
+void geometry_loader_probe_shots(const size_t first_shot)
+{
+	if (first_shot >= shots.count) return;
+	const size_t count = shots.count - first_shot;
+
+	Image_Info * const infos = ALLOC(Image_Info, count);
+	bool * const probed = ALLOC(bool, count);
+	if (!infos || !probed)
+	{
+		FREE(infos);
+		FREE(probed);
+		core_state.error = CORE_ERROR_OUT_OF_MEMORY;
+		return;
+	}
+
+	// split shots among threads (this one takes the first slice)
+	int threads_count = 2 * parser_processors();
+	if (threads_count > GEOMETRY_LOADER_PROBE_MAX_THREADS) threads_count = GEOMETRY_LOADER_PROBE_MAX_THREADS;
+	if ((size_t)threads_count > count / GEOMETRY_LOADER_PROBE_MIN_SHOTS + 1) threads_count = (int)(count / GEOMETRY_LOADER_PROBE_MIN_SHOTS + 1);
+
+	Geometry_Loader_Probe_Work work[GEOMETRY_LOADER_PROBE_MAX_THREADS];
+	bool threaded[GEOMETRY_LOADER_PROBE_MAX_THREADS];
+	for (int i = 0; i < threads_count; i++)
+	{
+		work[i].shots = &shots;
+		work[i].from = first_shot + count * i / threads_count;
+		work[i].to = first_shot + count * (i + 1) / threads_count;
+		work[i].infos = infos + (work[i].from - first_shot);
+		work[i].probed = probed + (work[i].from - first_shot);
+		threaded[i] = i > 0 && pthread_create(&work[i].thread, NULL, geometry_loader_probe_function, work + i) == 0;
+	}
+
+	geometry_loader_probe_function(work);
+	for (int i = 1; i < threads_count; i++)
+	{
+		if (threaded[i]) pthread_join(work[i].thread, NULL); else geometry_loader_probe_function(work + i);
+	}
+
+	// fill in what we've learned (calibration data the user already has are kept)
+	size_t loaded = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (!probed[i]) continue;
+		Shot * const shot = shots.data + first_shot + i;
+
+		shot->width = infos[i].width;
+		shot->height = infos[i].height;
+		shot->info_status = GEOMETRY_INFO_LOADED;
+		loaded++;
+
+		double f, film_back;
+		if (!shot->calibrated && shot->f == 0 && image_info_focal_length(infos[i], f, film_back))
+		{
+			shot->f = f;
+			shot->fovx = rad2deg(2 * atan(0.5 * shot->width / f));
+			shot->fovy = rad2deg(2 * atan(0.5 * shot->height / f));
+			if (shot->film_back == 0) shot->film_back = film_back;
+		}
+
+		geometry_shot_changed(first_shot + i);
+	}
+
+	printf("Image headers of %lu out of %lu images read.\n", (unsigned long)loaded, (unsigned long)count);
+	FREE(infos);
+	FREE(probed);
+}
+
+// create shot for image (the header isn't read)
+static bool geometry_loader_new_shot(const char * filename, size_t & shot_id)
 {
 	// obtain id for new shot 
-	size_t shot_id; 
 	if (!geometry_new_shot(shot_id)) return false; 
 
 	// fill in what we know about the image (which is just it's filename)
@@ -826,6 +1843,16 @@ bool geometry_loader_add_shot(const char * filename) // note that we're being in
 	return true;
 }
 
+// add another image to the sequence 
+bool geometry_loader_add_shot(const char * filename, const bool probe) // note that we're being inconsistent here by not passing reference to shots structure, but we can't do that since we manipulate it by geometry_new_shot - isn't this a bigger problem? 
+{
+	size_t shot_id;
+	if (!geometry_loader_new_shot(filename, shot_id)) return false;
+
+	if (probe) geometry_loader_probe_shots(shot_id);
+	return true;
+}
+
 // load IFL file (i.e., image file list) 
 bool geometry_loader_ifl(const char * filename) // note the same inconsistency as in geometry_loader_add_shot
 {
@@ -841,7 +1868,11 @@ bool geometry_loader_ifl(const char * filename) // note the same inconsistency a
 		return false; 
 	}
 
-	// add the shots 
+	// add the shots (their headers are read all at once at the end)
+	const size_t first_shot = shots.count;
+	Geometry_Loader_Names names;
+	geometry_loader_names_build(names, shots);
+
 	std::string picture_filename;
 	while (input_list >> picture_filename) 
 	{
@@ -851,6 +1882,8 @@ bool geometry_loader_ifl(const char * filename) // note the same inconsistency a
 			if (picture_filename[filename_iter] >= 0 && picture_filename[filename_iter] <= 31 && picture_filename[filename_iter] != 13 && picture_filename[filename_iter] != 10)
 			{
 				printf("Non-printable characters found, doesn't look like .ifl file.\n");
+				FREE(names.slots);
+				geometry_loader_probe_shots(first_shot);
 				return false;
 			}
 		}
@@ -876,21 +1909,10 @@ bool geometry_loader_ifl(const char * filename) // note the same inconsistency a
 		}
 
 		// try to find it - we don't add duplicates
-		bool skip = false;
-		for ALL(shots, i)
-		{
-			// if it is there, save it's index
-			if (interface_filesystem_compare_filenames(picture_filename.c_str(), shots.data[i].name)) 
-			{
-				skip = true;
-				break;
-			}
-		}
-
-		// load it 
-		if (!skip)
+		size_t shot_id;
+		if (!geometry_loader_names_find(names, shots, picture_filename.c_str(), shot_id) && geometry_loader_new_shot(picture_path, shot_id))
 		{
-			geometry_loader_add_shot(picture_path);
+			geometry_loader_names_add(names, shots, shot_id);
 		}
 
 		// clean-up if necessary 
@@ -901,6 +1923,8 @@ bool geometry_loader_ifl(const char * filename) // note the same inconsistency a
 	}
 
 	input_list.close();
+	FREE(names.slots);
+	geometry_loader_probe_shots(first_shot);
 	return true;
 }
 
@@ -5,45 +5,23 @@
 #include "core_math_routines.h"
 #include "geometry_structures.h"
 #include "geometry_routines.h"
+#include "geometry_project_format.h"
+#include "core_parser.h"
+#include "core_image_info.h"
 #include <fstream>
 #include <string>
 // #include "libxml/parser.h"
 
-// SAX state
-struct geometry_loader_SAX_state
-{
-	// loaded file's filename and directory
-	char * filename, * directory;
-
-	// photos and camera data 
-	Shots * shots;
-
-	// pointer to currently loaded shot
-	Shot * current_shot;
-
-	// first cammera's film back
-	double first_film_back;
-
-	// number of points currently loaded from the file 
-	size_t points_count; 
-
-	// points data  
-	Vertices * vertices; 
-};
-
 // process loaded data (compute focal length from fov, assemble projection matrices, ...)
+// shots are processed in parallel
+// obtains LOCK_RW(opencv)
 void geometry_process_data(Shots shots);
 
-// SAX callbacks
-/*void geometry_loader_SAX_start_element(geometry_loader_SAX_state * state, const xmlChar * name, const xmlChar ** attrs);
-void geometry_loader_SAX_end_element(geometry_loader_SAX_state * state, const xmlChar * name);
-void geometry_loader_SAX_characters(geometry_loader_SAX_state * state, const xmlChar * cdata, int len);*/
-
-// load saved project
+// load saved project (text or binary, the format is recognized from file's header)
 bool geometry_load_project(const char * filename);
 
-// load data from realviz xml file
-/* void geometry_loader(const char * xml_filename, Shots & shots); */
+// load data from realviz xml file (.rzml, .rzi), returns false if it can't be read
+bool geometry_loader_rzml(const char * rzml_filename);
 
 // load data from realviz rz3 file
 bool geometry_loader_rz3(const char * xml_filename, Shots & shots);
@@ -51,16 +29,26 @@ bool geometry_loader_rz3(const char * xml_filename, Shots & shots);
 // load 3d vertices from text file (one vertex per line: <id> <x> <y> <z>); returns true on success
 bool geometry_loader_vertices(const char * txt_filename, Vertices & vertices, size_t group = 0);
 
+// load vertices from PLY file (binary or ascii; positions, normals, colors and groups if present);
+// groups from the file which aren't below groups_count (don't exist) are replaced by group
+bool geometry_loader_ply(const char * ply_filename, Vertices & vertices, size_t group = 0, const size_t groups_count = 1);
+
 // load contours 
 bool geometry_loader_contours(const char * txt_filename, Shots & shots);
 
 // load points from text files
 bool geometry_loader_points(const char * pictures_filename, const char * tracks_filename, Shots & shots, Vertices & vertices, size_t group = 0);
 
-// add another image to the sequence 
-bool geometry_loader_add_shot(const char * filename);
+// read image size and camera optics (focal length, film back) of shots from first_shot on
+// from the image headers, so that they're ready for calibration without loading the images;
+// headers are read in parallel, shots which already have reliable size are skipped
+void geometry_loader_probe_shots(const size_t first_shot);
+
+// add another image to the sequence (and read its header, unless the caller adds more images
+// and probes them all at once)
+bool geometry_loader_add_shot(const char * filename, const bool probe = true);
 
-// load IFL file (i.e., image file list) 
+// load IFL file (i.e., image file list), headers of added images are read at the end
 bool geometry_loader_ifl(const char * filename);
 
 // load points from *_points.txt and *_pictures.ifl imagepair
@@ -0,0 +1,95 @@
+#ifndef __GEOMETRY_PROJECT_FORMAT
+#define __GEOMETRY_PROJECT_FORMAT
+
+// binary project file layout
+//
+// the file starts with a header followed by sections; every section has a header giving the
+// number of items, size of one item and size of the payload, which follows it (padded to 8 bytes);
+// records are plain arrays of fixed size structures, so the file can be memory mapped and the
+// arrays copied in bulk; sections unknown to the reader are skipped
+//
+// it holds the same data as the text "insight3d data file" (and can be converted to and from it)
+
+// files with this extension are saved in binary format
+const char * const GEOMETRY_PROJECT_BINARY_EXTENSION = ".i3db";
+
+const char GEOMETRY_PROJECT_MAGIC[16] = { 'i', 'n', 's', 'i', 'g', 'h', 't', '3', 'd', ' ', 'b', 'i', 'n', 'a', 'r', 'y' };
+const unsigned int GEOMETRY_PROJECT_VERSION = 1;
+const unsigned int GEOMETRY_PROJECT_BYTE_ORDER = 0x01020304; // reads differently on machine with different endianness
+
+#define GEOMETRY_PROJECT_TAG(a, b, c, d) ((unsigned int)(a) | ((unsigned int)(b) << 8) | ((unsigned int)(c) << 16) | ((unsigned int)(d) << 24))
+
+enum GEOMETRY_PROJECT_SECTION
+{
+	GEOMETRY_PROJECT_STRINGS = GEOMETRY_PROJECT_TAG('S', 'T', 'R', 'S'),          // zero terminated strings (item is a byte)
+	GEOMETRY_PROJECT_VERTICES = GEOMETRY_PROJECT_TAG('V', 'E', 'R', 'T'),         // Geometry_Project_Vertex
+	GEOMETRY_PROJECT_POLYGONS = GEOMETRY_PROJECT_TAG('P', 'O', 'L', 'Y'),         // index of the first vertex of each polygon (one more at the end)
+	GEOMETRY_PROJECT_POLYGON_VERTICES = GEOMETRY_PROJECT_TAG('P', 'V', 'R', 'T'), // vertex ids of all polygons
+	GEOMETRY_PROJECT_SHOTS = GEOMETRY_PROJECT_TAG('S', 'H', 'O', 'T'),            // Geometry_Project_Shot
+	GEOMETRY_PROJECT_POINTS = GEOMETRY_PROJECT_TAG('P', 'N', 'T', 'S')            // Geometry_Project_Point of all shots (in order of shots)
+};
+
+struct Geometry_Project_Header
+{
+	char magic[16];
+	unsigned int version, byte_order, sections_count, reserved;
+};
+
+struct Geometry_Project_Section
+{
+	unsigned int tag, item_size;
+	unsigned long long count, size;
+};
+
+struct Geometry_Project_Vertex
+{
+	double x, y, z;
+	int reconstructed, vertex_type;
+};
+
+struct Geometry_Project_Shot
+{
+	double f, film_back, fovx, fovy, pp_x, pp_y;
+	double P[12];                                 // projection matrix (zeros if there isn't any)
+	int width, height, calibrated, resected, info_status, reserved;
+	unsigned long long image_filename, name;      // offsets into strings section
+	unsigned long long points_first, points_count;
+};
+
+struct Geometry_Project_Point
+{
+	double x, y;
+	unsigned long long vertex;
+};
+
+// autosave journal layout
+//
+// the file starts with a header (with different magic and no sections) followed by records; every
+// record has a header giving its type, id of the item (and of its shot, for points) and size of the
+// payload, which follows it (padded to 8 bytes); a record holds the whole current state of the item
+// (or just the header if the item has been deleted), ids are the ones used in memory, so replaying
+// records in order restores the state exactly; records are written in batches, each terminated by
+// a commit record with checksum of the batch, a batch without valid commit is ignored
+
+const char GEOMETRY_AUTOSAVE_MAGIC[16] = { 'i', '3', 'd', ' ', 'a', 'u', 't', 'o', 's', 'a', 'v', 'e', ' ', 'l', 'o', 'g' };
+const unsigned int GEOMETRY_AUTOSAVE_VERSION = 1;
+
+enum GEOMETRY_AUTOSAVE_RECORD_TYPE
+{
+	GEOMETRY_AUTOSAVE_RESET = GEOMETRY_PROJECT_TAG('R', 'S', 'E', 'T'),          // everything is released (starts the snapshot)
+	GEOMETRY_AUTOSAVE_VERTEX = GEOMETRY_PROJECT_TAG('V', 'E', 'R', 'T'),         // Geometry_Project_Vertex
+	GEOMETRY_AUTOSAVE_POINT = GEOMETRY_PROJECT_TAG('P', 'N', 'T', 'S'),          // Geometry_Project_Point (vertex is raw id)
+	GEOMETRY_AUTOSAVE_POLYGON = GEOMETRY_PROJECT_TAG('P', 'O', 'L', 'Y'),        // vertex ids
+	GEOMETRY_AUTOSAVE_SHOT = GEOMETRY_PROJECT_TAG('S', 'H', 'O', 'T'),           // Geometry_Project_Shot followed by strings (offsets are relative to them)
+	GEOMETRY_AUTOSAVE_COMMIT = GEOMETRY_PROJECT_TAG('C', 'O', 'M', 'T')          // checksum of the batch
+};
+
+const unsigned int GEOMETRY_AUTOSAVE_DELETED = 1; // record flag
+
+struct Geometry_Autosave_Record
+{
+	unsigned int type, flags;
+	unsigned long long id, shot_id, size;
+};
+
+#endif
@@ -107,10 +107,7 @@ bool publish_triangulation_data_from_calibration(
 
 		// try to find this shot among those calibrated 
 		size_t P_id;
-		bool found;
-		LAMBDA_FIND(calibration->Ps, P_id, found, calibration->Ps.data[P_id].shot_id == shot_id);
-
-		if (found) 
+		if (geometry_calibration_find_P(calibration_id, shot_id, P_id)) 
 		{
 			// this point is on calibrated shot - fill in the indices and increase counter 
 			indices[2 * count_points + 0] = P_id;
@@ -261,8 +258,7 @@ bool publish_resection_data_from_calibration(
 
 		// try to find this point among the ones which are reconstructed 
 		size_t X_id; 
-		bool X_found; 
-		LAMBDA_FIND(calibration->Xs, X_id, X_found, calibration->Xs.data[X_id].vertex_id == vertex_id); 
+		const bool X_found = geometry_calibration_find_X(calibration_id, vertex_id, X_id); 
 
 		if (X_found)
 		{
@@ -303,8 +299,7 @@ bool publish_resection_data_from_calibration(
 
 		// find this point again
 		size_t X_id; 
-		bool X_found; 
-		LAMBDA_FIND(calibration->Xs, X_id, X_found, calibration->Xs.data[X_id].vertex_id == vertex_id);
+		const bool X_found = geometry_calibration_find_X(calibration_id, vertex_id, X_id);
 
 		// save the coordinates 
 		if (X_found) 
@@ -54,47 +54,325 @@ bool query_find_point_on_shot_by_vertex_id(size_t shot_id, size_t vertex_id, siz
 	return false; 
 }
 
+// * grid index of points on shots * 
+
+// points of each shot are bucketed into a uniform grid over the image (points outside of the 
+// image fall into border cells); the grid is built the first time the shot is queried and then 
+// kept up to date from the change journal (i.e., geometry_new_point, geometry_point_xy and 
+// geometry_delete_point) 
+
+// average number of points per cell we aim at and when we rebuild the grid with finer cells
+static const size_t QUERY_GRID_POINTS_PER_CELL = 4, QUERY_GRID_REBUILD_PER_CELL = 16;
+static const size_t QUERY_GRID_MAX_SIZE = 512;
+static const size_t QUERY_GRID_NONE = SIZE_MAX;
+
+struct Query_Grid_Cell 
+{
+	size_t * ids; 
+	size_t count, allocated;
+};
+
+struct Query_Grid 
+{
+	bool built;
+	size_t size;                      // cells per side 
+	Query_Grid_Cell * cells;
+	size_t * cell_of, * slot_of;      // point id -> cell and position in it (cell is QUERY_GRID_NONE if not indexed)
+	size_t points_allocated, indexed;
+};
+
+static Query_Grid * query_grids; // one for each shot 
+static size_t query_grids_count; 
+static size_t query_grids_version;
+
+// results of the last range query 
+static size_t * query_grid_results; 
+static size_t query_grid_results_count, query_grid_results_allocated; 
+
+// cell coordinate of relative image coordinate 
+inline static size_t query_grid_coordinate(const Query_Grid * const grid, const double t)
+{
+	if (!(t > 0)) return 0; // also catches nan
+	const size_t c = (size_t)(t * grid->size); 
+	return c < grid->size ? c : grid->size - 1;
+}
+
+// forget grid of a shot 
+static void query_grid_release(Query_Grid * const grid) 
+{
+	if (grid->cells) 
+	{
+		for (size_t i = 0; i < grid->size * grid->size; i++) FREE(grid->cells[i].ids);
+	}
+
+	FREE(grid->cells);
+	FREE(grid->cell_of);
+	FREE(grid->slot_of);
+	memset(grid, 0, sizeof(Query_Grid));
+}
+
+// put point into the grid 
+static void query_grid_insert(Query_Grid * const grid, const size_t shot_id, const size_t point_id)
+{
+	const Point * const point = shots.data[shot_id].points.data + point_id;
+	const size_t cell_id = query_grid_coordinate(grid, point->y) * grid->size + query_grid_coordinate(grid, point->x); 
+	Query_Grid_Cell * const cell = grid->cells + cell_id;
+
+	if (cell->count == cell->allocated) 
+	{
+		cell->allocated = cell->allocated ? 2 * cell->allocated : 4; 
+		cell->ids = (size_t *)realloc(cell->ids, cell->allocated * sizeof(size_t));
+	}
+
+	if (point_id >= grid->points_allocated) 
+	{
+		const size_t allocated = 2 * point_id + 16;
+		grid->cell_of = (size_t *)realloc(grid->cell_of, allocated * sizeof(size_t));
+		grid->slot_of = (size_t *)realloc(grid->slot_of, allocated * sizeof(size_t));
+		for (size_t i = grid->points_allocated; i < allocated; i++) grid->cell_of[i] = QUERY_GRID_NONE;
+		grid->points_allocated = allocated;
+	}
+
+	grid->cell_of[point_id] = cell_id; 
+	grid->slot_of[point_id] = cell->count; 
+	cell->ids[cell->count++] = point_id;
+	grid->indexed++;
+}
+
+// take point out of the grid (if it's there)
+static void query_grid_remove(Query_Grid * const grid, const size_t point_id)
+{
+	if (point_id >= grid->points_allocated || grid->cell_of[point_id] == QUERY_GRID_NONE) return;
+
+	// move the last point of the cell into the hole
+	Query_Grid_Cell * const cell = grid->cells + grid->cell_of[point_id];
+	const size_t slot = grid->slot_of[point_id], last = cell->ids[--cell->count]; 
+	cell->ids[slot] = last; 
+	grid->slot_of[last] = slot;
+
+	grid->cell_of[point_id] = QUERY_GRID_NONE;
+	grid->indexed--;
+}
+
+// index all points of the shot 
+static void query_grid_build(Query_Grid * const grid, const size_t shot_id)
+{
+	query_grid_release(grid);
+
+	const Points * const points = &shots.data[shot_id].points;
+	size_t count = 0; 
+	for ALL(*points, i) count++; 
+
+	grid->size = (size_t)ceil(sqrt(count / (double)QUERY_GRID_POINTS_PER_CELL)); 
+	if (grid->size < 1) grid->size = 1; 
+	if (grid->size > QUERY_GRID_MAX_SIZE) grid->size = QUERY_GRID_MAX_SIZE;
+
+	grid->cells = ALLOC(Query_Grid_Cell, grid->size * grid->size); 
+	memset(grid->cells, 0, grid->size * grid->size * sizeof(Query_Grid_Cell));
+
+	for ALL(*points, i) 
+	{
+		query_grid_insert(grid, shot_id, i);
+	}
+
+	grid->built = true;
+}
+
+// apply changes recorded since the last query
+static void query_grids_update() 
+{
+	if (query_grids_count < shots.count) 
+	{
+		query_grids = (Query_Grid *)realloc(query_grids, shots.count * sizeof(Query_Grid)); 
+		memset(query_grids + query_grids_count, 0, (shots.count - query_grids_count) * sizeof(Query_Grid)); 
+		query_grids_count = shots.count;
+	}
+
+	if (!geometry_journal_complete(query_grids_version)) 
+	{
+		// everything might have changed 
+		for (size_t i = 0; i < query_grids_count; i++) query_grid_release(query_grids + i);
+	}
+	else
+	{
+		size_t position = 0; 
+		Geometry_Change change; 
+		while (geometry_journal_next(position, query_grids_version, change)) 
+		{
+			if (change.kind == GEOMETRY_CHANGE_SHOTS) 
+			{
+				for (size_t i = change.from; i < change.to && i < query_grids_count; i++) query_grid_release(query_grids + i);
+			}
+			else if (change.kind == GEOMETRY_CHANGE_POINTS && change.shot_id < query_grids_count && query_grids[change.shot_id].built) 
+			{
+				// move points to their new cells 
+				Query_Grid * const grid = query_grids + change.shot_id; 
+				const Points * const points = &shots.data[change.shot_id].points;
+				for (size_t i = change.from; i < change.to; i++) 
+				{
+					query_grid_remove(grid, i); 
+					if (i < points->count && points->data[i].set) query_grid_insert(grid, change.shot_id, i);
+				}
+			}
+		}
+	}
+
+	query_grids_version = geometry_version();
+}
+
+// up to date grid of the shot 
+static Query_Grid * query_grid(const size_t shot_id) 
+{
+	query_grids_update(); 
+	Query_Grid * const grid = query_grids + shot_id; 
+
+	// build it (or rebuild it if the cells got too crowded)
+	if (
+		!grid->built || 
+		(grid->size < QUERY_GRID_MAX_SIZE && grid->indexed > QUERY_GRID_REBUILD_PER_CELL * grid->size * grid->size)
+	)
+	{
+		query_grid_build(grid, shot_id);
+	}
+
+	return grid;
+}
+
+// should the point be skipped by the query 
+inline static bool query_skip_point(const Point * const point, const bool skipping_auto) 
+{
+	return skipping_auto && vertices.data[point->vertex].vertex_type == GEOMETRY_VERTEX_AUTO;
+}
+
+// find nearest point in grid cell 
+inline static void query_nearest_in_cell(
+	const Query_Grid * const grid, const Shot * const shot, const size_t i, const size_t j, const double x, const double y, 
+	const bool skipping_auto, size_t & best_point_id, double & best_distance
+)
+{
+	const Query_Grid_Cell * const cell = grid->cells + j * grid->size + i; 
+	for (size_t k = 0; k < cell->count; k++) 
+	{
+		const Point * const point = shot->points.data + cell->ids[k]; 
+		if (query_skip_point(point, skipping_auto)) continue;
+
+		const double d = distance_sq_2(point->x * shot->width, point->y * shot->height, x * shot->width, y * shot->height); 
+		if (best_point_id == SIZE_MAX || d < best_distance || (d == best_distance && cell->ids[k] < best_point_id))
+		{
+			best_distance = d; 
+			best_point_id = cell->ids[k];
+		}
+	}
+}
+
 // find nearest point on shot, returns squared distance in image pixels
 double query_nearest_point(const size_t shot_id, const double x, const double y, size_t & point_id, bool skipping_auto /*= false*/)
 {
 	ASSERT(shots.data[shot_id].width > 0, "image has 0 width");
 	ASSERT(shots.data[shot_id].height > 0, "image has 0 height");
 
-	// go through all points on this shot and find the nearest one
-	size_t i, best_point_id;
-	double best_distance, d;
-	bool best_found = false;
+	const Shot * const shot = shots.data + shot_id; 
+	const Query_Grid * const grid = query_grid(shot_id);
+	const double cell_size = min_value(shot->width, shot->height) / grid->size; // lower bound of cell dimensions in pixels
+	const size_t last = grid->size - 1, cx = query_grid_coordinate(grid, x), cy = query_grid_coordinate(grid, y);
 
-	LAMBDA(
-		shots.data[shot_id].points, i,
+	// search rings of cells around the query until no nearer point can be found
+	size_t best_point_id = SIZE_MAX;
+	double best_distance = -1.0;
+	for (size_t ring = 0; ring < grid->size; ring++) 
+	{
+		// points in this ring and further away are at least this far
+		if (best_point_id != SIZE_MAX && ring > 0 && best_distance <= sqr_value((ring - 1) * cell_size)) break;
 
-		if (skipping_auto && vertices.data[shots.data[shot_id].points.data[i].vertex].vertex_type == GEOMETRY_VERTEX_AUTO) continue;
+		const size_t 
+			x1 = cx >= ring ? cx - ring : 0, x2 = cx + ring <= last ? cx + ring : last, 
+			y1 = cy >= ring ? cy - ring : 0, y2 = cy + ring <= last ? cy + ring : last
+		;
 
-		d = distance_sq_2(
-			shots.data[shot_id].points.data[i].x * shots.data[shot_id].width, 
-			shots.data[shot_id].points.data[i].y * shots.data[shot_id].height, 
-			x * shots.data[shot_id].width, 
-			y * shots.data[shot_id].height
-		);
+		// top and bottom rows of the ring
+		for (size_t i = x1; i <= x2; i++) 
+		{
+			if (cy >= ring) query_nearest_in_cell(grid, shot, i, cy - ring, x, y, skipping_auto, best_point_id, best_distance);
+			if (ring > 0 && cy + ring <= last) query_nearest_in_cell(grid, shot, i, cy + ring, x, y, skipping_auto, best_point_id, best_distance);
+		}
 
-		if (!best_found || d < best_distance)
+		// left and right columns (without corners)
+		for (size_t j = y1; j <= y2; j++) 
 		{
-			best_distance = d;
-			best_found = true;
-			best_point_id = i;
+			if (j + ring == cy || j == cy + ring) continue;
+			if (cx >= ring) query_nearest_in_cell(grid, shot, cx - ring, j, x, y, skipping_auto, best_point_id, best_distance);
+			if (ring > 0 && cx + ring <= last) query_nearest_in_cell(grid, shot, cx + ring, j, x, y, skipping_auto, best_point_id, best_distance);
 		}
+	}
+
+	point_id = best_point_id;
+	return best_point_id != SIZE_MAX ? best_distance : -1.0;
+}
+
+// comparator used to return points ordered by ids 
+static int query_compare_ids(const void * a, const void * b) 
+{
+	const size_t p = *(const size_t *)a, q = *(const size_t *)b; 
+	return p < q ? -1 : p > q ? 1 : 0;
+}
+
+// visit cells intersecting given rectangle (in relative image coordinates) and collect points accepted by the test 
+#define QUERY_GRID_COLLECT(grid, shot, x1, y1, x2, y2, test) \
+	query_grid_results_count = 0; \
+	for (size_t j = query_grid_coordinate((grid), (y1)); j <= query_grid_coordinate((grid), (y2)); j++) \
+	{ \
+		for (size_t i = query_grid_coordinate((grid), (x1)); i <= query_grid_coordinate((grid), (x2)); i++) \
+		{ \
+			const Query_Grid_Cell * const cell = (grid)->cells + j * (grid)->size + i; \
+			for (size_t k = 0; k < cell->count; k++) \
+			{ \
+				const Point * const point = (shot)->points.data + cell->ids[k]; \
+				if (!(test)) continue; \
+				if (query_grid_results_count == query_grid_results_allocated) \
+				{ \
+					query_grid_results_allocated = query_grid_results_allocated ? 2 * query_grid_results_allocated : 256; \
+					query_grid_results = (size_t *)realloc(query_grid_results, query_grid_results_allocated * sizeof(size_t)); \
+				} \
+				query_grid_results[query_grid_results_count++] = cell->ids[k]; \
+			} \
+		} \
+	} \
+	qsort(query_grid_results, query_grid_results_count, sizeof(size_t), query_compare_ids);
+
+// find points on shot inside rectangle [x1, x2] x [y1, y2] (relative image coordinates), 
+// returned ids are ordered and valid until the next query
+const size_t * query_points_in_rectangle(const size_t shot_id, double x1, double y1, double x2, double y2, size_t & count, bool skipping_auto /*= false*/)
+{
+	const Shot * const shot = shots.data + shot_id; 
+	const Query_Grid * const grid = query_grid(shot_id);
+	if (x1 > x2) swap_double(x1, x2); 
+	if (y1 > y2) swap_double(y1, y2);
+
+	QUERY_GRID_COLLECT(grid, shot, x1, y1, x2, y2, 
+		inside_2d_interval(point->x, point->y, x1, y1, x2, y2) && !query_skip_point(point, skipping_auto)
 	);
 
-	if (best_found)
-	{
-		point_id = best_point_id;
-		return best_distance; 
-	}
-	else
-	{
-		point_id = SIZE_MAX;
-		return -1.0;
-	}
+	count = query_grid_results_count; 
+	return query_grid_results;
+}
+
+// find points on shot within radius (in image pixels) from [x, y] (relative image coordinates), 
+// returned ids are ordered and valid until the next query
+const size_t * query_points_in_radius(const size_t shot_id, const double x, const double y, const double radius, size_t & count, bool skipping_auto /*= false*/)
+{
+	ASSERT(shots.data[shot_id].width > 0, "image has 0 width");
+	ASSERT(shots.data[shot_id].height > 0, "image has 0 height");
+
+	const Shot * const shot = shots.data + shot_id; 
+	const Query_Grid * const grid = query_grid(shot_id);
+	const double width = shot->width, height = shot->height, rx = radius / width, ry = radius / height;
+
+	QUERY_GRID_COLLECT(grid, shot, x - rx, y - ry, x + rx, y + ry, 
+		distance_sq_2(point->x * width, point->y * height, x * width, y * height) <= radius * radius && !query_skip_point(point, skipping_auto)
+	);
+
+	count = query_grid_results_count; 
+	return query_grid_results;
 }
 
 // count the number of reconstructed points on this shot 
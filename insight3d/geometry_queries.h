@@ -14,8 +14,17 @@ bool query_is_polygon_reconstructed(const Polygon_3d & polygon, const Vertices &
 bool query_find_point_on_shot_by_vertex_id(size_t shot_id, size_t vertex_id, size_t & point_id);
 
 // find nearest point on shot, returns squared distance in image pixels
+// (points are indexed by a grid, which is kept up to date from the change journal) 
 double query_nearest_point(const size_t shot_id, const double x, const double y, size_t & point_id, bool skipping_auto = false);
 
+// find points on shot inside rectangle given by two corners (relative image coordinates), 
+// returned ids are ordered and valid until the next query
+const size_t * query_points_in_rectangle(const size_t shot_id, double x1, double y1, double x2, double y2, size_t & count, bool skipping_auto = false);
+
+// find points on shot within radius (in image pixels) from [x, y] (relative image coordinates), 
+// returned ids are ordered and valid until the next query
+const size_t * query_points_in_radius(const size_t shot_id, const double x, const double y, const double radius, size_t & count, bool skipping_auto = false);
+
 // count the number of reconstructed points on this shot 
 size_t query_count_reconstructed_points_on_shot(const size_t shot_id);
 
@@ -72,6 +72,7 @@ bool geometry_calibration_from_P(const size_t shot_id)
 	shot->pp_x = OPENCV_ELEM(shot->internal_calibration, 0, 2); 
 	shot->pp_y = OPENCV_ELEM(shot->internal_calibration, 1, 2); 
 
+	geometry_shot_changed(shot_id);
 	return true;
 }
 
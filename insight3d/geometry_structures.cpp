@@ -28,6 +28,13 @@ Vertices_Incidence vertices_incidence; // incidence
 Calibrations calibrations; // calibrations
 std::map<int, std::map<int, unsigned int> > detected_edges; // debug
 
+// change journal (ring buffer holding the most recent changes) 
+static const size_t GEOMETRY_JOURNAL_SIZE = 4096;
+static Geometry_Change geometry_journal[GEOMETRY_JOURNAL_SIZE]; 
+static size_t geometry_journal_count = 0; // number of changes recorded so far 
+static size_t geometry_journal_version = 1; 
+static size_t geometry_journal_lost = 1; // changes up to this version are no longer in the journal
+
 // * initializers *
 
 // initialize scene info 
@@ -92,6 +99,8 @@ void geometry_release()
 		if (calibrations.data[i].pi_infinity) cvReleaseMat(&calibrations.data[i].pi_infinity);
 		DYN_FREE(calibrations.data[i].Ps);
 		DYN_FREE(calibrations.data[i].Xs);
+		DYN_FREE(calibrations.data[i].P_lookup);
+		DYN_FREE(calibrations.data[i].X_lookup);
 	}
 
 	for ALL(vertices_incidence, i) 
@@ -115,6 +124,8 @@ void geometry_release()
 	DYN_FREE(vertices);
 	DYN_FREE(polygons);
 	DYN_FREE(calibrations);
+
+	geometry_changed_all();
 }
 
 // * data validators * // note validators are probably unused and replaced by ASSERT_IS_SET (are they really?) // note currently I'm rewriting validators in terms of macros
@@ -240,6 +251,8 @@ void geometry_delete_point(size_t shot_id, size_t point_id) // todo remove it fr
 	}
 
 	shots.data[shot_id].points.data[point_id].set = false;
+	geometry_point_changed(shot_id, point_id);
+	geometry_vertex_changed(vertex_id);
 }
 
 // delete polygon
@@ -247,6 +260,7 @@ void geometry_delete_polygon(const size_t polygon_id)
 {
 	ASSERT_IS_SET(polygons, polygon_id);
 	polygons.data[polygon_id].set = false; 
+	geometry_polygon_changed(polygon_id);
 }
 
 // delete vertex (and all it's points, incidence structure, ...) 
@@ -266,6 +280,7 @@ void geometry_delete_vertex(const size_t vertex_id)
 		if (found) 
 		{
 			polygons.data[polygon_id].vertices.data[id].set = false;
+			geometry_polygon_changed(polygon_id);
 
 			// is the polygon now degenerated?
 			size_t count = 0;
@@ -289,11 +304,13 @@ void geometry_delete_vertex(const size_t vertex_id)
 		ASSERT_IS_SET(shots, index->primary);
 		ASSERT_IS_SET(shots.data[index->primary].points, index->secondary);
 		shots.data[index->primary].points.data[index->secondary].set = false;
+		geometry_point_changed(index->primary, index->secondary);
 	}
 
 	DYN_FREE(vertices_incidence.data[vertex_id].shot_point_ids);
 	vertices.data[vertex_id].set = false;
 	vertices_incidence.data[vertex_id].set = false;
+	geometry_vertex_changed(vertex_id);
 }
 
 // * accessors and modifiers *
@@ -312,6 +329,9 @@ void geometry_point_vertex_incidence(size_t shot_id, size_t point_id, size_t ver
 	ADD(vertices_incidence.data[vertex_id].shot_point_ids); 
 	LAST(vertices_incidence.data[vertex_id].shot_point_ids).primary = shot_id; 
 	LAST(vertices_incidence.data[vertex_id].shot_point_ids).secondary = point_id;
+
+	geometry_point_changed(shot_id, point_id);
+	geometry_vertex_changed(vertex_id);
 }
 
 // get 2d point x coordinate 
@@ -340,6 +360,7 @@ void geometry_point_xy(size_t shot_id, size_t point_id, double x, double y)
 
 	shots.data[shot_id].points.data[point_id].x = x; 
 	shots.data[shot_id].points.data[point_id].y = y; 
+	geometry_point_changed(shot_id, point_id);
 }
 
 // * initialization of new structures *
@@ -349,6 +370,7 @@ bool geometry_new_shot(size_t & shot)
 {
 	shot = shots.count;
 	DYN(shots, shot); // {}
+	geometry_shot_changed(shot);
 
 	return true;
 }
@@ -377,6 +399,7 @@ bool geometry_new_vertex(size_t & id)
 	id = vertices.count;
 	DYN(vertices, id); // {} 
 	DYN(vertices_incidence, id); // {}
+	geometry_vertex_changed(id);
 
 	return true;
 }
@@ -404,6 +427,7 @@ bool geometry_new_polygon(size_t & id)
 	// create new polygon 
 	id = polygons.count; 
 	DYN(polygons, id); // {}
+	geometry_polygon_changed(id);
 
 	return true;
 }
@@ -421,10 +445,118 @@ bool geometry_polygon_add_vertex(size_t polygon_id, size_t vertex_index)
 
 	// add vertex
 	polygons.data[polygon_id].vertices.data[id].value = vertex_index;
+	geometry_polygon_changed(polygon_id);
 
 	return true; 
 }
 
+// * modifying calibrations * 
+
+// add camera of given shot to calibration 
+size_t geometry_calibration_add_P(const size_t calibration_id, const size_t shot_id)
+{
+	ASSERT_IS_SET(calibrations, calibration_id);
+	Calibration * const calibration = calibrations.data + calibration_id;
+
+	ADD(calibration->Ps);
+	const size_t P_id = LAST_INDEX(calibration->Ps);
+	calibration->Ps.data[P_id].shot_id = shot_id;
+
+	DYN(calibration->P_lookup, shot_id);
+	calibration->P_lookup.data[shot_id].value = P_id;
+
+	geometry_calibration_changed(calibration_id);
+	return P_id;
+}
+
+// add triangulated vertex to calibration 
+size_t geometry_calibration_add_X(const size_t calibration_id, const size_t vertex_id)
+{
+	ASSERT_IS_SET(calibrations, calibration_id);
+	Calibration * const calibration = calibrations.data + calibration_id;
+
+	ADD(calibration->Xs);
+	const size_t X_id = LAST_INDEX(calibration->Xs);
+	calibration->Xs.data[X_id].vertex_id = vertex_id;
+
+	DYN(calibration->X_lookup, vertex_id);
+	calibration->X_lookup.data[vertex_id].value = X_id;
+
+	geometry_calibration_changed(calibration_id);
+	return X_id;
+}
+
+// remove camera from calibration 
+void geometry_calibration_remove_P(const size_t calibration_id, const size_t P_id)
+{
+	ASSERT_IS_SET(calibrations, calibration_id);
+	Calibration * const calibration = calibrations.data + calibration_id;
+	ASSERT_IS_SET(calibration->Ps, P_id);
+
+	const size_t shot_id = calibration->Ps.data[P_id].shot_id;
+	if (IS_SET(calibration->P_lookup, shot_id) && calibration->P_lookup.data[shot_id].value == P_id) 
+	{
+		calibration->P_lookup.data[shot_id].set = false;
+	}
+
+	calibration->Ps.data[P_id].set = false;
+	geometry_calibration_changed(calibration_id);
+}
+
+// remove triangulated vertex from calibration 
+void geometry_calibration_remove_X(const size_t calibration_id, const size_t X_id)
+{
+	ASSERT_IS_SET(calibrations, calibration_id);
+	Calibration * const calibration = calibrations.data + calibration_id;
+	ASSERT_IS_SET(calibration->Xs, X_id);
+
+	const size_t vertex_id = calibration->Xs.data[X_id].vertex_id;
+	if (IS_SET(calibration->X_lookup, vertex_id) && calibration->X_lookup.data[vertex_id].value == X_id) 
+	{
+		calibration->X_lookup.data[vertex_id].set = false;
+	}
+
+	calibration->Xs.data[X_id].set = false;
+	geometry_calibration_changed(calibration_id);
+}
+
+// remove all triangulated vertices from calibration 
+void geometry_calibration_remove_Xs(const size_t calibration_id)
+{
+	ASSERT_IS_SET(calibrations, calibration_id);
+	Calibration * const calibration = calibrations.data + calibration_id;
+
+	DYN_FREE(calibration->Xs);
+	DYN_FREE(calibration->X_lookup);
+	geometry_calibration_changed(calibration_id);
+}
+
+// find camera of given shot in calibration 
+bool geometry_calibration_find_P(const size_t calibration_id, const size_t shot_id, size_t & P_id)
+{
+	ASSERT_IS_SET(calibrations, calibration_id);
+	const Calibration * const calibration = calibrations.data + calibration_id;
+
+	if (!IS_SET(calibration->P_lookup, shot_id)) return false;
+	P_id = calibration->P_lookup.data[shot_id].value;
+	ASSERT(IS_SET(calibration->Ps, P_id) && calibration->Ps.data[P_id].shot_id == shot_id, "calibration camera lookup is inconsistent");
+
+	return true;
+}
+
+// find triangulated vertex in calibration 
+bool geometry_calibration_find_X(const size_t calibration_id, const size_t vertex_id, size_t & X_id)
+{
+	ASSERT_IS_SET(calibrations, calibration_id);
+	const Calibration * const calibration = calibrations.data + calibration_id;
+
+	if (!IS_SET(calibration->X_lookup, vertex_id)) return false;
+	X_id = calibration->X_lookup.data[vertex_id].value;
+	ASSERT(IS_SET(calibration->Xs, X_id) && calibration->Xs.data[X_id].vertex_id == vertex_id, "calibration vertex lookup is inconsistent");
+
+	return true;
+}
+
 // * releasing * 
 
 // release shot calibration 
@@ -438,6 +570,7 @@ void geometry_release_shot_calibration(size_t shot_id)
 	if (shot->rotation) cvReleaseMat(&shot->rotation);
 	if (shot->translation) cvReleaseMat(&shot->translation);
 	if (shot->internal_calibration) cvReleaseMat(&shot->internal_calibration);
+	geometry_shot_changed(shot_id);
 }
 
 // release calibration of all shots 
@@ -449,6 +582,110 @@ void geometry_release_shots_calibrations()
 	}
 }
 
+// * change journal * 
+
+// record change of items [from, to) of given kind 
+void geometry_changed(const GEOMETRY_CHANGE kind, const size_t from, const size_t to, const size_t shot_id /*= 0*/)
+{
+	if (from >= to) return;
+	geometry_journal_version++;
+
+	// consecutive changes of the same items are merged 
+	if (geometry_journal_count > 0) 
+	{
+		Geometry_Change * const last = geometry_journal + (geometry_journal_count - 1) % GEOMETRY_JOURNAL_SIZE;
+		if (last->kind == kind && last->shot_id == shot_id && from <= last->to && to >= last->from)
+		{
+			if (from < last->from) last->from = from; 
+			if (to > last->to) last->to = to;
+			last->version = geometry_journal_version;
+			return;
+		}
+	}
+
+	// the oldest change gets overwritten
+	Geometry_Change * const change = geometry_journal + geometry_journal_count % GEOMETRY_JOURNAL_SIZE;
+	if (geometry_journal_count >= GEOMETRY_JOURNAL_SIZE) 
+	{
+		geometry_journal_lost = change->version;
+	}
+
+	change->kind = kind; 
+	change->shot_id = shot_id; 
+	change->from = from; 
+	change->to = to; 
+	change->version = geometry_journal_version;
+	geometry_journal_count++;
+}
+
+// record change of single item 
+void geometry_vertex_changed(const size_t vertex_id)
+{
+	geometry_changed(GEOMETRY_CHANGE_VERTICES, vertex_id, vertex_id + 1);
+}
+
+void geometry_point_changed(const size_t shot_id, const size_t point_id)
+{
+	geometry_changed(GEOMETRY_CHANGE_POINTS, point_id, point_id + 1, shot_id);
+}
+
+void geometry_shot_changed(const size_t shot_id)
+{
+	geometry_changed(GEOMETRY_CHANGE_SHOTS, shot_id, shot_id + 1);
+}
+
+void geometry_polygon_changed(const size_t polygon_id)
+{
+	geometry_changed(GEOMETRY_CHANGE_POLYGONS, polygon_id, polygon_id + 1);
+}
+
+void geometry_calibration_changed(const size_t calibration_id)
+{
+	geometry_changed(GEOMETRY_CHANGE_CALIBRATIONS, calibration_id, calibration_id + 1);
+}
+
+// everything might have changed, forget the journal 
+void geometry_changed_all()
+{
+	geometry_journal_version++; 
+	geometry_journal_lost = geometry_journal_version; 
+	geometry_journal_count = 0;
+}
+
+// current version of geometric data 
+size_t geometry_version()
+{
+	return geometry_journal_version;
+}
+
+// check if the journal holds all changes made after given version 
+bool geometry_journal_complete(const size_t since)
+{
+	return since >= geometry_journal_lost;
+}
+
+// go through the changes made after given version 
+bool geometry_journal_next(size_t & position, const size_t since, Geometry_Change & change)
+{
+	if (since >= geometry_journal_version) return false;
+
+	// skip changes which are no longer in the journal
+	const size_t first = geometry_journal_count > GEOMETRY_JOURNAL_SIZE ? geometry_journal_count - GEOMETRY_JOURNAL_SIZE : 0;
+	if (position < first) position = first;
+
+	while (position < geometry_journal_count) 
+	{
+		const Geometry_Change * const recorded = geometry_journal + position++ % GEOMETRY_JOURNAL_SIZE;
+		if (recorded->version > since) 
+		{
+			change = *recorded; 
+			return true;
+		}
+	}
+
+	return false;
+}
+
 // * builders * 
 
 // for each vertex create list of shots on which said vertex is visible
@@ -249,10 +249,27 @@ struct Calibration
 	Calibration_Vertices Xs;
 	CvMat * pi_infinity;
 	bool refined;
+
+	// lookup of cameras by shot id and of vertices by vertex id (maintained by geometry_calibration_* routines)
+	Indices P_lookup, X_lookup;
 };
 
 DYNAMIC_STRUCTURE_DECLARATIONS(Calibrations, Calibration);
 
+// * change journal * 
+
+// kinds of items tracked by the change journal 
+enum GEOMETRY_CHANGE { GEOMETRY_CHANGE_VERTICES, GEOMETRY_CHANGE_POINTS, GEOMETRY_CHANGE_SHOTS, GEOMETRY_CHANGE_POLYGONS, GEOMETRY_CHANGE_CALIBRATIONS };
+
+// items [from, to) of some kind changed (points are recorded per shot) 
+struct Geometry_Change
+{
+	GEOMETRY_CHANGE kind;
+	size_t shot_id; 
+	size_t from, to; 
+	size_t version; // version of geometric data right after this change
+};
+
 // * allocated instances *
 
 extern Shots shots; // shots
@@ -346,6 +363,29 @@ bool geometry_new_polygon(size_t & id);
 // add vertex to polygon 
 bool geometry_polygon_add_vertex(size_t polygon_id, size_t vertex_index);
 
+// * modifying calibrations * 
+
+// add camera of given shot to calibration, returns its id 
+size_t geometry_calibration_add_P(const size_t calibration_id, const size_t shot_id);
+
+// add triangulated vertex to calibration, returns its id 
+size_t geometry_calibration_add_X(const size_t calibration_id, const size_t vertex_id);
+
+// remove camera from calibration 
+void geometry_calibration_remove_P(const size_t calibration_id, const size_t P_id);
+
+// remove triangulated vertex from calibration 
+void geometry_calibration_remove_X(const size_t calibration_id, const size_t X_id);
+
+// remove all triangulated vertices from calibration 
+void geometry_calibration_remove_Xs(const size_t calibration_id);
+
+// find camera of given shot in calibration 
+bool geometry_calibration_find_P(const size_t calibration_id, const size_t shot_id, size_t & P_id);
+
+// find triangulated vertex in calibration 
+bool geometry_calibration_find_X(const size_t calibration_id, const size_t vertex_id, size_t & X_id);
+
 // * releasing * 
 
 // release calibration matrices
@@ -354,6 +394,32 @@ void geometry_release_shot_calibration(size_t shot_id);
 // release calibration matrices for all shots
 void geometry_release_shots_calibrations();
 
+// * change journal * 
+
+// record change of items [from, to) of given kind (for points the range is within one shot)
+void geometry_changed(const GEOMETRY_CHANGE kind, const size_t from, const size_t to, const size_t shot_id = 0);
+
+// record change of single item 
+void geometry_vertex_changed(const size_t vertex_id);
+void geometry_point_changed(const size_t shot_id, const size_t point_id);
+void geometry_shot_changed(const size_t shot_id);
+void geometry_polygon_changed(const size_t polygon_id);
+void geometry_calibration_changed(const size_t calibration_id);
+
+// everything might have changed (whole project was loaded or released) 
+void geometry_changed_all();
+
+// current version of geometric data, increases with every recorded change 
+size_t geometry_version();
+
+// check if the journal still holds all changes made after given version; if not, the consumer 
+// has to process everything 
+bool geometry_journal_complete(const size_t since);
+
+// go through the changes made after given version, position has to be 0 on the first call 
+// returns false when there are no more changes
+bool geometry_journal_next(size_t & position, const size_t since, Geometry_Change & change);
+
 // * builders * 
 
 // for each vertex create list of shots on which said vertex is visible
@@ -164,6 +164,7 @@ void geometry_extract_texture(const size_t polygon_id)
 		// send request for this image region and save texturing coordinates
 		polygon->image_loader_request = image_loader_new_request(i, shots.data[i].image_filename, IMAGE_LOADER_CONTINUOUS_LOADING, IMAGE_LOADER_REGION, min_x, min_y, max_x, max_y);
 		polygon->texture_coords = texture_coords;
+		geometry_polygon_changed(polygon_id);
 	}
 
 	FREE(count);
@@ -22,6 +22,7 @@ bool mousealreadydown;
 /* Threading */ 
 static pthread_t gui_rendering_thread;
 static pthread_mutex_t gui_structures_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t gui_redraw_lock = PTHREAD_MUTEX_INITIALIZER;
 
 /* Global variables */
 GUI_Context gui_context;
@@ -68,6 +69,11 @@ void gui_initialize()
 
 	// initialize fonts subsystem
 	cvInitFont(&gui_context.font, CV_FONT_HERSHEY_SIMPLEX, 0.35, 0.35, 0, 1, CV_AA);
+
+	// render scheduling 
+	gui_context.redraw_wanted = true;
+	gui_context.frame_rate = 60;
+	gui_context.on_frame_begin = gui_context.on_frame_end = NULL;
 }
 
 /* helper functions do the routine stuff for you */
@@ -639,14 +645,25 @@ void * gui_rendering_thread_function(void * args)
 	gui_helper_opengl_adjust_size();
 
 	// GUI loop
+	Uint32 next_frame = SDL_GetTicks();
 	while (true) 
 	{
 		// note that we should render the window only if it's active
 
-		// redraw scene
-		gui_calculate_coordinates();
-		gui_render();
-		SDL_GL_SwapBuffers();
+		// redraw scene (only if something changed or somebody's animating)
+		pthread_mutex_lock(&gui_redraw_lock);
+		const bool redraw = gui_context.redraw_wanted;
+		gui_context.redraw_wanted = false;
+		pthread_mutex_unlock(&gui_redraw_lock);
+
+		if (redraw) 
+		{
+			if (gui_context.on_frame_begin) gui_context.on_frame_begin();
+			gui_calculate_coordinates();
+			gui_render();
+			if (gui_context.on_frame_end) gui_context.on_frame_end();
+			SDL_GL_SwapBuffers();
+		}
 
 		// check out new events
 		SDL_Event event;
@@ -655,6 +672,9 @@ void * gui_rendering_thread_function(void * args)
 		mousealreadydown = false;
 		while (SDL_PollEvent(&event))
 		{
+			// every event can change what's on screen 
+			gui_request_redraw();
+
 			/* gui_lock();
 			printf("%d ", (gui_context.event_queue_top - gui_context.event_queue_bottom) % GUI_EVENT_QUEUE_LENGTH);
 			gui_unlock();*/
@@ -688,6 +708,19 @@ void * gui_rendering_thread_function(void * args)
 				gui_aux_add_to_event_queue(NULL, NULL, event);
 			}
 		}
+
+		// frame pacing - sleep until the next frame is due (but don't try to catch up with frames we've missed)
+		const Uint32 period = 1000 / (gui_context.frame_rate > 0 ? gui_context.frame_rate : 60);
+		const Uint32 now = SDL_GetTicks();
+		next_frame += period;
+		if (next_frame > now) 
+		{
+			SDL_Delay(next_frame - now);
+		}
+		else
+		{
+			next_frame = now;
+		}
 	}
 
 	return NULL;
@@ -698,6 +731,27 @@ bool gui_start_rendering_thread()
 	return !pthread_create(&gui_rendering_thread, NULL, gui_rendering_thread_function, NULL);
 }
 
+// ask rendering thread to redraw the screen in the next frame
+void gui_request_redraw()
+{
+	pthread_mutex_lock(&gui_redraw_lock);
+	gui_context.redraw_wanted = true;
+	pthread_mutex_unlock(&gui_redraw_lock);
+}
+
+// set maximal number of frames drawn per second
+void gui_set_frame_rate(const int frame_rate)
+{
+	gui_context.frame_rate = frame_rate;
+}
+
+// set functions called at the beginning and at the end of each drawn frame
+void gui_set_frame_callbacks(GUI_Frame_Callback frame_begin, GUI_Frame_Callback frame_end)
+{
+	gui_context.on_frame_begin = frame_begin;
+	gui_context.on_frame_end = frame_end;
+}
+
 /* Respond to events */
 
 // resolve mouse move event - setting mouse over flags, sending events to individual panels 
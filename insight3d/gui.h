@@ -34,6 +34,7 @@ typedef void (*GUI_Positioner)(GUI_Panel * panel);
 typedef void (*GUI_Event)(GUI_Event_Descriptor event);
 typedef void (*GUI_Render)(GUI_Panel * panel);
 typedef void (*GUI_GLView_Render)();
+typedef void (*GUI_Frame_Callback)();
 
 // the entire GUI is constructed from simple rectangular elements called panels
 struct GUI_Panel
@@ -149,6 +150,11 @@ struct GUI_Context
 
 	// font support 
 	CvFont font;
+
+	// render scheduling (the screen is redrawn only when somebody asks for it, at most frame_rate times per second)
+	bool redraw_wanted;
+	int frame_rate;
+	GUI_Frame_Callback on_frame_begin, on_frame_end;
 };
 
 extern GUI_Context gui_context;
@@ -219,6 +225,13 @@ void gui_caption_discard_opengl_texture(GUI_Panel * panel);
 // rendering thread 
 bool gui_start_rendering_thread();
 
+// render scheduling 
+// note gui_request_redraw can be called from any thread (also while rendering, to keep animations going)
+// note frame_end callback is called after the gui is rendered and before buffers are swapped, so it can draw overlays
+void gui_request_redraw();
+void gui_set_frame_rate(const int frame_rate);
+void gui_set_frame_callbacks(GUI_Frame_Callback frame_begin, GUI_Frame_Callback frame_end);
+
 // respond to SDL events
 bool gui_resolve_mousemotion(SDL_Event * event);
 bool gui_resolve_mousebuttondown(SDL_Event * event);
@@ -1,4 +1,17 @@
 #include "interface_filesystem.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _MSC_VER
+#include "windows.h"
+#include <sys/utime.h>
+#include <direct.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utime.h>
+#include <dirent.h>
+#endif
 
 // returns file's directory, NULL is returned if filename ends with path separator
 char * interface_filesystem_dirpath(const char * const filename)
@@ -57,7 +70,7 @@ char * interface_filesystem_extract_filename(const char * filename)
 	const size_t separator_pos = last_separator - filename;
 	const size_t filename_len = len - separator_pos;
 	char * extracted = /*(char *)malloc(sizeof(char) * (filename_len + 1));*/ ALLOC(char, filename_len + 1); 
-	memcpy(extracted, last_separator + 1, sizeof(char) * (filename_len + 1)); 
+	memcpy(extracted, last_separator + 1, sizeof(char) * filename_len); 
 	extracted[filename_len] = '\0';
 	return extracted;
 }
@@ -152,3 +165,181 @@ bool interface_filesystem_is_relative(const char * filename)
 	if (!filename) return true; // note really necessary
 	return !(filename[0] == '/' || strlen(filename) > 1 && filename[1] == ':');
 }
+
+// checks if filename ends with given extension (case insensitive, extension includes the dot)
+bool interface_filesystem_has_extension(const char * filename, const char * extension) 
+{
+	const size_t length = strlen(filename), extension_length = strlen(extension);
+	return length >= extension_length && strcmpi(filename + length - extension_length, extension) == 0;
+}
+
+// maps the whole file into memory 
+bool interface_filesystem_map_file(const char * filename, Filesystem_Mapping * mapping)
+{
+	mapping->data = NULL; 
+	mapping->size = 0;
+
+#ifdef _MSC_VER
+	mapping->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (mapping->file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mapping->file, &size) || size.QuadPart == 0) 
+	{
+		CloseHandle(mapping->file);
+		return false;
+	}
+
+	mapping->mapping = CreateFileMappingA(mapping->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapping->mapping) 
+	{
+		CloseHandle(mapping->file);
+		return false;
+	}
+
+	mapping->data = (const unsigned char *)MapViewOfFile(mapping->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!mapping->data) 
+	{
+		CloseHandle(mapping->mapping);
+		CloseHandle(mapping->file);
+		return false;
+	}
+
+	mapping->size = (size_t)size.QuadPart;
+#else
+	if ((mapping->file = open(filename, O_RDONLY)) < 0) return false;
+
+	struct stat info;
+	if (fstat(mapping->file, &info) != 0 || info.st_size == 0)
+	{
+		close(mapping->file);
+		return false;
+	}
+
+	void * data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, mapping->file, 0);
+	if (data == MAP_FAILED) 
+	{
+		close(mapping->file);
+		return false;
+	}
+
+	mapping->data = (const unsigned char *)data;
+	mapping->size = info.st_size;
+#endif
+
+	return true;
+}
+
+// releases the mapping
+void interface_filesystem_unmap_file(Filesystem_Mapping * mapping)
+{
+	if (!mapping->data) return;
+
+#ifdef _MSC_VER
+	UnmapViewOfFile(mapping->data);
+	CloseHandle(mapping->mapping);
+	CloseHandle(mapping->file);
+#else
+	munmap((void *)mapping->data, mapping->size);
+	close(mapping->file);
+#endif
+
+	mapping->data = NULL; 
+	mapping->size = 0;
+}
+
+// returns time of the last modification of the file (0 if it doesn't exist)
+time_t interface_filesystem_modification_time(const char * filename)
+{
+	struct stat info; 
+	if (stat(filename, &info) != 0) return 0;
+	return info.st_mtime;
+}
+
+// returns size of the file in bytes (0 if it doesn't exist)
+unsigned long long interface_filesystem_file_size(const char * filename)
+{
+	struct stat info; 
+	if (stat(filename, &info) != 0) return 0;
+	return info.st_size;
+}
+
+// sets time of the last modification of the file to now
+bool interface_filesystem_touch(const char * filename)
+{
+#ifdef _MSC_VER
+	return _utime(filename, NULL) == 0;
+#else
+	return utime(filename, NULL) == 0;
+#endif
+}
+
+// creates directory (parent directory has to exist), returns true if it exists afterwards
+bool interface_filesystem_make_directory(const char * path)
+{
+	struct stat info; 
+	if (stat(path, &info) == 0) return (info.st_mode & S_IFMT) == S_IFDIR;
+
+#ifdef _MSC_VER
+	return _mkdir(path) == 0;
+#else
+	return mkdir(path, 0777) == 0;
+#endif
+}
+
+// calls visitor for every regular file in the directory (name is without the path)
+bool interface_filesystem_list_directory(const char * path, Filesystem_Visitor visitor, void * data)
+{
+#ifdef _MSC_VER
+	char * pattern = ALLOC(char, strlen(path) + 3);
+	strcpy(pattern, path);
+	strcat(pattern, "\\*");
+
+	WIN32_FIND_DATAA entry;
+	HANDLE find = FindFirstFileA(pattern, &entry);
+	FREE(pattern);
+	if (find == INVALID_HANDLE_VALUE) return false;
+
+	do
+	{
+		if (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+
+		// FILETIME counts 100 ns intervals since 1601
+		ULARGE_INTEGER time; 
+		time.LowPart = entry.ftLastWriteTime.dwLowDateTime; 
+		time.HighPart = entry.ftLastWriteTime.dwHighDateTime;
+		const time_t modification_time = (time_t)(time.QuadPart / 10000000ULL - 11644473600ULL);
+		const unsigned long long size = ((unsigned long long)entry.nFileSizeHigh << 32) | entry.nFileSizeLow;
+
+		visitor(entry.cFileName, size, modification_time, data);
+	} 
+	while (FindNextFileA(find, &entry));
+
+	FindClose(find);
+#else
+	DIR * directory = opendir(path);
+	if (!directory) return false;
+
+	const size_t path_length = strlen(path);
+	struct dirent * entry;
+	while ((entry = readdir(directory)))
+	{
+		char * filename = ALLOC(char, path_length + strlen(entry->d_name) + 2);
+		strcpy(filename, path); 
+		strcat(filename, FILESYSTEM_PATH_SEPARATOR);
+		strcat(filename, entry->d_name);
+
+		struct stat info;
+		if (stat(filename, &info) == 0 && S_ISREG(info.st_mode))
+		{
+			visitor(entry->d_name, info.st_size, info.st_mtime, data);
+		}
+
+		FREE(filename);
+	}
+
+	closedir(directory);
+#endif
+
+	return true;
+}
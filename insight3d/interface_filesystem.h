@@ -13,6 +13,7 @@ const char * const FILESYSTEM_PATH_SEPARATOR = "\\";
 #include "stdio.h"
 #include "string.h"
 #include "portability.h"
+#include <time.h>
 
 // returns file's directory, NULL is returned if filename ends with path separator
 char * interface_filesystem_dirpath(const char * const filename);
@@ -35,4 +36,41 @@ char * interface_filesystem_realviz_filename(const char * filename);
 // determines if path is absolute or relative 
 bool interface_filesystem_is_relative(const char * filename);
 
+// checks if filename ends with given extension (case insensitive, extension includes the dot)
+bool interface_filesystem_has_extension(const char * filename, const char * extension);
+
+// read-only memory mapping of a file 
+struct Filesystem_Mapping
+{
+	const unsigned char * data; 
+	size_t size;
+#ifdef _MSC_VER
+	void * file, * mapping; // windows handles
+#else
+	int file;
+#endif
+};
+
+// maps the whole file into memory 
+bool interface_filesystem_map_file(const char * filename, Filesystem_Mapping * mapping);
+
+// releases the mapping
+void interface_filesystem_unmap_file(Filesystem_Mapping * mapping);
+
+// returns time of the last modification of the file (0 if it doesn't exist)
+time_t interface_filesystem_modification_time(const char * filename);
+
+// returns size of the file in bytes (0 if it doesn't exist)
+unsigned long long interface_filesystem_file_size(const char * filename);
+
+// sets time of the last modification of the file to now
+bool interface_filesystem_touch(const char * filename);
+
+// creates directory (parent directory has to exist), returns true if it exists afterwards
+bool interface_filesystem_make_directory(const char * path);
+
+// calls visitor for every regular file in the directory (name is without the path)
+typedef void (*Filesystem_Visitor)(const char * name, unsigned long long size, time_t modification_time, void * data);
+bool interface_filesystem_list_directory(const char * path, Filesystem_Visitor visitor, void * data);
+
 #endif
@@ -46,3 +46,63 @@ void opengl_push_attribs()
 {
 	glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_TEXTURE_BIT | GL_POINT_BIT | GL_LINE_BIT);
 }
+
+// buffer object entry points 
+PFNGLGENBUFFERSARBPROC opengl_gen_buffers = NULL;
+PFNGLDELETEBUFFERSARBPROC opengl_delete_buffers = NULL;
+PFNGLBINDBUFFERARBPROC opengl_bind_buffer = NULL;
+PFNGLBUFFERDATAARBPROC opengl_buffer_data = NULL;
+PFNGLBUFFERSUBDATAARBPROC opengl_buffer_sub_data = NULL;
+PFNGLMAPBUFFERARBPROC opengl_map_buffer = NULL;
+PFNGLUNMAPBUFFERARBPROC opengl_unmap_buffer = NULL;
+
+static bool opengl_buffers_supported = false, opengl_pixel_buffers_supported = false;
+
+// checks if the extension is listed in the extension string 
+static bool opengl_extension_supported(const char * name)
+{
+	const char * extensions = (const char *)glGetString(GL_EXTENSIONS);
+	if (!extensions) return false;
+
+	const size_t length = strlen(name);
+	for (const char * p = strstr(extensions, name); p; p = strstr(p + length, name))
+	{
+		// match whole words only 
+		if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0'))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// loads buffer object entry points, returns true if vertex buffers can be used 
+bool opengl_initialize_buffers()
+{
+	opengl_buffers_supported = opengl_pixel_buffers_supported = false;
+	if (!opengl_extension_supported("GL_ARB_vertex_buffer_object")) return false;
+
+	opengl_gen_buffers = (PFNGLGENBUFFERSARBPROC)OPENGL_GET_PROC_ADDRESS("glGenBuffersARB");
+	opengl_delete_buffers = (PFNGLDELETEBUFFERSARBPROC)OPENGL_GET_PROC_ADDRESS("glDeleteBuffersARB");
+	opengl_bind_buffer = (PFNGLBINDBUFFERARBPROC)OPENGL_GET_PROC_ADDRESS("glBindBufferARB");
+	opengl_buffer_data = (PFNGLBUFFERDATAARBPROC)OPENGL_GET_PROC_ADDRESS("glBufferDataARB");
+	opengl_buffer_sub_data = (PFNGLBUFFERSUBDATAARBPROC)OPENGL_GET_PROC_ADDRESS("glBufferSubDataARB");
+	opengl_map_buffer = (PFNGLMAPBUFFERARBPROC)OPENGL_GET_PROC_ADDRESS("glMapBufferARB");
+	opengl_unmap_buffer = (PFNGLUNMAPBUFFERARBPROC)OPENGL_GET_PROC_ADDRESS("glUnmapBufferARB");
+
+	opengl_buffers_supported = 
+		opengl_gen_buffers && opengl_delete_buffers && opengl_bind_buffer && opengl_buffer_data && 
+		opengl_buffer_sub_data && opengl_map_buffer && opengl_unmap_buffer
+	;
+
+	opengl_pixel_buffers_supported = opengl_buffers_supported && opengl_extension_supported("GL_ARB_pixel_buffer_object");
+
+	return opengl_buffers_supported;
+}
+
+// true if pixel buffers are available too 
+bool opengl_pixel_buffers_available()
+{
+	return opengl_pixel_buffers_supported;
+}
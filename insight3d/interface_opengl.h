@@ -9,6 +9,14 @@
 #include "SDL/SDL_opengl.h"
 #include "pthread.h"
 
+// headless builds render offscreen through OSMesa (make OSMESA=1)
+#ifdef INSIGHT3D_OSMESA
+#include "GL/osmesa.h"
+#define OPENGL_GET_PROC_ADDRESS(name) OSMesaGetProcAddress(name)
+#else
+#define OPENGL_GET_PROC_ADDRESS(name) SDL_GL_GetProcAddress(name)
+#endif
+
 extern pthread_mutex_t opengl_mutex;
 
 // #include "GL/gl.h"
@@ -31,4 +39,21 @@ void opengl_drawing_style(const Drawing_Style & style);
 // saves settings of some common OpenGL attributes
 void opengl_push_attribs();
 
+// buffer objects (ARB_vertex_buffer_object and ARB_pixel_buffer_object), 
+// entry points are loaded at runtime since we link only against OpenGL 1.1
+extern PFNGLGENBUFFERSARBPROC opengl_gen_buffers;
+extern PFNGLDELETEBUFFERSARBPROC opengl_delete_buffers;
+extern PFNGLBINDBUFFERARBPROC opengl_bind_buffer;
+extern PFNGLBUFFERDATAARBPROC opengl_buffer_data;
+extern PFNGLBUFFERSUBDATAARBPROC opengl_buffer_sub_data;
+extern PFNGLMAPBUFFERARBPROC opengl_map_buffer;
+extern PFNGLUNMAPBUFFERARBPROC opengl_unmap_buffer;
+
+// loads buffer object entry points, returns true if vertex buffers can be used 
+// note that this has to be called by the thread owning the OpenGL context
+bool opengl_initialize_buffers();
+
+// true if pixel buffers are available too (valid after opengl_initialize_buffers)
+bool opengl_pixel_buffers_available();
+
 #endif
@@ -5,6 +5,18 @@ extern "C" FILE * __cdecl __iob_func(void) { return _iob; }
 
 int main(int argc, char* argv[])
 {
+	// render frames described by a benchmark script instead of running the ui
+	if (argc == 3 && strcmp(argv[1], "--benchmark") == 0)
+	{
+		return initialization(true) && ui_benchmark_run(argv[2]) && release() ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// run reconstruction pipeline given on command line without user interface
+	if (argc >= 2 && strcmp(argv[1], "--batch") == 0)
+	{
+		return initialization_batch() && tool_batch_run(argc - 2, argv + 2) && release_batch() ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
 	// start, do stuff and finish happily
 	return initialization() && main_loop() && release() ? EXIT_SUCCESS : EXIT_FAILURE;
 }
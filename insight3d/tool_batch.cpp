@@ -0,0 +1,326 @@
+#include "tool_batch.h"
+
+// pipeline settings (defaults are the same as in the tool panels)
+struct Tool_Batch
+{
+	// matching
+	int resolution;
+	double similarity;
+	int topology, neighbours;
+
+	// calibration
+	double threshold;
+	int randomness;
+	bool normalize_data, normalize_A;
+
+	const char * timings_filename;
+	FILE * timings;
+};
+
+static Tool_Batch tool_batch;
+
+// stages
+enum Tool_Batch_Stage
+{
+	TOOL_BATCH_IMAGES,
+	TOOL_BATCH_PROJECT,
+	TOOL_BATCH_MATCH,
+	TOOL_BATCH_CALIBRATE,
+	TOOL_BATCH_BUNDLE,
+	TOOL_BATCH_EXPORT,
+	TOOL_BATCH_STAGES_COUNT
+};
+
+static const char * const tool_batch_stage_names[TOOL_BATCH_STAGES_COUNT] = { "images", "project", "match", "calibrate", "bundle", "export" };
+
+// stage given by name (TOOL_BATCH_STAGES_COUNT if it isn't one)
+static Tool_Batch_Stage tool_batch_find_stage(const char * name)
+{
+	int stage = 0;
+	while (stage < TOOL_BATCH_STAGES_COUNT && strcmp(name, tool_batch_stage_names[stage]) != 0) stage++;
+	return (Tool_Batch_Stage)stage;
+}
+
+// number of arguments of the stage (everything up to the next stage)
+static int tool_batch_arguments_count(const int argc, char * const argv[], const int stage)
+{
+	int count = 0;
+	while (stage + 1 + count < argc && tool_batch_find_stage(argv[stage + 1 + count]) == TOOL_BATCH_STAGES_COUNT) count++;
+	return count;
+}
+
+// add images, headers of all of them are read at once
+static bool tool_batch_images(char * const * filenames, const int count)
+{
+	const size_t first_shot = shots.count;
+	bool ok = true;
+
+	for (int i = 0; ok && i < count; i++)
+	{
+		ok = interface_filesystem_has_extension(filenames[i], ".ifl") ? geometry_loader_ifl(filenames[i]) : geometry_loader_add_shot(filenames[i], false);
+		if (!ok) fprintf(stderr, "[Batch] Couldn't add '%s'\n", filenames[i]);
+	}
+
+	geometry_loader_probe_shots(first_shot);
+	return ok;
+}
+
+// load project
+static bool tool_batch_project(const char * filename)
+{
+	geometry_release();
+	if (!geometry_load_project(filename))
+	{
+		fprintf(stderr, "[Batch] Couldn't load project '%s'\n", filename);
+		return false;
+	}
+
+	visualization_process_data(vertices, shots);
+	cache_open(filename);
+	return true;
+}
+
+// begin calibration and extend it to as many views as possible
+static bool tool_batch_calibrate()
+{
+	if (!calibration_auto_begin(tool_batch.randomness, tool_batch.normalize_data, tool_batch.normalize_A, tool_batch.threshold))
+	{
+		fprintf(stderr, "[Batch] Couldn't calibrate any image pair\n");
+		return false;
+	}
+
+	size_t steps = 0;
+	while (calibration_auto_step(tool_batch.randomness, tool_batch.normalize_data, tool_batch.normalize_A, tool_batch.threshold))
+	{
+		steps++;
+	}
+
+	printf("[Batch] calibration extended in %lu steps\n", (unsigned long)steps);
+	return true;
+}
+
+// save or export, depending on the extension
+static bool tool_batch_export(const char * filename)
+{
+	bool ok;
+	if (interface_filesystem_has_extension(filename, ".i3d") || interface_filesystem_has_extension(filename, GEOMETRY_PROJECT_BINARY_EXTENSION))
+	{
+		ok = geometry_save(filename);
+	}
+	else if (interface_filesystem_has_extension(filename, ".rzml") || interface_filesystem_has_extension(filename, ".rzi"))
+	{
+		ok = geometry_export_rzml(filename, shots);
+	}
+	else if (interface_filesystem_has_extension(filename, ".ply"))
+	{
+		ok = geometry_export_ply(filename, vertices);
+	}
+	else if (interface_filesystem_has_extension(filename, ".wrl"))
+	{
+		ok = geometry_export_vrml(filename, vertices, polygons, true, true);
+	}
+	else if (interface_filesystem_has_extension(filename, ".obj"))
+	{
+		ok = geometry_export_obj(filename, vertices, polygons);
+	}
+	else if (interface_filesystem_has_extension(filename, ".glb"))
+	{
+		ok = geometry_export_gltf(filename, vertices, polygons);
+	}
+	else
+	{
+		fprintf(stderr, "[Batch] Unknown format of '%s'\n", filename);
+		return false;
+	}
+
+	if (!ok) fprintf(stderr, "[Batch] Couldn't write '%s'\n", filename);
+	return ok;
+}
+
+// run one stage
+// expects LOCK(geometry)
+static bool tool_batch_stage(const Tool_Batch_Stage stage, char * const * arguments, const int count)
+{
+	switch (stage)
+	{
+		case TOOL_BATCH_IMAGES:
+			return tool_batch_images(arguments, count);
+
+		case TOOL_BATCH_PROJECT:
+			return tool_batch_project(arguments[0]);
+
+		case TOOL_BATCH_MATCH:
+			matching_standard(
+				tool_batch.similarity, tool_batch.resolution, tool_batch.threshold, false,
+				true, false, tool_batch.topology, tool_batch.neighbours
+			);
+			return true;
+
+		case TOOL_BATCH_CALIBRATE:
+			return tool_batch_calibrate();
+
+		case TOOL_BATCH_BUNDLE:
+			return calibration_auto_end(tool_batch.randomness, tool_batch.normalize_data, tool_batch.normalize_A, tool_batch.threshold);
+
+		case TOOL_BATCH_EXPORT:
+		{
+			bool ok = true;
+			for (int i = 0; i < count; i++)
+			{
+				ok = tool_batch_export(arguments[i]) && ok;
+			}
+			return ok;
+		}
+
+		default:
+			return false;
+	}
+}
+
+// read options, returns index of the first stage (or -1 if the options are wrong)
+static int tool_batch_options(const int argc, char * const argv[])
+{
+	int i = 0;
+	for (; i < argc && strncmp(argv[i], "--", 2) == 0; i += 2)
+	{
+		const char * const option = argv[i] + 2, * const value = i + 1 < argc ? argv[i + 1] : NULL;
+
+		// all options but timings are numbers
+		char * end = NULL;
+		const double number = value ? strtod(value, &end) : 0;
+		bool ok = value && end != value && *end == '\0';
+
+		if (strcmp(option, "timings") == 0) 
+		{
+			tool_batch.timings_filename = value;
+			ok = value != NULL;
+		}
+		else if (!ok) 
+		{
+			// not a number
+		}
+		else if (strcmp(option, "resolution") == 0) tool_batch.resolution = (int)number;
+		else if (strcmp(option, "similarity") == 0) tool_batch.similarity = number;
+		else if (strcmp(option, "threshold") == 0) tool_batch.threshold = number;
+		else if (strcmp(option, "randomness") == 0) tool_batch.randomness = (int)number;
+		else if (strcmp(option, "seed") == 0) srand((unsigned int)number);
+		else if (strcmp(option, "cache-limit") == 0) cache_set_limit((unsigned long long)(number * (1 << 20)));
+		else if (strcmp(option, "sequence") == 0)
+		{
+			tool_batch.topology = MATCHING_TOPOLOGY_SEQUENCE;
+			tool_batch.neighbours = (int)number;
+		}
+		else ok = false;
+
+		if (!ok)
+		{
+			fprintf(stderr, "[Batch] Wrong option '%s'\n", argv[i]);
+			return -1;
+		}
+	}
+
+	return i;
+}
+
+// run the pipeline
+bool tool_batch_run(const int argc, char * const argv[])
+{
+	memset(&tool_batch, 0, sizeof(tool_batch));
+	tool_batch.resolution = 1600;
+	tool_batch.similarity = 0.7;
+	tool_batch.topology = MATCHING_TOPOLOGY_UNORDERED;
+	tool_batch.neighbours = 2;
+	tool_batch.threshold = 12;
+	tool_batch.randomness = 3;
+	tool_batch.normalize_data = true;
+	tool_batch.normalize_A = false;
+
+	// intermediate results are cached in current directory, unless we load a project
+	cache_open(NULL);
+
+	const int first = tool_batch_options(argc, argv);
+	if (first < 0) return false;
+
+	// check the pipeline before we spend hours on it
+	bool calibrating = false;
+	int stages_count = 0;
+	for (int i = first; i < argc; i++)
+	{
+		const Tool_Batch_Stage stage = tool_batch_find_stage(argv[i]);
+		const int count = tool_batch_arguments_count(argc, argv, i);
+
+		const char * error = NULL;
+		if (stage == TOOL_BATCH_STAGES_COUNT) error = "unknown stage";
+		else if ((stage == TOOL_BATCH_IMAGES || stage == TOOL_BATCH_EXPORT) && count == 0) error = "missing filename";
+		else if (stage == TOOL_BATCH_PROJECT && count != 1) error = "expects one filename";
+		else if ((stage == TOOL_BATCH_MATCH || stage == TOOL_BATCH_CALIBRATE || stage == TOOL_BATCH_BUNDLE) && count > 0) error = "doesn't take arguments";
+		else if (stage == TOOL_BATCH_CALIBRATE && calibrating) error = "previous calibration hasn't been finished by bundle";
+		else if (stage == TOOL_BATCH_BUNDLE && !calibrating) error = "has to follow calibrate";
+
+		if (error)
+		{
+			fprintf(stderr, "[Batch] '%s': %s\n", argv[i], error);
+			return false;
+		}
+
+		if (stage == TOOL_BATCH_CALIBRATE) calibrating = true;
+		if (stage == TOOL_BATCH_BUNDLE) calibrating = false;
+		stages_count++;
+		i += count;
+	}
+
+	if (stages_count == 0 || calibrating)
+	{
+		fprintf(stderr, stages_count == 0 ? "[Batch] Nothing to do\n" : "[Batch] calibrate has to be followed by bundle\n");
+		return false;
+	}
+
+	if (tool_batch.timings_filename)
+	{
+		if (!(tool_batch.timings = fopen(tool_batch.timings_filename, "w")))
+		{
+			fprintf(stderr, "[Batch] Couldn't open '%s'\n", tool_batch.timings_filename);
+			return false;
+		}
+
+		fprintf(tool_batch.timings, "stage,seconds,ok\n");
+	}
+
+	printf("[Batch] running %d stages on %d processors\n", stages_count, parser_processors());
+
+	// run it
+	bool ok = true;
+	const double start = ui_profiler_time();
+	LOCK(geometry)
+	{
+		for (int i = first; ok && i < argc; i++)
+		{
+			const Tool_Batch_Stage stage = tool_batch_find_stage(argv[i]);
+			const int count = tool_batch_arguments_count(argc, argv, i);
+
+			const double stage_start = ui_profiler_time();
+			ok = tool_batch_stage(stage, argv + i + 1, count);
+			const double seconds = (ui_profiler_time() - stage_start) / 1000.0;
+
+			printf("[Batch] %s %s in %.3f s\n", argv[i], ok ? "finished" : "failed", seconds);
+			if (tool_batch.timings)
+			{
+				fprintf(tool_batch.timings, "%s,%.3f,%d\n", argv[i], seconds, ok ? 1 : 0);
+				fflush(tool_batch.timings);
+			}
+
+			i += count;
+		}
+	}
+	UNLOCK(geometry);
+
+	const double seconds = (ui_profiler_time() - start) / 1000.0;
+	printf("[Batch] pipeline %s in %.3f s\n", ok ? "finished" : "failed", seconds);
+	if (tool_batch.timings)
+	{
+		fprintf(tool_batch.timings, "total,%.3f,%d\n", seconds, ok ? 1 : 0);
+		fclose(tool_batch.timings);
+	}
+
+	return ok;
+}
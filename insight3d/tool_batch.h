@@ -0,0 +1,42 @@
+#ifndef __TOOL_BATCH
+#define __TOOL_BATCH
+
+#include "tool_typical_includes.h"
+#include "tool_matching.h"
+#include "tool_calibration.h"
+#include "geometry_loader.h"
+#include "geometry_export.h"
+#include "core_cache.h"
+#include "ui_visualization.h"
+#include "ui_profiler.h"
+
+// batch pipeline - reconstructs a project without user interface (e.g., on a render farm node);
+// the pipeline is given on the command line as a sequence of stages, which are run in that order
+// (images and pairs are processed on all cores) and the time spent in every stage is reported
+//
+//   insight3d --batch [options] <stage> [<arguments>] [<stage> [<arguments>] ...]
+//
+// stages:
+//   images <file>...          add images (image files or image lists .ifl)
+//   project <file>            load project (intermediate results are cached next to it)
+//   match                     extract features and match images
+//   calibrate                 automatic calibration of image pair and resection of other views
+//   bundle                    bundle adjustment, metric upgrade and use of the calibration
+//                             (has to follow calibrate)
+//   export <file>...          save project (.i3d, .i3db) or export it, the format is given by the
+//                             extension (.rzml, .ply, .wrl, .obj, .glb)
+//
+// options:
+//   --resolution <px>         size of images used for matching (default 1600)
+//   --similarity <ratio>      similarity threshold of matched features (default 0.7)
+//   --threshold <px>          image measurement threshold (default 12)
+//   --sequence <neighbours>   match only neighbouring images of a sequence
+//   --randomness <n>          randomness of automatic calibration (default 3)
+//   --seed <n>                seed of random number generator, so that runs are repeatable
+//   --cache-limit <MB>        size limit of the cache
+//   --timings <file>          write time spent in every stage (csv)
+//
+// note requires initialization_batch()
+bool tool_batch_run(const int argc, char * const argv[]);
+
+#endif
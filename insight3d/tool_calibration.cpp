@@ -162,6 +162,8 @@ void calibration_update_inliers(const size_t calibration_id, const size_t P_id,
 			ASSERT(false, "unknown value in status matrix");
 		}
 	}
+
+	geometry_calibration_changed(calibration_id);
 }
 
 // update current estimation of the set of inlying points on one shot
@@ -177,6 +179,8 @@ void calibration_update_inliers(const size_t calibration_id, const size_t P_id,
 		DYN(camera->points_meta, points_indices[i]);
 		camera->points_meta.data[points_indices[i]].inlier = status[i]; 
 	}
+
+	geometry_calibration_changed(calibration_id);
 }
 
 // update current estimation of the set of inlying points for one vertex
@@ -195,6 +199,8 @@ void calibration_update_inliers(const size_t calibration_id, const size_t count,
 		DYN(P->points_meta, point_id);
 		P->points_meta.data[point_id].inlier = status[i];
 	}
+
+	geometry_calibration_changed(calibration_id);
 }
 
 // update current estimation of the set of inlying points for the whole calibration 
@@ -452,12 +458,11 @@ bool calibration_pair(
 			// triangulate only inliers 
 			if (CV_MAT_ELEM(*status, signed char, 0, i) == 0) continue;
 
-			ADD(calibration->Xs); 
-			Calibration_Vertex * const vertex = calibration->Xs.data + LAST_INDEX(calibration->Xs);
 			ASSERT(validate_point(shot_id1, points1_indices[i]), "invalid point encountered in triangulation code");
 			ASSERT(validate_point(shot_id2, points2_indices[i]), "invalid point encountered in triangulation code");
 			ASSERT(shots.data[shot_id1].points.data[points1_indices[i]].vertex == shots.data[shot_id2].points.data[points2_indices[i]].vertex, "inconsistent indexing of vertex");
-			vertex->vertex_id = shots.data[shot_id1].points.data[points1_indices[i]].vertex;
+			const size_t X_id = geometry_calibration_add_X(*calibration_id, shots.data[shot_id1].points.data[points1_indices[i]].vertex);
+			Calibration_Vertex * const vertex = calibration->Xs.data + X_id;
 
 			// fill the data in a matrix 
 			OPENCV_ELEM(projected_points, 0, 0) = OPENCV_ELEM(points1, 0, i); 
@@ -479,20 +484,16 @@ bool calibration_pair(
 		}
 
 		// save first camera
-		ADD(calibration->Ps);
-		size_t P1_id = LAST_INDEX(calibration->Ps);
+		size_t P1_id = geometry_calibration_add_P(*calibration_id, shot_id1);
 		Calibration_Camera * const camera1 = calibration->Ps.data + P1_id;
 		camera1->P = P1;
-		camera1->shot_id = shot_id1;
 		DYN_INIT(camera1->Fs);
 		DYN_INIT(camera1->points_meta);
 
 		// save second camera
-		ADD(calibration->Ps);
-		size_t P2_id = LAST_INDEX(calibration->Ps);
+		size_t P2_id = geometry_calibration_add_P(*calibration_id, shot_id2);
 		Calibration_Camera * const camera2 = calibration->Ps.data + P2_id;
 		camera2->P = P2;
-		camera2->shot_id = shot_id2;
 		DYN_INIT(camera2->Fs);
 		DYN_INIT(camera2->points_meta);
 		/*ADD(camera2->Fs);
@@ -648,14 +649,12 @@ bool calibration_add_view(const size_t calibration_id, const size_t shot_id, con
 
 			// try to find the camera among those already calibrated
 			size_t P_id;
-			bool P_found;
-			LAMBDA_FIND(calibration->Ps, P_id, P_found, calibration->Ps.data[P_id].shot_id == shot_id);
+			const bool P_found = geometry_calibration_find_P(calibration_id, shot_id, P_id);
 
 			// if it hasn't been found, create a new one
 			if (!P_found) 
 			{
-				ADD(calibration->Ps);
-				P_id = LAST_INDEX(calibration->Ps);
+				P_id = geometry_calibration_add_P(calibration_id, shot_id);
 			}
 			else
 			{
@@ -668,7 +667,7 @@ bool calibration_add_view(const size_t calibration_id, const size_t shot_id, con
 			
 			// save it
 			calibration->Ps.data[P_id].P = P;
-			calibration->Ps.data[P_id].shot_id = shot_id;
+			geometry_calibration_changed(calibration_id);
 
 			// also update the estimate of inliers and outliers
 			calibration_update_inliers(calibration_id, P_id, points->cols, points_indices, inliers);
@@ -1380,6 +1379,7 @@ void calibration_rectify(bool affine)
 		ATOMIC_RW(opencv, cvReleaseMat(&calibration->pi_infinity); );
 	}
 	calibration->pi_infinity = pi_inf;
+	geometry_calibration_changed(ui_state.current_calibration);
 
 	// release resources 
 	FREE(principal_points);
@@ -1508,8 +1508,7 @@ void calibration_triangulate_vertex(
 
 		// try to find the vertex in existing dataset
 		size_t X_id; 
-		bool X_found;
-		LAMBDA_FIND(calibration->Xs, X_id, X_found, calibration->Xs.data[X_id].vertex_id == vertex_id);
+		const bool X_found = geometry_calibration_find_X(calibration_id, vertex_id, X_id);
 		Calibration_Vertex * vertex = NULL;
 		if (X_found)
 		{
@@ -1537,12 +1536,12 @@ void calibration_triangulate_vertex(
 				{
 					if (vertex->X) cvReleaseMat(&vertex->X);
 					vertex->X = X;
+					geometry_calibration_changed(calibration_id);
 				}
 				else
 				{
-					ADD(calibration->Xs);
-					vertex = calibration->Xs.data + LAST_INDEX(calibration->Xs);
-					vertex->vertex_id = vertex_id;
+					X_id = geometry_calibration_add_X(calibration_id, vertex_id);
+					vertex = calibration->Xs.data + X_id;
 					vertex->X = X;
 				}
 
@@ -1552,7 +1551,7 @@ void calibration_triangulate_vertex(
 			else if (vertex)
 			{
 				if (vertex->X) cvReleaseMat(&vertex->X);
-				vertex->set = false;
+				geometry_calibration_remove_X(calibration_id, X_id);
 
 				// mark the inliers and outliers anyway
 				calibration_update_inliers(calibration_id, points->cols, indices, inliers);
@@ -1783,13 +1782,10 @@ void tool_calibration_clear()
 	}
 
 	// find current shot's calibration and erase it 
-	bool found;
 	size_t id;
-	LAMBDA_FIND(calibrations.data[ui_state.current_calibration].Ps, id, found, calibrations.data[ui_state.current_calibration].Ps.data[id].shot_id == ui_state.current_shot);
-
-	if (found)
+	if (geometry_calibration_find_P(ui_state.current_calibration, ui_state.current_shot, id))
 	{
-		calibrations.data[ui_state.current_calibration].Ps.data[id].set = false;
+		geometry_calibration_remove_P(ui_state.current_calibration, id);
 	}
 
 	// update calibrated flag 
@@ -2196,6 +2192,7 @@ void calibration_bundle(const double measurement_threhsold)
 		Xs_i++;
 	}
 	ASSERT(Xs_i == Xs_count, "inconsistent counters");
+	geometry_calibration_changed(calibration_id);
 
 	// * re-evaluate inliers and outliers * 
 
@@ -33,4 +33,13 @@ void tool_calibration_auto_step();
 void tool_calibration_auto_end(); 
 void tool_calibration_test_rectification();
 
+// automatic calibration: begin calibrates the best image pair (picked randomly among randomness + 1 
+// pairs with the most correspondences), every step adds another view and end runs bundle adjustment,
+// upgrades the reconstruction to metric and applies it to the shots; calibration_auto does all of it
+// expects LOCK(geometry)
+bool calibration_auto_begin(const unsigned int randomness, const bool normalize_data, const bool normalize_A, const double distance_threshold);
+bool calibration_auto_step(const unsigned int randomness, const bool normalize_data, const bool normalize_A, const double distance_threshold);
+bool calibration_auto_end(const unsigned int randomness, const bool normalize_data, const bool normalize_A, const double distance_threshold);
+bool calibration_auto(const unsigned int randomness, const bool normalize_data, const bool normalize_A, const double distance_threshold);
+
 #endif
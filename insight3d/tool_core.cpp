@@ -794,6 +794,7 @@ void tool_show_progress(double percentage)
 	if (percentage > 1) percentage = 1;
 
 	ATOMIC(tools, tools_state.progressbar_percentage = percentage; );
+	gui_request_redraw();
 
 	/*LOCK_RW(opencv)
 	{
@@ -164,8 +164,7 @@ void tool_edit_erase_all_vertices_and_points()
 	// go through all calibrations and release all triangulated points 
 	for ALL(calibrations, i) 
 	{
-		Calibration * calibration = calibrations.data + i; 
-		DYN_FREE(calibration->Xs);
+		geometry_calibration_remove_Xs(i);
 	}
 
 	ui_list_update();
@@ -7,7 +7,8 @@ struct Tool_File
 
 static Tool_File tool_file;
 
-void tool_file_new()
+// delete everything 
+static void tool_file_release()
 {
 	ui_prepare_for_deletition(true, true, true, true, true);
 	image_loader_cancel_all_requests();
@@ -22,6 +23,13 @@ void tool_file_new()
 	ui_workflow_default_shot();
 }
 
+void tool_file_new()
+{
+	tool_file_release();
+	geometry_autosave_start(NULL);
+	cache_open(NULL);
+}
+
 void tool_file_open_project()
 {
 	char * const filename = tool_choose_file();
@@ -30,24 +38,38 @@ void tool_file_open_project()
 	if (!filename) return;
 
 	// detete everything 
-	ui_prepare_for_deletition(true, true, true, true, true);
-	image_loader_cancel_all_requests();
-	
-	for ALL(shots, i) 
-	{
-		memset(&shots.data[i].image_loader_request, 0, sizeof(Image_Loader_Request));
-	}
+	tool_file_release();
 
-	geometry_release();
+	// load something new 
+	const bool loaded = geometry_load_project(filename);
 	ui_list_update();
 	ui_workflow_default_shot();
+	visualization_process_data(vertices, shots);
 
-	// load something new 
-	geometry_load_project(filename);
+	// edits are journaled and intermediate results cached next to the project
+	geometry_autosave_start(loaded ? filename : NULL);
+	cache_open(loaded ? filename : NULL);
+
+	FREE(filename);
+}
+
+// replay autosave journal left behind by a session which didn't finish
+void tool_file_recover_autosave()
+{
+	char * const filename = tool_choose_file();
+	if (!filename) return;
+
+	tool_file_release();
+
+	geometry_autosave_recover(filename);
 	ui_list_update();
 	ui_workflow_default_shot();
 	visualization_process_data(vertices, shots);
 
+	// recovered state doesn't have project file until it's saved
+	geometry_autosave_start(NULL);
+	cache_open(NULL);
+
 	FREE(filename);
 }
 
@@ -56,7 +78,11 @@ void tool_file_save_project()
 	char * filename = tool_choose_new_file();
 	if (!filename) return; 
 
-	geometry_save(filename);
+	if (geometry_save(filename)) 
+	{
+		geometry_autosave_start(filename);
+		cache_open(filename);
+	}
 
 	FREE(filename);
 }
@@ -87,16 +113,15 @@ void tool_file_add_image()
 
 void tool_file_import_realviz_project()
 {
-	/* char * filename = tool_choose_file();
+	char * filename = tool_choose_file();
 	if (!filename) return; 
 	
-	geometry_loader(filename, shots);
-	visualization_process_data(vertices, shots);
+	geometry_loader_rzml(filename);
 	ui_list_update();
 	ui_workflow_default_shot();
 	visualization_process_data(vertices, shots);
 
-	FREE(filename); */
+	FREE(filename);
 }
 
 void tool_file_import_points()
@@ -115,7 +140,7 @@ void tool_file_import_pointcloud()
 	char * filename = tool_choose_file();
 	if (!filename) return; 
 	
-	bool success = geometry_loader_vertices(filename, vertices);
+	bool success = interface_filesystem_has_extension(filename, ".ply") ? geometry_loader_ply(filename, vertices, 0, ui_state.groups.count) : geometry_loader_vertices(filename, vertices);
 	visualization_process_data(vertices, shots);
 
 	FREE(filename);
@@ -141,6 +166,26 @@ void tool_file_export_sandy3d()
 	FREE(filename);
 }
 
+void tool_file_export_obj()
+{
+	char * filename = tool_choose_new_file();
+	if (!filename) return; 
+	
+	bool success = geometry_export_obj(filename, vertices, polygons); // {}
+
+	FREE(filename);
+}
+
+void tool_file_export_gltf()
+{
+	char * filename = tool_choose_new_file();
+	if (!filename) return; 
+	
+	bool success = geometry_export_gltf(filename, vertices, polygons); // {}
+
+	FREE(filename);
+}
+
 void tool_file_export_realviz_project()
 {
 	char * filename = tool_choose_new_file();
@@ -155,25 +200,43 @@ void tool_file_export_pointcloud()
 {
 	char * filename = tool_choose_new_file();
 	if (!filename) return; 
+
+	// binary PLY is much smaller and faster
+	if (interface_filesystem_has_extension(filename, ".ply"))
+	{
+		geometry_export_ply(filename, vertices);
+		FREE(filename);
+		return;
+	}
 		
-	FILE * fp = fopen(filename, "w");
+	Output_File * out = output_open(filename, true);
+	if (!out) 
+	{
+		FREE(filename);
+		return;
+	}
 	// fprintf(fp, "# insight3d vertices export; line format = x y z nx ny nz r g b");
 
+	const char separators[] = "        \n";
 	for ALL(vertices, i) 
 	{
 		const Vertex * vertex = vertices.data + i; 
 		if (!vertex->reconstructed) continue; 
 
-		fprintf(
-			fp, 
-			"%lf %lf %lf %lf %lf %lf %lf %lf %lf\n", 
+		const double values[9] = { 
 			vertex->x, vertex->y, vertex->z, 
 			vertex->nx, vertex->ny, vertex->nz,
 			vertex->color[0], vertex->color[1], vertex->color[2]
-		);
+		};
+
+		for (int k = 0; k < 9; k++) 
+		{
+			output_double(out, values[k]);
+			output_char(out, separators[k]);
+		}
 	}
 	
-	fclose(fp); 
+	output_close(out); 
 
 	FREE(filename);
 }
@@ -184,7 +247,12 @@ void tool_file_export_cameras()
 	if (!filename) return; 
 	
 	
-	FILE * fp = fopen(filename, "w");
+	Output_File * out = output_open(filename);
+	if (!out) 
+	{
+		FREE(filename);
+		return;
+	}
 	// fprintf(fp, "# insight3d camera export; line format = x y z nx ny nz r g b");
 
 	for ALL(shots, i) 
@@ -198,13 +266,14 @@ void tool_file_export_cameras()
 		{
 			for (int j = 0; j < P->cols; j++)
 			{
-				fprintf(fp, "%lf ", OPENCV_ELEM(P, i, j));
+				output_double(out, OPENCV_ELEM(P, i, j));
+				output_char(out, ' ');
 			}
 		}
-		fprintf(fp, "\n");
+		output_char(out, '\n');
 	}
 	
-	fclose(fp);
+	output_close(out);
 
 	FREE(filename);
 }
@@ -219,15 +288,18 @@ void tool_file_create()
 	tool_register_menu_function("Main menu|File|New|", tool_file_new);
 	tool_register_menu_function("Main menu|File|Open project (.i3d)|", tool_file_open_project);
 	tool_register_menu_function("Main menu|File|Save project (.i3d)|", tool_file_save_project);
+	tool_register_menu_function("Main menu|File|Recover autosave (.autosave)|", tool_file_recover_autosave);
 	tool_register_menu_function("Main menu|File|Add list of images (.ifl)|", tool_file_add_list_of_images);
 	tool_register_menu_function("Main menu|File|Add image (.jpg, .png)|", tool_file_add_image);
 	tool_register_menu_function("Main menu|File|Import RealVIZ project (.rzml, .rzi)|", tool_file_import_realviz_project);
 	tool_register_menu_function("Main menu|File|Import points (file pair)|", tool_file_import_points);
-	tool_register_menu_function("Main menu|File|Import pointcloud (.txt)|", tool_file_import_pointcloud);
+	tool_register_menu_function("Main menu|File|Import pointcloud (.txt, .ply)|", tool_file_import_pointcloud);
 	tool_register_menu_function("Main menu|File|Export VRML (.vrml)|", tool_file_export_vrml);
 	tool_register_menu_function("Main menu|File|Export Sandy3D ActionScript (.as)|", tool_file_export_sandy3d);
+	tool_register_menu_function("Main menu|File|Export OBJ (.obj)|", tool_file_export_obj);
+	tool_register_menu_function("Main menu|File|Export glTF (.glb)|", tool_file_export_gltf);
 	tool_register_menu_function("Main menu|File|Export RealVIZ project (.rzml, .rzi)|", tool_file_export_realviz_project);
 	tool_register_menu_function("Main menu|File|Export cameras (.txt)|", tool_file_export_cameras);
-	tool_register_menu_function("Main menu|File|Export pointcloud (.txt)|", tool_file_export_pointcloud);
+	tool_register_menu_function("Main menu|File|Export pointcloud (.txt, .ply)|", tool_file_export_pointcloud);
 	tool_register_menu_function("Main menu|File|Quit|", tool_file_quit);
 }
@@ -6,6 +6,8 @@
 #include "geometry_structures.h"
 #include "geometry_loader.h"
 #include "geometry_export.h"
+#include "geometry_autosave.h"
+#include "core_cache.h"
 #include "ui_core.h"
 #include "ui_inspection_mode.h"
 #include "ui_shot_mode.h"
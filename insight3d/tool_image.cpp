@@ -6,6 +6,12 @@ void tool_image_generate_textures()
 	geometry_extract_all_textures();
 }
 
+// toggle tiled stores for very large images 
+void tool_image_tiled_images()
+{
+	image_loader_set_tiled(!image_loader_get_tiled());
+}
+
 // colorize vertices 
 void tool_image_colorize()
 {
@@ -74,6 +80,8 @@ void tool_image_colorize()
 		vertex->color[2] = accum_blue[vertex_id] / ((float)count[vertex_id] * 255); 
 	}
 
+	geometry_changed(GEOMETRY_CHANGE_VERTICES, 0, vertices.count);
+
 	printf("\n");
 
 	// release resources
@@ -220,5 +228,6 @@ void tool_image_create()
 	tool_create(UI_MODE_UNSPECIFIED, "Resection", "Estimate cameras using correspondence between reconstructred 3d vertices and their projection");
 	tool_register_menu_function("Main menu|Image|Colorize vertices|", tool_image_colorize);
 	tool_register_menu_function("Main menu|Image|Generate textures|", tool_image_generate_textures);
+	tool_register_menu_function("Main menu|Image|Enable/disable tiled images|", tool_image_tiled_images);
 	// tool_register_menu_function("Main menu|Image|Pinhole correction|", tool_image_pinhole_deform);
 }
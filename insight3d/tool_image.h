@@ -8,6 +8,7 @@
 
 void tool_image_create();
 void tool_image_colorize();
+void tool_image_tiled_images();
 void tool_image_pinhole_deform();
 
 #endif
@@ -14,11 +14,6 @@ const size_t
 	MATCHING_INCLUDE_UNVERIFIED = 9
 	;
 
-const size_t
-	MATCHING_TOPOLOGY_UNORDERED = 0, 
-	MATCHING_TOPOLOGY_SEQUENCE = 1
-	;
-
 const size_t 
 	MATCHING_SIFT = 0, 
 	MATCHING_MSER = 1
@@ -108,6 +103,15 @@ void tool_matching_standard()
 	const int topology = tool_get_enum(tool_matching_id, MATCHING_TOPOLOGY);
 	const int neighbours = tool_get_int(tool_matching_id, MATCHING_NEIGHBOURS);
 
+	matching_standard(fsor_limit, max_size, epipolar_distance_threshold, skip_feature_extraction, use_ransac, include_unverified, topology, neighbours);
+}
+
+// match all images and create vertices from tracks 
+void matching_standard(
+	const double fsor_limit, const int max_size, const double epipolar_distance_threshold, const bool skip_feature_extraction, 
+	const bool use_ransac, const bool include_unverified, const int topology, const int neighbours
+)
+{
 	// extract features
 	if (!skip_feature_extraction)
 	{
@@ -178,63 +182,271 @@ void tool_matching_remove_conflicts()
 	matching_remove_conflicting_tracks();
 }*/
 
+// * keypoints cache * 
+
+// keypoints of every image are cached (bump the version when anything changes about how 
+// they're computed, including parameters of the SIFT library)
+const int MATCHING_FEATURES_CACHE_VERSION = 1;
+static const char * const MATCHING_FEATURES_CACHE_EXTENSION = ".sift";
+
+// header of cached keypoints, features follow 
+struct Matching_Features_Header
+{
+	int width, height; // size of the image the keypoints were extracted from 
+	int count, feature_size;
+};
+
+// key of keypoints extracted from given image, returns false if the image can't be read 
+static bool matching_features_key(Cache_Key & key, const char * image_filename, const double max_size)
+{
+	cache_key_init(key, "sift", MATCHING_FEATURES_CACHE_VERSION);
+	cache_key_add_double(key, max_size);
+	cache_key_add_int(key, sizeof(feature));
+	return cache_key_add_file(key, image_filename);
+}
+
+// load keypoints from the cache
+static bool matching_features_load(const Cache_Key & key, feature *& keypoints, int & count, int & width, int & height)
+{
+	void * data; 
+	size_t size;
+	if (!cache_get(key, MATCHING_FEATURES_CACHE_EXTENSION, &data, &size)) return false;
+
+	Matching_Features_Header header;
+	bool ok = size >= sizeof(header);
+	if (ok)
+	{
+		memcpy(&header, data, sizeof(header));
+		ok = 
+			header.feature_size == sizeof(feature) && header.count >= 0 && 
+			(size - sizeof(header)) / sizeof(feature) == (size_t)header.count && (size - sizeof(header)) % sizeof(feature) == 0;
+	}
+
+	keypoints = NULL;
+	if (ok && header.count > 0)
+	{
+		keypoints = (feature *)malloc(header.count * sizeof(feature));
+		ok = keypoints != NULL;
+	}
+
+	if (ok)
+	{
+		if (header.count > 0) memcpy(keypoints, (char *)data + sizeof(header), header.count * sizeof(feature));
+		count = header.count;
+		width = header.width;
+		height = header.height;
+
+		// pointers are meaningless outside the session which stored them 
+		for (int i = 0; i < count; i++) 
+		{
+			keypoints[i].fwd_match = keypoints[i].bck_match = keypoints[i].mdl_match = NULL;
+			keypoints[i].feature_data = NULL;
+		}
+	}
+
+	FREE(data);
+	return ok;
+}
+
+// store keypoints in the cache
+static void matching_features_store(const Cache_Key & key, const feature * keypoints, const int count, const int width, const int height)
+{
+	const size_t size = sizeof(Matching_Features_Header) + count * sizeof(feature);
+	char * const data = ALLOC(char, size);
+	if (!data) return;
+
+	Matching_Features_Header header; 
+	header.width = width; 
+	header.height = height; 
+	header.count = count; 
+	header.feature_size = sizeof(feature);
+	memcpy(data, &header, sizeof(header));
+	if (count > 0) memcpy(data + sizeof(header), keypoints, count * sizeof(feature));
+
+	cache_put(key, MATCHING_FEATURES_CACHE_EXTENSION, data, size);
+	FREE(data);
+}
+
+// * feature extraction * 
+
+// keypoints of one image
+struct Matching_Features_Item
+{
+	size_t shot_id;
+	char * image_filename;
+	bool extracted, cached;
+	feature * keypoints;
+	int keypoints_count;
+	int width, height; // size of the image the keypoints were extracted from 
+};
+
+// images shared by threads extracting their keypoints (each takes the next unprocessed one)
+struct Matching_Features_Work
+{
+	Matching_Features_Item * items;
+	size_t count, next, done;
+	double max_size;
+	pthread_mutex_t mutex;
+};
+
+// every thread holds scale space of one image, which takes a few hundred MB for large images
+static const int MATCHING_FEATURES_MAX_THREADS = 8;
+
+// extract keypoints of images until there are none left
+static void * matching_features_function(void * arg)
+{
+	Matching_Features_Work * const work = (Matching_Features_Work *)arg;
+
+	while (true)
+	{
+		pthread_mutex_lock(&work->mutex);
+		const size_t i = work->next < work->count ? work->next++ : work->count;
+		pthread_mutex_unlock(&work->mutex);
+		if (i == work->count) break;
+
+		Matching_Features_Item * const item = work->items + i;
+
+		// keypoints extracted earlier from the same image are reused
+		Cache_Key key; 
+		const bool keyed = item->image_filename && matching_features_key(key, item->image_filename, work->max_size);
+		if (keyed && matching_features_load(key, item->keypoints, item->keypoints_count, item->width, item->height))
+		{
+			item->extracted = item->cached = true;
+		}
+		else if (item->image_filename)
+		{
+			// load the picture
+			IplImage * img; 
+			ATOMIC_RW(opencv, img = opencv_load_image(item->image_filename, (int)work->max_size); );
+
+			if (img)
+			{
+				item->width = img->width;
+				item->height = img->height;
+
+				// extract SIFT keypoints (the scale space is private to this thread, so we don't 
+				// need to hold the opencv lock and threads can run in parallel)
+				item->keypoints_count = sift_features(img, &item->keypoints);
+				item->extracted = true;
+
+				// release resources 
+				ATOMIC_RW(opencv, cvReleaseImage(&img); );
+
+				if (keyed) matching_features_store(key, item->keypoints, item->keypoints_count, item->width, item->height);
+			}
+		}
+
+		if (item->extracted) 
+		{
+			printf(item->cached ? "[count = %d, cached]\n" : "[count = %d]\n", item->keypoints_count);
+			fflush(stdout);
+		}
+
+		pthread_mutex_lock(&work->mutex);
+		const size_t done = ++work->done;
+		pthread_mutex_unlock(&work->mutex);
+		tool_show_progress(done * (1.0 / work->count));
+	}
+
+	return NULL;
+}
+
 // extract features 
+// images are processed in parallel
 // todo delete existing keypoints on relevant images
+// expects LOCK(geometry)
 void matching_extract_features(const double max_size)
 {
 	// extract keypoints from all images 
 	debug("extracting keypoints");
 
-	double progress; 
 	size_t shots_count = 0; 
 	for ALL(shots, i)
 	{
 		shots_count++;
 	}
 
-	tool_start_progressbar(); 
+	Matching_Features_Work work;
+	memset(&work, 0, sizeof(work));
+	work.items = ALLOC(Matching_Features_Item, shots_count);
+	work.max_size = max_size;
+	if (!work.items) 
+	{
+		core_state.error = CORE_ERROR_OUT_OF_MEMORY;
+		return;
+	}
+
+	memset(work.items, 0, sizeof(Matching_Features_Item) * shots_count);
+	pthread_mutex_init(&work.mutex, NULL);
 
-	int shot_no = 0;
+	// delete all previous information, if any
 	for ALL(shots, i)
 	{
-		shot_no++;
-
 		Shot * const shot = shots.data + i; 
-		debug(shot->image_filename);
-
-		// delete all previous information, if any 
 		if (shot->matching) { FREE(shot->matching); shot->matching = NULL; }
 		if (shot->keypoints) { free(shot->keypoints); shot->keypoints = NULL; shot->keypoints_count = 0; }
 		if (shot->kd_tree) { kdtree_release(shot->kd_tree); shot->kd_tree = NULL; }
 
-		// update progressbar
-		tool_show_progress((shot_no - 1) * (1.0 / shots_count));
+		// workers get their own copy of the filename, since they run without the geometry lock
+		Matching_Features_Item * const item = work.items + work.count++;
+		item->shot_id = i;
+		item->image_filename = shot->image_filename ? strdup(shot->image_filename) : NULL;
+	}
 
-		// load the picture
-		IplImage * img; 
-		ATOMIC_RW(opencv, img = opencv_load_image(shot->image_filename, (int)max_size); );
-		if (!img)
+	tool_start_progressbar(); 
+
+	// split images among threads (this one takes part too)
+	int threads_count = parser_processors();
+	if (threads_count > MATCHING_FEATURES_MAX_THREADS) threads_count = MATCHING_FEATURES_MAX_THREADS;
+	if ((size_t)threads_count > work.count) threads_count = (int)work.count;
+
+	UNLOCK(geometry)
+	{
+		pthread_t threads[MATCHING_FEATURES_MAX_THREADS];
+		bool threaded[MATCHING_FEATURES_MAX_THREADS];
+		for (int i = 1; i < threads_count; i++)
+		{
+			threaded[i] = pthread_create(threads + i, NULL, matching_features_function, &work) == 0;
+		}
+
+		matching_features_function(&work);
+		for (int i = 1; i < threads_count; i++)
+		{
+			if (threaded[i]) pthread_join(threads[i], NULL);
+		}
+	}
+	LOCK(geometry);
+
+	// hand keypoints over to shots
+	for (size_t k = 0; k < work.count; k++)
+	{
+		Matching_Features_Item * const item = work.items + k;
+		FREE(item->image_filename);
+
+		if (!item->extracted)
 		{
 			TOOL_PARTIAL_FAIL("Cannot load image from disk", continue);
 		}
 
+		// the shot could have been deleted meanwhile
+		if (!validate_shot(item->shot_id))
+		{
+			free(item->keypoints);
+			continue;
+		}
+
+		Shot * const shot = shots.data + item->shot_id; 
+		shot->keypoints = item->keypoints;
+		shot->keypoints_count = item->keypoints_count;
+
 		// create new matching meta structure, since we'll regenerate the features
 		shot->matching = ALLOC(Matching_Shot, 1);
 		memset(shot->matching, 0, sizeof(Matching_Shot));
 
 		// fill in image's meta-values
 		Matching_Shot * const meta = (Matching_Shot *)shot->matching;
-		meta->width = img->width;
-		meta->height = img->height;
-
-		// extract SIFT keypoints
-		UNLOCK(geometry)
-		{
-			ATOMIC_RW(opencv, shot->keypoints_count = sift_features(img, &shot->keypoints); );
-			printf("[count = %d]\n", shot->keypoints_count);
-			fflush(stdout);
-		}
-		LOCK(geometry);
+		meta->width = item->width;
+		meta->height = item->height;
 
 		// build kd tree
 		ATOMIC_RW(opencv, shot->kd_tree = kdtree_build(shot->keypoints, shot->keypoints_count); ); // todo check if this is really necessary; maybe kdtree_build doesn't use opencv that much
@@ -247,7 +459,6 @@ void matching_extract_features(const double max_size)
 			free(shot->keypoints); 
 			shot->keypoints = NULL; 
 			shot->keypoints_count = 0;
-			ATOMIC_RW(opencv, cvReleaseImage(&img); );
 			TOOL_PARTIAL_FAIL("Failed to build kd-tree", continue);
 		}
 
@@ -256,11 +467,11 @@ void matching_extract_features(const double max_size)
 		{
 			shot->keypoints[j].feature_data = NULL;
 		}
-
-		// release resources 
-		ATOMIC_RW(opencv, cvReleaseImage(&img); );
 	}
 
+	pthread_mutex_destroy(&work.mutex);
+	FREE(work.items);
+
 	tool_end_progressbar();
 }
 
@@ -300,7 +511,11 @@ void matching_extract_tracks(const double fsor_limit, const bool use_ransac, con
 		}
 	}
 
-	FILE * fplan = fopen("matching_plan.txt", "r"); 
+	// matching plan is looked up in project's cache directory, then in the current directory
+	char * const plan_filename = cache_named_filename("matching_plan.txt");
+	FILE * fplan = fopen(plan_filename, "r"); 
+	FREE(plan_filename);
+	if (!fplan) fplan = fopen("matching_plan.txt", "r");
 	bool * plan = NULL;
 	if (fplan) 
 	{
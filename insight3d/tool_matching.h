@@ -4,12 +4,27 @@
 #include "tool_typical_includes.h"
 #include "ui_list.h"
 #include "mvg_matching.h"
+#include "core_cache.h"
+
+// which image pairs are matched
+const size_t
+	MATCHING_TOPOLOGY_UNORDERED = 0, 
+	MATCHING_TOPOLOGY_SEQUENCE = 1
+	;
 
 // tool registration and public routines
 void tool_matching_create();
 void tool_matching_standard();
 void tool_matching_remove_conflicts();
 
+// match images and create vertices from the tracks (the tool calls this with parameters set 
+// in its panel, batch pipeline with the ones given on command line)
+// expects LOCK(geometry)
+void matching_standard(
+	const double fsor_limit, const int max_size, const double epipolar_distance_threshold, const bool skip_feature_extraction, 
+	const bool use_ransac, const bool include_unverified, const int topology, const int neighbours
+);
+
 // additional shot info 
 struct Matching_Shot
 {
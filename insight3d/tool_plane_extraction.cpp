@@ -167,6 +167,8 @@ double * tool_plane_extraction(Vertices & vertices, double threshold /*= 0.5*/,
 		}
 	}
 
+	geometry_changed(GEOMETRY_CHANGE_VERTICES, 0, vertices.count);
+
 	// return plane coefficients
 	double * result = ALLOC(double, 4);
 	memcpy(result, best_sample, 4 * sizeof(double));
@@ -36,6 +36,7 @@ void tool_selection_create()
 	tool_register_menu_function("Main menu|View|Show/hide automatic points|", selection_option_show_automatic_points);
 	tool_register_menu_function("Main menu|View|Enable/disable dualview|", selection_option_show_dualview);
 	tool_register_menu_function("Main menu|View|Thumbnails only for selected|", selection_option_thumbs_only_for_selected);
+	tool_register_menu_function("Main menu|View|Show/hide frame profiler|", ui_profiler_toggle);
 	tool_register_menu_function("Main menu|View|Print projection matrices|", debug_print_Ps);
 	tool_register_menu_function("Main menu|View|Save initial solution|", debug_save_initial_solution);
 	tool_register_menu_function("Main menu|View|Save vertices|", debug_save_vertices);
@@ -568,7 +569,9 @@ void selection_option_show_automatic_points()
 
 void debug_print_Ps()
 {
-	std::ofstream Ps_out("./Ps.txt");
+	char * const Ps_filename = cache_named_filename("Ps.txt");
+	std::ofstream Ps_out(Ps_filename);
+	FREE(Ps_filename);
 
 	for ALL(shots, i) 
 	{
@@ -694,7 +697,9 @@ void debug_save_initial_solution()
 	size_t count_Ps = 0, count_Xs = 0;
 
 	// create indexing array for calibrated cameras
-	std::ofstream cameras_out("./cameras.txt");
+	char * const cameras_filename = cache_named_filename("cameras.txt");
+	std::ofstream cameras_out(cameras_filename);
+	FREE(cameras_filename);
 	for ALL(calibration->Ps, i)
 	{
 		const Calibration_Camera * const P = calibration->Ps.data + i; 
@@ -716,7 +721,9 @@ void debug_save_initial_solution()
 	}
 
 	// export 3d and 2d points
-	std::ofstream points_out("./points.txt");
+	char * const points_filename = cache_named_filename("points.txt");
+	std::ofstream points_out(points_filename);
+	FREE(points_filename);
 	for ALL(calibration->Xs, i)
 	{
 		const Calibration_Vertex * const X = calibration->Xs.data + i;
@@ -770,7 +777,9 @@ void debug_save_initial_solution()
 // save vertices coordinates 
 void debug_save_vertices()
 {
-	std::ofstream vertices_out("./vertices.txt"); 
+	char * const vertices_filename = cache_named_filename("vertices.txt");
+	std::ofstream vertices_out(vertices_filename);
+	FREE(vertices_filename);
 	
 	for ALL(vertices, i) 
 	{
@@ -8,7 +8,9 @@
 #include "ui_visualization.h"
 #include "ui_selection.h"
 #include "ui_workflow.h"
+#include "ui_profiler.h"
 #include "tool_core.h"
+#include "core_cache.h"
 
 // selection tool handles viewing options which are read by other tools and the rest of the application 
 extern bool option_show_dualview, option_thumbs_only_for_selected, option_hide_automatic;
@@ -85,6 +85,8 @@ void tool_triangulate_clear()
 		vertex->z = 0;
 	}
 
+	geometry_changed(GEOMETRY_CHANGE_VERTICES, 0, vertices.count);
+
 	triangulate_refresh_ui();
 }
 
@@ -0,0 +1,584 @@
+#include "ui_benchmark.h"
+
+// frames rendered by wait command before we give up on the image loader
+static const int UI_BENCHMARK_WAIT_FRAMES = 10000;
+
+// benchmark state
+struct UI_Benchmark
+{
+#ifdef INSIGHT3D_OSMESA
+	OSMesaContext context;
+	GLubyte * buffer;
+#endif
+	FILE * report;
+	size_t frame;
+};
+
+static UI_Benchmark ui_benchmark;
+
+// set size of the framebuffer (and create it if necessary)
+static bool ui_benchmark_resize(const int width, const int height)
+{
+	gui_set_size(width, height);
+
+#ifdef INSIGHT3D_OSMESA
+	// context keeps its objects, we only draw into a new buffer
+	FREE(ui_benchmark.buffer);
+	ui_benchmark.buffer = ALLOC(GLubyte, 4 * width * height);
+	if (!ui_benchmark.buffer || !OSMesaMakeCurrent(ui_benchmark.context, ui_benchmark.buffer, GL_UNSIGNED_BYTE, width, height))
+	{
+		fprintf(stderr, "[Benchmark] Couldn't bind %dx%d offscreen buffer\n", width, height);
+		return false;
+	}
+#else
+	// new video mode means new opengl context, all textures are gone
+	if (!(gui_context.surface = SDL_SetVideoMode(width, height, 32, gui_context.video_flags)))
+	{
+		fprintf(stderr, "[Benchmark] Video mode set failed: %s\n", SDL_GetError());
+		return false;
+	}
+
+	for (size_t i = 0; i < gui_context.panels_count; i++)
+	{
+		gui_caption_discard_opengl_texture(gui_context.panels[i]);
+	}
+
+	ui_event_resize();
+#endif
+
+	gui_helper_initialize_opengl();
+	gui_helper_opengl_adjust_size();
+
+	return true;
+}
+
+// create opengl context of current gui size
+static bool ui_benchmark_create_context()
+{
+#ifdef INSIGHT3D_OSMESA
+	// sdl is still used for timing
+	SDL_Init(SDL_INIT_TIMER);
+
+	if (!(ui_benchmark.context = OSMesaCreateContextExt(OSMESA_RGBA, 24, 8, 0, NULL)))
+	{
+		fprintf(stderr, "[Benchmark] Couldn't create OSMesa context\n");
+		return false;
+	}
+
+	return ui_benchmark_resize(gui_context.width, gui_context.height);
+#else
+	if (!gui_helper_initialize_sdl() || !gui_helper_initialize_opengl()) return false;
+	gui_helper_opengl_adjust_size();
+	return true;
+#endif
+}
+
+// release context
+static void ui_benchmark_release_context()
+{
+#ifdef INSIGHT3D_OSMESA
+	OSMesaDestroyContext(ui_benchmark.context);
+	FREE(ui_benchmark.buffer);
+	ui_benchmark.buffer = NULL;
+#else
+	SDL_Quit();
+#endif
+}
+
+// render one frame exactly like the rendering thread does, but wait until it's really drawn
+static void ui_benchmark_frame()
+{
+	if (gui_context.on_frame_begin) gui_context.on_frame_begin();
+	gui_calculate_coordinates();
+	gui_render();
+	glFinish();
+	if (gui_context.on_frame_end) gui_context.on_frame_end();
+
+	// write pass timings
+	if (ui_benchmark.report)
+	{
+		fprintf(ui_benchmark.report, "%u,%d", (unsigned int)ui_benchmark.frame, (int)ui_state.mode);
+		for (int i = 0; i < UI_PROFILER_PASSES_COUNT; i++)
+		{
+			fprintf(ui_benchmark.report, ",%.3f", ui_profiler_last((UI_PROFILER_PASS)i));
+		}
+		fprintf(ui_benchmark.report, "\n");
+	}
+
+	ui_benchmark.frame++;
+}
+
+// show rendered frame (there's nothing to show when drawing offscreen)
+static void ui_benchmark_present()
+{
+#ifndef INSIGHT3D_OSMESA
+	SDL_PumpEvents();
+	SDL_GL_SwapBuffers();
+#endif
+}
+
+// render frames and print mean time of each pass
+static void ui_benchmark_frames(const int count)
+{
+	double sum[UI_PROFILER_PASSES_COUNT];
+	memset(sum, 0, sizeof(sum));
+
+	for (int frame = 0; frame < count; frame++)
+	{
+		ui_benchmark_frame();
+		for (int i = 0; i < UI_PROFILER_PASSES_COUNT; i++)
+		{
+			sum[i] += ui_profiler_last((UI_PROFILER_PASS)i);
+		}
+		ui_benchmark_present();
+	}
+
+	if (count <= 0) return;
+	printf("[Benchmark] %d frames:", count);
+	for (int i = 0; i < UI_PROFILER_PASSES_COUNT; i++)
+	{
+		printf(" %s %.3f ms%s", ui_profiler_pass_name((UI_PROFILER_PASS)i), sum[i] / count, i + 1 < UI_PROFILER_PASSES_COUNT ? "," : "\n");
+	}
+}
+
+// render frame and save it
+static bool ui_benchmark_capture(const char * const filename)
+{
+	ui_benchmark_frame();
+
+	// read the frame before the buffers are swapped
+	IplImage * image = cvCreateImage(cvSize(gui_context.width, gui_context.height), IPL_DEPTH_8U, 3);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4); // rows of IplImage are aligned to 4 bytes
+	glReadPixels(0, 0, gui_context.width, gui_context.height, GL_BGR, GL_UNSIGNED_BYTE, image->imageData);
+	cvFlip(image, NULL, 0);
+
+	const bool saved = cvSaveImage(filename, image) != 0;
+	cvReleaseImage(&image);
+	ui_benchmark_present();
+
+	if (!saved)
+	{
+		fprintf(stderr, "[Benchmark] Couldn't save frame to '%s'\n", filename);
+	}
+
+	return saved;
+}
+
+// render until the image loader has nothing left to do
+static void ui_benchmark_wait()
+{
+	int frames = 0;
+	do
+	{
+		ui_benchmark_frame();
+		ui_benchmark_present();
+		SDL_Delay(1);
+	}
+	while (image_loader_busy() && ++frames < UI_BENCHMARK_WAIT_FRAMES);
+
+	// one more frame so that everything that was loaded is also uploaded
+	ui_benchmark_frame();
+	ui_benchmark_present();
+}
+
+// pseudo-random number from [0, 1] (the same sequence everywhere, so that runs are repeatable)
+static double ui_benchmark_random(unsigned int & seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 8 & 0xffff) / 65535.0;
+}
+
+// time nearest point and box queries (the hot path of hovering and selecting) at repeatable positions
+static bool ui_benchmark_pick(const int count)
+{
+	if (!INDEX_IS_SET(ui_state.current_shot) || !validate_shot(ui_state.current_shot)) return false;
+	const size_t shot_id = ui_state.current_shot;
+	if (shots.data[shot_id].width <= 0 || shots.data[shot_id].height <= 0) return false;
+
+	// first query builds the index
+	size_t point_id, found = 0, selected = 0;
+	double start = ui_profiler_time();
+	query_nearest_point(shot_id, 0.5, 0.5, point_id);
+	const double build = ui_profiler_time() - start;
+
+	unsigned int seed = 1;
+	start = ui_profiler_time();
+	for (int i = 0; i < count; i++)
+	{
+		const double x = ui_benchmark_random(seed);
+		const double y = ui_benchmark_random(seed);
+		if (query_nearest_point(shot_id, x, y, point_id) >= 0) found++;
+	}
+	const double nearest = ui_profiler_time() - start;
+
+	start = ui_profiler_time();
+	for (int i = 0; i < count; i++)
+	{
+		const double x = ui_benchmark_random(seed);
+		const double y = ui_benchmark_random(seed);
+		size_t inside;
+		query_points_in_rectangle(shot_id, x, y, x + 0.1, y + 0.1, inside);
+		selected += inside;
+	}
+	const double box = ui_profiler_time() - start;
+
+	printf(
+		"[Benchmark] picking on shot %u: index built in %.3f ms, nearest point %.3f us (%u found), box %.3f us (%.1f points)\n",
+		(unsigned int)shot_id, build, count > 0 ? 1000 * nearest / count : 0.0, (unsigned int)found,
+		count > 0 ? 1000 * box / count : 0.0, count > 0 ? selected / (double)count : 0.0
+	);
+
+	return true;
+}
+
+// load project the same way as file menu does
+static bool ui_benchmark_load_project(const char * const filename)
+{
+	geometry_release();
+	ui_list_update();
+	ui_workflow_default_shot();
+
+	const double start = ui_profiler_time();
+	if (!geometry_load_project(filename))
+	{
+		fprintf(stderr, "[Benchmark] Couldn't load project '%s'\n", filename);
+		return false;
+	}
+
+	printf("[Benchmark] project '%s' loaded in %.3f ms\n", filename, ui_profiler_time() - start);
+
+	ui_list_update();
+	ui_workflow_default_shot();
+	visualization_process_data(vertices, shots);
+
+	return true;
+}
+
+// save project (format is given by the extension)
+static bool ui_benchmark_save_project(const char * const filename)
+{
+	const double start = ui_profiler_time();
+	if (!geometry_save(filename))
+	{
+		fprintf(stderr, "[Benchmark] Couldn't save project '%s'\n", filename);
+		return false;
+	}
+
+	printf("[Benchmark] project '%s' saved in %.3f ms\n", filename, ui_profiler_time() - start);
+	return true;
+}
+
+// generate synthetic scene - vertices fill a ball of unit radius watched by shots placed on a circle 
+// around it, every vertex is marked on the shot facing it and on its two neighbours; images of 
+// the shots are written into the directory (created if necessary), so that the scene can be saved 
+// and loaded again by other scripts 
+static bool ui_benchmark_scene(
+	const int shots_count, const int vertices_count, const int width, const int height, const char * const directory
+)
+{
+	if (!interface_filesystem_make_directory(directory))
+	{
+		fprintf(stderr, "[Benchmark] Couldn't create directory '%s'\n", directory);
+		return false;
+	}
+
+	geometry_release();
+	ui_list_update();
+	ui_workflow_default_shot();
+
+	const double start = ui_profiler_time();
+	const double f = 0.9 * width, distance = 4; // the ball is seen whole by every shot 
+	char filename[1024];
+	IplImage * image = cvCreateImage(cvSize(width, height), IPL_DEPTH_8U, 3);
+
+	for (int i = 0; i < shots_count; i++)
+	{
+		// checkerboard tinted differently on every shot 
+		for (int y = 0; y < height; y++)
+		{
+			uchar * const row = (uchar *)image->imageData + y * image->widthStep;
+			for (int x = 0; x < width; x++)
+			{
+				const bool dark = (x / 32 + y / 32) % 2 == 0;
+				row[3 * x + 0] = (uchar)(dark ? 40 : 200);
+				row[3 * x + 1] = (uchar)((dark ? 40 : 120) + 120 * i / shots_count);
+				row[3 * x + 2] = (uchar)(255 * y / height);
+			}
+		}
+
+		snprintf(filename, sizeof(filename), "%s/shot%04d.jpg", directory, i);
+		if (!cvSaveImage(filename, image))
+		{
+			fprintf(stderr, "[Benchmark] Couldn't save image '%s'\n", filename);
+			cvReleaseImage(&image);
+			return false;
+		}
+
+		size_t shot_id;
+		geometry_new_shot(shot_id);
+		Shot * const shot = shots.data + shot_id;
+		shot->image_filename = strdup(filename);
+		shot->name = interface_filesystem_extract_filename(shot->image_filename);
+		shot->width = width;
+		shot->height = height;
+		shot->info_status = GEOMETRY_INFO_LOADED;
+		shot->f = f;
+		shot->fovx = rad2deg(2 * atan(0.5 * width / f));
+		shot->fovy = rad2deg(2 * atan(0.5 * height / f));
+		shot->calibrated = true;
+
+		// camera looks at the origin (rows of R are its x axis, y axis pointing down and z axis)
+		const double angle = 2 * OPENCV_PI * i / shots_count;
+		const double C[3] = { distance * cos(angle), 0.5 * sin(3 * angle), distance * sin(angle) };
+		const double length = sqrt(C[X] * C[X] + C[Y] * C[Y] + C[Z] * C[Z]);
+		double R[9];
+		R[6] = -C[X] / length; 
+		R[7] = -C[Y] / length; 
+		R[8] = -C[Z] / length;
+		const double side = sqrt(R[6] * R[6] + R[8] * R[8]);
+		R[0] = -R[8] / side; 
+		R[1] = 0; 
+		R[2] = R[6] / side;
+		R[3] = R[7] * R[2] - R[8] * R[1]; 
+		R[4] = R[8] * R[0] - R[6] * R[2]; 
+		R[5] = R[6] * R[1] - R[7] * R[0];
+		const double K[9] = { f, 0, 0.5 * width, 0, f, 0.5 * height, 0, 0, 1 };
+
+		// P = K R [I | -C]
+		shot->projection = opencv_create_matrix(3, 4);
+		for (int r = 0; r < 3; r++)
+		{
+			double t = 0;
+			for (int c = 0; c < 3; c++)
+			{
+				double m = 0;
+				for (int k = 0; k < 3; k++) m += K[3 * r + k] * R[3 * k + c];
+				OPENCV_ELEM(shot->projection, r, c) = m;
+				t -= m * C[c];
+			}
+			OPENCV_ELEM(shot->projection, r, 3) = t;
+		}
+
+		shot->rotation = opencv_create_matrix(3, 3);
+		shot->internal_calibration = opencv_create_matrix(3, 3);
+		shot->translation = opencv_create_matrix(3, 1);
+		geometry_calibration_from_P(shot_id);
+	}
+
+	cvReleaseImage(&image);
+
+	unsigned int seed = 1;
+	size_t points_count = 0;
+	const int track = shots_count < 3 ? shots_count : 3;
+	for (int i = 0; i < vertices_count; i++)
+	{
+		double v[3];
+		do
+		{
+			for (int k = 0; k < 3; k++) v[k] = 2 * ui_benchmark_random(seed) - 1;
+		}
+		while (v[X] * v[X] + v[Y] * v[Y] + v[Z] * v[Z] > 1);
+
+		size_t vertex_id;
+		geometry_new_vertex(vertex_id);
+		Vertex * const vertex = vertices.data + vertex_id;
+		vertex->x = v[X];
+		vertex->y = v[Y];
+		vertex->z = v[Z];
+		vertex->reconstructed = true;
+		vertex->vertex_type = GEOMETRY_VERTEX_AUTO;
+		for (int k = 0; k < 3; k++) vertex->color[k] = (float)(0.5 + 0.5 * v[k]);
+
+		// shot on the same side of the ball and its neighbours 
+		const double azimuth = atan2(v[Z], v[X]);
+		const int nearest = (int)floor(azimuth / (2 * OPENCV_PI) * shots_count + 0.5);
+		for (int j = 0; j < track; j++)
+		{
+			const size_t shot_id = ((nearest - track / 2 + j) % shots_count + shots_count) % shots_count;
+			const CvMat * const P = shots.data[shot_id].projection;
+
+			double x[3];
+			for (int r = 0; r < 3; r++)
+			{
+				x[r] = OPENCV_ELEM(P, r, 0) * v[X] + OPENCV_ELEM(P, r, 1) * v[Y] + OPENCV_ELEM(P, r, 2) * v[Z] + OPENCV_ELEM(P, r, 3);
+			}
+			if (x[2] <= 0) continue;
+
+			const double px = x[0] / x[2] / width, py = x[1] / x[2] / height;
+			if (px < 0 || px > 1 || py < 0 || py > 1) continue;
+
+			size_t point_id;
+			geometry_new_point(point_id, px, py, shot_id, vertex_id);
+			points_count++;
+		}
+	}
+
+	printf(
+		"[Benchmark] scene with %d shots, %d vertices and %u points generated in %.3f ms\n", 
+		shots_count, vertices_count, (unsigned int)points_count, ui_profiler_time() - start
+	);
+
+	ui_list_update();
+	ui_workflow_default_shot();
+	visualization_process_data(vertices, shots);
+
+	return true;
+}
+
+// execute one line of the script
+static bool ui_benchmark_command(char * line, const int line_number)
+{
+	// strip comments and trailing whitespace
+	char * comment = strchr(line, '#');
+	if (comment) *comment = '\0';
+	size_t length = strlen(line);
+	while (length > 0 && isspace((unsigned char)line[length - 1])) line[--length] = '\0';
+
+	char command[32];
+	int offset = 0;
+	if (sscanf(line, " %31s %n", command, &offset) < 1) return true; // empty line
+	const char * const argument = line + offset;
+
+	bool ok = false;
+	if (strcmp(command, "size") == 0)
+	{
+		int width, height;
+		ok = sscanf(argument, "%d %d", &width, &height) == 2 && width > 0 && height > 0 && ui_benchmark_resize(width, height);
+	}
+	else if (strcmp(command, "project") == 0)
+	{
+		ok = *argument && ui_benchmark_load_project(argument);
+	}
+	else if (strcmp(command, "scene") == 0)
+	{
+		int shots_count, vertices_count, width, height, directory = 0;
+		ok = 
+			sscanf(argument, "%d %d %d %d %n", &shots_count, &vertices_count, &width, &height, &directory) == 4 && 
+			shots_count > 0 && vertices_count >= 0 && width > 0 && height > 0 && argument[directory] &&
+			ui_benchmark_scene(shots_count, vertices_count, width, height, argument + directory)
+		;
+	}
+	else if (strcmp(command, "save") == 0)
+	{
+		ok = *argument && ui_benchmark_save_project(argument);
+	}
+	else if (strcmp(command, "mode") == 0)
+	{
+		ok = true;
+		if (strcmp(argument, "overview") == 0) ui_state.mode = UI_MODE_OVERVIEW;
+		else if (strcmp(argument, "inspection") == 0) ui_switch_to_inspection_mode();
+		else if (strcmp(argument, "shot") == 0) ui_switch_to_shot_mode();
+		else ok = false;
+	}
+	else if (strcmp(command, "shot") == 0)
+	{
+		unsigned int shot_id;
+		ok = sscanf(argument, "%u", &shot_id) == 1 && validate_shot(shot_id);
+		if (ok) ui_workflow_select_shot(shot_id);
+	}
+	else if (strcmp(command, "view") == 0)
+	{
+		double x, y, zoom;
+		ok = sscanf(argument, "%lf %lf %lf", &x, &y, &zoom) == 3 && INDEX_IS_SET(ui_state.current_shot);
+		if (ok)
+		{
+			UI_Shot_Meta * meta = ui_check_shot_meta(ui_state.current_shot);
+			meta->view_center_x = x;
+			meta->view_center_y = y;
+			meta->view_zoom = zoom;
+		}
+	}
+	else if (strcmp(command, "camera") == 0)
+	{
+		double T[3], R[3];
+		ok = sscanf(argument, "%lf %lf %lf %lf %lf %lf", T + X, T + Y, T + Z, R + X, R + Y, R + Z) == 6;
+		if (ok)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				visualization_state.T[i] = T[i];
+				visualization_state.R[i] = R[i];
+			}
+		}
+	}
+	else if (strcmp(command, "profiler") == 0)
+	{
+		ok = strcmp(argument, "on") == 0 || strcmp(argument, "off") == 0;
+		if (ok) ui_profiler_set_visible(strcmp(argument, "on") == 0);
+	}
+	else if (strcmp(command, "wait") == 0)
+	{
+		ui_benchmark_wait();
+		ok = true;
+	}
+	else if (strcmp(command, "frames") == 0)
+	{
+		int count;
+		ok = sscanf(argument, "%d", &count) == 1;
+		if (ok) ui_benchmark_frames(count);
+	}
+	else if (strcmp(command, "pick") == 0)
+	{
+		int count;
+		ok = sscanf(argument, "%d", &count) == 1 && ui_benchmark_pick(count);
+	}
+	else if (strcmp(command, "capture") == 0)
+	{
+		ok = *argument && ui_benchmark_capture(argument);
+	}
+	else if (strcmp(command, "report") == 0)
+	{
+		if (ui_benchmark.report) fclose(ui_benchmark.report);
+		ui_benchmark.report = *argument ? fopen(argument, "w") : NULL;
+		ok = ui_benchmark.report != NULL;
+		if (ok)
+		{
+			fprintf(ui_benchmark.report, "frame,mode");
+			for (int i = 0; i < UI_PROFILER_PASSES_COUNT; i++)
+			{
+				fprintf(ui_benchmark.report, ",%s", ui_profiler_pass_name((UI_PROFILER_PASS)i));
+			}
+			fprintf(ui_benchmark.report, "\n");
+		}
+	}
+
+	if (!ok)
+	{
+		fprintf(stderr, "[Benchmark] Line %d: can't execute '%s'\n", line_number, line);
+	}
+
+	return ok;
+}
+
+// run benchmark script
+bool ui_benchmark_run(const char * const script_filename)
+{
+	FILE * script = fopen(script_filename, "r");
+	if (!script)
+	{
+		fprintf(stderr, "[Benchmark] Couldn't open script '%s'\n", script_filename);
+		return false;
+	}
+
+	memset(&ui_benchmark, 0, sizeof(ui_benchmark));
+	if (!ui_benchmark_create_context())
+	{
+		fclose(script);
+		return false;
+	}
+
+	// we're the rendering thread now
+	bool ok = true;
+	char line[1024];
+	int line_number = 0;
+	while (ok && fgets(line, sizeof(line), script))
+	{
+		ok = ui_benchmark_command(line, ++line_number);
+	}
+
+	if (ui_benchmark.report) fclose(ui_benchmark.report);
+	fclose(script);
+	ui_benchmark_release_context();
+
+	return ok;
+}
@@ -0,0 +1,49 @@
+#ifndef __UI_BENCHMARK
+#define __UI_BENCHMARK
+
+#include "portability.h"
+#include "interface_opengl.h"
+#include "interface_opencv.h"
+#include "core_structures.h"
+#include "core_image_loader.h"
+#include "geometry_structures.h"
+#include "geometry_loader.h"
+#include "geometry_routines.h"
+#include "geometry_export.h"
+#include "geometry_queries.h"
+#include "gui.h"
+#include "ui_core.h"
+#include "ui_list.h"
+#include "ui_workflow.h"
+#include "ui_events.h"
+#include "ui_inspection_mode.h"
+#include "ui_shot_mode.h"
+#include "ui_visualization.h"
+#include "ui_profiler.h"
+
+// headless benchmark - renders frames described by a script on the main thread (no rendering
+// thread, no event handling), so that runs are repeatable; frames are drawn into an offscreen
+// OSMesa buffer when built with INSIGHT3D_OSMESA, otherwise into a plain SDL window
+//
+// script has one command per line ('#' starts a comment):
+//   size <width> <height>                   resize the framebuffer
+//   project <filename>                      load project (prints how long it took)
+//   save <filename>                         save project, binary if it ends with .i3db (prints how long it took)
+//   scene <shots> <vertices> <width> <height> <directory>
+//                                           generate synthetic scene, images of the shots are written into
+//                                           the directory (see scripts in benchmark/ for the usual sizes)
+//   mode overview|inspection|shot           switch application mode
+//   shot <id>                               select shot
+//   view <center x> <center y> <zoom>       place the image in shot mode
+//   camera <tx> <ty> <tz> <rx> <ry> <rz>    place the camera in inspection mode (euler angles)
+//   profiler on|off                         show or hide profiler overlay
+//   wait                                    render until all requested images are loaded
+//   frames <count>                          render frames
+//   capture <filename>                      render one more frame and save it as an image
+//   report <filename>                       write per-frame pass timings (csv) of subsequent frames
+//   pick <count>                            time point picking queries on current shot
+//
+// note requires initialization(true)
+bool ui_benchmark_run(const char * const script_filename);
+
+#endif
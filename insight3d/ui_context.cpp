@@ -41,6 +41,12 @@ void ui_context_display(double shot_x, double shot_y)
 		context_state.timer = 1;
 	}
 
+	// keep fading in 
+	if (context_state.timer < 1) 
+	{
+		gui_request_redraw();
+	}
+
 	const double animation_alpha = context_state.timer;
 
 	// convert shot coordinates to opengl 
@@ -7,7 +7,7 @@ bool ui_initialize()
 
 	// if we're on linux, we use gtk for dialogs (as every sane person should do)  
 #ifdef LINUX
-	gtk_init(NULL, NULL);
+	if (!core_state.headless) gtk_init(NULL, NULL);
 #endif
 
 	// set default application mode to "shot mode"
@@ -282,6 +282,7 @@ bool ui_create()
 		ui_create_main_window() && 
 		ui_create_menu() && 
 		ui_context_initialize() &&
+		ui_profiler_initialize() &&
 		ui_register_tools() &&
 		ui_done()
 	;
@@ -1,5 +1,128 @@
 #include "ui_epipolars.h"
 
+// fundamental matrix mapping points on another shot to lines on the target shot
+struct UI_Epipolars_Pair
+{
+	size_t shot_id;
+	double F[9];
+};
+
+// fundamental matrices from all shots of the calibration to the target shot, derived from
+// calibrated projection matrices and kept until the calibration changes
+static UI_Epipolars_Pair * ui_epipolars_pairs;
+static size_t ui_epipolars_pairs_count, ui_epipolars_pairs_allocated;
+static size_t * ui_epipolars_lookup; // shot id -> pair index + 1 (0 if the shot isn't calibrated)
+static size_t ui_epipolars_lookup_allocated;
+static size_t ui_epipolars_shot = SIZE_MAX, ui_epipolars_calibration = SIZE_MAX, ui_epipolars_version;
+
+// line endpoints of one batch
+static GLdouble * ui_epipolars_lines;
+static size_t ui_epipolars_lines_allocated;
+
+// determinant of 4x4 matrix given by rows
+static double ui_epipolars_det4(const double * r[4])
+{
+	double det = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		// expand along the first row
+		const int c0 = i == 0 ? 1 : 0, c1 = i <= 1 ? 2 : 1, c2 = i <= 2 ? 3 : 2;
+		const double minor =
+			r[1][c0] * (r[2][c1] * r[3][c2] - r[2][c2] * r[3][c1]) -
+			r[1][c1] * (r[2][c0] * r[3][c2] - r[2][c2] * r[3][c0]) +
+			r[1][c2] * (r[2][c0] * r[3][c1] - r[2][c1] * r[3][c0]);
+		det += (i % 2 ? -1 : 1) * r[0][i] * minor;
+	}
+
+	return det;
+}
+
+// fundamental matrix F such that x2^T F x1 = 0 for cameras A (x1) and B (x2), computed
+// from determinants of the stacked projection matrices (Hartley, Zisserman, 17.1.2)
+static void ui_epipolars_fundamental(const double A[12], const double B[12], double F[9])
+{
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			// rows of A without row i and rows of B without row j
+			const double * r[4];
+			int k = 0;
+			for (int a = 0; a < 3; a++) if (a != i) r[k++] = A + 4 * a;
+			for (int b = 0; b < 3; b++) if (b != j) r[k++] = B + 4 * b;
+
+			F[3 * j + i] = ((i + j) % 2 ? -1 : 1) * ui_epipolars_det4(r);
+		}
+	}
+}
+
+// copy projection matrix of calibration camera
+static void ui_epipolars_P(const CvMat * const P, double M[12])
+{
+	for (int i = 0; i < 12; i++)
+	{
+		M[i] = OPENCV_ELEM(P, i / 4, i % 4);
+	}
+}
+
+// recompute fundamental matrices if calibration changed
+static void ui_epipolars_update(const size_t shot_id, const size_t calibration_id, const size_t P_id)
+{
+	bool valid =
+		ui_epipolars_shot == shot_id &&
+		ui_epipolars_calibration == calibration_id &&
+		ui_epipolars_lookup_allocated >= shots.count &&
+		geometry_journal_complete(ui_epipolars_version)
+	;
+
+	size_t position = 0;
+	Geometry_Change change;
+	while (valid && geometry_journal_next(position, ui_epipolars_version, change))
+	{
+		if (change.kind == GEOMETRY_CHANGE_SHOTS) valid = false;
+		if (change.kind == GEOMETRY_CHANGE_CALIBRATIONS && change.from <= calibration_id && calibration_id < change.to) valid = false;
+	}
+
+	ui_epipolars_version = geometry_version();
+	if (valid) return;
+
+	// make room
+	const Calibration_Cameras * const cameras = &calibrations.data[calibration_id].Ps;
+	if (cameras->count > ui_epipolars_pairs_allocated)
+	{
+		ui_epipolars_pairs_allocated = cameras->count;
+		ui_epipolars_pairs = (UI_Epipolars_Pair *)realloc(ui_epipolars_pairs, ui_epipolars_pairs_allocated * sizeof(UI_Epipolars_Pair));
+	}
+
+	if (shots.count > ui_epipolars_lookup_allocated)
+	{
+		ui_epipolars_lookup_allocated = shots.count;
+		ui_epipolars_lookup = (size_t *)realloc(ui_epipolars_lookup, ui_epipolars_lookup_allocated * sizeof(size_t));
+	}
+
+	memset(ui_epipolars_lookup, 0, ui_epipolars_lookup_allocated * sizeof(size_t));
+	ui_epipolars_pairs_count = 0;
+
+	// pair target shot with every other calibrated shot
+	double B[12], A[12];
+	ui_epipolars_P(cameras->data[P_id].P, B);
+
+	for ALL(*cameras, i)
+	{
+		const Calibration_Camera * const camera = cameras->data + i;
+		if (i == P_id || !camera->P || camera->shot_id >= shots.count) continue;
+
+		UI_Epipolars_Pair * const pair = ui_epipolars_pairs + ui_epipolars_pairs_count;
+		pair->shot_id = camera->shot_id;
+		ui_epipolars_P(camera->P, A);
+		ui_epipolars_fundamental(A, B, pair->F);
+		ui_epipolars_lookup[camera->shot_id] = ++ui_epipolars_pairs_count;
+	}
+
+	ui_epipolars_shot = shot_id;
+	ui_epipolars_calibration = calibration_id;
+}
+
 // displays epipolars
 void ui_epipolars_display(const size_t shot_id, const size_t point_id)
 {
@@ -7,75 +130,84 @@ void ui_epipolars_display(const size_t shot_id, const size_t point_id)
 	ASSERT(validate_point(shot_id, point_id), "invalid point supplied");
 	Shot * const shot = shots.data + shot_id;
 	const size_t vertex_id = shot->points.data[point_id].vertex;
-	ASSERT_IS_SET(vertices_incidence, vertex_id);
+
+	// incidence is built only from time to time, points added since then don't have epipolars yet
+	if (!IS_SET(vertices_incidence, vertex_id)) return;
 	ASSERT(shots.data[shot_id].info_status >= GEOMETRY_INFO_DEDUCED, "image is displayed, but it's meta information wasn't stored");
 
-	// which calibration to use 
-	if (INDEX_IS_SET(ui_state.current_calibration))
+	// which calibration to use
+	if (!INDEX_IS_SET(ui_state.current_calibration)) return;
+
+	// find this shot in current calibration
+	size_t P_id;
+	if (!geometry_calibration_find_P(ui_state.current_calibration, shot_id, P_id)) return;
+	if (!calibrations.data[ui_state.current_calibration].Ps.data[P_id].P) return;
+
+	// * the shot is calibrated in this calibration, show epipolars *
+	ui_epipolars_update(shot_id, ui_state.current_calibration, P_id);
+
+	// every shot on which this vertex is marked gives one epipolar
+	const Double_Indices * const ids = &vertices_incidence.data[vertex_id].shot_point_ids;
+	if (6 * ids->count > ui_epipolars_lines_allocated)
 	{
-		// find this shot in current calibration 
-		Calibration_Cameras * cameras = &calibrations.data[ui_state.current_calibration].Ps;
-		bool found;
-		size_t camera_id;
-		LAMBDA_FIND(*cameras, camera_id, found, cameras->data[camera_id].shot_id == shot_id);
+		ui_epipolars_lines_allocated = 6 * ids->count;
+		ui_epipolars_lines = (GLdouble *)realloc(ui_epipolars_lines, ui_epipolars_lines_allocated * sizeof(GLdouble));
+	}
+
+	size_t count = 0;
+	for ALL(*ids, i)
+	{
+		const size_t first_shot_id = ids->data[i].primary;
+		if (first_shot_id == shot_id || first_shot_id >= ui_epipolars_lookup_allocated || !ui_epipolars_lookup[first_shot_id]) continue;
+		if (!validate_point(first_shot_id, ids->data[i].secondary)) continue;
+
+		// check if we know the size of this image
+		const Shot * const first_shot = shots.data + first_shot_id;
+		if (first_shot->info_status < GEOMETRY_INFO_DEDUCED) continue;
+
+		// epipolar of the correspondence (ax + by + c = 0)
+		const double * const F = ui_epipolars_pairs[ui_epipolars_lookup[first_shot_id] - 1].F;
+		const Point * const point = first_shot->points.data + ids->data[i].secondary;
+		const double x = point->x * first_shot->width, y = point->y * first_shot->height;
+		const double
+			a = F[0] * x + F[1] * y + F[2],
+			b = F[3] * x + F[4] * y + F[5],
+			c = F[6] * x + F[7] * y + F[8];
 
-		if (found)
+		// clip it by image borders (along the axis it's less steep in)
+		double x1, y1, x2, y2;
+		if (fabs(b) >= fabs(a))
 		{
-			// * the shot is calibrated in this calibration, show epipolars *
-			Calibration_Camera * camera = cameras->data + camera_id;
-
-			// consider every fundamental matrix
-			for ALL(camera->Fs, i)
-			{
-				Calibration_Fundamental_Matrix * fund = camera->Fs.data + i; 
-				const size_t first_shot_id = fund->first_shot_id;
-
-				// check if we know the size of this image 
-				if (shots.data[first_shot_id].info_status < GEOMETRY_INFO_DEDUCED) continue;
-
-				// check if this vertex is visible on this shot 
-				Double_Indices * ids = &vertices_incidence.data[vertex_id].shot_point_ids;
-				bool first_shot_found; 
-				size_t first_shot_iter; 
-				LAMBDA_FIND(*ids, first_shot_iter, first_shot_found, ids->data[first_shot_iter].primary == first_shot_id);
-
-				if (first_shot_found)
-				{
-					const size_t point_id = ids->data[first_shot_iter].secondary;
-
-					// fundamental matrix is estimated and correspondence was marked on this shot
-					double a, b, c;
-					double 
-						x = shots.data[first_shot_id].points.data[point_id].x * shots.data[first_shot_id].width,
-						y = shots.data[first_shot_id].points.data[point_id].y * shots.data[first_shot_id].height;
-
-					// calculate epipolar 
-					opencv_epipolar(fund->F, x, y, a, b, c);
-
-					// dipslay epipolar 
-					if (b != 0) 
-					{
-						double x1 = 0, x2 = shots.data[first_shot_id].width;
-						double y1 = (-a * x1 - c) / b, y2 = (-a * x2 - c) / b;
-						x1 /= shots.data[first_shot_id].width; 
-						x2 /= shots.data[first_shot_id].width; 
-						y1 /= shots.data[first_shot_id].height;
-						y2 /= shots.data[first_shot_id].height;
-
-						ui_convert_xy_from_shot_to_opengl(x1, y1, x1, y1); 
-						ui_convert_xy_from_shot_to_opengl(x2, y2, x2, y2); 
-
-						LOCK_RW(opengl)
-						{
-							glBegin(GL_LINES);
-								glVertex3d(x1, y1, -1); 
-								glVertex3d(x2, y2, -1);
-							glEnd();
-						}
-						UNLOCK_RW(opengl);
-					}
-				}
-			}
+			if (b == 0) continue;
+			x1 = 0;
+			x2 = shot->width;
+			y1 = (-a * x1 - c) / b;
+			y2 = (-a * x2 - c) / b;
 		}
+		else
+		{
+			y1 = 0;
+			y2 = shot->height;
+			x1 = (-b * y1 - c) / a;
+			x2 = (-b * y2 - c) / a;
+		}
+
+		GLdouble * const line = ui_epipolars_lines + 6 * count++;
+		ui_convert_xy_from_shot_to_opengl(x1 / shot->width, y1 / shot->height, line[0], line[1]);
+		ui_convert_xy_from_shot_to_opengl(x2 / shot->width, y2 / shot->height, line[3], line[4]);
+		line[2] = line[5] = -1;
+	}
+
+	if (!count) return;
+
+	// draw them all at once
+	LOCK_RW(opengl)
+	{
+		glColor4d(1, 1, 0, 0.6);
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glVertexPointer(3, GL_DOUBLE, 0, ui_epipolars_lines);
+		glDrawArrays(GL_LINES, 0, (GLsizei)(2 * count));
+		glDisableClientState(GL_VERTEX_ARRAY);
 	}
+	UNLOCK_RW(opengl);
 }
@@ -1,23 +1,40 @@
 #include "ui_events.h"
 
+// how long is the rendering thread willing to wait for geometry (milliseconds)
+static const Uint32 UI_EVENT_GEOMETRY_WAIT = 100;
+
+// try to lock geometry for a while; long running actions hold it and we don't want to freeze the whole gui 
+// obtains LOCK(geometry) if it returns true
+static bool ui_event_lock_geometry()
+{
+	const Uint32 start = SDL_GetTicks();
+	while (!TRYLOCK(geometry)) 
+	{
+		if (SDL_GetTicks() - start > UI_EVENT_GEOMETRY_WAIT) return false;
+		SDL_Delay(1);
+	}
+
+	return true;
+}
+
 // call visualization routines compatible with current application mode
 void ui_event_redraw()
 {
 	static double angle = 0; // debug
 	static int frame_count = 0;
 	frame_count++;
+	ui_profiler_begin(UI_PROFILER_SCENE);
 
 	// OpenGL settings 
 	ATOMIC(opengl, opengl_push_attribs(); );
 
-	// if (pthread_mutex_trylock(&geometry_mutex) == 0)
 	{
 		LOCK(tools);
+		const bool progressbar = tools_state.progressbar_show;
+		UNLOCK(tools);
 
-		if (tools_state.progressbar_show == false) 
+		if (!progressbar && ui_event_lock_geometry()) 
 		{
-			UNLOCK(tools);
-			LOCK(geometry);
 			LOCK(opengl);
 
 			// which mode we're in? 
@@ -40,11 +57,20 @@ void ui_event_redraw()
 					UNLOCK(opengl);
 
 					// visualize data
+					ui_profiler_begin(UI_PROFILER_CAMERAS);
 					visualization_cameras(shots, 0.5); 
+					ui_profiler_end(UI_PROFILER_CAMERAS);
+					ui_profiler_begin(UI_PROFILER_VERTICES);
 					visualization_vertices(vertices, 0.5);
+					ui_profiler_end(UI_PROFILER_VERTICES);
+					ui_profiler_begin(UI_PROFILER_POLYGONS);
 					visualization_polygons(polygons, 0.5);
+					ui_profiler_end(UI_PROFILER_POLYGONS);
 					visualization_helper_cube();
 
+					// keep spinning
+					gui_request_redraw();
+
 				break; 
 
 				// inspection mode
@@ -56,11 +82,20 @@ void ui_event_redraw()
 					// place user camera
 					visualization_inspection_user_camera();
 
+					// cull large scenes against the view
+					ui_profiler_begin(UI_PROFILER_VERTICES);
+					visualization_octree_cull(vertices);
+
 					// visualize data
-					visualization_vertices(vertices);
-					visualization_cameras(shots);
+					visualization_vertices(vertices, 1, true);
+					ui_profiler_end(UI_PROFILER_VERTICES);
+					ui_profiler_begin(UI_PROFILER_CAMERAS);
+					visualization_cameras(shots, 1, true);
+					ui_profiler_end(UI_PROFILER_CAMERAS);
 					// visualization_contours(shots, vertices); // specific (more or less)
-					visualization_polygons(polygons);
+					ui_profiler_begin(UI_PROFILER_POLYGONS);
+					visualization_polygons(polygons, 1, true);
+					ui_profiler_end(UI_PROFILER_POLYGONS);
 
 				break;
 
@@ -84,6 +119,7 @@ void ui_event_redraw()
 						);
 					}
 
+					ui_profiler_begin(UI_PROFILER_SHOT_IMAGE);
 					UNLOCK(opengl)
 					{
 						image_loader_upload_to_opengl(shots.data[ui_state.current_shot].image_loader_request);
@@ -100,7 +136,10 @@ void ui_event_redraw()
 						visualization_shot_image(shots.data[ui_state.current_shot]);
 					}
 					LOCK(opengl); 
+					ui_profiler_end(UI_PROFILER_SHOT_IMAGE);
+					ui_profiler_begin(UI_PROFILER_POLYGONS);
 					visualization_shot_polygons(ui_state.current_shot);
+					ui_profiler_end(UI_PROFILER_POLYGONS);
 
 					// if meta info about this image is loaded and display widget has positive size, we can display geometry 
 					if (shots.data[ui_state.current_shot].info_status >= GEOMETRY_INFO_DEDUCED && gui_get_width(ui_state.gl) > 0 && gui_get_height(ui_state.gl) > 0)
@@ -163,12 +202,16 @@ void ui_event_redraw()
 						// visualization_shot_polygons(ui_state.current_shot);
 						if (!dualview_displayed) 
 						{
+							ui_profiler_begin(UI_PROFILER_POINTS);
 							visualization_shot_points(); // note this function can render only current shot, because other shots have undefined focused point and selected points...
-							/*if (INDEX_IS_SET(ui_state.focused_point))
+							if (INDEX_IS_SET(ui_state.focused_point))
 							{
 								ui_epipolars_display(ui_state.current_shot, ui_state.focused_point);
-							}*/
+							}
+							ui_profiler_end(UI_PROFILER_POINTS);
+							ui_profiler_begin(UI_PROFILER_CONTEXT);
 							if (ui_state.mouse_over) ui_context_display(ui_state.tool_x, ui_state.tool_y);
+							ui_profiler_end(UI_PROFILER_CONTEXT);
 						}
 					}
 					else
@@ -219,7 +262,10 @@ void ui_event_redraw()
 		}
 		else
 		{
+			// either the action shows progress or it's holding geometry for too long (then we only show it's busy)
+			LOCK(tools);
 			LOCK(opengl); 
+			const double percentage = progressbar ? tools_state.progressbar_percentage : 0;
 
 			glBegin(GL_POLYGON);
 				glColor3f(0.2, 0.2, 0.2);
@@ -236,12 +282,15 @@ void ui_event_redraw()
 				glColor3f(0.4 + opacity, 0.4 + opacity, 0.4 + opacity);
 				glVertex3f(-0.3 + border, 0.07 - border, 0);
 				glVertex3f(-0.3 + border, -0.07 + border, 0);
-				glVertex3f(-0.3 + tools_state.progressbar_percentage * (0.6 - 3 * border) + 2 * border, -0.07 + border, 0);
-				glVertex3f(-0.3 + tools_state.progressbar_percentage * (0.6 - 3 * border) + 2 * border, 0.07 - border, 0);
+				glVertex3f(-0.3 + percentage * (0.6 - 3 * border) + 2 * border, -0.07 + border, 0);
+				glVertex3f(-0.3 + percentage * (0.6 - 3 * border) + 2 * border, 0.07 - border, 0);
 			glEnd();
 
 			UNLOCK(opengl);
 			UNLOCK(tools);
+
+			// keep pulsing (and check again if the action is done)
+			gui_request_redraw();
 		}
 
 		// restore OpenGL settings
@@ -249,6 +298,8 @@ void ui_event_redraw()
 
 		UNLOCK(opengl);
 	}
+
+	ui_profiler_end(UI_PROFILER_SCENE);
 }
 
 // dispatch mouse button down events
@@ -593,6 +644,9 @@ void ui_event_update_shot(const Uint32 delta_time)
 void ui_event_resize()
 {
 	image_loader_flush_texture_ids();
+	visualization_cloud_flush();
+	visualization_atlas_flush();
+	ui_profiler_flush();
  
 	if (ui_state.mode == UI_MODE_SHOT && INDEX_IS_SET(ui_state.current_shot))
 	{
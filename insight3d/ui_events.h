@@ -12,6 +12,10 @@
 #include "ui_visualization_helpers.h"
 #include "ui_visualization_point.h"
 #include "ui_visualization.h"
+#include "ui_visualization_cloud.h"
+#include "ui_visualization_octree.h"
+#include "ui_visualization_atlas.h"
+#include "ui_profiler.h"
 #include "ui_selection.h"
 #include "ui_list.h"
 #include "ui_epipolars.h"
@@ -0,0 +1,242 @@
+#include "ui_profiler.h"
+
+#ifdef LINUX
+#include <sys/time.h>
+#endif
+
+// weight of the last frame in running averages
+static const double UI_PROFILER_SMOOTHING = 0.05;
+
+// overlay text is re-rendered at most this often (milliseconds)
+static const double UI_PROFILER_OVERLAY_REFRESH = 250;
+static const int UI_PROFILER_LINE_HEIGHT = 14, UI_PROFILER_TEXT_WIDTH = 128, UI_PROFILER_BAR_SCALE = 8; // pixels per millisecond
+
+static const char * const ui_profiler_pass_names[UI_PROFILER_PASSES_COUNT] = { 
+	"frame", "gui", "scene", "shot image", "points", "polygons", "vertices", "cameras", "context popup"
+};
+
+// bar colors 
+static const float ui_profiler_colors[UI_PROFILER_PASSES_COUNT][3] = { 
+	{ 0.9f, 0.9f, 0.9f }, { 0.5f, 0.5f, 0.9f }, { 0.9f, 0.6f, 0.3f }, { 0.3f, 0.8f, 0.3f }, { 0.9f, 0.3f, 0.3f }, 
+	{ 0.8f, 0.8f, 0.3f }, { 0.3f, 0.8f, 0.8f }, { 0.8f, 0.3f, 0.8f }, { 0.6f, 0.6f, 0.6f }
+};
+
+// profiler state (touched only by the rendering thread)
+struct UI_Profiler
+{
+	bool visible;
+	double started[UI_PROFILER_PASSES_COUNT];    // time the pass was entered
+	double current[UI_PROFILER_PASSES_COUNT];    // time spent in the pass during current frame
+	double average[UI_PROFILER_PASSES_COUNT];
+	double frame_start, last_frame_start, frame_interval; 
+
+	// overlay 
+	IplImage * text_image; 
+	GLuint text_texture;
+	double text_time;
+};
+
+static UI_Profiler ui_profiler;
+
+// high resolution time (in milliseconds)
+double ui_profiler_time()
+{
+#ifdef LINUX
+	timeval t;
+	gettimeofday(&t, NULL);
+	return 1000.0 * t.tv_sec + t.tv_usec / 1000.0;
+#else
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return 1000.0 * counter.QuadPart / (double)frequency.QuadPart;
+#endif
+}
+
+// measure time spent in a pass 
+void ui_profiler_begin(const UI_PROFILER_PASS pass)
+{
+	ui_profiler.started[pass] = ui_profiler_time();
+}
+
+void ui_profiler_end(const UI_PROFILER_PASS pass)
+{
+	ui_profiler.current[pass] += ui_profiler_time() - ui_profiler.started[pass];
+}
+
+// average time spent in pass per frame
+double ui_profiler_average(const UI_PROFILER_PASS pass)
+{
+	return ui_profiler.average[pass];
+}
+
+// time spent in pass during the last drawn frame (kept until the next frame begins)
+double ui_profiler_last(const UI_PROFILER_PASS pass)
+{
+	return ui_profiler.current[pass];
+}
+
+// human readable name of the pass 
+const char * ui_profiler_pass_name(const UI_PROFILER_PASS pass)
+{
+	return ui_profiler_pass_names[pass];
+}
+
+// frame is about to be drawn
+static void ui_profiler_frame_begin()
+{
+	memset(ui_profiler.current, 0, sizeof(ui_profiler.current));
+
+	ui_profiler.frame_start = ui_profiler_time();
+	if (ui_profiler.last_frame_start > 0) 
+	{
+		const double interval = ui_profiler.frame_start - ui_profiler.last_frame_start;
+		ui_profiler.frame_interval += UI_PROFILER_SMOOTHING * (interval - ui_profiler.frame_interval);
+	}
+	ui_profiler.last_frame_start = ui_profiler.frame_start;
+}
+
+// render overlay text into texture 
+// expects LOCK(opengl)
+static void ui_profiler_render_text()
+{
+	const int height = UI_PROFILER_LINE_HEIGHT * (UI_PROFILER_PASSES_COUNT + 1);
+	if (!ui_profiler.text_image) 
+	{
+		ui_profiler.text_image = cvCreateImage(cvSize(UI_PROFILER_TEXT_WIDTH, height), IPL_DEPTH_8U, 1);
+	}
+
+	cvZero(ui_profiler.text_image);
+	char line[64];
+	for (int i = 0; i < UI_PROFILER_PASSES_COUNT; i++)
+	{
+		sprintf(line, "%s %.2f ms", ui_profiler_pass_names[i], ui_profiler.average[i]);
+		cvPutText(ui_profiler.text_image, line, cvPoint(2, UI_PROFILER_LINE_HEIGHT * (i + 1) - 3), &gui_context.font, cvScalar(255, 255, 255));
+	}
+
+	sprintf(line, "%.1f fps", ui_profiler.frame_interval > 0 ? 1000.0 / ui_profiler.frame_interval : 0.0);
+	cvPutText(ui_profiler.text_image, line, cvPoint(2, UI_PROFILER_LINE_HEIGHT * (UI_PROFILER_PASSES_COUNT + 1) - 3), &gui_context.font, cvScalar(255, 255, 255));
+
+	if (!ui_profiler.text_texture) 
+	{
+		ui_profiler.text_texture = gui_upload_opengl_texture(ui_profiler.text_image);
+	}
+	else
+	{
+		glBindTexture(GL_TEXTURE_2D, ui_profiler.text_texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, UI_PROFILER_TEXT_WIDTH, height, GL_ALPHA, GL_UNSIGNED_BYTE, ui_profiler.text_image->imageData);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+}
+
+// draw overlay with frame times over the glview
+// expects LOCK(opengl)
+static void ui_profiler_overlay()
+{
+	const int 
+		x = ui_state.gl->effective_x1 + 10, 
+		y = ui_state.gl->effective_y1 + 10, 
+		height = UI_PROFILER_LINE_HEIGHT * (UI_PROFILER_PASSES_COUNT + 1)
+	;
+
+	glPushAttrib(GL_ALL_ATTRIB_BITS);
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_TEXTURE_2D);
+
+	// refresh text now and then 
+	const double now = ui_profiler_time();
+	if (!ui_profiler.text_texture || now - ui_profiler.text_time > UI_PROFILER_OVERLAY_REFRESH) 
+	{
+		ui_profiler_render_text();
+		ui_profiler.text_time = now;
+	}
+
+	// background
+	glDisable(GL_TEXTURE_2D);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glColor4f(0, 0, 0, 0.6f);
+	glBegin(GL_POLYGON);
+		gui_opengl_vertex(x - 4, y - 4);
+		gui_opengl_vertex(x + UI_PROFILER_TEXT_WIDTH + 200, y - 4);
+		gui_opengl_vertex(x + UI_PROFILER_TEXT_WIDTH + 200, y + height + 4);
+		gui_opengl_vertex(x - 4, y + height + 4);
+	glEnd();
+
+	// bars 
+	for (int i = 0; i < UI_PROFILER_PASSES_COUNT; i++) 
+	{
+		double width = UI_PROFILER_BAR_SCALE * ui_profiler.average[i];
+		if (width > 200) width = 200;
+
+		const double bar_x = x + UI_PROFILER_TEXT_WIDTH, bar_y = y + UI_PROFILER_LINE_HEIGHT * i + 3;
+		glColor4f(ui_profiler_colors[i][0], ui_profiler_colors[i][1], ui_profiler_colors[i][2], 0.8f);
+		glBegin(GL_POLYGON);
+			gui_opengl_vertex(bar_x, bar_y);
+			gui_opengl_vertex(bar_x + width, bar_y);
+			gui_opengl_vertex(bar_x + width, bar_y + UI_PROFILER_LINE_HEIGHT - 4);
+			gui_opengl_vertex(bar_x, bar_y + UI_PROFILER_LINE_HEIGHT - 4);
+		glEnd();
+	}
+
+	// text
+	glEnable(GL_TEXTURE_2D);
+	gui_opengl_display_text(ui_profiler.text_texture, UI_PROFILER_TEXT_WIDTH, height, UI_PROFILER_TEXT_WIDTH, height, x, y, 1);
+
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glPopAttrib();
+}
+
+// frame was drawn (buffers aren't swapped yet)
+static void ui_profiler_frame_end()
+{
+	ui_profiler.current[UI_PROFILER_FRAME] = ui_profiler_time() - ui_profiler.frame_start;
+	ui_profiler.current[UI_PROFILER_GUI] = ui_profiler.current[UI_PROFILER_FRAME] - ui_profiler.current[UI_PROFILER_SCENE];
+
+	for (int i = 0; i < UI_PROFILER_PASSES_COUNT; i++) 
+	{
+		ui_profiler.average[i] += UI_PROFILER_SMOOTHING * (ui_profiler.current[i] - ui_profiler.average[i]);
+	}
+
+	if (ui_profiler.visible) 
+	{
+		ATOMIC(opengl, ui_profiler_overlay(); );
+	}
+}
+
+// register frame callbacks with gui 
+bool ui_profiler_initialize()
+{
+	memset(&ui_profiler, 0, sizeof(ui_profiler));
+	gui_set_frame_callbacks(ui_profiler_frame_begin, ui_profiler_frame_end);
+	return true;
+}
+
+// show or hide overlay with frame times
+void ui_profiler_toggle()
+{
+	ui_profiler.visible = !ui_profiler.visible;
+	gui_request_redraw();
+}
+
+void ui_profiler_set_visible(const bool visible)
+{
+	ui_profiler.visible = visible;
+	gui_request_redraw();
+}
+
+// forget overlay texture
+void ui_profiler_flush()
+{
+	ui_profiler.text_texture = 0;
+}
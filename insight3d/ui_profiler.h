@@ -0,0 +1,47 @@
+#ifndef __UI_PROFILER
+#define __UI_PROFILER
+
+#include "portability.h"
+#include "interface_opengl.h"
+#include "interface_opencv.h"
+#include "core_structures.h"
+#include "gui.h"
+#include "ui_state.h"
+
+// passes of a frame the profiler keeps track of 
+// (gui time is everything spent in the frame outside of the scene)
+enum UI_PROFILER_PASS 
+{ 
+	UI_PROFILER_FRAME, UI_PROFILER_GUI, UI_PROFILER_SCENE, UI_PROFILER_SHOT_IMAGE, UI_PROFILER_POINTS, 
+	UI_PROFILER_POLYGONS, UI_PROFILER_VERTICES, UI_PROFILER_CAMERAS, UI_PROFILER_CONTEXT, 
+	UI_PROFILER_PASSES_COUNT
+};
+
+// register frame callbacks with gui 
+bool ui_profiler_initialize();
+
+// high resolution time (in milliseconds)
+double ui_profiler_time();
+
+// measure time spent in a pass (during one frame, a pass can be entered several times) 
+// note must be called by the rendering thread
+void ui_profiler_begin(const UI_PROFILER_PASS pass);
+void ui_profiler_end(const UI_PROFILER_PASS pass);
+
+// average time spent in pass per frame (in milliseconds)
+double ui_profiler_average(const UI_PROFILER_PASS pass);
+
+// time spent in pass during the last drawn frame (in milliseconds)
+double ui_profiler_last(const UI_PROFILER_PASS pass);
+
+// human readable name of the pass 
+const char * ui_profiler_pass_name(const UI_PROFILER_PASS pass);
+
+// show or hide overlay with frame times
+void ui_profiler_toggle();
+void ui_profiler_set_visible(const bool visible);
+
+// forget overlay texture (it's lost together with opengl context)
+void ui_profiler_flush();
+
+#endif
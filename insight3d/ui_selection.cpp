@@ -74,11 +74,13 @@ void ui_empty_selection_list()
 				ASSERT_IS_SET(shots, selected_item->shot_id);
 				ASSERT_IS_SET(shots.data[selected_item->shot_id].points, selected_item->item_id);
 				shots.data[selected_item->shot_id].points.data[selected_item->item_id].selected = false; 
+				geometry_point_changed(selected_item->shot_id, selected_item->item_id);
 				break; 
 			case GEOMETRY_VERTEX:
 				// mark vertex as not selected
 				ASSERT_IS_SET(vertices, selected_item->item_id);
 				vertices.data[selected_item->item_id].selected = false; 
+				geometry_vertex_changed(selected_item->item_id);
 				break; 
 		}
 	}
@@ -98,6 +100,7 @@ bool ui_add_vertex_to_selection(const size_t vertex_id)
 	LAST(ui_state.selection_list).item_id = vertex_id; 
 	LAST(ui_state.selection_list).item_type = GEOMETRY_VERTEX;
 	vertices.data[vertex_id].selected = true; 
+	geometry_vertex_changed(vertex_id);
 	return true; // todo true only if the addition succeeded 
 }
 
@@ -114,6 +117,7 @@ void ui_remove_vertex_from_selection(const size_t selection_id)
 	// remove vertex
 	ui_state.selection_list.data[selection_id].set = false; 
 	vertices.data[vertex_id].selected = false;
+	geometry_vertex_changed(vertex_id);
 }
 
 // add point to selection box 
@@ -133,6 +137,7 @@ bool ui_add_point_to_selection(const size_t shot_id, const size_t point_id)
 	LAST(ui_state.selection_list).item_id = point_id;
 	LAST(ui_state.selection_list).item_type = GEOMETRY_POINT;
 	shots.data[shot_id].points.data[point_id].selected = true;
+	geometry_point_changed(shot_id, point_id);
 	return true; // todo true only if the addition succeeded 
 }
 
@@ -151,6 +156,7 @@ void ui_remove_point_from_selection(const size_t selection_id)
 	// remove point 
 	ui_state.selection_list.data[selection_id].set = false;
 	shots.data[shot_id].points.data[point_id].selected = false;
+	geometry_point_changed(shot_id, point_id);
 }
 
 // select all points on shot 
@@ -334,6 +340,7 @@ void ui_3d_selection_box(double x1, double y1, double x2, double y2, Selection_T
 				if (operation == SELECTION_TYPE_INTERSECTION) 
 				{
 					vertex->selected = false;
+					geometry_vertex_changed(i);
 				}
 
 				continue;
@@ -374,6 +381,7 @@ void ui_3d_selection_box(double x1, double y1, double x2, double y2, Selection_T
 			{
 				// finally remove the 'selected flag' when selecting subset of previous selection 
 				vertex->selected = false;
+				geometry_vertex_changed(i);
 			}
 		}
 	}
@@ -432,9 +440,24 @@ void ui_2d_selection_box(double x1, double y1, double x2, double y2, Selection_T
 	ui_convert_xy_from_screen_to_shot(ui_state.mouse_x, ui_state.mouse_y, x2, y2); 
 
 	// add points to selection
-	// if (operation != SELECTION_TYPE_REMOVE)
+	ASSERT_IS_SET(shots, ui_state.current_shot);
+	if (operation != SELECTION_TYPE_INTERSECTION) 
+	{
+		// only points inside the box are affected, ask the grid index for them 
+		size_t count;
+		const size_t * const ids = query_points_in_rectangle(ui_state.current_shot, x1, y1, x2, y2, count, option_hide_automatic);
+
+		for (size_t j = 0; j < count; j++) 
+		{
+			const size_t i = ids[j];
+			if (operation == SELECTION_TYPE_REPLACEMENT || !shots.data[ui_state.current_shot].points.data[i].selected) 
+			{
+				ui_add_point_to_selection(ui_state.current_shot, i); 
+			}
+		}
+	}
+	else
 	{
-		ASSERT_IS_SET(shots, ui_state.current_shot);
 		for ALL(shots.data[ui_state.current_shot].points, i) 
 		{
 			Point * point = shots.data[ui_state.current_shot].points.data + i; 
@@ -449,31 +472,17 @@ void ui_2d_selection_box(double x1, double y1, double x2, double y2, Selection_T
 				&& (!option_hide_automatic || vertices.data[shots.data[ui_state.current_shot].points.data[i].vertex].vertex_type != GEOMETRY_VERTEX_AUTO)
 			)
 			{
-				switch (operation) 
+				if (point->selected) 
 				{
-					case SELECTION_TYPE_REPLACEMENT: 
-						ui_add_point_to_selection(ui_state.current_shot, i); 
-						break; 
-
-					case SELECTION_TYPE_UNION: 
-						if (!point->selected) 
-						{
-							ui_add_point_to_selection(ui_state.current_shot, i); 
-						}
-						break; 
-
-					case SELECTION_TYPE_INTERSECTION: 
-						if (point->selected) 
-						{
-							point->selected = false; // just to keep application invariant intact
-							ui_add_point_to_selection(ui_state.current_shot, i);
-						}
+					point->selected = false; // just to keep application invariant intact
+					ui_add_point_to_selection(ui_state.current_shot, i);
 				}
 			}
-			else if (operation == SELECTION_TYPE_INTERSECTION)
+			else
 			{
 				// finally remove the 'selected flag' when selecting subset of previous selection 
 				point->selected = false;
+				geometry_point_changed(ui_state.current_shot, i);
 			}
 		}
 	}
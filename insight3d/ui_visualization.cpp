@@ -1,4 +1,7 @@
 #include "ui_visualization.h"
+#include "ui_visualization_cloud.h"
+#include "ui_visualization_octree.h"
+#include "ui_visualization_atlas.h"
 
 Visualization_State visualization_state; 
 
@@ -485,7 +488,7 @@ void visualization_selection_box(double x1, double y1, double x2, double y2)
 
 // displays camera centers as points in normalized space
 // conditions: visualization_process_data has to be run before the first time calling this function on modified (or newly constructed) data
-void visualization_cameras(const Shots shots, const double world_scale /*= 1*/)
+void visualization_cameras(const Shots shots, const double world_scale /*= 1*/, const bool cull /*= false*/)
 {
 	LOCK(opengl)
 	{
@@ -503,6 +506,29 @@ void visualization_cameras(const Shots shots, const double world_scale /*= 1*/)
 
 				if (!nearly_zero(shots.data[i].T[W]))
 				{
+					// skip cameras whose pyramid lies outside of the view
+					if (cull) 
+					{
+						const double * const corners[4] = { 
+							shots.data[i].visualization_pyr_00, shots.data[i].visualization_pyr_01, 
+							shots.data[i].visualization_pyr_10, shots.data[i].visualization_pyr_11
+						};
+
+						double min[3], max[3]; 
+						for (int k = 0; k < 3; k++) 
+						{
+							min[k] = max[k] = visualization_normalize(shots.data[i].visualization_T[k], (Core_Axes)k);
+							for (int c = 0; c < 4; c++) 
+							{
+								const double value = visualization_normalize(shots.data[i].visualization_T[k] + camera_size * corners[c][k], (Core_Axes)k);
+								if (value < min[k]) min[k] = value; 
+								if (value > max[k]) max[k] = value;
+							}
+						}
+
+						if (!visualization_octree_box_visible(min, max)) continue;
+					}
+
 					if (!current) glColor3f(0.9, 0.9, 0.9); else glColor3f(0.9, 0.45, 0.45);
 					glBegin(GL_POLYGON);
 					
@@ -636,245 +662,46 @@ void visualization_cameras(const Shots shots, const double world_scale /*= 1*/)
 }
 
 // display vertices using normalization from visualization_state
-void visualization_vertices(const Vertices & vertices, double world_scale /*= 1*/)
-{
-	LOCK(opengl)
-	{
-		opengl_drawing_style(UI_STYLE_VERTEX);
-
-		glDisable(GL_BLEND);
-		glBegin(GL_POINTS);
-
-		// go through all vertices
-		for ALL(vertices, i)
-		{
-			// process only reconstructed vertices
-			if (!vertices.data[i].reconstructed) continue;
-
-			// don't display hidden vertices
-			if (vertices.data[i].group)
-			{
-				ASSERT_IS_SET(ui_state.groups, vertices.data[i].group);
-				if (ui_state.groups.data[vertices.data[i].group].hidden) continue;
-			}
-		
-			// optionally skip generated vertices 
-			if (option_hide_automatic && vertices.data[i].vertex_type == GEOMETRY_VERTEX_AUTO) continue;
-
-			// pick appropriate style 
-			if (!vertices.data[i].selected)
-			{
-				opengl_drawing_style(UI_STYLE_VERTEX);
-
-				if (vertices.data[i].color[0] > 0 || vertices.data[i].color[1] > 0 || vertices.data[i].color[2] > 0)
-				{
-					glColor4f(vertices.data[i].color[0], vertices.data[i].color[1], vertices.data[i].color[2], 1);
-				}
-				else if (vertices.data[i].group)
-				{
-					if (vertices.data[i].group == 1) 
-					{
-						glColor3d(0.52, 0.83, 0.52);
-					}
-				}
-			}
-			else
-			{
-				opengl_drawing_style(UI_STYLE_SELECTED_VERTEX);
-			}
-
-			// display them in normalized space
-			glVertex3d(
-				world_scale * visualization_normalize(vertices.data[i].x, X),
-				world_scale * visualization_normalize(vertices.data[i].y, Y),
-				world_scale * visualization_normalize(vertices.data[i].z, Z)
-			);
-		}
-
-		glEnd(); 
-
-		const double normal_len = 0.1;
-
-		// glColor4f(1, 1, 1, 0.3);
-		glBegin(GL_LINES);
-
-		// go through all vertices
-		for ALL(vertices, i)
-		{
-			// process only reconstructed vertices
-			if (!vertices.data[i].reconstructed) continue;
-
-			// don't display hidden vertices
-			if (vertices.data[i].group)
-			{
-				ASSERT_IS_SET(ui_state.groups, vertices.data[i].group);
-				if (ui_state.groups.data[vertices.data[i].group].hidden) continue;
-			}
-		
-			// optionally skip generated vertices 
-			if (option_hide_automatic && vertices.data[i].vertex_type == GEOMETRY_VERTEX_AUTO) continue;
-
-			// pick appropriate style 
-			if (!vertices.data[i].selected)
-			{
-				opengl_drawing_style(UI_STYLE_VERTEX);
-
-				if (vertices.data[i].color[0] > 0 || vertices.data[i].color[1] > 0 || vertices.data[i].color[2] > 0)
-				{
-					glColor4f(vertices.data[i].color[0], vertices.data[i].color[1], vertices.data[i].color[2], 1.0);
-				}
-				else if (vertices.data[i].group)
-				{
-					if (vertices.data[i].group == 1) // debug ?
-					{
-						glColor3d(0.52, 0.83, 0.52);
-					}
-				}
-			}
-			else
-			{
-				opengl_drawing_style(UI_STYLE_SELECTED_VERTEX);
-			}
-
-			// * display the direction of the normal *
-
-			glVertex3d(
-				world_scale * (visualization_normalize(vertices.data[i].x, X) + normal_len * vertices.data[i].nx),
-				world_scale * (visualization_normalize(vertices.data[i].y, Y) + normal_len * vertices.data[i].ny),
-				world_scale * (visualization_normalize(vertices.data[i].z, Z) + normal_len * vertices.data[i].nz)
-			);
-
-			glVertex3d(
-				world_scale * visualization_normalize(vertices.data[i].x, X), 
-				world_scale * visualization_normalize(vertices.data[i].y, Y),
-				world_scale * visualization_normalize(vertices.data[i].z, Z)
-			);
-		}
-
-		glEnd();
-
-		// go through all detected edges 
-		/*glLineWidth(1.0);
-		glBegin(GL_LINES);
-		glColor3d(1, 1, 1);
-		for (std::map<int, std::map<int, unsigned int> >::iterator edge_i1 = detected_edges.begin(); edge_i1 != detected_edges.end(); ++edge_i1)
-		{
-			for (std::map<int, unsigned int>::iterator edge_i2 = edge_i1->second.begin(); edge_i2 != edge_i1->second.end(); ++edge_i2) 
-			{
-				if (edge_i2->second >= 1)
-				{
-					size_t 
-						e1 = edge_i1->first,
-						e2 = edge_i2->first
-					;
-
-					glVertex3d(
-						world_scale * visualization_normalize(vertices.data[e1].x, X), 
-						world_scale * visualization_normalize(vertices.data[e1].y, Y), 
-						world_scale * visualization_normalize(vertices.data[e1].z, Z)
-					);
-
-					glVertex3d(
-						world_scale * visualization_normalize(vertices.data[e2].x, X),
-						world_scale * visualization_normalize(vertices.data[e2].y, Y), 
-						world_scale * visualization_normalize(vertices.data[e2].z, Z)
-					);
-				}
-			}
-		}
-		glEnd();*/
-	}
-	UNLOCK(opengl);
-}
-
-// display reconstructed polygons 
-void visualization_polygons(const Polygons_3d & polygons, const double world_scale /*= 1*/)
+void visualization_vertices(const Vertices & vertices, double world_scale /*= 1*/, const bool cull /*= false*/)
 {
-	// set drawing style
-	ATOMIC(opengl, opengl_drawing_style(UI_STYLE_POLYGON); );
+	visualization_cloud(vertices, world_scale, cull);
 
-	// go through all polygons 
-	for ALL(polygons, i) 
+	// go through all detected edges 
+	/*glLineWidth(1.0);
+	glBegin(GL_LINES);
+	glColor3d(1, 1, 1);
+	for (std::map<int, std::map<int, unsigned int> >::iterator edge_i1 = detected_edges.begin(); edge_i1 != detected_edges.end(); ++edge_i1)
 	{
-		const Polygon_3d * const polygon = polygons.data + i; 
-
-		// draw only reconstruted polygons
-		if (!query_is_polygon_reconstructed(*polygon, vertices)) continue;
-
-		// check if we have texture for this polygon 
-		bool texture_ready = false; 
-		GLuint texture_id;
-		double tx, ty, sx, sy;
-		if (image_loader_nonempty_handle(polygon->image_loader_request))
-		{
-			image_loader_upload_to_opengl(polygon->image_loader_request);
-			texture_ready = image_loader_opengl_upload_ready(polygon->image_loader_request, &texture_id, &tx, &ty, &sx, &sy);
-		}
-		
-		// prepare texture mapping
-		LOCK(opengl)
+		for (std::map<int, unsigned int>::iterator edge_i2 = edge_i1->second.begin(); edge_i2 != edge_i1->second.end(); ++edge_i2) 
 		{
-			if (texture_ready) 
-			{
-				glBindTexture(GL_TEXTURE_2D, texture_id);
-				glBegin(GL_POLYGON);
-			}
-			else
-			{
-				glBegin(GL_LINE_STRIP);
-			}
-		
-			// go through all of it's vertices
-			size_t first = 0;
-			bool first_set = false;
-			size_t v = 0;
-			for ALL(polygon->vertices, j)
+			if (edge_i2->second >= 1)
 			{
-				const size_t vertex_id = polygon->vertices.data[j].value;
-				ASSERT_IS_SET(vertices, vertex_id); 
-				if (!first_set)
-				{
-					first_set = true; 
-					first = vertex_id;
-				}
+				size_t 
+					e1 = edge_i1->first,
+					e2 = edge_i2->first
+				;
 
-				if (texture_ready)
-				{
-					glTexCoord2d(tx + polygon->texture_coords[2 * v + 0] * (sx - tx), ty + polygon->texture_coords[2 * v + 1] * (sy - ty));
-				}
-				
 				glVertex3d(
-					world_scale * visualization_normalize(vertices.data[vertex_id].x, X), 
-					world_scale * visualization_normalize(vertices.data[vertex_id].y, Y), 
-					world_scale * visualization_normalize(vertices.data[vertex_id].z, Z)
+					world_scale * visualization_normalize(vertices.data[e1].x, X), 
+					world_scale * visualization_normalize(vertices.data[e1].y, Y), 
+					world_scale * visualization_normalize(vertices.data[e1].z, Z)
 				);
 
-				v++;
-			}
-
-			if (first_set)
-			{
-				if (texture_ready)
-				{
-					glTexCoord2d(tx + polygon->texture_coords[0] * (sx - tx), ty + polygon->texture_coords[1] * (sy - ty));
-				}
-
 				glVertex3d(
-					world_scale * visualization_normalize(vertices.data[first].x, X), 
-					world_scale * visualization_normalize(vertices.data[first].y, Y), 
-					world_scale * visualization_normalize(vertices.data[first].z, Z)
+					world_scale * visualization_normalize(vertices.data[e2].x, X),
+					world_scale * visualization_normalize(vertices.data[e2].y, Y), 
+					world_scale * visualization_normalize(vertices.data[e2].z, Z)
 				);
 			}
-
-			glEnd();
-			
-			if (texture_ready) 
-			{
-				glBindTexture(GL_TEXTURE_2D, 0);
-			}
 		}
-		UNLOCK(opengl);
 	}
+	glEnd();*/
+}
+
+// display reconstructed polygons 
+void visualization_polygons(const Polygons_3d & polygons, const double world_scale /*= 1*/, const bool cull /*= false*/)
+{
+	visualization_atlas_polygons(polygons, world_scale, cull);
 }
 
 // display 3d reconstruction contours (which are 2d shots' polygons)
@@ -1018,6 +845,45 @@ void visualization_shot_user_camera(const double world_scale /*= 1*/)
 	visualization_export_opengl_matrices();
 }
 
+// maximum number of tiles drawn over the image 
+static const int VISUALIZATION_MAX_TILES = 256;
+
+// draw tiles of the original image over the full version when zoomed in beyond it's resolution 
+static void visualization_shot_tiles(const Shot & shot)
+{
+	static Image_Loader_Tile tiles[VISUALIZATION_MAX_TILES];
+
+	// visible part of the image (viewport's y axis goes upwards)
+	double x1, y1, x2, y2;
+	bool pending;
+	visualization_viewport_in_shot_coordinates(x1, y1, x2, y2);
+	const int count = image_loader_get_tiles(
+		shot.image_loader_request, x1, 1 - y2, x2, 1 - y1, gui_get_width(ui_state.gl), tiles, VISUALIZATION_MAX_TILES, &pending
+	);
+
+	// remaining tiles are uploaded during next frames 
+	if (pending) gui_request_redraw();
+	if (count == 0) return;
+
+	LOCK(opengl)
+	{
+		glColor4f(1, 1, 1, 1);
+		for (int i = 0; i < count; i++) 
+		{
+			const Image_Loader_Tile * const tile = tiles + i;
+			glBindTexture(GL_TEXTURE_2D, tile->texture);
+			glBegin(GL_POLYGON);
+				glTexCoord2d(0, tile->texture_y); glVertex3d(2 * tile->x1 - 1, 1 - 2 * tile->y2, -1);
+				glTexCoord2d(tile->texture_x, tile->texture_y); glVertex3d(2 * tile->x2 - 1, 1 - 2 * tile->y2, -1);
+				glTexCoord2d(tile->texture_x, 0); glVertex3d(2 * tile->x2 - 1, 1 - 2 * tile->y1, -1);
+				glTexCoord2d(0, 0); glVertex3d(2 * tile->x1 - 1, 1 - 2 * tile->y1, -1);
+			glEnd();
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	UNLOCK(opengl);
+}
+
 // show shot
 void visualization_shot_image(Shot & shot)
 {
@@ -1125,6 +991,13 @@ void visualization_shot_image(Shot & shot)
 				glBindTexture(GL_TEXTURE_2D, 0);
 			}
 			UNLOCK(opengl);
+
+			// more detail is available for the current shot if it has tiled store 
+			// (called without opengl lock, image loader has to be locked first)
+			if (full_texture && visualization_state.continuous_loading_alpha < 0.001 && &shot == shots.data + ui_state.current_shot)
+			{
+				visualization_shot_tiles(shot);
+			}
 		}
 	}
 
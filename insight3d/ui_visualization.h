@@ -93,13 +93,14 @@ void visualization_selection_box(double x1, double y1, double x2, double y2);
 
 // displays camera centers as points in normalized space
 // conditions: visualization_process_data has to be run before the first time calling this function on modified (or newly constructed) data
-void visualization_cameras(const Shots shots, const double world_scale = 1);
+// if cull is set, cameras outside of the view frustum of the last visualization_octree_cull are skipped (same for vertices and polygons)
+void visualization_cameras(const Shots shots, const double world_scale = 1, const bool cull = false);
 
 // display vertices using normalization from visualization_state
-void visualization_vertices(const Vertices & vertices, double world_scale = 1);
+void visualization_vertices(const Vertices & vertices, double world_scale = 1, const bool cull = false);
 
 // display reconstructed polygons 
-void visualization_polygons(const Polygons_3d & polygons, const double world_scale = 1);
+void visualization_polygons(const Polygons_3d & polygons, const double world_scale = 1, const bool cull = false);
 
 // display 3d reconstruction contours (which are 2d shots' polygons)
 void visualization_contours(const Shots & shots, const Vertices & vertices, const double world_scale = 1);
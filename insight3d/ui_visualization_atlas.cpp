@@ -0,0 +1,561 @@
+#include "ui_visualization_atlas.h"
+#include "ui_visualization_octree.h"
+
+// atlas pages are square textures of this size (or less if the implementation can't handle it)
+static const GLint VISUALIZATION_ATLAS_PAGE_SIZE = 2048;
+static const int VISUALIZATION_ATLAS_GUTTER = 1; // pixels copied around each texture to avoid bleeding
+
+// vertex of cached mesh (in normalized space)
+struct Visualization_Atlas_Vertex
+{
+	GLfloat x, y, z;
+	GLfloat u, v;
+};
+
+// atlas page, textures are packed on shelves (rows of rectangles)
+struct Visualization_Atlas_Page
+{
+	GLuint texture;
+	int shelf_x, shelf_y, shelf_height;
+
+	// triangles of polygons textured from this page (and indices of visible ones when culling)
+	Visualization_Atlas_Vertex * mesh;
+	size_t mesh_count, mesh_allocated;
+	GLuint * indices;
+	size_t indices_count, indices_allocated;
+};
+
+// polygon's texture copied into the atlas
+struct Visualization_Atlas_Texture
+{
+	bool set;
+	Image_Loader_Request_Handle request;    // request the texture was copied from
+	Image_Loader_Quality quality;           // quality of the copied texture
+	bool packed;
+	size_t page;
+	int x, y, width, height;                // rectangle in the page (gutter included)
+	double u, v, du, dv;                    // mapping of polygon's texture coordinates into the page
+};
+
+// where polygon ended up in the mesh
+struct Visualization_Atlas_Polygon
+{
+	bool drawn;
+	size_t page;                            // SIZE_MAX if it's drawn as outline
+	size_t first, count;                    // range of mesh vertices
+	double min[3], max[3];                  // bounding box (normalized space)
+};
+
+// pages
+static Visualization_Atlas_Page * visualization_atlas_pages;
+static size_t visualization_atlas_pages_count, visualization_atlas_pages_allocated;
+static GLint visualization_atlas_page_size;
+static size_t visualization_atlas_packed_area, visualization_atlas_wasted_area; // wasted by textures replaced with better ones
+
+// textures (indexed by polygon id)
+static Visualization_Atlas_Texture * visualization_atlas_textures;
+static size_t visualization_atlas_textures_count;
+static size_t visualization_atlas_revision;    // bumped whenever any texture gets (re)packed
+
+// cached mesh and what it was built from
+static Visualization_Atlas_Page visualization_atlas_outlines; // untextured polygons (lines, no texture)
+static Visualization_Atlas_Polygon * visualization_atlas_polygons_placement;
+static size_t visualization_atlas_polygons_count;
+static bool * visualization_atlas_used;        // vertices used by polygons
+static size_t visualization_atlas_used_count;
+static bool visualization_atlas_mesh_built;
+static size_t visualization_atlas_mesh_version, visualization_atlas_mesh_revision;
+static double visualization_atlas_mean[3], visualization_atlas_max_dev;
+
+// temporary buffers
+static GLubyte * visualization_atlas_pixels, * visualization_atlas_scaled;
+static size_t visualization_atlas_pixels_size, visualization_atlas_scaled_size;
+static Visualization_Atlas_Vertex * visualization_atlas_loop;
+static size_t visualization_atlas_loop_allocated;
+
+// make sure that the buffer can hold given number of items
+template<typename T> static void visualization_atlas_reserve(T * & data, size_t & allocated, const size_t count)
+{
+	if (count <= allocated) return;
+	while (allocated < count) allocated = allocated ? 2 * allocated : 256;
+	data = (T *)realloc(data, allocated * sizeof(T));
+}
+
+// page with given id (or the outlines)
+static Visualization_Atlas_Page * visualization_atlas_page(const size_t page_id)
+{
+	if (page_id == SIZE_MAX) return &visualization_atlas_outlines;
+	ASSERT(page_id < visualization_atlas_pages_count, "atlas page out of range");
+	return visualization_atlas_pages + page_id;
+}
+
+// texture entry of polygon
+static Visualization_Atlas_Texture * visualization_atlas_texture(const size_t polygon_id)
+{
+	if (polygon_id >= visualization_atlas_textures_count)
+	{
+		const size_t count = polygon_id + 1;
+		visualization_atlas_textures = (Visualization_Atlas_Texture *)realloc(visualization_atlas_textures, count * sizeof(Visualization_Atlas_Texture));
+		memset(visualization_atlas_textures + visualization_atlas_textures_count, 0, (count - visualization_atlas_textures_count) * sizeof(Visualization_Atlas_Texture));
+		visualization_atlas_textures_count = count;
+	}
+
+	return visualization_atlas_textures + polygon_id;
+}
+
+// throw away packed textures (they'll be copied again from image loader's textures)
+static void visualization_atlas_reset()
+{
+	for (size_t i = 0; i < visualization_atlas_textures_count; i++)
+	{
+		visualization_atlas_textures[i].packed = false;
+		visualization_atlas_textures[i].quality = IMAGE_LOADER_NOT_LOADED;
+	}
+
+	for (size_t i = 0; i < visualization_atlas_pages_count; i++)
+	{
+		visualization_atlas_pages[i].shelf_x = visualization_atlas_pages[i].shelf_y = visualization_atlas_pages[i].shelf_height = 0;
+	}
+
+	visualization_atlas_packed_area = visualization_atlas_wasted_area = 0;
+	visualization_atlas_revision++;
+}
+
+// try to place rectangle on page's current (or next) shelf
+static bool visualization_atlas_shelf(Visualization_Atlas_Page * const page, const int width, const int height, int & x, int & y)
+{
+	int shelf_x = page->shelf_x, shelf_y = page->shelf_y, shelf_height = page->shelf_height;
+
+	// start new shelf if this one is full
+	if (shelf_x + width > visualization_atlas_page_size)
+	{
+		shelf_y += shelf_height;
+		shelf_x = 0;
+		shelf_height = 0;
+	}
+
+	if (width > visualization_atlas_page_size || shelf_y + height > visualization_atlas_page_size) return false;
+
+	x = shelf_x;
+	y = shelf_y;
+	page->shelf_x = shelf_x + width;
+	page->shelf_y = shelf_y;
+	page->shelf_height = height > shelf_height ? height : shelf_height;
+	return true;
+}
+
+// find place for rectangle, eventually in a new page
+// expects LOCK(opengl)
+static void visualization_atlas_allocate(const int width, const int height, size_t & page_id, int & x, int & y)
+{
+	for (page_id = 0; page_id < visualization_atlas_pages_count; page_id++)
+	{
+		if (visualization_atlas_shelf(visualization_atlas_pages + page_id, width, height, x, y)) return;
+	}
+
+	// create new page (cpu buffers of dropped pages are reused)
+	if (visualization_atlas_pages_count >= visualization_atlas_pages_allocated)
+	{
+		const size_t allocated = visualization_atlas_pages_allocated ? 2 * visualization_atlas_pages_allocated : 4;
+		visualization_atlas_pages = (Visualization_Atlas_Page *)realloc(visualization_atlas_pages, allocated * sizeof(Visualization_Atlas_Page));
+		memset(visualization_atlas_pages + visualization_atlas_pages_allocated, 0, (allocated - visualization_atlas_pages_allocated) * sizeof(Visualization_Atlas_Page));
+		visualization_atlas_pages_allocated = allocated;
+	}
+
+	page_id = visualization_atlas_pages_count++;
+	Visualization_Atlas_Page * const page = visualization_atlas_pages + page_id;
+	page->shelf_x = page->shelf_y = page->shelf_height = 0;
+	page->mesh_count = page->indices_count = 0;
+
+	glGenTextures(1, &page->texture);
+	glBindTexture(GL_TEXTURE_2D, page->texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, visualization_atlas_page_size, visualization_atlas_page_size, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	const bool placed = visualization_atlas_shelf(page, width, height, x, y);
+	ASSERT(placed, "texture doesn't fit into empty atlas page");
+}
+
+// copy region tx, ty, sx, sy of source texture into the atlas
+// expects LOCK(opengl)
+static bool visualization_atlas_copy(Visualization_Atlas_Texture * const texture, const GLuint source, const double tx, const double ty, const double sx, const double sy)
+{
+	// read the source back (region textures are small)
+	GLint source_width, source_height;
+	glBindTexture(GL_TEXTURE_2D, source);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &source_width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &source_height);
+	if (source_width <= 0 || source_height <= 0)
+	{
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return false;
+	}
+
+	visualization_atlas_reserve(visualization_atlas_pixels, visualization_atlas_pixels_size, 3 * source_width * source_height);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, visualization_atlas_pixels);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// region covered by polygon's texture coordinates (with gutter)
+	int x1 = (int)floor(tx * source_width) - VISUALIZATION_ATLAS_GUTTER, x2 = (int)ceil(sx * source_width) + VISUALIZATION_ATLAS_GUTTER;
+	int y1 = (int)floor(ty * source_height) - VISUALIZATION_ATLAS_GUTTER, y2 = (int)ceil(sy * source_height) + VISUALIZATION_ATLAS_GUTTER;
+	if (x1 < 0) x1 = 0;
+	if (y1 < 0) y1 = 0;
+	if (x2 > source_width) x2 = source_width;
+	if (y2 > source_height) y2 = source_height;
+	const int width = x2 - x1, height = y2 - y1;
+	if (width <= 0 || height <= 0) return false;
+
+	// textures larger than a page are shrunk
+	int packed_width = width, packed_height = height;
+	if (width > visualization_atlas_page_size || height > visualization_atlas_page_size)
+	{
+		const double scale = visualization_atlas_page_size / (double)(width > height ? width : height);
+		packed_width = (int)(scale * width);
+		packed_height = (int)(scale * height);
+		if (packed_width < 1) packed_width = 1;
+		if (packed_height < 1) packed_height = 1;
+	}
+
+	// keep texture's place if the new version fits there, otherwise it's wasted
+	if (!texture->packed || packed_width > texture->width || packed_height > texture->height)
+	{
+		if (texture->packed)
+		{
+			visualization_atlas_wasted_area += texture->width * texture->height;
+		}
+
+		visualization_atlas_allocate(packed_width, packed_height, texture->page, texture->x, texture->y);
+		texture->width = packed_width;
+		texture->height = packed_height;
+		texture->packed = true;
+		visualization_atlas_packed_area += packed_width * packed_height;
+	}
+
+	// upload
+	glBindTexture(GL_TEXTURE_2D, visualization_atlas_pages[texture->page].texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (packed_width == width && packed_height == height)
+	{
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, source_width);
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS, x1);
+		glPixelStorei(GL_UNPACK_SKIP_ROWS, y1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, texture->x, texture->y, width, height, GL_RGB, GL_UNSIGNED_BYTE, visualization_atlas_pixels);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+		glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+	}
+	else
+	{
+		// nearest neighbour is good enough for textures this large
+		visualization_atlas_reserve(visualization_atlas_scaled, visualization_atlas_scaled_size, 3 * packed_width * packed_height);
+		for (int y = 0; y < packed_height; y++)
+		{
+			const int from_y = y1 + y * height / packed_height;
+			for (int x = 0; x < packed_width; x++)
+			{
+				const int from_x = x1 + x * width / packed_width;
+				memcpy(visualization_atlas_scaled + 3 * (y * packed_width + x), visualization_atlas_pixels + 3 * (from_y * source_width + from_x), 3);
+			}
+		}
+
+		glTexSubImage2D(GL_TEXTURE_2D, 0, texture->x, texture->y, packed_width, packed_height, GL_RGB, GL_UNSIGNED_BYTE, visualization_atlas_scaled);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// map polygon's texture coordinates (which go from 0 to 1 over tx..sx, ty..sy) into the page
+	const double
+		scale_x = packed_width / (double)width,
+		scale_y = packed_height / (double)height;
+
+	texture->u = (texture->x + (tx * source_width - x1) * scale_x) / visualization_atlas_page_size;
+	texture->v = (texture->y + (ty * source_height - y1) * scale_y) / visualization_atlas_page_size;
+	texture->du = (sx - tx) * source_width * scale_x / visualization_atlas_page_size;
+	texture->dv = (sy - ty) * source_height * scale_y / visualization_atlas_page_size;
+	return true;
+}
+
+// copy polygons' textures into the atlas as they get loaded
+static void visualization_atlas_update_textures(const Polygons_3d & polygons)
+{
+	if (!visualization_atlas_page_size)
+	{
+		ATOMIC(opengl, glGetIntegerv(GL_MAX_TEXTURE_SIZE, &visualization_atlas_page_size); );
+		if (visualization_atlas_page_size > VISUALIZATION_ATLAS_PAGE_SIZE || visualization_atlas_page_size <= 0)
+		{
+			visualization_atlas_page_size = VISUALIZATION_ATLAS_PAGE_SIZE;
+		}
+	}
+
+	// repack everything when too much space is taken by replaced textures
+	if (
+		visualization_atlas_wasted_area > visualization_atlas_packed_area / 2 &&
+		visualization_atlas_wasted_area > (size_t)(visualization_atlas_page_size * visualization_atlas_page_size / 4)
+	)
+	{
+		visualization_atlas_reset();
+	}
+
+	for ALL(polygons, i)
+	{
+		const Polygon_3d * const polygon = polygons.data + i;
+		if (!image_loader_nonempty_handle(polygon->image_loader_request) || !polygon->texture_coords) continue;
+
+		// texture could have been extracted again
+		Visualization_Atlas_Texture * const texture = visualization_atlas_texture(i);
+		if (!texture->set || texture->request.id != polygon->image_loader_request.id || texture->request.time != polygon->image_loader_request.time)
+		{
+			if (texture->packed)
+			{
+				visualization_atlas_wasted_area += texture->width * texture->height;
+			}
+
+			texture->set = true;
+			texture->request = polygon->image_loader_request;
+			texture->quality = IMAGE_LOADER_NOT_LOADED;
+			texture->packed = false;
+			visualization_atlas_revision++;
+		}
+
+		// nothing better will come
+		if (texture->quality >= IMAGE_LOADER_FULL_RESOLUTION) continue;
+
+		// see if image loader has better version
+		image_loader_upload_to_opengl(polygon->image_loader_request);
+		const Image_Loader_Quality quality = image_loader_opengl_texture_quality(polygon->image_loader_request);
+		if (quality <= texture->quality) continue;
+
+		GLuint source;
+		double tx, ty, sx, sy;
+		if (!image_loader_opengl_upload_ready(polygon->image_loader_request, &source, &tx, &ty, &sx, &sy)) continue;
+
+		ATOMIC(opengl, visualization_atlas_copy(texture, source, tx, ty, sx, sy); );
+		texture->quality = quality;
+		visualization_atlas_revision++;
+	}
+}
+
+// check if the mesh has to be rebuilt
+static bool visualization_atlas_mesh_outdated()
+{
+	if (
+		!visualization_atlas_mesh_built ||
+		visualization_atlas_mesh_revision != visualization_atlas_revision ||
+		visualization_atlas_max_dev != visualization_state.max_dev ||
+		memcmp(visualization_atlas_mean, visualization_state.shots_T_mean, sizeof(visualization_atlas_mean)) != 0 ||
+		!geometry_journal_complete(visualization_atlas_mesh_version)
+	)
+	{
+		return true;
+	}
+
+	// polygons changed or some of their vertices moved
+	size_t position = 0;
+	Geometry_Change change;
+	while (geometry_journal_next(position, visualization_atlas_mesh_version, change))
+	{
+		if (change.kind == GEOMETRY_CHANGE_POLYGONS) return true;
+		if (change.kind != GEOMETRY_CHANGE_VERTICES) continue;
+
+		for (size_t i = change.from; i < change.to && i < visualization_atlas_used_count; i++)
+		{
+			if (visualization_atlas_used[i]) return true;
+		}
+	}
+
+	return false;
+}
+
+// triangulate polygons into mesh of each page
+static void visualization_atlas_build_mesh(const Polygons_3d & polygons)
+{
+	for (size_t i = 0; i < visualization_atlas_pages_count; i++) visualization_atlas_pages[i].mesh_count = 0;
+	visualization_atlas_outlines.mesh_count = 0;
+
+	visualization_atlas_polygons_placement = (Visualization_Atlas_Polygon *)realloc(visualization_atlas_polygons_placement, (polygons.count + 1) * sizeof(Visualization_Atlas_Polygon));
+	memset(visualization_atlas_polygons_placement, 0, (polygons.count + 1) * sizeof(Visualization_Atlas_Polygon));
+	visualization_atlas_polygons_count = polygons.count;
+
+	visualization_atlas_used = (bool *)realloc(visualization_atlas_used, (vertices.count + 1) * sizeof(bool));
+	memset(visualization_atlas_used, 0, (vertices.count + 1) * sizeof(bool));
+	visualization_atlas_used_count = vertices.count;
+
+	for ALL(polygons, i)
+	{
+		const Polygon_3d * const polygon = polygons.data + i;
+		Visualization_Atlas_Polygon * const placement = visualization_atlas_polygons_placement + i;
+
+		// draw only reconstruted polygons
+		if (!query_is_polygon_reconstructed(*polygon, vertices)) continue;
+
+		// check if we have texture for this polygon
+		const Visualization_Atlas_Texture * texture = NULL;
+		if (
+			i < visualization_atlas_textures_count && visualization_atlas_textures[i].packed && polygon->texture_coords &&
+			visualization_atlas_textures[i].request.id == polygon->image_loader_request.id &&
+			visualization_atlas_textures[i].request.time == polygon->image_loader_request.time
+		)
+		{
+			texture = visualization_atlas_textures + i;
+		}
+
+		// collect polygon's vertices
+		size_t n = 0;
+		for ALL(polygon->vertices, j)
+		{
+			const size_t vertex_id = polygon->vertices.data[j].value;
+			ASSERT_IS_SET(vertices, vertex_id);
+			visualization_atlas_used[vertex_id] = true;
+
+			visualization_atlas_reserve(visualization_atlas_loop, visualization_atlas_loop_allocated, n + 1);
+			Visualization_Atlas_Vertex * const vertex = visualization_atlas_loop + n;
+			vertex->x = (GLfloat)visualization_normalize(vertices.data[vertex_id].x, X);
+			vertex->y = (GLfloat)visualization_normalize(vertices.data[vertex_id].y, Y);
+			vertex->z = (GLfloat)visualization_normalize(vertices.data[vertex_id].z, Z);
+			vertex->u = texture ? (GLfloat)(texture->u + polygon->texture_coords[2 * n + 0] * texture->du) : 0;
+			vertex->v = texture ? (GLfloat)(texture->v + polygon->texture_coords[2 * n + 1] * texture->dv) : 0;
+
+			const double p[3] = { vertex->x, vertex->y, vertex->z };
+			for (int k = 0; k < 3; k++)
+			{
+				if (n == 0 || p[k] < placement->min[k]) placement->min[k] = p[k];
+				if (n == 0 || p[k] > placement->max[k]) placement->max[k] = p[k];
+			}
+
+			n++;
+		}
+
+		if (n < 2) continue;
+		if (n < 3) texture = NULL;
+
+		// textured polygons are triangulated as fans (they were drawn as convex GL_POLYGON), others are outlined
+		Visualization_Atlas_Page * const page = visualization_atlas_page(texture ? texture->page : SIZE_MAX);
+		const size_t count = texture ? 3 * (n - 2) : 2 * n;
+		visualization_atlas_reserve(page->mesh, page->mesh_allocated, page->mesh_count + count);
+
+		placement->drawn = true;
+		placement->page = texture ? texture->page : SIZE_MAX;
+		placement->first = page->mesh_count;
+		placement->count = count;
+
+		Visualization_Atlas_Vertex * mesh = page->mesh + page->mesh_count;
+		for (size_t k = texture ? 1 : 0; k < (texture ? n - 1 : n); k++)
+		{
+			if (texture)
+			{
+				*mesh++ = visualization_atlas_loop[0];
+				*mesh++ = visualization_atlas_loop[k];
+				*mesh++ = visualization_atlas_loop[k + 1];
+			}
+			else
+			{
+				*mesh++ = visualization_atlas_loop[k];
+				*mesh++ = visualization_atlas_loop[(k + 1) % n];
+			}
+		}
+
+		page->mesh_count += count;
+	}
+
+	visualization_atlas_mesh_built = true;
+	visualization_atlas_mesh_version = geometry_version();
+	visualization_atlas_mesh_revision = visualization_atlas_revision;
+	visualization_atlas_max_dev = visualization_state.max_dev;
+	memcpy(visualization_atlas_mean, visualization_state.shots_T_mean, sizeof(visualization_atlas_mean));
+}
+
+// collect indices of polygons inside view frustum
+static void visualization_atlas_cull()
+{
+	for (size_t i = 0; i < visualization_atlas_pages_count; i++) visualization_atlas_pages[i].indices_count = 0;
+	visualization_atlas_outlines.indices_count = 0;
+
+	for (size_t i = 0; i < visualization_atlas_polygons_count; i++)
+	{
+		const Visualization_Atlas_Polygon * const placement = visualization_atlas_polygons_placement + i;
+		if (!placement->drawn || !visualization_octree_box_visible(placement->min, placement->max)) continue;
+
+		Visualization_Atlas_Page * const page = visualization_atlas_page(placement->page);
+		visualization_atlas_reserve(page->indices, page->indices_allocated, page->indices_count + placement->count);
+		for (size_t k = 0; k < placement->count; k++)
+		{
+			page->indices[page->indices_count++] = (GLuint)(placement->first + k);
+		}
+	}
+}
+
+// draw page's mesh
+// expects LOCK(opengl)
+static void visualization_atlas_draw(const Visualization_Atlas_Page * const page, const GLenum mode, const bool cull)
+{
+	if (page->mesh_count == 0 || (cull && page->indices_count == 0)) return;
+
+	glVertexPointer(3, GL_FLOAT, sizeof(Visualization_Atlas_Vertex), &page->mesh->x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(Visualization_Atlas_Vertex), &page->mesh->u);
+
+	if (cull)
+	{
+		glDrawElements(mode, (GLsizei)page->indices_count, GL_UNSIGNED_INT, page->indices);
+	}
+	else
+	{
+		glDrawArrays(mode, 0, (GLsizei)page->mesh_count);
+	}
+}
+
+// display reconstructed polygons
+void visualization_atlas_polygons(const Polygons_3d & polygons, const double world_scale, const bool cull /*= false*/)
+{
+	visualization_atlas_update_textures(polygons);
+	if (visualization_atlas_mesh_outdated())
+	{
+		visualization_atlas_build_mesh(polygons);
+	}
+
+	if (cull)
+	{
+		visualization_atlas_cull();
+	}
+
+	LOCK(opengl)
+	{
+		opengl_drawing_style(UI_STYLE_POLYGON);
+
+		glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+		glMatrixMode(GL_MODELVIEW);
+		glPushMatrix();
+		glScaled(world_scale, world_scale, world_scale);
+
+		// one pass per page
+		for (size_t i = 0; i < visualization_atlas_pages_count; i++)
+		{
+			glBindTexture(GL_TEXTURE_2D, visualization_atlas_pages[i].texture);
+			visualization_atlas_draw(visualization_atlas_pages + i, GL_TRIANGLES, cull);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		// polygons without texture
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		visualization_atlas_draw(&visualization_atlas_outlines, GL_LINES, cull);
+
+		glPopMatrix();
+		glPopClientAttrib();
+	}
+	UNLOCK(opengl);
+}
+
+// forget atlas pages
+void visualization_atlas_flush()
+{
+	ATOMIC(opengl,
+		visualization_atlas_reset();
+		visualization_atlas_pages_count = 0;
+	);
+}
@@ -0,0 +1,18 @@
+#ifndef __UI_VISUALIZATION_ATLAS
+#define __UI_VISUALIZATION_ATLAS
+
+#include "interface_opengl.h"
+#include "core_image_loader.h"
+#include "ui_visualization.h"
+
+// display reconstructed polygons; extracted textures are copied into a few atlas pages and
+// polygons are triangulated into cached mesh (rebuilt only when geometry or textures change),
+// so all textured polygons are drawn in one pass per page
+// if cull is set, polygons outside of the view frustum of the last visualization_octree_cull are skipped
+// note must be called by the rendering thread
+void visualization_atlas_polygons(const Polygons_3d & polygons, const double world_scale, const bool cull = false);
+
+// forget atlas pages (they're lost together with opengl context)
+void visualization_atlas_flush();
+
+#endif
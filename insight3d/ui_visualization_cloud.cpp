@@ -0,0 +1,375 @@
+#include "ui_visualization_cloud.h"
+#include "ui_visualization_octree.h"
+
+// vertices are packed in blocks, a block is uploaded again only if it's contents changed 
+static const size_t VISUALIZATION_CLOUD_BLOCK = 4096;
+static const double VISUALIZATION_CLOUD_NORMAL_LENGTH = 0.1;
+
+// packed vertex (in normalized space, hidden vertices are fully transparent and get discarded by alpha test)
+struct Visualization_Cloud_Vertex
+{
+	GLfloat x, y, z;
+	GLubyte color[4];
+};
+
+// cpu copy of the buffers - points and normal lines (two vertices for every point) 
+static Visualization_Cloud_Vertex * visualization_cloud_points, * visualization_cloud_lines;
+static bool * visualization_cloud_dirty; // blocks which have to be uploaded
+static size_t visualization_cloud_count, visualization_cloud_capacity;
+
+// what the cloud was packed from - version of geometric data and display settings 
+static size_t visualization_cloud_version;
+static double visualization_cloud_mean[3], visualization_cloud_max_dev; 
+static bool visualization_cloud_hide_automatic;
+static bool * visualization_cloud_hidden_groups; 
+static size_t visualization_cloud_groups_count;
+
+// vertex buffers (if they're not supported, we're drawing straight from the cpu copy)
+static bool visualization_cloud_initialized, visualization_cloud_buffered;
+static GLuint visualization_cloud_points_buffer, visualization_cloud_lines_buffer;
+static size_t visualization_cloud_buffers_capacity; 
+
+// indices of normals' endpoints of culled vertices 
+static GLuint * visualization_cloud_lines_indices; 
+static size_t visualization_cloud_lines_indices_allocated;
+
+// pack one vertex 
+static void visualization_cloud_pack(const Vertices & vertices, const size_t i, Visualization_Cloud_Vertex * point, Visualization_Cloud_Vertex * line)
+{
+	memset(point, 0, sizeof(Visualization_Cloud_Vertex));
+	memset(line, 0, 2 * sizeof(Visualization_Cloud_Vertex));
+
+	// process only reconstructed vertices
+	if (!IS_SET(vertices, i) || !vertices.data[i].reconstructed) return;
+	const Vertex * const vertex = vertices.data + i;
+
+	// don't display hidden vertices
+	if (vertex->group)
+	{
+		ASSERT_IS_SET(ui_state.groups, vertex->group);
+		if (ui_state.groups.data[vertex->group].hidden) return;
+	}
+
+	// optionally skip generated vertices 
+	if (option_hide_automatic && vertex->vertex_type == GEOMETRY_VERTEX_AUTO) return;
+
+	// pick appropriate color 
+	float color[3];
+	if (vertex->selected) 
+	{
+		memcpy(color, UI_STYLE_SELECTED_VERTEX.color, sizeof(color));
+	}
+	else if (vertex->color[0] > 0 || vertex->color[1] > 0 || vertex->color[2] > 0)
+	{
+		memcpy(color, vertex->color, sizeof(color));
+	}
+	else if (vertex->group == 1)
+	{
+		color[0] = 0.52f; 
+		color[1] = 0.83f; 
+		color[2] = 0.52f;
+	}
+	else
+	{
+		memcpy(color, UI_STYLE_VERTEX.color, sizeof(color));
+	}
+
+	for (int j = 0; j < 3; j++) 
+	{
+		point->color[j] = (GLubyte)(255 * (color[j] < 0 ? 0 : color[j] > 1 ? 1 : color[j]));
+	}
+	point->color[3] = 255;
+
+	// position in normalized space
+	point->x = (GLfloat)visualization_normalize(vertex->x, X);
+	point->y = (GLfloat)visualization_normalize(vertex->y, Y);
+	point->z = (GLfloat)visualization_normalize(vertex->z, Z);
+
+	// direction of the normal 
+	line[0] = *point; 
+	line[0].x += (GLfloat)(VISUALIZATION_CLOUD_NORMAL_LENGTH * vertex->nx); 
+	line[0].y += (GLfloat)(VISUALIZATION_CLOUD_NORMAL_LENGTH * vertex->ny); 
+	line[0].z += (GLfloat)(VISUALIZATION_CLOUD_NORMAL_LENGTH * vertex->nz); 
+	line[1] = *point;
+}
+
+// repack one block of vertices and mark it if it changed 
+static void visualization_cloud_repack(const Vertices & vertices, const size_t block)
+{
+	static Visualization_Cloud_Vertex points[VISUALIZATION_CLOUD_BLOCK], lines[2 * VISUALIZATION_CLOUD_BLOCK];
+
+	const size_t from = block * VISUALIZATION_CLOUD_BLOCK; 
+	if (from >= visualization_cloud_count) return;
+	const size_t to = from + VISUALIZATION_CLOUD_BLOCK < visualization_cloud_count ? from + VISUALIZATION_CLOUD_BLOCK : visualization_cloud_count;
+
+	for (size_t i = from; i < to; i++)
+	{
+		visualization_cloud_pack(vertices, i, points + i - from, lines + 2 * (i - from));
+	}
+
+	if (
+		memcmp(visualization_cloud_points + from, points, (to - from) * sizeof(Visualization_Cloud_Vertex)) != 0 || 
+		memcmp(visualization_cloud_lines + 2 * from, lines, 2 * (to - from) * sizeof(Visualization_Cloud_Vertex)) != 0
+	)
+	{
+		memcpy(visualization_cloud_points + from, points, (to - from) * sizeof(Visualization_Cloud_Vertex));
+		memcpy(visualization_cloud_lines + 2 * from, lines, 2 * (to - from) * sizeof(Visualization_Cloud_Vertex));
+		visualization_cloud_dirty[block] = true;
+	}
+}
+
+// check if display settings changed since the cloud was packed (and remember the current ones) 
+static bool visualization_cloud_settings_changed()
+{
+	bool changed = 
+		visualization_cloud_max_dev != visualization_state.max_dev || 
+		memcmp(visualization_cloud_mean, visualization_state.shots_T_mean, sizeof(visualization_cloud_mean)) != 0 || 
+		visualization_cloud_hide_automatic != option_hide_automatic || 
+		visualization_cloud_groups_count != ui_state.groups.count
+	;
+
+	for (size_t i = 0; !changed && i < ui_state.groups.count; i++) 
+	{
+		changed = visualization_cloud_hidden_groups[i] != (IS_SET(ui_state.groups, i) && ui_state.groups.data[i].hidden);
+	}
+
+	if (changed) 
+	{
+		visualization_cloud_max_dev = visualization_state.max_dev; 
+		memcpy(visualization_cloud_mean, visualization_state.shots_T_mean, sizeof(visualization_cloud_mean)); 
+		visualization_cloud_hide_automatic = option_hide_automatic; 
+
+		visualization_cloud_groups_count = ui_state.groups.count; 
+		visualization_cloud_hidden_groups = (bool *)realloc(visualization_cloud_hidden_groups, (ui_state.groups.count + 1) * sizeof(bool));
+		for (size_t i = 0; i < ui_state.groups.count; i++) 
+		{
+			visualization_cloud_hidden_groups[i] = IS_SET(ui_state.groups, i) && ui_state.groups.data[i].hidden;
+		}
+	}
+
+	return changed;
+}
+
+// repack vertices which changed since the last frame 
+static void visualization_cloud_update(const Vertices & vertices)
+{
+	const size_t previous_count = visualization_cloud_count;
+
+	// make room for all vertices 
+	if (vertices.count > visualization_cloud_capacity) 
+	{
+		size_t capacity = visualization_cloud_capacity ? 2 * visualization_cloud_capacity : VISUALIZATION_CLOUD_BLOCK;
+		while (capacity < vertices.count) capacity *= 2;
+
+		visualization_cloud_points = (Visualization_Cloud_Vertex *)realloc(visualization_cloud_points, capacity * sizeof(Visualization_Cloud_Vertex));
+		visualization_cloud_lines = (Visualization_Cloud_Vertex *)realloc(visualization_cloud_lines, 2 * capacity * sizeof(Visualization_Cloud_Vertex));
+		visualization_cloud_dirty = (bool *)realloc(visualization_cloud_dirty, capacity / VISUALIZATION_CLOUD_BLOCK * sizeof(bool));
+
+		// new part has to be packed and uploaded 
+		const size_t old = visualization_cloud_capacity;
+		memset(visualization_cloud_points + old, 0, (capacity - old) * sizeof(Visualization_Cloud_Vertex));
+		memset(visualization_cloud_lines + 2 * old, 0, 2 * (capacity - old) * sizeof(Visualization_Cloud_Vertex));
+		memset(visualization_cloud_dirty + old / VISUALIZATION_CLOUD_BLOCK, 1, (capacity - old) / VISUALIZATION_CLOUD_BLOCK * sizeof(bool));
+		visualization_cloud_capacity = capacity;
+	}
+
+	// vertices removed from the end are simply not drawn 
+	visualization_cloud_count = vertices.count;
+
+	// repack everything if the journal can't tell us what changed or if vertices are displayed differently 
+	const bool settings_changed = visualization_cloud_settings_changed();
+	if (settings_changed || !geometry_journal_complete(visualization_cloud_version))
+	{
+		for (size_t block = 0; block * VISUALIZATION_CLOUD_BLOCK < visualization_cloud_count; block++) 
+		{
+			visualization_cloud_repack(vertices, block);
+		}
+	}
+	else
+	{
+		// otherwise repack only blocks containing changed vertices 
+		size_t position = 0; 
+		Geometry_Change change; 
+		while (geometry_journal_next(position, visualization_cloud_version, change))
+		{
+			if (change.kind != GEOMETRY_CHANGE_VERTICES) continue; 
+
+			const size_t to = change.to < visualization_cloud_count ? change.to : visualization_cloud_count;
+			for (size_t block = change.from / VISUALIZATION_CLOUD_BLOCK; block * VISUALIZATION_CLOUD_BLOCK < to; block++) 
+			{
+				visualization_cloud_repack(vertices, block);
+			}
+		}
+
+		// vertices which appeared without being recorded 
+		for (size_t block = previous_count / VISUALIZATION_CLOUD_BLOCK; block * VISUALIZATION_CLOUD_BLOCK < visualization_cloud_count; block++)
+		{
+			visualization_cloud_repack(vertices, block);
+		}
+	}
+
+	visualization_cloud_version = geometry_version();
+}
+
+// upload dirty blocks (consecutive blocks are uploaded together)
+// expects LOCK(opengl)
+static void visualization_cloud_upload()
+{
+	const size_t blocks = visualization_cloud_capacity / VISUALIZATION_CLOUD_BLOCK;
+
+	// buffers are too small, upload everything 
+	if (visualization_cloud_buffers_capacity < visualization_cloud_capacity) 
+	{
+		opengl_bind_buffer(GL_ARRAY_BUFFER_ARB, visualization_cloud_points_buffer); 
+		opengl_buffer_data(GL_ARRAY_BUFFER_ARB, visualization_cloud_capacity * sizeof(Visualization_Cloud_Vertex), visualization_cloud_points, GL_DYNAMIC_DRAW_ARB);
+		opengl_bind_buffer(GL_ARRAY_BUFFER_ARB, visualization_cloud_lines_buffer); 
+		opengl_buffer_data(GL_ARRAY_BUFFER_ARB, 2 * visualization_cloud_capacity * sizeof(Visualization_Cloud_Vertex), visualization_cloud_lines, GL_DYNAMIC_DRAW_ARB);
+		opengl_bind_buffer(GL_ARRAY_BUFFER_ARB, 0);
+
+		memset(visualization_cloud_dirty, 0, blocks * sizeof(bool));
+		visualization_cloud_buffers_capacity = visualization_cloud_capacity;
+		return;
+	}
+
+	for (size_t block = 0; block < blocks; block++) 
+	{
+		if (!visualization_cloud_dirty[block]) continue;
+
+		// find the run of dirty blocks 
+		size_t end = block; 
+		while (end < blocks && visualization_cloud_dirty[end]) visualization_cloud_dirty[end++] = false;
+
+		const size_t 
+			from = block * VISUALIZATION_CLOUD_BLOCK, 
+			count = (end - block) * VISUALIZATION_CLOUD_BLOCK;
+
+		opengl_bind_buffer(GL_ARRAY_BUFFER_ARB, visualization_cloud_points_buffer); 
+		opengl_buffer_sub_data(GL_ARRAY_BUFFER_ARB, from * sizeof(Visualization_Cloud_Vertex), count * sizeof(Visualization_Cloud_Vertex), visualization_cloud_points + from);
+		opengl_bind_buffer(GL_ARRAY_BUFFER_ARB, visualization_cloud_lines_buffer); 
+		opengl_buffer_sub_data(GL_ARRAY_BUFFER_ARB, 2 * from * sizeof(Visualization_Cloud_Vertex), 2 * count * sizeof(Visualization_Cloud_Vertex), visualization_cloud_lines + 2 * from);
+
+		block = end;
+	}
+
+	opengl_bind_buffer(GL_ARRAY_BUFFER_ARB, 0);
+}
+
+// draw array of packed vertices (either from the buffer or from the cpu copy)
+// if indices are given, only those elements are drawn
+// expects LOCK(opengl)
+static void visualization_cloud_draw(
+	const GLenum mode, const GLuint buffer, const Visualization_Cloud_Vertex * data, const size_t count, 
+	const GLuint * indices = NULL, const size_t indices_count = 0
+)
+{
+	const char * base = (const char *)data; 
+	if (visualization_cloud_buffered) 
+	{
+		opengl_bind_buffer(GL_ARRAY_BUFFER_ARB, buffer);
+		base = NULL;
+	}
+
+	glVertexPointer(3, GL_FLOAT, sizeof(Visualization_Cloud_Vertex), base);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Visualization_Cloud_Vertex), base + 3 * sizeof(GLfloat));
+	if (indices) 
+	{
+		glDrawElements(mode, (GLsizei)indices_count, GL_UNSIGNED_INT, indices);
+	}
+	else
+	{
+		glDrawArrays(mode, 0, (GLsizei)count);
+	}
+
+	if (visualization_cloud_buffered) 
+	{
+		opengl_bind_buffer(GL_ARRAY_BUFFER_ARB, 0);
+	}
+}
+
+// display reconstructed vertices as point cloud 
+void visualization_cloud(const Vertices & vertices, const double world_scale, const bool cull /*= false*/)
+{
+	visualization_cloud_update(vertices);
+	if (visualization_cloud_count == 0) return;
+
+	LOCK(opengl)
+	{
+		// buffers have to be created in current context 
+		if (!visualization_cloud_initialized) 
+		{
+			visualization_cloud_initialized = true;
+			visualization_cloud_buffered = opengl_initialize_buffers();
+			visualization_cloud_buffers_capacity = 0;
+
+			if (visualization_cloud_buffered) 
+			{
+				opengl_gen_buffers(1, &visualization_cloud_points_buffer);
+				opengl_gen_buffers(1, &visualization_cloud_lines_buffer);
+			}
+		}
+
+		if (visualization_cloud_buffered) 
+		{
+			visualization_cloud_upload();
+		}
+
+		opengl_drawing_style(UI_STYLE_VERTEX);
+		glDisable(GL_BLEND);
+
+		glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT);
+		glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+		glEnable(GL_ALPHA_TEST); 
+		glAlphaFunc(GL_GREATER, 0);
+		glEnableClientState(GL_VERTEX_ARRAY); 
+		glEnableClientState(GL_COLOR_ARRAY);
+
+		glMatrixMode(GL_MODELVIEW);
+		glPushMatrix();
+		glScaled(world_scale, world_scale, world_scale);
+
+		if (cull) 
+		{
+			// draw only visible vertices
+			size_t visible_count; 
+			const GLuint * const visible = visualization_octree_visible(visible_count);
+
+			if (2 * visible_count > visualization_cloud_lines_indices_allocated) 
+			{
+				visualization_cloud_lines_indices_allocated = 4 * visible_count;
+				visualization_cloud_lines_indices = (GLuint *)realloc(visualization_cloud_lines_indices, visualization_cloud_lines_indices_allocated * sizeof(GLuint));
+			}
+
+			for (size_t i = 0; i < visible_count; i++) 
+			{
+				ASSERT(visible[i] < visualization_cloud_count, "culled vertex out of range");
+				visualization_cloud_lines_indices[2 * i + 0] = 2 * visible[i] + 0;
+				visualization_cloud_lines_indices[2 * i + 1] = 2 * visible[i] + 1;
+			}
+
+			if (visible_count > 0) 
+			{
+				visualization_cloud_draw(GL_POINTS, visualization_cloud_points_buffer, visualization_cloud_points, visualization_cloud_count, visible, visible_count);
+				visualization_cloud_draw(GL_LINES, visualization_cloud_lines_buffer, visualization_cloud_lines, 2 * visualization_cloud_count, visualization_cloud_lines_indices, 2 * visible_count);
+			}
+		}
+		else
+		{
+			visualization_cloud_draw(GL_POINTS, visualization_cloud_points_buffer, visualization_cloud_points, visualization_cloud_count);
+			visualization_cloud_draw(GL_LINES, visualization_cloud_lines_buffer, visualization_cloud_lines, 2 * visualization_cloud_count);
+		}
+
+		glPopMatrix();
+		glPopClientAttrib();
+		glPopAttrib();
+	}
+	UNLOCK(opengl);
+}
+
+// forget vertex buffers 
+void visualization_cloud_flush()
+{
+	ATOMIC(opengl, 
+		visualization_cloud_initialized = false; 
+		if (visualization_cloud_dirty) memset(visualization_cloud_dirty, 1, visualization_cloud_capacity / VISUALIZATION_CLOUD_BLOCK * sizeof(bool)); 
+	);
+}
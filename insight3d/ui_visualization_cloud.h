@@ -0,0 +1,16 @@
+#ifndef __UI_VISUALIZATION_CLOUD
+#define __UI_VISUALIZATION_CLOUD
+
+#include "interface_opengl.h"
+#include "ui_visualization.h"
+
+// display reconstructed vertices (and their normals) as point cloud kept in vertex buffers; 
+// only blocks of vertices recorded as changed in geometry journal get repacked and uploaded
+// if cull is set, only vertices which survived the last visualization_octree_cull are drawn
+// note must be called by the rendering thread 
+void visualization_cloud(const Vertices & vertices, const double world_scale, const bool cull = false);
+
+// forget vertex buffers (they're lost together with opengl context) 
+void visualization_cloud_flush();
+
+#endif
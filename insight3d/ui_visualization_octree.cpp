@@ -0,0 +1,381 @@
+#include "ui_visualization_octree.h"
+
+// octree parameters 
+static const size_t VISUALIZATION_OCTREE_LEAF = 256;       // maximal number of vertices in leaf 
+static const size_t VISUALIZATION_OCTREE_DEPTH = 16;       
+static const size_t VISUALIZATION_OCTREE_SAMPLES = 64;     // number of representative vertices kept in every node 
+static const double VISUALIZATION_OCTREE_LOD_PIXELS = 8;   // nodes smaller than this are drawn decimated 
+
+// node of the octree, vertices of each node occupy continuous range of visualization_octree_items 
+struct Visualization_Octree_Node 
+{
+	float min[3], max[3];
+	size_t first, count; 
+	size_t samples_first, samples_count; // evenly spread subset of node's vertices
+	size_t children[8];                  // 0 if there's no such child (root is never a child)
+	bool leaf;
+};
+
+static Visualization_Octree_Node * visualization_octree_nodes = NULL;
+static size_t visualization_octree_nodes_count = 0, visualization_octree_nodes_allocated = 0;
+static GLuint * visualization_octree_items = NULL, * visualization_octree_samples = NULL;
+static size_t visualization_octree_samples_count = 0, visualization_octree_samples_allocated = 0;
+
+// positions the octree was built from (to tell if changed vertices actually moved) 
+static float * visualization_octree_positions = NULL; 
+static bool * visualization_octree_reconstructed = NULL;
+static size_t visualization_octree_vertices_count = 0;
+static size_t visualization_octree_version = 0; 
+static double visualization_octree_mean[3], visualization_octree_max_dev; 
+
+// result of the last culling 
+static GLuint * visualization_octree_visible_ids = NULL;
+static size_t visualization_octree_visible_count = 0, visualization_octree_visible_allocated = 0;
+static double visualization_octree_planes[6][4];
+static double visualization_octree_eye[3], visualization_octree_pixels; // eye position and pixels per unit at unit distance
+
+// allocate new node 
+static size_t visualization_octree_new_node()
+{
+	if (visualization_octree_nodes_count >= visualization_octree_nodes_allocated) 
+	{
+		visualization_octree_nodes_allocated = visualization_octree_nodes_allocated ? 2 * visualization_octree_nodes_allocated : 256;
+		visualization_octree_nodes = (Visualization_Octree_Node *)realloc(visualization_octree_nodes, visualization_octree_nodes_allocated * sizeof(Visualization_Octree_Node));
+	}
+
+	memset(visualization_octree_nodes + visualization_octree_nodes_count, 0, sizeof(Visualization_Octree_Node));
+	return visualization_octree_nodes_count++;
+}
+
+// split node's vertices among its children (recursively)
+static void visualization_octree_split(const size_t node_id, const size_t depth)
+{
+	Visualization_Octree_Node * node = visualization_octree_nodes + node_id;
+
+	// pick evenly spread representative vertices
+	const size_t step = node->count > VISUALIZATION_OCTREE_SAMPLES ? node->count / VISUALIZATION_OCTREE_SAMPLES : 1;
+	node->samples_first = visualization_octree_samples_count; 
+	for (size_t i = 0; i < node->count && node->samples_count < VISUALIZATION_OCTREE_SAMPLES; i += step) 
+	{
+		if (visualization_octree_samples_count >= visualization_octree_samples_allocated) 
+		{
+			visualization_octree_samples_allocated = visualization_octree_samples_allocated ? 2 * visualization_octree_samples_allocated : 4096;
+			visualization_octree_samples = (GLuint *)realloc(visualization_octree_samples, visualization_octree_samples_allocated * sizeof(GLuint));
+		}
+
+		visualization_octree_samples[visualization_octree_samples_count++] = visualization_octree_items[node->first + i];
+		node->samples_count++;
+	}
+
+	// small enough nodes are leaves 
+	if (node->count <= VISUALIZATION_OCTREE_LEAF || depth >= VISUALIZATION_OCTREE_DEPTH) 
+	{
+		node->leaf = true; 
+		return;
+	}
+
+	// sort vertices by octants (counting sort)
+	float center[3]; 
+	for (int k = 0; k < 3; k++) center[k] = 0.5f * (node->min[k] + node->max[k]);
+
+	size_t counts[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	unsigned char * const octants = ALLOC(unsigned char, node->count);
+	for (size_t i = 0; i < node->count; i++) 
+	{
+		const float * const p = visualization_octree_positions + 3 * visualization_octree_items[node->first + i];
+		octants[i] = (p[0] >= center[0] ? 1 : 0) | (p[1] >= center[1] ? 2 : 0) | (p[2] >= center[2] ? 4 : 0);
+		counts[octants[i]]++;
+	}
+
+	size_t offsets[8];
+	offsets[0] = 0; 
+	for (int o = 1; o < 8; o++) offsets[o] = offsets[o - 1] + counts[o - 1];
+
+	GLuint * const sorted = ALLOC(GLuint, node->count); 
+	{
+		size_t positions[8]; 
+		memcpy(positions, offsets, sizeof(positions));
+		for (size_t i = 0; i < node->count; i++) 
+		{
+			sorted[positions[octants[i]]++] = visualization_octree_items[node->first + i];
+		}
+	}
+	memcpy(visualization_octree_items + node->first, sorted, node->count * sizeof(GLuint));
+	FREE(sorted); 
+	FREE(octants);
+
+	// create children (note that nodes can be reallocated meanwhile)
+	for (int o = 0; o < 8; o++) 
+	{
+		if (!counts[o]) continue;
+
+		const size_t child_id = visualization_octree_new_node();
+		node = visualization_octree_nodes + node_id;
+		Visualization_Octree_Node * const child = visualization_octree_nodes + child_id;
+
+		for (int k = 0; k < 3; k++) 
+		{
+			child->min[k] = o & (1 << k) ? center[k] : node->min[k]; 
+			child->max[k] = o & (1 << k) ? node->max[k] : center[k];
+		}
+
+		child->first = node->first + offsets[o]; 
+		child->count = counts[o];
+		node->children[o] = child_id;
+
+		visualization_octree_split(child_id, depth + 1);
+		node = visualization_octree_nodes + node_id;
+	}
+}
+
+// build the octree from scratch
+static void visualization_octree_build(const Vertices & vertices) 
+{
+	visualization_octree_nodes_count = 0; 
+	visualization_octree_samples_count = 0;
+
+	// store positions of all reconstructed vertices
+	visualization_octree_vertices_count = vertices.count;
+	visualization_octree_positions = (float *)realloc(visualization_octree_positions, (3 * vertices.count + 3) * sizeof(float));
+	visualization_octree_reconstructed = (bool *)realloc(visualization_octree_reconstructed, (vertices.count + 1) * sizeof(bool));
+	visualization_octree_items = (GLuint *)realloc(visualization_octree_items, (vertices.count + 1) * sizeof(GLuint));
+
+	const size_t root_id = visualization_octree_new_node(); 
+	Visualization_Octree_Node * const root = visualization_octree_nodes + root_id;
+
+	for (size_t i = 0; i < vertices.count; i++) 
+	{
+		float * const p = visualization_octree_positions + 3 * i;
+		visualization_octree_reconstructed[i] = IS_SET(vertices, i) && vertices.data[i].reconstructed;
+		if (!visualization_octree_reconstructed[i]) 
+		{
+			p[0] = p[1] = p[2] = 0;
+			continue;
+		}
+
+		p[0] = (float)visualization_normalize(vertices.data[i].x, X);
+		p[1] = (float)visualization_normalize(vertices.data[i].y, Y);
+		p[2] = (float)visualization_normalize(vertices.data[i].z, Z);
+
+		// update bounding box
+		for (int k = 0; k < 3; k++) 
+		{
+			if (root->count == 0 || p[k] < root->min[k]) root->min[k] = p[k];
+			if (root->count == 0 || p[k] > root->max[k]) root->max[k] = p[k];
+		}
+
+		visualization_octree_items[root->count++] = (GLuint)i;
+	}
+
+	visualization_octree_split(root_id, 0);
+}
+
+// check if vertices moved since the octree was built 
+static bool visualization_octree_moved(const Vertices & vertices, const size_t from, const size_t to)
+{
+	for (size_t i = from; i < to && i < vertices.count; i++) 
+	{
+		const bool reconstructed = IS_SET(vertices, i) && vertices.data[i].reconstructed;
+		if (i >= visualization_octree_vertices_count) 
+		{
+			if (reconstructed) return true; 
+			continue;
+		}
+
+		if (reconstructed != visualization_octree_reconstructed[i]) return true;
+		if (!reconstructed) continue;
+
+		const float * const p = visualization_octree_positions + 3 * i;
+		if (
+			p[0] != (float)visualization_normalize(vertices.data[i].x, X) || 
+			p[1] != (float)visualization_normalize(vertices.data[i].y, Y) || 
+			p[2] != (float)visualization_normalize(vertices.data[i].z, Z)
+		)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// rebuild the octree if vertices moved 
+static void visualization_octree_update(const Vertices & vertices)
+{
+	bool rebuild = 
+		visualization_octree_nodes_count == 0 || 
+		visualization_octree_max_dev != visualization_state.max_dev || 
+		memcmp(visualization_octree_mean, visualization_state.shots_T_mean, sizeof(visualization_octree_mean)) != 0 || 
+		!geometry_journal_complete(visualization_octree_version)
+	;
+
+	size_t position = 0; 
+	Geometry_Change change;
+	while (!rebuild && geometry_journal_next(position, visualization_octree_version, change)) 
+	{
+		if (change.kind != GEOMETRY_CHANGE_VERTICES) continue;
+		rebuild = visualization_octree_moved(vertices, change.from, change.to);
+	}
+
+	if (rebuild) 
+	{
+		visualization_octree_build(vertices);
+		visualization_octree_max_dev = visualization_state.max_dev; 
+		memcpy(visualization_octree_mean, visualization_state.shots_T_mean, sizeof(visualization_octree_mean));
+	}
+
+	visualization_octree_version = geometry_version();
+}
+
+// extract view frustum planes and eye position from current opengl matrices
+// expects LOCK(opengl)
+static void visualization_octree_frustum(const double world_scale)
+{
+	double projection[16], modelview[16], clip[16]; 
+	GLint viewport[4];
+	glGetDoublev(GL_PROJECTION_MATRIX, projection); 
+	glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	// points are drawn scaled by world_scale
+	for (int i = 0; i < 12; i++) modelview[i] *= world_scale;
+
+	// clip = projection * modelview (column major)
+	for (int c = 0; c < 4; c++) 
+	{
+		for (int r = 0; r < 4; r++) 
+		{
+			clip[4 * c + r] = 
+				projection[0 * 4 + r] * modelview[4 * c + 0] + 
+				projection[1 * 4 + r] * modelview[4 * c + 1] + 
+				projection[2 * 4 + r] * modelview[4 * c + 2] + 
+				projection[3 * 4 + r] * modelview[4 * c + 3];
+		}
+	}
+
+	// planes are rows of clip matrix added to or subtracted from the last one 
+	for (int p = 0; p < 6; p++) 
+	{
+		const int row = p / 2; 
+		const double sign = p % 2 ? -1 : 1;
+		for (int k = 0; k < 4; k++) 
+		{
+			visualization_octree_planes[p][k] = clip[4 * k + 3] + sign * clip[4 * k + row];
+		}
+	}
+
+	// eye is at -R^T t (in scaled space) 
+	for (int k = 0; k < 3; k++) 
+	{
+		visualization_octree_eye[k] = -(
+			modelview[4 * k + 0] * modelview[12] + 
+			modelview[4 * k + 1] * modelview[13] + 
+			modelview[4 * k + 2] * modelview[14]
+		) / (world_scale * world_scale);
+	}
+
+	// how many pixels does unit length cover at unit distance
+	visualization_octree_pixels = 0.5 * viewport[3] * projection[5] * world_scale;
+}
+
+// check if box intersects view frustum 
+bool visualization_octree_box_visible(const double min[3], const double max[3])
+{
+	for (int p = 0; p < 6; p++) 
+	{
+		const double * const plane = visualization_octree_planes[p];
+
+		// test the corner lying farthest along plane's normal 
+		const double d = 
+			plane[0] * (plane[0] > 0 ? max[0] : min[0]) + 
+			plane[1] * (plane[1] > 0 ? max[1] : min[1]) + 
+			plane[2] * (plane[2] > 0 ? max[2] : min[2]) + 
+			plane[3];
+
+		if (d < 0) return false;
+	}
+
+	return true;
+}
+
+// add vertices to the visible set 
+static void visualization_octree_emit(const GLuint * const ids, const size_t count)
+{
+	if (visualization_octree_visible_count + count > visualization_octree_visible_allocated) 
+	{
+		while (visualization_octree_visible_count + count > visualization_octree_visible_allocated) 
+		{
+			visualization_octree_visible_allocated = visualization_octree_visible_allocated ? 2 * visualization_octree_visible_allocated : 4096;
+		}
+
+		visualization_octree_visible_ids = (GLuint *)realloc(visualization_octree_visible_ids, visualization_octree_visible_allocated * sizeof(GLuint));
+	}
+
+	memcpy(visualization_octree_visible_ids + visualization_octree_visible_count, ids, count * sizeof(GLuint));
+	visualization_octree_visible_count += count;
+}
+
+// collect visible vertices of node 
+static void visualization_octree_traverse(const size_t node_id)
+{
+	const Visualization_Octree_Node * const node = visualization_octree_nodes + node_id;
+	const double min[3] = { node->min[0], node->min[1], node->min[2] }, max[3] = { node->max[0], node->max[1], node->max[2] };
+	if (!visualization_octree_box_visible(min, max)) return;
+
+	// estimate node's size on screen 
+	double diagonal = 0, distance = 0; 
+	for (int k = 0; k < 3; k++) 
+	{
+		diagonal += sqr_value(max[k] - min[k]); 
+		distance += sqr_value(0.5 * (min[k] + max[k]) - visualization_octree_eye[k]);
+	}
+	diagonal = sqrt(diagonal); 
+	distance = sqrt(distance);
+
+	// too small nodes are represented by a few of their vertices
+	if (distance > diagonal) 
+	{
+		const double pixels = visualization_octree_pixels * diagonal / distance;
+		if (pixels < VISUALIZATION_OCTREE_LOD_PIXELS && node->count > node->samples_count) 
+		{
+			size_t count = (size_t)(pixels * pixels) + 1; 
+			if (count > node->samples_count) count = node->samples_count;
+			visualization_octree_emit(visualization_octree_samples + node->samples_first, count);
+			return;
+		}
+	}
+
+	if (node->leaf) 
+	{
+		visualization_octree_emit(visualization_octree_items + node->first, node->count);
+		return;
+	}
+
+	for (int o = 0; o < 8; o++) 
+	{
+		if (node->children[o]) 
+		{
+			visualization_octree_traverse(node->children[o]);
+		}
+	}
+}
+
+// update octree and cull it against current view frustum 
+void visualization_octree_cull(const Vertices & vertices, const double world_scale /*= 1*/)
+{
+	visualization_octree_update(vertices);
+	ATOMIC(opengl, visualization_octree_frustum(world_scale); );
+
+	visualization_octree_visible_count = 0;
+	if (visualization_octree_nodes_count > 0 && visualization_octree_nodes[0].count > 0) 
+	{
+		visualization_octree_traverse(0);
+	}
+}
+
+// ids of vertices which survived the last culling 
+const GLuint * visualization_octree_visible(size_t & count)
+{
+	count = visualization_octree_visible_count;
+	return visualization_octree_visible_ids;
+}
@@ -0,0 +1,18 @@
+#ifndef __UI_VISUALIZATION_OCTREE
+#define __UI_VISUALIZATION_OCTREE
+
+#include "interface_opengl.h"
+#include "ui_visualization.h"
+
+// update octree over reconstructed vertices (in normalized space) and cull it against current 
+// view frustum; parts of the scene too small on screen to show all their vertices are decimated
+// note must be called by the rendering thread after the user camera has been placed 
+void visualization_octree_cull(const Vertices & vertices, const double world_scale = 1);
+
+// ids of vertices which survived the last culling 
+const GLuint * visualization_octree_visible(size_t & count);
+
+// check if box in normalized space intersects view frustum of the last culling 
+bool visualization_octree_box_visible(const double min[3], const double max[3]);
+
+#endif
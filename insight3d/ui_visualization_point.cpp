@@ -148,6 +148,315 @@ void visualization_point_reprojection_calibration(
 	visualization_reprojection(x, y, reprojection[0], reprojection[1], outlier);
 }
 
+// reprojections of points on current shot, kept until geometric data change 
+struct Visualization_Reprojection
+{
+	bool valid; 
+	double x, y; // in opengl coordinates
+};
+
+static Visualization_Reprojection * visualization_reprojections = NULL;
+static size_t visualization_reprojections_allocated = 0;
+static size_t 
+	visualization_reprojections_version = 0, // version of geometric data they were computed from 
+	visualization_reprojections_shot, 
+	visualization_reprojections_calibration; 
+static int visualization_reprojections_width = 0, visualization_reprojections_height = 0; // size of the shot they were computed for
+
+// project a batch of homogeneous vertices using projection matrix stored by rows 
+static void visualization_project(const double P[12], const double * X, double * x, const size_t count)
+{
+	for (size_t i = 0; i < count; i++, X += 4, x += 2) 
+	{
+		double w = P[8] * X[0] + P[9] * X[1] + P[10] * X[2] + P[11] * X[3];
+		if (w == 0) w = 0.00001;
+		x[0] = (P[0] * X[0] + P[1] * X[1] + P[2] * X[2] + P[3] * X[3]) / w;
+		x[1] = (P[4] * X[0] + P[5] * X[1] + P[6] * X[2] + P[7] * X[3]) / w;
+	}
+}
+
+// reprojections of all points on shot, either in partial calibration (if calibration_id is set) 
+// or using shot's own projection matrix 
+static const Visualization_Reprojection * visualization_shot_reprojections(const size_t shot_id, const size_t calibration_id, const size_t P_id)
+{
+	const Shot * const shot = shots.data + shot_id;
+	const bool use_calibration = calibration_id != SIZE_MAX;
+
+	// are the cached ones still valid? 
+	if (
+		visualization_reprojections_version == geometry_version() && 
+		visualization_reprojections_shot == shot_id && 
+		visualization_reprojections_calibration == calibration_id && 
+		visualization_reprojections_width == shot->width && 
+		visualization_reprojections_height == shot->height
+	)
+	{
+		return visualization_reprojections;
+	}
+
+	// make room for all points 
+	if (shot->points.count > visualization_reprojections_allocated) 
+	{
+		visualization_reprojections_allocated = shot->points.count;
+		visualization_reprojections = (Visualization_Reprojection *)realloc(visualization_reprojections, visualization_reprojections_allocated * sizeof(Visualization_Reprojection));
+	}
+
+	memset(visualization_reprojections, 0, shot->points.count * sizeof(Visualization_Reprojection));
+
+	// gather homogeneous coordinates of all reconstructed vertices 
+	double * const X = ALLOC(double, 4 * shot->points.count + 4); 
+	double * const x = ALLOC(double, 2 * shot->points.count + 2);
+	size_t * const ids = ALLOC(size_t, shot->points.count + 1); 
+	size_t count = 0; 
+
+	for ALL(shot->points, i) 
+	{
+		const size_t vertex_id = shot->points.data[i].vertex;
+		double * const h = X + 4 * count;
+
+		if (use_calibration) 
+		{
+			size_t X_id; 
+			if (!geometry_calibration_find_X(calibration_id, vertex_id, X_id)) continue;
+			const CvMat * const M = calibrations.data[calibration_id].Xs.data[X_id].X;
+			if (!M) continue;
+
+			h[0] = OPENCV_ELEM(M, 0, 0);
+			h[1] = OPENCV_ELEM(M, 1, 0);
+			h[2] = OPENCV_ELEM(M, 2, 0);
+			h[3] = OPENCV_ELEM(M, 3, 0);
+		}
+		else
+		{
+			if (!vertices.data[vertex_id].reconstructed) continue;
+
+			h[0] = vertices.data[vertex_id].x; 
+			h[1] = vertices.data[vertex_id].y; 
+			h[2] = vertices.data[vertex_id].z; 
+			h[3] = 1;
+		}
+
+		ids[count++] = i;
+	}
+
+	// project them all at once 
+	const CvMat * const projection = use_calibration ? calibrations.data[calibration_id].Ps.data[P_id].P : shot->projection;
+	double P[12];
+	for (int i = 0; i < 12; i++) 
+	{
+		P[i] = OPENCV_ELEM(projection, i / 4, i % 4);
+	}
+
+	visualization_project(P, X, x, count);
+
+	// convert to opengl coordinates 
+	for (size_t j = 0; j < count; j++) 
+	{
+		Visualization_Reprojection * const reprojection = visualization_reprojections + ids[j];
+		reprojection->valid = true; 
+		ui_convert_xy_from_shot_to_opengl(x[2 * j + 0] / shot->width, x[2 * j + 1] / shot->height, reprojection->x, reprojection->y);
+	}
+
+	FREE(ids); 
+	FREE(x); 
+	FREE(X);
+
+	visualization_reprojections_version = geometry_version();
+	visualization_reprojections_shot = shot_id; 
+	visualization_reprojections_calibration = calibration_id; 
+	visualization_reprojections_width = shot->width; 
+	visualization_reprojections_height = shot->height;
+
+	return visualization_reprojections;
+}
+
+// * shot overlay * 
+
+// markers of all points on current shot and their reprojections are drawn in batches 
+// which are rebuilt only when geometric data or zoom change
+struct Visualization_Overlay_Vertex
+{
+	GLfloat x, y, z; 
+	GLubyte color[4];
+};
+
+struct Visualization_Overlay_Batch
+{
+	Visualization_Overlay_Vertex * data; 
+	size_t count, allocated;
+};
+
+enum VISUALIZATION_OVERLAY_BATCH
+{
+	VISUALIZATION_OVERLAY_CROSSES,               // crosses marking manually entered points 
+	VISUALIZATION_OVERLAY_CROSSES_INNER, 
+	VISUALIZATION_OVERLAY_AUTO,                  // automatically generated points 
+	VISUALIZATION_OVERLAY_AUTO_INNER, 
+	VISUALIZATION_OVERLAY_REPROJECTIONS,         // reprojection error line segments 
+	VISUALIZATION_OVERLAY_REPROJECTIONS_OUTER,   // and reprojected vertices 
+	VISUALIZATION_OVERLAY_REPROJECTIONS_INNER, 
+	VISUALIZATION_OVERLAY_BATCHES
+};
+
+static Visualization_Overlay_Batch visualization_overlay[VISUALIZATION_OVERLAY_BATCHES];
+static size_t 
+	visualization_overlay_version = 0, // version of geometric data the overlay was built from 
+	visualization_overlay_shot, 
+	visualization_overlay_calibration; 
+static bool visualization_overlay_hide_automatic;
+static double visualization_overlay_dx, visualization_overlay_dy;
+
+// append vertex to batch 
+static void visualization_overlay_add(
+	Visualization_Overlay_Batch * const batch, const double x, const double y, 
+	const double r, const double g, const double b, const double a
+)
+{
+	if (batch->count >= batch->allocated) 
+	{
+		batch->allocated = batch->allocated ? 2 * batch->allocated : 1024;
+		batch->data = (Visualization_Overlay_Vertex *)realloc(batch->data, batch->allocated * sizeof(Visualization_Overlay_Vertex));
+	}
+
+	Visualization_Overlay_Vertex * const vertex = batch->data + batch->count++;
+	vertex->x = (GLfloat)x; 
+	vertex->y = (GLfloat)y; 
+	vertex->z = -1; 
+	vertex->color[0] = (GLubyte)(255 * r);
+	vertex->color[1] = (GLubyte)(255 * g);
+	vertex->color[2] = (GLubyte)(255 * b);
+	vertex->color[3] = (GLubyte)(255 * a);
+}
+
+// append cross to batch 
+static void visualization_overlay_cross(
+	Visualization_Overlay_Batch * const batch, const double x, const double y, const double size_x, const double size_y, 
+	const double r, const double g, const double b
+)
+{
+	visualization_overlay_add(batch, x, y, r, g, b, 1); 
+	visualization_overlay_add(batch, x + size_x, y, r, g, b, 1); 
+	visualization_overlay_add(batch, x, y, r, g, b, 1); 
+	visualization_overlay_add(batch, x - size_x, y, r, g, b, 1); 
+	visualization_overlay_add(batch, x, y, r, g, b, 1); 
+	visualization_overlay_add(batch, x, y + size_y, r, g, b, 1); 
+	visualization_overlay_add(batch, x, y, r, g, b, 1); 
+	visualization_overlay_add(batch, x, y - size_y, r, g, b, 1); 
+}
+
+// rebuild overlay batches for current shot 
+static void visualization_overlay_build(const size_t shot_id, const size_t calibration_id, const size_t P_id, const bool P_found)
+{
+	const Shot * const shot = shots.data + shot_id;
+	const Calibration * const calibration = calibrations.data + calibration_id;
+
+	for (int i = 0; i < VISUALIZATION_OVERLAY_BATCHES; i++) 
+	{
+		visualization_overlay[i].count = 0;
+	}
+
+	// marker sizes (the same as in visualization_point)
+	const double 
+		cross_x = visualization_calc_dx(VISUALIZATION_POINT_SIZE + 1.5), 
+		cross_y = visualization_calc_dy(VISUALIZATION_POINT_SIZE + 1.5), 
+		cross_inner_x = visualization_calc_dx(VISUALIZATION_POINT_SIZE), 
+		cross_inner_y = visualization_calc_dy(VISUALIZATION_POINT_SIZE);
+
+	// unselected points go first, selected ones are drawn over them 
+	for (int selected = 0; selected < 2; selected++)
+	{
+		for ALL(shot->points, i)
+		{
+			const Point * const point = shot->points.data + i;
+			if (point->selected != (selected == 1)) continue;
+
+			// skipping automatic points if the user wishes so 
+			const bool automatic = vertices.data[point->vertex].vertex_type == GEOMETRY_VERTEX_AUTO;
+			if (option_hide_automatic && automatic) continue;
+
+			double x, y;
+			ui_convert_xy_from_shot_to_opengl(point->x, point->y, x, y);
+
+			if (automatic) 
+			{
+				if (selected) 
+				{
+					visualization_overlay_add(visualization_overlay + VISUALIZATION_OVERLAY_AUTO, x, y, 0.8, 0, 0.8, 1);
+				}
+				else
+				{
+					visualization_overlay_add(visualization_overlay + VISUALIZATION_OVERLAY_AUTO, x, y, 1, 1, 1, 0.7);
+				}
+
+				visualization_overlay_add(visualization_overlay + VISUALIZATION_OVERLAY_AUTO_INNER, x, y, 0, 0, 0, 0.7);
+			}
+			else
+			{
+				if (selected) 
+				{
+					visualization_overlay_cross(visualization_overlay + VISUALIZATION_OVERLAY_CROSSES, x, y, cross_x, cross_y, 0.8, 0, 0.8);
+				}
+				else
+				{
+					visualization_overlay_cross(visualization_overlay + VISUALIZATION_OVERLAY_CROSSES, x, y, cross_x, cross_y, 1, 1, 1);
+				}
+
+				visualization_overlay_cross(visualization_overlay + VISUALIZATION_OVERLAY_CROSSES_INNER, x, y, cross_inner_x, cross_inner_y, 0, 0, 0);
+			}
+		}
+	}
+
+	// reprojection errors of individual points (either in partial calibration or using shot's own calibration)
+	if (P_found || shot->calibrated)
+	{
+		ASSERT(P_found || shot->projection, "calibrated shot doesn't have projection matrix");
+		const Visualization_Reprojection * const reprojections = 
+			visualization_shot_reprojections(shot_id, P_found ? calibration_id : SIZE_MAX, P_id);
+
+		for ALL(shot->points, i) 
+		{
+			// skipping automatic points if the user wishes so 
+			if (option_hide_automatic && vertices.data[shot->points.data[i].vertex].vertex_type == GEOMETRY_VERTEX_AUTO) continue;
+
+			// skip points without reconstructed vertex 
+			if (!reprojections[i].valid) continue;
+
+			// check if this is outlier 
+			const bool outlier = P_found && IS_SET(calibration->Ps.data[P_id].points_meta, i) && calibration->Ps.data[P_id].points_meta.data[i].inlier == 0;
+
+			double x, y;
+			ui_convert_xy_from_shot_to_opengl(shot->points.data[i].x, shot->points.data[i].y, x, y);
+			const double rx = reprojections[i].x, ry = reprojections[i].y;
+
+			if (!outlier) 
+			{
+				visualization_overlay_add(visualization_overlay + VISUALIZATION_OVERLAY_REPROJECTIONS, x, y, 0, 0.8, 0, 0.6);
+				visualization_overlay_add(visualization_overlay + VISUALIZATION_OVERLAY_REPROJECTIONS, rx, ry, 0, 0.8, 0, 0.6);
+				visualization_overlay_add(visualization_overlay + VISUALIZATION_OVERLAY_REPROJECTIONS_INNER, rx, ry, 0, 1, 0, 1);
+			}
+			else
+			{
+				visualization_overlay_add(visualization_overlay + VISUALIZATION_OVERLAY_REPROJECTIONS, x, y, 0.7, 0, 0, 0.6);
+				visualization_overlay_add(visualization_overlay + VISUALIZATION_OVERLAY_REPROJECTIONS, rx, ry, 0.7, 0, 0, 0.6);
+				visualization_overlay_add(visualization_overlay + VISUALIZATION_OVERLAY_REPROJECTIONS_INNER, rx, ry, 1, 0, 0, 1);
+			}
+
+			visualization_overlay_add(visualization_overlay + VISUALIZATION_OVERLAY_REPROJECTIONS_OUTER, rx, ry, 0, 0.2, 0, 1);
+		}
+	}
+}
+
+// draw one batch 
+static void visualization_overlay_draw(const VISUALIZATION_OVERLAY_BATCH batch, const GLenum mode)
+{
+	if (visualization_overlay[batch].count == 0) return;
+
+	const Visualization_Overlay_Vertex * const data = visualization_overlay[batch].data;
+	glVertexPointer(3, GL_FLOAT, sizeof(Visualization_Overlay_Vertex), &data->x);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Visualization_Overlay_Vertex), data->color);
+	glDrawArrays(mode, 0, (GLsizei)visualization_overlay[batch].count);
+}
+
 // show 2d points in shot mode
 void visualization_shot_points()
 {
@@ -159,62 +468,58 @@ void visualization_shot_points()
 	const Shot * shot = shots.data + ui_state.current_shot;
 
 	// check if there is current calibration selected 
-	Calibration * const calibration = calibrations.data + ui_state.current_calibration;
-	size_t P_id;
-	bool use_calibration = false, P_found = false;
+	const size_t calibration_id = INDEX_IS_SET(ui_state.current_calibration) ? ui_state.current_calibration : SIZE_MAX;
+	size_t P_id = 0;
+	bool P_found = false;
 
 	if (INDEX_IS_SET(ui_state.current_calibration))
 	{
 		// if partial calibration was picked, show it 
 		ASSERT_IS_SET(calibrations, ui_state.current_calibration);
-		Calibration * const calibration = calibrations.data + ui_state.current_calibration;
-		use_calibration = true;
 
 		// find id of this shot 
-		LAMBDA_FIND(calibration->Ps, P_id, P_found, calibration->Ps.data[P_id].shot_id == shot_id);
+		P_found = geometry_calibration_find_P(ui_state.current_calibration, shot_id, P_id);
 	}
 
-	// go through all unselected and unfocused 2d points on this shot
-	for ALL(shot->points, i)
+	// rebuild the overlay if something changed 
+	const double dx = visualization_calc_dx(1), dy = visualization_calc_dy(1);
+	if (
+		visualization_overlay_version != geometry_version() || 
+		visualization_overlay_shot != shot_id || 
+		visualization_overlay_calibration != calibration_id || 
+		visualization_overlay_hide_automatic != option_hide_automatic || 
+		visualization_overlay_dx != dx || 
+		visualization_overlay_dy != dy
+	)
 	{
-		// skipping automatic points if the user wishes so 
-		if (option_hide_automatic && vertices.data[shot->points.data[i].vertex].vertex_type == GEOMETRY_VERTEX_AUTO) continue;
-
-		// fetch point data and skip selected and focused
-		const Point * point = shot->points.data + i;
-		if (INDEX_IS_SET(ui_state.focused_point) && ui_state.focused_point == i || point->selected) continue;
-
-		// check if this is outlier 
-		const bool outlier = P_found && IS_SET(calibration->Ps.data[P_id].points_meta, i) && calibration->Ps.data[P_id].points_meta.data[i].inlier == 0;
-		const bool automatic = vertices.data[point->vertex].vertex_type == GEOMETRY_VERTEX_AUTO;
-
-		// draw it 
-		double x, y;
-		ui_convert_xy_from_shot_to_opengl(geometry_get_point_x(shot_id, i), geometry_get_point_y(shot_id, i), x, y);
-		visualization_point(x, y, VISUALIZATION_DEFAULT | (outlier ? VISUALIZATION_OUTLIER : 0) | (automatic ? VISUALIZATION_AUTO : 0));
+		visualization_overlay_build(shot_id, calibration_id, P_id, P_found);
+
+		visualization_overlay_version = geometry_version();
+		visualization_overlay_shot = shot_id; 
+		visualization_overlay_calibration = calibration_id; 
+		visualization_overlay_hide_automatic = option_hide_automatic; 
+		visualization_overlay_dx = dx; 
+		visualization_overlay_dy = dy;
 	}
 
-	// now display the selected ones 
-	for ALL(shot->points, i)
-	{
-		// fetch point data and skip unselected or focused
-		const Point * point = shot->points.data + i;
-		if (!point->selected || INDEX_IS_SET(ui_state.focused_point) && ui_state.focused_point == i) continue;
+	// draw markers of all points
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
 
-		// skipping automatic points if the user wishes so 
-		if (option_hide_automatic && vertices.data[shot->points.data[i].vertex].vertex_type == GEOMETRY_VERTEX_AUTO) continue;
+	glLineWidth(4);
+	visualization_overlay_draw(VISUALIZATION_OVERLAY_CROSSES, GL_LINES);
+	glLineWidth(1.0);
+	visualization_overlay_draw(VISUALIZATION_OVERLAY_CROSSES_INNER, GL_LINES);
+	glPointSize(8);
+	visualization_overlay_draw(VISUALIZATION_OVERLAY_AUTO, GL_POINTS);
+	glPointSize(5);
+	visualization_overlay_draw(VISUALIZATION_OVERLAY_AUTO_INNER, GL_POINTS);
 
-		// check if this is outlier 
-		const bool outlier = P_found && IS_SET(calibration->Ps.data[P_id].points_meta, i) && calibration->Ps.data[P_id].points_meta.data[i].inlier == 0;
-		const bool automatic = vertices.data[point->vertex].vertex_type == GEOMETRY_VERTEX_AUTO;
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
 
-		// draw it
-		double x, y; 
-		ui_convert_xy_from_shot_to_opengl(geometry_get_point_x(shot_id, i), geometry_get_point_y(shot_id, i), x, y);
-		visualization_point(x, y, VISUALIZATION_SELECTED | (outlier ? VISUALIZATION_OUTLIER : 0) | (automatic ? VISUALIZATION_AUTO : 0));
-	}
-
-	// and finally the focused point is displayed
+	// the focused point is displayed over them
 	if (INDEX_IS_SET(ui_state.focused_point))
 	{
 		ASSERT_IS_SET(shot->points, ui_state.focused_point);
@@ -229,8 +534,8 @@ void visualization_shot_points()
 		);
 
 		// check if this is outlier 
-		const bool outlier = P_found && IS_SET(calibration->Ps.data[P_id].points_meta, ui_state.focused_point) 
-		                     && calibration->Ps.data[P_id].points_meta.data[ui_state.focused_point].inlier == 0;
+		const bool outlier = P_found && IS_SET(calibrations.data[calibration_id].Ps.data[P_id].points_meta, ui_state.focused_point) 
+		                     && calibrations.data[calibration_id].Ps.data[P_id].points_meta.data[ui_state.focused_point].inlier == 0;
 		const bool automatic = vertices.data[focused_point->vertex].vertex_type == GEOMETRY_VERTEX_AUTO;
 
 		int style = VISUALIZATION_FOCUSED;
@@ -242,52 +547,16 @@ void visualization_shot_points()
 		visualization_point(x, y, style | (outlier ? VISUALIZATION_OUTLIER : 0) | (automatic ? VISUALIZATION_AUTO : 0));
 	}
 
-	// show reprojection errors of individual points
-	if (use_calibration && P_found)
-	{
-		// go through all points
-		for ALL(shot->points, i) 
-		{
-			// skipping automatic points if the user wishes so 
-			if (option_hide_automatic && vertices.data[shot->points.data[i].vertex].vertex_type == GEOMETRY_VERTEX_AUTO) continue;
-
-			const Point * const point = shot->points.data + i;
-			const size_t vertex_id = point->vertex;
-
-			bool found; 
-			size_t X_id = 0; 
-			LAMBDA_FIND(calibration->Xs, X_id, found, calibration->Xs.data[X_id].vertex_id == vertex_id);
-
-			// check if this is outlier 
-			const bool outlier = P_found && IS_SET(calibration->Ps.data[P_id].points_meta, i) && calibration->Ps.data[P_id].points_meta.data[i].inlier == 0;
-
-			if (found) 
-			{
-				// draw it
-				visualization_point_reprojection_calibration(
-					shot_id, i, ui_state.current_calibration, 
-					P_id, X_id, outlier
-				);
-			}
-		}
-	}
-	else if (shot->calibrated)
-	{
-		ASSERT(shot->projection, "calibrated shot doesn't have projection matrix");
-
-		for ALL(shot->points, i)
-		{
-			// skipping automatic points if the user wishes so 
-			if (option_hide_automatic && vertices.data[shot->points.data[i].vertex].vertex_type == GEOMETRY_VERTEX_AUTO) continue;
+	// and finally reprojection errors
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
 
-			// fetch point data and skip selected and focused
-			const Point * point = shot->points.data + i;
-
-			// check if it's reconstructed
-			if (!vertices.data[point->vertex].reconstructed) continue;
+	glLineWidth(1.0);
+	visualization_overlay_draw(VISUALIZATION_OVERLAY_REPROJECTIONS, GL_LINES);
+	glPointSize(5);
+	visualization_overlay_draw(VISUALIZATION_OVERLAY_REPROJECTIONS_OUTER, GL_POINTS);
+	glPointSize(3);
+	visualization_overlay_draw(VISUALIZATION_OVERLAY_REPROJECTIONS_INNER, GL_POINTS);
 
-			// draw it
-			visualization_point_reprojection(shot_id, i);
-		}
-	}
+	glPopClientAttrib();
 }
@@ -1,5 +1,42 @@
 #include "ui_workflow.h"
 
+// how many shots around the current one are prefetched by image loader 
+static const size_t UI_WORKFLOW_PREFETCH_FULL = 1, UI_WORKFLOW_PREFETCH_LOW = 4;
+
+// suggest image loader which images will be probably needed next - neighbouring 
+// shots in the sequence and shots on which the processed vertex is visible 
+static void ui_workflow_prefetch()
+{
+	image_loaded_flush_suggested();
+	if (!INDEX_IS_SET(ui_state.current_shot)) return;
+
+	// neighbours in both directions 
+	size_t after = 0, before = 0;
+	for (size_t id = ui_state.current_shot + 1; id < shots.count && after < UI_WORKFLOW_PREFETCH_LOW; id++) 
+	{
+		if (!validate_shot(id)) continue;
+		image_loader_suggest(id, shots.data[id].image_filename, after++ < UI_WORKFLOW_PREFETCH_FULL ? IMAGE_LOADER_FULL_RESOLUTION : IMAGE_LOADER_LOW_RESOLUTION);
+	}
+
+	for (size_t id = ui_state.current_shot; id > 0 && before < UI_WORKFLOW_PREFETCH_LOW; id--) 
+	{
+		if (!validate_shot(id - 1)) continue;
+		image_loader_suggest(id - 1, shots.data[id - 1].image_filename, before++ < UI_WORKFLOW_PREFETCH_FULL ? IMAGE_LOADER_FULL_RESOLUTION : IMAGE_LOADER_LOW_RESOLUTION);
+	}
+
+	// shots covisible with processed vertex 
+	if (INDEX_IS_SET(ui_state.processed_vertex) && IS_SET(vertices_incidence, ui_state.processed_vertex))
+	{
+		const Double_Indices * const incidence = &vertices_incidence.data[ui_state.processed_vertex].shot_point_ids;
+		for ALL(*incidence, i) 
+		{
+			const size_t shot_id = incidence->data[i].primary;
+			if (shot_id == ui_state.current_shot || !validate_shot(shot_id)) continue;
+			image_loader_suggest(shot_id, shots.data[shot_id].image_filename, IMAGE_LOADER_LOW_RESOLUTION);
+		}
+	}
+}
+
 // cancels processing of a vertex, this usually results in a new vertex being created
 void ui_workflow_no_vertex()
 {
@@ -43,6 +80,7 @@ void ui_workflow_next_vertex()
 	if (found)
 	{
 		INDEX_SET(ui_state.processed_vertex, vertex_id);
+		ui_workflow_prefetch();
 	}
 	else
 	{
@@ -139,6 +177,7 @@ void ui_workflow_prev_vertex()
 	if (found)
 	{
 		INDEX_SET(ui_state.processed_vertex, vertex_id);
+		ui_workflow_prefetch();
 	}
 	else
 	{
@@ -255,6 +294,9 @@ void ui_workflow_select_shot(size_t shot_id)
 	// update cursor of unprocessed items 
 	ui_workflow_first_vertex();
 
+	// prefetch images we'll probably need next (also when there's no vertex to process)
+	ui_workflow_prefetch();
+
 	// begin working with current tool again 
 	if (tools_state.tools[tools_state.current].begin)
 	{